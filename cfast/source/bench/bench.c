@@ -0,0 +1,214 @@
+// ============================================================================
+// bench.c - Micro benchmark harness
+// ============================================================================
+#ifndef _WIN32
+#    define _POSIX_C_SOURCE 200809L    // clock_gettime
+#endif
+
+#include "bench.h"
+#include "simd.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#    include <windows.h>
+#else
+#    include <time.h>
+#endif
+
+#if SIMD_X86 && !defined( _MSC_VER )
+#    include <x86intrin.h>    // __rdtsc
+#endif
+
+#if defined( _MSC_VER ) && !defined( __clang__ )
+volatile const void* g_bench_sink;
+#endif
+
+// ============================================================================
+// Clocks
+// ============================================================================
+
+uint64_t
+bench_now_ns( void )
+{
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER        now;
+    if ( !frequency.QuadPart )
+        QueryPerformanceFrequency( &frequency );
+    QueryPerformanceCounter( &now );
+    return (uint64_t)( (double)now.QuadPart * 1e9 / (double)frequency.QuadPart );
+#else
+    struct timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+#endif
+}
+
+uint64_t
+bench_ticks( void )
+{
+#if SIMD_X86
+    return __rdtsc();
+#else
+    return bench_now_ns();
+#endif
+}
+
+// ============================================================================
+// Running a case
+// ============================================================================
+
+typedef struct BenchSample
+{
+    uint64_t ns;
+    uint64_t ticks;
+
+} BenchSample;
+
+static BenchSample
+bench_sample( const BenchCase* bench, uint64_t iterations )
+{
+    if ( bench->setup )
+        bench->setup( bench->ctx );
+
+    bench_clobber();
+    uint64_t start_ns    = bench_now_ns();
+    uint64_t start_ticks = bench_ticks();
+    bench->run( bench->ctx, iterations );
+    uint64_t end_ticks = bench_ticks();
+    uint64_t end_ns    = bench_now_ns();
+    bench_clobber();
+
+    BenchSample sample = { end_ns - start_ns, end_ticks - start_ticks };
+    return sample;
+}
+
+// Grow the iteration count until one sample reaches the target duration
+static uint64_t
+bench_calibrate( const BenchCase* bench, uint64_t sample_ns )
+{
+    uint64_t iterations = 1;
+    for ( ;; )
+    {
+        uint64_t elapsed = bench_sample( bench, iterations ).ns;
+        if ( elapsed >= sample_ns || iterations >= ( 1ull << 40 ) )
+            return iterations;
+
+        uint64_t scale = elapsed ? sample_ns / elapsed + 1 : 10;
+        iterations *= scale < 2 ? 2 : scale > 10 ? 10 : scale;
+    }
+}
+
+static int
+compare_double( const void* a, const void* b )
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return ( x > y ) - ( x < y );
+}
+
+// Nearest rank on sorted data
+static double
+percentile( const double* sorted, uint32_t count, double p )
+{
+    uint32_t rank = (uint32_t)( p * count + 0.999999 );
+    return sorted[ rank ? rank - 1 : 0 ];
+}
+
+int
+bench_run( const BenchCase* bench, const BenchOptions* options, BenchResult* out )
+{
+    if ( options->filter && !strstr( bench->name, options->filter ) )
+        return 0;
+
+    // One untimed pass first so lazy setup (plan compiles, page faults) does not cut calibration short
+    bench_sample( bench, 1 );
+
+    uint32_t samples    = bench->samples ? bench->samples : options->samples;
+    uint64_t iterations = bench->iterations ? bench->iterations : bench_calibrate( bench, options->sample_ns );
+
+    // Warmup - caches, branch predictors, CPU clock ramp
+    uint64_t warmup_end = bench_now_ns() + (uint64_t)options->warmup_ms * 1000000ull;
+    do
+    {
+        bench_sample( bench, iterations );
+    } while ( bench_now_ns() < warmup_end );
+
+    double* ns    = (double*)malloc( samples * sizeof( double ) );
+    double* ticks = (double*)malloc( samples * sizeof( double ) );
+    double  total = 0;
+    for ( uint32_t i = 0; i < samples; i++ )
+    {
+        BenchSample sample = bench_sample( bench, iterations );
+        ns[ i ]            = (double)sample.ns / (double)iterations;
+        ticks[ i ]         = (double)sample.ticks / (double)iterations;
+        total += ns[ i ];
+    }
+    qsort( ns, samples, sizeof( double ), compare_double );
+    qsort( ticks, samples, sizeof( double ), compare_double );
+
+    out->name         = bench->name;
+    out->iterations   = iterations;
+    out->samples      = samples;
+    out->median_ns    = percentile( ns, samples, 0.50 );
+    out->p99_ns       = percentile( ns, samples, 0.99 );
+    out->min_ns       = ns[ 0 ];
+    out->mean_ns      = total / samples;
+    out->median_ticks = SIMD_X86 ? percentile( ticks, samples, 0.50 ) : 0.0;
+    out->ops_per_sec  = out->median_ns > 0 ? 1e9 / out->median_ns : 0.0;
+
+    free( ns );
+    free( ticks );
+    return 1;
+}
+
+// ============================================================================
+// Output
+// ============================================================================
+
+void
+bench_print_header( FILE* file )
+{
+    fprintf( file, "%-32s %12s %12s %12s %10s %14s\n", "case", "median ns", "p99 ns", "min ns", "ticks",
+             "ops/s" );
+}
+
+void
+bench_print_result( FILE* file, const BenchResult* result )
+{
+    fprintf( file, "%-32s %12.2f %12.2f %12.2f %10.1f %14.0f\n", result->name, result->median_ns, result->p99_ns,
+             result->min_ns, result->median_ticks, result->ops_per_sec );
+}
+
+void
+bench_write_csv( FILE* file, const BenchResult* results, int count )
+{
+    fprintf( file, "name,iterations,samples,median_ns,p99_ns,min_ns,mean_ns,median_ticks,ops_per_sec\n" );
+    for ( int i = 0; i < count; i++ )
+    {
+        const BenchResult* r = &results[ i ];
+        fprintf( file, "%s,%llu,%u,%.3f,%.3f,%.3f,%.3f,%.2f,%.0f\n", r->name, (unsigned long long)r->iterations,
+                 r->samples, r->median_ns, r->p99_ns, r->min_ns, r->mean_ns, r->median_ticks, r->ops_per_sec );
+    }
+}
+
+void
+bench_write_json( FILE* file, const char* suite, const BenchResult* results, int count )
+{
+    fprintf( file, "{\n  \"suite\": \"%s\",\n  \"simd\": \"%s\",\n  \"results\": [\n", suite,
+             simd_level_name( simd_level() ) );
+    for ( int i = 0; i < count; i++ )
+    {
+        const BenchResult* r = &results[ i ];
+        fprintf( file,
+                 "    { \"name\": \"%s\", \"iterations\": %llu, \"samples\": %u, \"median_ns\": %.3f, "
+                 "\"p99_ns\": %.3f, \"min_ns\": %.3f, \"mean_ns\": %.3f, \"median_ticks\": %.2f, "
+                 "\"ops_per_sec\": %.0f }%s\n",
+                 r->name, (unsigned long long)r->iterations, r->samples, r->median_ns, r->p99_ns, r->min_ns,
+                 r->mean_ns, r->median_ticks, r->ops_per_sec, i + 1 < count ? "," : "" );
+    }
+    fprintf( file, "  ]\n}\n" );
+}
+
+// ============================================================================
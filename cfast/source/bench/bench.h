@@ -0,0 +1,108 @@
+// ============================================================================
+// bench.h - Micro benchmark harness
+// ============================================================================
+//
+// Each case runs a warmup, then calibrates how many operations fit in one
+// sample so timer overhead stays negligible, then takes many samples. Results
+// are per operation: median and p99 over samples, plus throughput from the
+// median. bench_escape / bench_clobber keep the optimizer from folding or
+// hoisting the measured work.
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#if defined( _MSC_VER ) && !defined( __clang__ )
+#    include <intrin.h>
+extern volatile const void* g_bench_sink;
+#endif
+
+// ----------------------------------------------------------------------------
+// Optimization barriers
+// ----------------------------------------------------------------------------
+
+// The compiler must assume ptr is read and everything it points to is written
+static inline void
+bench_escape( const void* ptr )
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+    __asm__ __volatile__( "" : : "g"( ptr ) : "memory" );
+#else
+    g_bench_sink = ptr;
+    _ReadWriteBarrier();
+#endif
+}
+
+// All memory is assumed read and written
+static inline void
+bench_clobber( void )
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+    __asm__ __volatile__( "" : : : "memory" );
+#else
+    _ReadWriteBarrier();
+#endif
+}
+
+// Force a computed value to exist
+#define BENCH_KEEP( value ) bench_escape( &( value ) )
+
+// ----------------------------------------------------------------------------
+// Cases and results
+// ----------------------------------------------------------------------------
+
+// Performs `iterations` operations; state lives in ctx
+typedef void ( *BenchFunc )( void* ctx, uint64_t iterations );
+typedef void ( *BenchSetupFunc )( void* ctx );
+
+typedef struct BenchCase
+{
+    const char*    name;
+    BenchFunc      run;
+    BenchSetupFunc setup;         // Untimed, before every sample (optional)
+    void*          ctx;
+    uint64_t       iterations;    // Operations per sample, 0 = calibrate
+    uint32_t       samples;       // 0 = BenchOptions default
+
+} BenchCase;
+
+typedef struct BenchOptions
+{
+    uint32_t    samples;      // Samples per case
+    uint32_t    warmup_ms;    // Untimed running before calibration
+    uint64_t    sample_ns;    // Calibration target per sample
+    const char* filter;       // Substring of case names to run, NULL = all
+
+} BenchOptions;
+
+typedef struct BenchResult
+{
+    const char* name;
+    uint64_t    iterations;       // Operations per sample
+    uint32_t    samples;
+    double      median_ns;        // Per operation
+    double      p99_ns;
+    double      min_ns;
+    double      mean_ns;
+    double      median_ticks;     // Per operation in TSC ticks, 0 without a TSC
+    double      ops_per_sec;      // From the median
+
+} BenchResult;
+
+#define BENCH_OPTIONS_DEFAULT { 101, 50, 200000, NULL }
+
+uint64_t bench_now_ns( void );    // Monotonic clock
+uint64_t bench_ticks( void );     // TSC where available, else bench_now_ns
+
+// Returns 0 when the case is filtered out
+int bench_run( const BenchCase* bench, const BenchOptions* options, BenchResult* out );
+
+// Output - table for people, CSV / JSON for regression tracking
+void bench_print_header( FILE* file );
+void bench_print_result( FILE* file, const BenchResult* result );
+void bench_write_csv( FILE* file, const BenchResult* results, int count );
+void bench_write_json( FILE* file, const char* suite, const BenchResult* results, int count );
+
+#endif    // BENCH_H
@@ -0,0 +1,1237 @@
+// ============================================================================
+// bench_reflection.c - Registry, field access, serialization and reload timings
+// ============================================================================
+//
+// reflection_bench [--filter text] [--samples n] [--quick] [--csv path] [--json path]
+//
+// A path of "-" writes to stdout. Per-object cases (pack, gather, write)
+// report time per object, so numbers stay comparable as batch sizes change.
+
+#include "bench.h"
+#include "reflection_core.h"
+#include "serialize_binary.h"
+#include "field_batch.h"
+#include "json_writer.h"
+#include "json_reader.h"
+#include "layout_migrate.h"
+#include "snapshot.h"
+#include "type_pool.h"
+#include "delta.h"
+#include "replicate.h"
+#include "job_system.h"
+#include "entity_kernels.h"
+#include "soa_storage.h"
+#include "simd.h"
+#include "trace.h"
+#include "type_ops.h"
+#include "query.h"
+#include "display_list.h"
+#include "game_types.h"
+
+#ifdef HOT_RELOAD_ENABLED
+#    include "hot_reload.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_MODULE_ID 2
+#define LOOKUP_TYPES    512     // Power of two, fits in L2 with the registry hot array
+#define REGISTER_TYPES  256     // Types registered per registration sample
+#define OBJECT_BATCH    1024    // Objects per pack / gather / write call
+#define MAX_RESULTS     56
+#define MIGRATE_OBJECTS 100000    // Live entities re-laid out per migration sample
+#define DELTA_CHANGED   ( MIGRATE_OBJECTS / 100 )    // Players touched per autosave, 1%
+#define SNAPSHOT_PATH   "reflection_bench.snapshot"    // MIGRATE_OBJECTS players, removed on exit
+#define UPDATE_OBJECTS  ( 1u << 20 )    // Players per game_update-style tick
+
+// ============================================================================
+// Fixture - a mirror of the game's Player plus synthetic lookup types
+// ============================================================================
+
+// Player as a later build might declare it: reordered, id widened, name shrunk
+typedef struct BenchPlayerV2
+{
+    uint32_t  flags;
+    float     speed;
+    Health    health;
+    Transform transform;
+    char      name[ 16 ];
+    int64_t   id;
+
+} BenchPlayerV2;
+
+typedef struct BenchFixture
+{
+    Type*     player_type;
+    FieldPath health_current;
+    FieldPath speed;
+    FieldPath position_x;
+    FieldRef  health_ref;
+    FieldRef  speed_ref;
+    FieldRef  position_x_ref;
+
+    Player   player;
+    Player*  players;    // OBJECT_BATCH objects
+    uint8_t*   packed;
+    float*     gathered;
+    FILE*      file;
+    JsonWriter json;           // Memory output, rewound per sample
+    JsonWriter json_player;    // One player as serialize_to_json writes it, reader input
+
+    Type*          player_v2_type;
+    MigrationPlan* migrate_plan;    // player_type -> player_v2_type
+    BenchPlayerV2* players_v2;      // OBJECT_BATCH objects
+    SoaStorage*    migrate_soa;     // MIGRATE_OBJECTS players, flips layout every migration
+
+    SoaStorage*    delta_soa;         // MIGRATE_OBJECTS players, never migrated
+    ChangeTracker* delta_marked;      // Writes go through change_set
+    ChangeTracker* delta_shadowed;    // Writes go straight in, found by change_scan
+    DeltaBuffer    delta;
+    int            delta_column;      // health.current
+    uint32_t       delta_round;
+
+    ReplicaSchema* replica;
+    Player*        replica_baseline;    // Snapped players, one in 16 since moved
+    Player*        replica_decoded;
+    uint8_t*       replica_packet;
+    uint8_t*       replica_full;        // All players against nothing, decode input
+    uint32_t       replica_full_bits;
+
+    TypePool* pool;
+    Handle    pool_handles[ OBJECT_BATCH ];    // Live players, recycled by spawn / despawn
+
+    Player*   ops_from;       // MIGRATE_OBJECTS each, ops_to differs in DELTA_CHANGED players
+    Player*   ops_to;
+    Player*   ops_out;
+    uint32_t* ops_changed;
+    uint64_t* ops_hashes;
+
+    Query     query;           // "health.current < 20 && speed > 3" over ops_from
+    FieldPath query_fields[ 2 ];
+    uint64_t* query_bitmap;
+
+    DisplayView display;       // Over players, a table of OBJECT_BATCH rows
+    Player*     display_rows;
+    uint32_t    display_round;
+
+    float* update_columns[ 5 ];    // UPDATE_OBJECTS each: current, maximum, regen_rate, speed, position_x
+
+    TypeID   lookup_ids[ LOOKUP_TYPES ];       // Shuffled access order
+    TypeHash lookup_hashes[ LOOKUP_TYPES ];
+    char     lookup_names[ LOOKUP_TYPES ][ 24 ];    // Not the interned pointers
+
+    char     register_names[ REGISTER_TYPES ][ 24 ];
+    Field    register_fields[ 4 ];
+    TypeDesc register_descs[ REGISTER_TYPES ];
+
+    float dt;    // Read through a barrier so loops cannot fold it
+
+} BenchFixture;
+
+static BenchFixture s_fixture;
+static Registry     s_registry_snapshot;
+
+static void
+register_core_types( void )
+{
+    TypeDesc float_type = { .hash = hash_string( "float" ), .name = "float", .size = sizeof( float ) };
+    type_register( &float_type );
+}
+
+// The game module's tables, built from the same lists in game_types.h
+TYPE_TABLE( Vec3, VEC3_FIELDS );
+TYPE_TABLE( Transform, TRANSFORM_FIELDS );
+TYPE_TABLE( Health, HEALTH_FIELDS );
+TYPE_TABLE( Player, PLAYER_FIELDS );
+
+static const FieldQuant k_transform_quants[] = { TRANSFORM_QUANTS };
+static const FieldQuant k_health_quants[]    = { HEALTH_QUANTS };
+
+// In dependency order - nested types are looked up by name as each registers
+static const TypeDesc k_player_types[] = {
+    TYPE_DESC( Vec3, NULL, BENCH_MODULE_ID, 1 ),
+    TYPE_DESC( Transform, k_transform_quants, BENCH_MODULE_ID, 1 ),
+    TYPE_DESC( Health, k_health_quants, BENCH_MODULE_ID, 1 ),
+    TYPE_DESC( Player, NULL, BENCH_MODULE_ID, 2 ),
+};
+
+// Player last, so its TypeID is the one returned
+static Type*
+register_player_types( void )
+{
+    TypeID id = 0;
+    for ( size_t i = 0; i < sizeof( k_player_types ) / sizeof( k_player_types[ 0 ] ); i++ )
+        id = type_register( &k_player_types[ i ] );
+    return type_get( id );
+}
+
+static Type*
+register_player_v2_type( const Type* player_type )
+{
+    const Field* transform = type_field( player_type, PLAYER_TRANSFORM );
+    const Field* health    = type_field( player_type, PLAYER_HEALTH );
+    Field        fields[]  = {
+        { "flags", offsetof( BenchPlayerV2, flags ), sizeof( uint32_t ), 0, FIELD_KIND_FLAG( FIELD_KIND_UINT32 ) },
+        { "speed", offsetof( BenchPlayerV2, speed ), sizeof( float ), 0, FIELD_EDITABLE },
+        { "health", offsetof( BenchPlayerV2, health ), sizeof( Health ), health->type_id, 0 },
+        { "transform", offsetof( BenchPlayerV2, transform ), sizeof( Transform ), transform->type_id, 0 },
+        { "name", offsetof( BenchPlayerV2, name ), 16, 0, FIELD_KIND_FLAG( FIELD_KIND_BYTES ) },
+        { "id", offsetof( BenchPlayerV2, id ), sizeof( int64_t ), 0, FIELD_KIND_FLAG( FIELD_KIND_INT32 ) },
+    };
+    TypeDesc desc = {
+        .hash        = hash_string( "BenchPlayerV2" ),
+        .name        = "BenchPlayerV2",
+        .size        = sizeof( BenchPlayerV2 ),
+        .alignment   = _Alignof( BenchPlayerV2 ),
+        .fields      = fields,
+        .field_count = 6,
+        .module_id   = BENCH_MODULE_ID,
+        .version     = 2,
+    };
+    return type_get( type_register( &desc ) );
+}
+
+static void
+fixture_init( BenchFixture* fx )
+{
+    register_core_types();
+    fx->player_type = register_player_types();
+    field_path_resolve( fx->player_type, "health.current", &fx->health_current );
+    field_path_resolve( fx->player_type, "speed", &fx->speed );
+    field_path_resolve( fx->player_type, "transform.position.x", &fx->position_x );
+    fx->health_ref     = ( FieldRef )FIELD_REF( "Player", "health.current" );
+    fx->speed_ref      = ( FieldRef )FIELD_REF( "Player", "speed" );
+    fx->position_x_ref = ( FieldRef )FIELD_REF( "Player", "transform.position.x" );
+    fx->dt             = 0.016f;
+
+    fx->player = ( Player ){ .id = 1, .name = "Hero", .transform = { .scale = 1.0f }, .health = { 100, 100, 1 },
+                             .speed = 5.0f };
+    fx->players  = (Player*)calloc( OBJECT_BATCH, sizeof( Player ) );
+    fx->packed   = (uint8_t*)malloc( (size_t)OBJECT_BATCH * sizeof( Player ) );
+    fx->gathered = (float*)malloc( OBJECT_BATCH * sizeof( float ) );
+    fx->file     = tmpfile();
+    json_writer_init( &fx->json, NULL, JSON_COMPACT );
+    for ( uint32_t i = 0; i < OBJECT_BATCH; i++ )
+    {
+        fx->players[ i ]    = fx->player;
+        fx->players[ i ].id = i;
+    }
+    json_writer_init( &fx->json_player, NULL, JSON_TYPE_NAMES );
+    json_write_object( &fx->json_player, fx->player_type, &fx->player );
+
+    fx->player_v2_type = register_player_v2_type( fx->player_type );
+    fx->migrate_plan   = migration_compile( fx->player_type, fx->player_v2_type );
+    fx->players_v2     = (BenchPlayerV2*)calloc( OBJECT_BATCH, sizeof( BenchPlayerV2 ) );
+    fx->migrate_soa    = soa_create( fx->player_type, MIGRATE_OBJECTS );
+    for ( uint32_t i = 0; i < MIGRATE_OBJECTS; i++ ) soa_push( fx->migrate_soa, &fx->players[ i % OBJECT_BATCH ] );
+
+    fx->delta_soa = soa_create( fx->player_type, MIGRATE_OBJECTS );
+    for ( uint32_t i = 0; i < MIGRATE_OBJECTS; i++ ) soa_push( fx->delta_soa, &fx->players[ i % OBJECT_BATCH ] );
+    fx->delta_marked   = change_tracker_create( fx->delta_soa, 0 );
+    fx->delta_shadowed = change_tracker_create( fx->delta_soa, CHANGE_SHADOW );
+    fx->delta_column   = soa_column_index( fx->delta_soa, fx->player_type, "health.current" );
+
+    fx->replica          = replica_schema_compile( fx->player_type );
+    fx->replica_baseline = (Player*)malloc( OBJECT_BATCH * sizeof( Player ) );
+    fx->replica_decoded  = (Player*)malloc( OBJECT_BATCH * sizeof( Player ) );
+    fx->replica_packet   = (uint8_t*)malloc( (size_t)OBJECT_BATCH * sizeof( Player ) * 2 );
+    for ( uint32_t i = 0; i < OBJECT_BATCH; i++ )
+    {
+        fx->players[ i ].transform.position = ( Vec3 ){ (float)i * 1.5f, 0.0f, -(float)i };
+        fx->players[ i ].transform.rotation = ( Vec3 ){ 0.0f, (float)( i % 628 ) * 0.01f - 3.14f, 0.0f };
+    }
+    replica_snap( fx->replica, fx->players, fx->replica_baseline, OBJECT_BATCH );
+    for ( uint32_t i = 0; i < OBJECT_BATCH; i += 16 ) fx->replica_baseline[ i ].transform.position.x -= 1.0f;
+    fx->replica_full      = (uint8_t*)malloc( (size_t)OBJECT_BATCH * sizeof( Player ) * 2 );
+    fx->replica_full_bits = replica_encode( fx->replica, fx->players, OBJECT_BATCH, NULL, 0, fx->replica_full,
+                                            (size_t)OBJECT_BATCH * sizeof( Player ) * 2 );
+
+    fx->ops_from    = (Player*)malloc( MIGRATE_OBJECTS * sizeof( Player ) );
+    fx->ops_to      = (Player*)malloc( MIGRATE_OBJECTS * sizeof( Player ) );
+    fx->ops_out     = (Player*)malloc( MIGRATE_OBJECTS * sizeof( Player ) );
+    fx->ops_changed = (uint32_t*)malloc( MIGRATE_OBJECTS * sizeof( uint32_t ) );
+    fx->ops_hashes  = (uint64_t*)malloc( MIGRATE_OBJECTS * sizeof( uint64_t ) );
+    for ( uint32_t i = 0; i < MIGRATE_OBJECTS; i++ )
+    {
+        fx->ops_from[ i ]    = fx->players[ i % OBJECT_BATCH ];
+        fx->ops_from[ i ].id = i;
+        fx->ops_from[ i ].health.current = (float)( i % 100 );
+        fx->ops_to[ i ]      = fx->ops_from[ i ];
+    }
+    for ( uint32_t k = 0; k < DELTA_CHANGED; k++ ) fx->ops_to[ k * 97 % MIGRATE_OBJECTS ].transform.position.y += 1.0f;
+
+    query_compile( &fx->query, fx->player_type, "health.current < 20 && speed > 3" );
+    field_path_resolve( fx->player_type, "health.current", &fx->query_fields[ 0 ] );
+    field_path_resolve( fx->player_type, "speed", &fx->query_fields[ 1 ] );
+    fx->query_bitmap = (uint64_t*)malloc( QUERY_WORDS( MIGRATE_OBJECTS ) * sizeof( uint64_t ) );
+
+    fx->display_rows = (Player*)malloc( OBJECT_BATCH * sizeof( Player ) );
+    memcpy( fx->display_rows, fx->players, OBJECT_BATCH * sizeof( Player ) );
+    display_view_init( &fx->display, fx->player_type, fx->display_rows, OBJECT_BATCH );
+
+    for ( int c = 0; c < 5; c++ )
+    {
+        fx->update_columns[ c ] = (float*)malloc( UPDATE_OBJECTS * sizeof( float ) );
+        for ( uint32_t i = 0; i < UPDATE_OBJECTS; i++ ) fx->update_columns[ c ][ i ] = (float)( i % 100 + c );
+    }
+
+    fx->pool = pool_create( fx->player_type, 2 * OBJECT_BATCH );
+    for ( uint32_t i = 0; i < OBJECT_BATCH; i++ ) fx->pool_handles[ i ] = pool_alloc( fx->pool );
+
+    SnapshotWriter* writer = snapshot_writer_create();
+    snapshot_add_soa( writer, "players", fx->player_type, fx->migrate_soa );
+    snapshot_write( writer, SNAPSHOT_PATH );
+    snapshot_writer_free( writer );
+
+    // Lookup targets, visited in a fixed pseudo-random order
+    for ( uint32_t i = 0; i < LOOKUP_TYPES; i++ )
+    {
+        char name[ 24 ];
+        snprintf( name, sizeof( name ), "bench_lookup_%03u", i );
+        TypeDesc desc = { .hash = hash_string( name ), .name = name, .size = 4, .module_id = BENCH_MODULE_ID };
+        fx->lookup_ids[ i ] = type_register( &desc );
+    }
+    uint32_t seed = 12345;
+    for ( uint32_t i = LOOKUP_TYPES - 1; i > 0; i-- )
+    {
+        seed       = seed * 1664525u + 1013904223u;
+        uint32_t j = ( seed >> 8 ) % ( i + 1 );
+        TypeID   t = fx->lookup_ids[ i ];
+
+        fx->lookup_ids[ i ] = fx->lookup_ids[ j ];
+        fx->lookup_ids[ j ] = t;
+    }
+    for ( uint32_t i = 0; i < LOOKUP_TYPES; i++ )
+    {
+        Type* type = type_get( fx->lookup_ids[ i ] );
+        fx->lookup_hashes[ i ] = type->hash;
+        strcpy( fx->lookup_names[ i ], type_name( type ) );
+    }
+
+    // Registration batch - four primitive fields each
+    for ( int i = 0; i < 4; i++ )
+    {
+        static const char* const names[] = { "a", "b", "c", "d" };
+        fx->register_fields[ i ] = ( Field ){ names[ i ], (uint16_t)( i * 4 ), 4, 0, 0 };
+    }
+    for ( uint32_t i = 0; i < REGISTER_TYPES; i++ )
+    {
+        snprintf( fx->register_names[ i ], sizeof( fx->register_names[ i ] ), "bench_register_%03u", i );
+        fx->register_descs[ i ] = ( TypeDesc ){
+            .hash        = hash_string( fx->register_names[ i ] ),
+            .name        = fx->register_names[ i ],
+            .size        = 16,
+            .alignment   = 4,
+            .fields      = fx->register_fields,
+            .field_count = 4,
+            .module_id   = BENCH_MODULE_ID + 1,
+        };
+    }
+}
+
+// Cases that register types roll the registry back before every sample
+static void
+registry_snapshot( void )
+{
+    memcpy( &s_registry_snapshot, &g_registry, sizeof( Registry ) );
+}
+
+static void
+registry_restore( void* ctx )
+{
+    memcpy( &g_registry, &s_registry_snapshot, sizeof( Registry ) );
+}
+
+// ============================================================================
+// Field access - the old main.c loop, every variant doing the same two stores
+// ============================================================================
+
+static void
+bench_update_direct( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    Player*       p  = &fx->player;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        p->health.current = 100.0f;
+        p->transform.position.x += p->speed * fx->dt;
+        bench_escape( p );
+    }
+}
+
+static void
+bench_update_field_index( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        Health*    health    = (Health*)field_get_ptr( &fx->player, fx->player_type, PLAYER_HEALTH );
+        Transform* transform = (Transform*)field_get_ptr( &fx->player, fx->player_type, PLAYER_TRANSFORM );
+        float*     speed     = (float*)field_get_ptr( &fx->player, fx->player_type, PLAYER_SPEED );
+        health->current      = 100.0f;
+        transform->position.x += *speed * fx->dt;
+        bench_escape( &fx->player );
+    }
+}
+
+static void
+bench_update_field_path( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        *(float*)field_path_ptr( &fx->player, &fx->health_current ) = 100.0f;
+        *(float*)field_path_ptr( &fx->player, &fx->position_x ) +=
+            *(float*)field_path_ptr( &fx->player, &fx->speed ) * fx->dt;
+        bench_escape( &fx->player );
+    }
+}
+
+static void
+bench_update_field_ref( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        *(float*)field_ref_ptr( &fx->player, &fx->health_ref ) = 100.0f;
+        *(float*)field_ref_ptr( &fx->player, &fx->position_x_ref ) +=
+            *(float*)field_ref_ptr( &fx->player, &fx->speed_ref ) * fx->dt;
+        bench_escape( &fx->player );
+    }
+}
+
+static void
+bench_field_path_resolve( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    FieldPath     path;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        field_path_resolve( fx->player_type, "transform.position.x", &path );
+        BENCH_KEEP( path );
+    }
+}
+
+static void
+bench_field_gather( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t done = 0; done < iterations; done += OBJECT_BATCH )
+    {
+        size_t count = iterations - done < OBJECT_BATCH ? (size_t)( iterations - done ) : OBJECT_BATCH;
+        field_gather( fx->players, sizeof( Player ), count, &fx->health_current, fx->gathered );
+        bench_escape( fx->gathered );
+    }
+}
+
+// ============================================================================
+// Registry lookups
+// ============================================================================
+
+static void
+bench_lookup_id( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        Type* type = type_get( fx->lookup_ids[ i & ( LOOKUP_TYPES - 1 ) ] );
+        BENCH_KEEP( type );
+    }
+}
+
+static void
+bench_lookup_hash( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        Type* type = type_find_by_hash( fx->lookup_hashes[ i & ( LOOKUP_TYPES - 1 ) ] );
+        BENCH_KEEP( type );
+    }
+}
+
+static void
+bench_lookup_hash_miss( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        Type* type = type_find_by_hash( fx->lookup_hashes[ i & ( LOOKUP_TYPES - 1 ) ] ^ 0x9E3779B9u );
+        BENCH_KEEP( type );
+    }
+}
+
+static void
+bench_lookup_name( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        Type* type = type_find_by_name( fx->lookup_names[ i & ( LOOKUP_TYPES - 1 ) ] );
+        BENCH_KEEP( type );
+    }
+}
+
+// The per-frame pattern type handles replace: hash a literal, probe
+static void
+bench_lookup_literal( void* ctx, uint64_t iterations )
+{
+    (void)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        Type* type = type_find_by_hash( hash_string( "Player" ) );
+        BENCH_KEEP( type );
+    }
+}
+
+static void
+bench_lookup_handle( void* ctx, uint64_t iterations )
+{
+    (void)ctx;
+    static TypeHandle handle = TYPE_HANDLE( "Player" );
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        Type* type = type_handle_get( &handle );
+        BENCH_KEEP( type );
+    }
+}
+
+static void
+bench_lookup_field_name( void* ctx, uint64_t iterations )
+{
+    static const char* const names[]   = { "id", "name", "transform", "health", "speed", "flags", "missing", "x" };
+    static const size_t      lengths[] = { 2, 4, 9, 6, 5, 5, 7, 1 };
+
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        int index = type_field_index( fx->player_type, names[ i & 7 ], lengths[ i & 7 ] );
+        BENCH_KEEP( index );
+    }
+}
+
+// ============================================================================
+// Serialization - per object
+// ============================================================================
+
+static void
+bench_pack( void* ctx, uint64_t iterations )
+{
+    BenchFixture*   fx   = (BenchFixture*)ctx;
+    const CopyPlan* plan = copy_plan_get( fx->player_type );
+    for ( uint64_t done = 0; done < iterations; done += OBJECT_BATCH )
+    {
+        size_t count = iterations - done < OBJECT_BATCH ? (size_t)( iterations - done ) : OBJECT_BATCH;
+        copy_plan_pack( plan, fx->players, count, fx->packed );
+        bench_escape( fx->packed );
+    }
+}
+
+static void
+bench_unpack( void* ctx, uint64_t iterations )
+{
+    BenchFixture*   fx   = (BenchFixture*)ctx;
+    const CopyPlan* plan = copy_plan_get( fx->player_type );
+    for ( uint64_t done = 0; done < iterations; done += OBJECT_BATCH )
+    {
+        size_t count = iterations - done < OBJECT_BATCH ? (size_t)( iterations - done ) : OBJECT_BATCH;
+        copy_plan_unpack( plan, fx->players, count, fx->packed );
+        bench_escape( fx->players );
+    }
+}
+
+static void
+bench_write_setup( void* ctx )
+{
+    rewind( ( (BenchFixture*)ctx )->file );
+}
+
+static void
+bench_write( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t done = 0; done < iterations; done += OBJECT_BATCH )
+    {
+        size_t count = iterations - done < OBJECT_BATCH ? (size_t)( iterations - done ) : OBJECT_BATCH;
+        serialize_binary_write( fx->file, fx->player_type, fx->players, count );
+    }
+    fflush( fx->file );
+}
+
+static void
+bench_json_setup( void* ctx )
+{
+    ( (BenchFixture*)ctx )->json.length = 0;
+}
+
+static void
+bench_json( BenchFixture* fx, uint64_t iterations, uint32_t flags, int threads )
+{
+    fx->json.flags = flags;
+    for ( uint64_t done = 0; done < iterations; done += OBJECT_BATCH )
+    {
+        size_t count = iterations - done < OBJECT_BATCH ? (size_t)( iterations - done ) : OBJECT_BATCH;
+        json_write_array_parallel( &fx->json, fx->player_type, fx->players, count, threads );
+    }
+    bench_escape( fx->json.buffer );
+}
+
+static void
+bench_json_compact( void* ctx, uint64_t iterations )
+{
+    bench_json( (BenchFixture*)ctx, iterations, JSON_COMPACT, 1 );
+}
+
+static void
+bench_json_pretty( void* ctx, uint64_t iterations )
+{
+    bench_json( (BenchFixture*)ctx, iterations, 0, 1 );
+}
+
+static void
+bench_json_parallel( void* ctx, uint64_t iterations )
+{
+    bench_json( (BenchFixture*)ctx, iterations, JSON_COMPACT, 4 );
+}
+
+static void
+bench_json_read( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        JsonReader reader;
+        json_reader_init( &reader, fx->json_player.buffer, fx->json_player.length );
+        json_read_object( &reader, fx->player_type, &fx->players[ i & ( OBJECT_BATCH - 1 ) ] );
+    }
+    bench_escape( fx->players );
+}
+
+// ============================================================================
+// Registration and reload - fixed batches, registry rolled back per sample
+// ============================================================================
+
+static void
+bench_register( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        TypeID id = type_register( &fx->register_descs[ i % REGISTER_TYPES ] );
+        BENCH_KEEP( id );
+    }
+}
+
+// Per object, array of structs through the compiled plan
+static void
+bench_migrate_aos( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t done = 0; done < iterations; done += OBJECT_BATCH )
+    {
+        size_t count = iterations - done < OBJECT_BATCH ? (size_t)( iterations - done ) : OBJECT_BATCH;
+        migration_run( fx->migrate_plan, fx->players, fx->players_v2, count );
+        bench_escape( fx->players_v2 );
+    }
+}
+
+// Per reload, MIGRATE_OBJECTS entities in columns, alternating between the two layouts
+static void
+bench_migrate_soa( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        int   is_v1 = fx->migrate_soa->type_hash == fx->player_type->hash;
+        Type* next  = is_v1 ? fx->player_v2_type : fx->player_type;
+        soa_migrate( fx->migrate_soa, next );
+    }
+    bench_escape( fx->migrate_soa );
+}
+
+// Per autosave of MIGRATE_OBJECTS players: everything, then only the 1% that changed
+static void
+bench_delta_full( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        fx->delta.length = 0;
+        change_tracker_reset( fx->delta_marked, fx->delta_soa );
+        delta_encode( fx->delta_marked, fx->delta_soa, &fx->delta );
+        change_tracker_clear( fx->delta_marked, fx->delta_soa );
+    }
+    bench_escape( fx->delta.data );
+}
+
+static void
+delta_touch( BenchFixture* fx, ChangeTracker* tracker )
+{
+    float* current = (float*)soa_column_data( fx->delta_soa, fx->delta_column );
+    for ( uint32_t k = 0; k < DELTA_CHANGED; k++ )
+    {
+        uint32_t index = ( k * 97 + fx->delta_round ) % MIGRATE_OBJECTS;
+        float    value = current[ index ] - 1.0f;
+        if ( tracker )
+            change_set( tracker, fx->delta_soa, index, fx->delta_column, &value );
+        else
+            current[ index ] = value;
+    }
+    fx->delta_round++;
+}
+
+static void
+bench_delta_marked( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        delta_touch( fx, fx->delta_marked );
+        fx->delta.length = 0;
+        delta_encode( fx->delta_marked, fx->delta_soa, &fx->delta );
+        change_tracker_clear( fx->delta_marked, fx->delta_soa );
+    }
+    bench_escape( fx->delta.data );
+}
+
+static void
+bench_delta_scanned( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        delta_touch( fx, NULL );
+        change_scan( fx->delta_shadowed, fx->delta_soa );
+        fx->delta.length = 0;
+        delta_encode( fx->delta_shadowed, fx->delta_soa, &fx->delta );
+        change_tracker_clear( fx->delta_shadowed, fx->delta_soa );
+    }
+    bench_escape( fx->delta.data );
+}
+
+// Per object, OBJECT_BATCH players to a bit stream against nothing, then against a baseline
+static void
+bench_replicate( BenchFixture* fx, uint64_t iterations, const void* baseline )
+{
+    for ( uint64_t done = 0; done < iterations; done += OBJECT_BATCH )
+    {
+        uint32_t count = iterations - done < OBJECT_BATCH ? (uint32_t)( iterations - done ) : OBJECT_BATCH;
+        uint32_t bits  = replica_encode( fx->replica, fx->players, count, baseline, OBJECT_BATCH, fx->replica_packet,
+                                         (size_t)OBJECT_BATCH * sizeof( Player ) * 2 );
+        BENCH_KEEP( bits );
+    }
+}
+
+static void
+bench_replicate_full( void* ctx, uint64_t iterations )
+{
+    bench_replicate( (BenchFixture*)ctx, iterations, NULL );
+}
+
+static void
+bench_replicate_delta( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    bench_replicate( fx, iterations, fx->replica_baseline );
+}
+
+static void
+bench_replicate_decode( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t done = 0; done < iterations; done += OBJECT_BATCH )
+    {
+        uint32_t count = iterations - done < OBJECT_BATCH ? (uint32_t)( iterations - done ) : OBJECT_BATCH;
+        replica_decode( fx->replica, fx->replica_full, fx->replica_full_bits, NULL, 0, fx->replica_decoded, count );
+        bench_escape( fx->replica_decoded );
+    }
+}
+
+// Per entity, despawn one player and spawn its replacement - free list only, no malloc
+static void
+bench_pool_respawn( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        Handle* handle = &fx->pool_handles[ ( i * 7 ) & ( OBJECT_BATCH - 1 ) ];
+        pool_free( fx->pool, *handle );
+        *handle = pool_alloc( fx->pool );
+    }
+    bench_escape( fx->pool_handles );
+}
+
+// Per lookup, handle to object with the generation check
+static void
+bench_pool_get( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        Player* player = (Player*)pool_get( fx->pool, fx->pool_handles[ ( i * 7 ) & ( OBJECT_BATCH - 1 ) ] );
+        BENCH_KEEP( player );
+    }
+}
+
+// Per restore, open the MIGRATE_OBJECTS player snapshot and rebuild its columns
+static void
+bench_snapshot_load( BenchFixture* fx, uint64_t iterations, const Type* type )
+{
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        Snapshot*   snap    = snapshot_open( SNAPSHOT_PATH );
+        SoaStorage* players = snap ? snapshot_load_soa( snap, "players", type ) : NULL;
+        bench_escape( players );
+        soa_destroy( players );
+        snapshot_close( snap );
+    }
+}
+
+static void
+bench_snapshot_load_same( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    bench_snapshot_load( fx, iterations, fx->player_type );
+}
+
+static void
+bench_snapshot_load_migrate( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    bench_snapshot_load( fx, iterations, fx->player_v2_type );
+}
+
+// ============================================================================
+// Type ops - MIGRATE_OBJECTS players per iteration
+// ============================================================================
+
+static void
+bench_ops_diff( void* ctx, uint64_t iterations )
+{
+    BenchFixture*  fx  = (BenchFixture*)ctx;
+    const TypeOps* ops = type_ops_get( fx->player_type );
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        size_t changed = type_ops_diff( ops, fx->ops_from, fx->ops_to, MIGRATE_OBJECTS, fx->ops_changed );
+        bench_escape( &changed );
+    }
+}
+
+static void
+bench_ops_hash( void* ctx, uint64_t iterations )
+{
+    BenchFixture*  fx  = (BenchFixture*)ctx;
+    const TypeOps* ops = type_ops_get( fx->player_type );
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        type_ops_hash_array( ops, fx->ops_from, MIGRATE_OBJECTS, fx->ops_hashes );
+        bench_escape( fx->ops_hashes );
+    }
+}
+
+static void
+bench_ops_lerp( void* ctx, uint64_t iterations )
+{
+    BenchFixture*  fx  = (BenchFixture*)ctx;
+    const TypeOps* ops = type_ops_get( fx->player_type );
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        type_ops_lerp_array( ops, fx->ops_out, fx->ops_from, fx->ops_to, MIGRATE_OBJECTS, 0.25f );
+        bench_escape( fx->ops_out );
+    }
+}
+
+// Baseline: the recursive walk over Type::fields every generic pass used to need
+static void
+lerp_fields( const Type* type, char* out, const char* a, const char* b, float t )
+{
+    for ( uint16_t f = 0; f < type->field_count; f++ )
+    {
+        const Field* field  = type_field( type, f );
+        Type*        nested = field_nested_type( field );
+        if ( nested )
+        {
+            lerp_fields( nested, out + field->offset, a + field->offset, b + field->offset, t );
+        }
+        else if ( field_kind( field ) == FIELD_KIND_FLOAT )
+        {
+            float from, to;
+            memcpy( &from, a + field->offset, sizeof( float ) );
+            memcpy( &to, b + field->offset, sizeof( float ) );
+            float value = from + ( to - from ) * t;
+            memcpy( out + field->offset, &value, sizeof( float ) );
+        }
+        else
+        {
+            memcpy( out + field->offset, ( t < 0.5f ? a : b ) + field->offset, field->size );
+        }
+    }
+}
+
+static void
+bench_ops_lerp_fields( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        for ( uint32_t k = 0; k < MIGRATE_OBJECTS; k++ )
+        {
+            lerp_fields( fx->player_type, (char*)&fx->ops_out[ k ], (const char*)&fx->ops_from[ k ],
+                         (const char*)&fx->ops_to[ k ], 0.25f );
+        }
+        bench_escape( fx->ops_out );
+    }
+}
+
+// ============================================================================
+// Queries - "health.current < 20 && speed > 3" over MIGRATE_OBJECTS players
+// ============================================================================
+
+static void
+bench_query_scan( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        size_t matches = query_select( &fx->query, fx->ops_from, sizeof( Player ), MIGRATE_OBJECTS, fx->query_bitmap );
+        bench_escape( &matches );
+    }
+}
+
+static void
+bench_query_scan_parallel( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        size_t matches =
+            query_select_parallel( &fx->query, fx->ops_from, sizeof( Player ), MIGRATE_OBJECTS, fx->query_bitmap );
+        bench_escape( &matches );
+    }
+}
+
+// Baseline: the hand-written loop, one resolved path read per field per object
+static void
+bench_query_scan_fields( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        memset( fx->query_bitmap, 0, QUERY_WORDS( MIGRATE_OBJECTS ) * sizeof( uint64_t ) );
+        for ( uint32_t k = 0; k < MIGRATE_OBJECTS; k++ )
+        {
+            void* player = &fx->ops_from[ k ];
+            if ( *(float*)field_path_ptr( player, &fx->query_fields[ 0 ] ) < 20.0f &&
+                 *(float*)field_path_ptr( player, &fx->query_fields[ 1 ] ) > 3.0f )
+            {
+                fx->query_bitmap[ k / QUERY_BLOCK ] |= (uint64_t)1 << ( k % QUERY_BLOCK );
+            }
+        }
+        bench_escape( fx->query_bitmap );
+    }
+}
+
+// ============================================================================
+// Property display - a table of OBJECT_BATCH players redrawn every frame
+// ============================================================================
+
+static void
+bench_display_item( void* ctx, size_t object, const DisplayItem* item, const void* base )
+{
+    bench_escape( (const char*)base + item->offset );
+}
+
+static void
+bench_display_full( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        fx->display.drawn = 0;
+        size_t drawn      = display_view_refresh( &fx->display, bench_display_item, NULL );
+        BENCH_KEEP( drawn );
+    }
+}
+
+static void
+bench_display_idle( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        size_t drawn = display_view_refresh( &fx->display, bench_display_item, NULL );
+        BENCH_KEEP( drawn );
+    }
+}
+
+// One row in 16 moves per frame
+static void
+bench_display_changed( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        uint32_t round = fx->display_round++;
+        for ( uint32_t k = round % 16; k < OBJECT_BATCH; k += 16 ) fx->display_rows[ k ].speed += 1.0f;
+        size_t drawn = display_view_refresh( &fx->display, bench_display_item, NULL );
+        BENCH_KEEP( drawn );
+    }
+}
+
+// Baseline: the recursion draw_property_editor used to repeat for every object, every frame
+static size_t
+display_walk( void* obj, Type* type )
+{
+    size_t drawn = 1;
+    for ( uint16_t i = 0; i < type->field_count; i++, drawn++ )
+    {
+        Field* field = type_field( type, i );
+        void*  ptr   = field_get_ptr( obj, type, i );
+        if ( !( field->flags & FIELD_EDITABLE ) )
+            continue;
+        if ( field_kind( field ) == FIELD_KIND_FLOAT )
+            bench_escape( ptr );
+        else if ( field->type_id != 0 && type_get( field->type_id ) )
+            drawn += display_walk( ptr, type_get( field->type_id ) );
+    }
+    return drawn;
+}
+
+static void
+bench_display_walk( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        size_t drawn = 0;
+        for ( uint32_t k = 0; k < OBJECT_BATCH; k++ )
+        {
+            drawn += display_walk( &fx->display_rows[ k ], fx->player_type );
+        }
+        BENCH_KEEP( drawn );
+    }
+}
+
+// ============================================================================
+// Jobs - one game_update tick over UPDATE_OBJECTS players
+// ============================================================================
+
+static void
+bench_update_range( void* ctx, uint32_t begin, uint32_t end )
+{
+    BenchFixture*        fx      = (BenchFixture*)ctx;
+    const EntityKernels* kernels = entity_kernels();
+    float**              c       = fx->update_columns;
+    kernels->regen_clamp( c[ 0 ] + begin, c[ 2 ] + begin, c[ 1 ] + begin, fx->dt, end - begin );
+    kernels->integrate( c[ 4 ] + begin, c[ 3 ] + begin, fx->dt, end - begin );
+}
+
+static void
+bench_jobs_serial( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        bench_update_range( fx, 0, UPDATE_OBJECTS );
+        bench_escape( fx->update_columns[ 0 ] );
+    }
+}
+
+static void
+bench_jobs_parallel( void* ctx, uint64_t iterations )
+{
+    BenchFixture* fx = (BenchFixture*)ctx;
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        job_parallel_for( UPDATE_OBJECTS, 4096, bench_update_range, fx );
+        bench_escape( fx->update_columns[ 0 ] );
+    }
+}
+
+// One empty zone per iteration: what instrumenting a call site costs
+static void
+bench_trace_zones( uint64_t iterations )
+{
+    for ( uint64_t i = 0; i < iterations; i++ )
+    {
+        TRACE_BEGIN( zone, "bench_zone" );
+        bench_clobber();
+        TRACE_END( zone );
+    }
+}
+
+static void
+bench_trace_off( void* ctx, uint64_t iterations )
+{
+    bench_trace_zones( iterations );
+}
+
+static void
+bench_trace_on( void* ctx, uint64_t iterations )
+{
+    trace_enable( 1 );
+    bench_trace_zones( iterations );
+    trace_enable( 0 );    // Keep the other cases untraced
+}
+
+#ifdef HOT_RELOAD_ENABLED
+static void
+bench_reload( void* ctx, uint64_t iterations )
+{
+    for ( uint64_t i = 0; i < iterations; i++ ) reload_module( (Module*)ctx );
+}
+#endif
+
+// ============================================================================
+// Main
+// ============================================================================
+
+static FILE*
+open_output( const char* path )
+{
+    if ( strcmp( path, "-" ) == 0 )
+        return stdout;
+    FILE* file = fopen( path, "w" );
+    if ( !file )
+        printf( "ERROR: cannot write %s\n", path );
+    return file;
+}
+
+int
+main( int argc, char** argv )
+{
+    BenchOptions options   = BENCH_OPTIONS_DEFAULT;
+    const char*  csv_path  = NULL;
+    const char*  json_path = NULL;
+    for ( int i = 1; i < argc; i++ )
+    {
+        if ( strcmp( argv[ i ], "--filter" ) == 0 && i + 1 < argc )
+            options.filter = argv[ ++i ];
+        else if ( strcmp( argv[ i ], "--samples" ) == 0 && i + 1 < argc )
+            options.samples = (uint32_t)atoi( argv[ ++i ] );
+        else if ( strcmp( argv[ i ], "--csv" ) == 0 && i + 1 < argc )
+            csv_path = argv[ ++i ];
+        else if ( strcmp( argv[ i ], "--json" ) == 0 && i + 1 < argc )
+            json_path = argv[ ++i ];
+        else if ( strcmp( argv[ i ], "--quick" ) == 0 )
+        {
+            options.samples   = 11;
+            options.warmup_ms = 5;
+            options.sample_ns = 20000;
+        }
+        else
+        {
+            printf( "usage: %s [--filter text] [--samples n] [--quick] [--csv path] [--json path]\n", argv[ 0 ] );
+            return 1;
+        }
+    }
+    if ( options.samples == 0 )
+        options.samples = 1;
+
+    BenchFixture* fx = &s_fixture;
+    fixture_init( fx );
+    int job_threads = job_system_init( 0 );
+
+    BenchCase cases[] = {
+        { "update/direct", bench_update_direct, NULL, fx, 0, 0 },
+        { "update/field_index", bench_update_field_index, NULL, fx, 0, 0 },
+        { "update/field_path", bench_update_field_path, NULL, fx, 0, 0 },
+        { "update/field_ref", bench_update_field_ref, NULL, fx, 0, 0 },
+        { "field/path_resolve", bench_field_path_resolve, NULL, fx, 0, 0 },
+        { "field/gather", bench_field_gather, NULL, fx, 0, 0 },
+        { "lookup/id", bench_lookup_id, NULL, fx, 0, 0 },
+        { "lookup/hash", bench_lookup_hash, NULL, fx, 0, 0 },
+        { "lookup/hash_miss", bench_lookup_hash_miss, NULL, fx, 0, 0 },
+        { "lookup/name", bench_lookup_name, NULL, fx, 0, 0 },
+        { "lookup/literal", bench_lookup_literal, NULL, fx, 0, 0 },
+        { "lookup/handle", bench_lookup_handle, NULL, fx, 0, 0 },
+        { "lookup/field_name", bench_lookup_field_name, NULL, fx, 0, 0 },
+        { "serialize/pack", bench_pack, NULL, fx, 0, 0 },
+        { "serialize/unpack", bench_unpack, NULL, fx, 0, 0 },
+        { "serialize/write", bench_write, bench_write_setup, fx, 0, 0 },
+        { "serialize/json_compact", bench_json_compact, bench_json_setup, fx, 0, 0 },
+        { "serialize/json_pretty", bench_json_pretty, bench_json_setup, fx, 0, 0 },
+        { "serialize/json_parallel4", bench_json_parallel, bench_json_setup, fx, 0, 0 },
+        { "serialize/json_read", bench_json_read, NULL, fx, 0, 0 },
+        { "registry/register", bench_register, registry_restore, fx, REGISTER_TYPES, 0 },
+        { "migrate/aos", bench_migrate_aos, NULL, fx, 0, 0 },
+        { "migrate/soa_100k", bench_migrate_soa, NULL, fx, 1, 21 },
+        { "delta/autosave_100k_full", bench_delta_full, NULL, fx, 1, 21 },
+        { "delta/autosave_100k_1pct", bench_delta_marked, NULL, fx, 1, 21 },
+        { "delta/autosave_100k_1pct_scan", bench_delta_scanned, NULL, fx, 1, 21 },
+        { "replicate/encode_full", bench_replicate_full, NULL, fx, 0, 0 },
+        { "replicate/encode_delta", bench_replicate_delta, NULL, fx, 0, 0 },
+        { "replicate/decode_full", bench_replicate_decode, NULL, fx, 0, 0 },
+        { "pool/respawn", bench_pool_respawn, NULL, fx, 0, 0 },
+        { "pool/get", bench_pool_get, NULL, fx, 0, 0 },
+        { "snapshot/load_100k", bench_snapshot_load_same, NULL, fx, 1, 21 },
+        { "snapshot/load_100k_migrate", bench_snapshot_load_migrate, NULL, fx, 1, 21 },
+        { "ops/diff_100k", bench_ops_diff, NULL, fx, 1, 21 },
+        { "ops/hash_100k", bench_ops_hash, NULL, fx, 1, 21 },
+        { "ops/lerp_100k", bench_ops_lerp, NULL, fx, 1, 21 },
+        { "ops/lerp_100k_fields", bench_ops_lerp_fields, NULL, fx, 1, 21 },
+        { "query/scan_100k", bench_query_scan, NULL, fx, 1, 21 },
+        { "query/scan_100k_parallel", bench_query_scan_parallel, NULL, fx, 1, 21 },
+        { "query/scan_100k_fields", bench_query_scan_fields, NULL, fx, 1, 21 },
+        { "display/table_1k_full", bench_display_full, NULL, fx, 0, 0 },
+        { "display/table_1k_idle", bench_display_idle, NULL, fx, 0, 0 },
+        { "display/table_1k_changed", bench_display_changed, NULL, fx, 0, 0 },
+        { "display/table_1k_walk", bench_display_walk, NULL, fx, 0, 0 },
+        { "jobs/update_1m_serial", bench_jobs_serial, NULL, fx, 1, 21 },
+        { "jobs/update_1m_parallel", bench_jobs_parallel, NULL, fx, 1, 21 },
+        { "trace/zone_off", bench_trace_off, NULL, fx, 0, 0 },
+        { "trace/zone_on", bench_trace_on, NULL, fx, 0, 0 },
+    };
+    int case_count = (int)( sizeof( cases ) / sizeof( cases[ 0 ] ) );
+
+    BenchResult results[ MAX_RESULTS ];
+    int         result_count = 0;
+
+    printf( "reflection_bench (%s, %d job threads)\n\n", simd_level_name( simd_level() ), job_threads );
+    bench_print_header( stdout );
+    registry_snapshot();
+    for ( int i = 0; i < case_count; i++ )
+    {
+        if ( bench_run( &cases[ i ], &options, &results[ result_count ] ) )
+            bench_print_result( stdout, &results[ result_count++ ] );
+    }
+    registry_restore( NULL );
+
+#ifdef HOT_RELOAD_ENABLED
+    // Full reload of the real game module: shadow copy, dlopen, re-register
+    Module* game = NULL;
+#    ifdef GAME_MODULE_PATH
+    if ( !options.filter || strstr( "module/reload", options.filter ) )
+        game = module_open( GAME_MODULE_PATH );
+#    endif
+    if ( game )
+    {
+        BenchCase reload = { "module/reload", bench_reload, registry_restore, game, 1, 15 };
+        registry_snapshot();
+        if ( bench_run( &reload, &options, &results[ result_count ] ) )
+            bench_print_result( stdout, &results[ result_count++ ] );
+        module_close( game );
+    }
+#endif
+
+    job_system_shutdown();
+    remove( SNAPSHOT_PATH );
+
+    FILE* file;
+    if ( csv_path && ( file = open_output( csv_path ) ) )
+    {
+        bench_write_csv( file, results, result_count );
+        if ( file != stdout )
+            fclose( file );
+    }
+    if ( json_path && ( file = open_output( json_path ) ) )
+    {
+        bench_write_json( file, "reflection", results, result_count );
+        if ( file != stdout )
+            fclose( file );
+    }
+    return 0;
+}
+
+// ============================================================================
@@ -0,0 +1,435 @@
+// ============================================================================
+// delta.c - Per-field change tracking and delta encoding for column storage
+// ============================================================================
+
+#include "delta.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined( _MSC_VER ) && !defined( __clang__ )
+#    include <intrin.h>
+#endif
+
+#define SCAN_BLOCK 64    // Objects compared per memcmp before looking at single elements
+
+static inline int
+bit_scan64( uint64_t mask )
+{
+#if defined( _MSC_VER ) && !defined( __clang__ )
+    unsigned long index;
+    _BitScanForward64( &index, mask );
+    return (int)index;
+#else
+    return __builtin_ctzll( mask );
+#endif
+}
+
+static inline int
+bit_count64( uint64_t mask )
+{
+    int count = 0;
+    for ( ; mask; mask &= mask - 1 ) count++;
+    return count;
+}
+
+static uint64_t
+all_columns( uint16_t column_count )
+{
+    return column_count >= 64 ? ~(uint64_t)0 : ( (uint64_t)1 << column_count ) - 1;
+}
+
+uint32_t
+delta_layout_hash( const SoaStorage* soa )
+{
+    uint32_t hash = 5381;
+    for ( uint16_t i = 0; i < soa->column_count; i++ )
+    {
+        hash = ( ( hash << 5 ) + hash ) ^ soa->columns[ i ].path_hash;
+        hash = ( ( hash << 5 ) + hash ) ^ soa->columns[ i ].size;
+    }
+    return hash;
+}
+
+// ============================================================================
+// Tracker bookkeeping
+// ============================================================================
+
+static void
+release_shadow( ChangeTracker* tracker )
+{
+    for ( uint16_t i = 0; i < SOA_MAX_COLUMNS; i++ )
+    {
+        free( tracker->shadow[ i ] );
+        tracker->shadow[ i ] = NULL;
+    }
+}
+
+static int
+grow( ChangeTracker* tracker, const SoaStorage* soa, uint32_t capacity )
+{
+    if ( capacity <= tracker->capacity )
+        return 1;
+    if ( capacity < tracker->capacity * 2 )
+        capacity = tracker->capacity * 2;
+
+    uint64_t* masks = (uint64_t*)realloc( tracker->masks, capacity * sizeof( uint64_t ) );
+    if ( !masks )
+        return 0;
+    memset( masks + tracker->capacity, 0, ( capacity - tracker->capacity ) * sizeof( uint64_t ) );
+    tracker->masks = masks;
+
+    uint32_t* dirty = (uint32_t*)realloc( tracker->dirty, capacity * sizeof( uint32_t ) );
+    if ( !dirty )
+        return 0;
+    tracker->dirty = dirty;
+
+    for ( uint16_t i = 0; ( tracker->flags & CHANGE_SHADOW ) && i < soa->column_count; i++ )
+    {
+        char* shadow = (char*)realloc( tracker->shadow[ i ], (size_t)capacity * soa->columns[ i ].size );
+        if ( !shadow )
+            return 0;
+        tracker->shadow[ i ] = shadow;
+    }
+    tracker->capacity = capacity;
+    return 1;
+}
+
+// Follows the storage: new layout -> everything dirty, appended objects dirty
+// and shadowed as they are, removed ones forgotten
+static int
+sync( ChangeTracker* tracker, const SoaStorage* soa )
+{
+    if ( soa->type_hash != tracker->type_hash || delta_layout_hash( soa ) != tracker->layout_hash )
+        return change_tracker_reset( tracker, soa );
+    if ( !grow( tracker, soa, soa->count ) )
+        return 0;
+
+    if ( soa->count > tracker->count )
+    {
+        for ( uint16_t c = 0; ( tracker->flags & CHANGE_SHADOW ) && c < soa->column_count; c++ )
+        {
+            size_t size = soa->columns[ c ].size;
+            memcpy( tracker->shadow[ c ] + tracker->count * size, soa->columns[ c ].data + tracker->count * size,
+                    ( soa->count - tracker->count ) * size );
+        }
+        uint32_t first = tracker->count;
+        tracker->count = soa->count;
+        for ( uint32_t i = first; i < soa->count; i++ ) change_mark_object( tracker, i );
+    }
+    else if ( soa->count < tracker->count )
+    {
+        uint32_t kept = 0;
+        for ( uint32_t i = 0; i < tracker->dirty_count; i++ )
+        {
+            uint32_t index = tracker->dirty[ i ];
+            if ( index < soa->count )
+                tracker->dirty[ kept++ ] = index;
+            else
+                tracker->masks[ index ] = 0;
+        }
+        tracker->dirty_count = kept;
+        tracker->count       = soa->count;
+    }
+    return 1;
+}
+
+// ============================================================================
+// Create / destroy
+// ============================================================================
+
+ChangeTracker*
+change_tracker_create( const SoaStorage* soa, uint8_t flags )
+{
+    ChangeTracker* tracker = (ChangeTracker*)calloc( 1, sizeof( ChangeTracker ) );
+    if ( !tracker )
+        return NULL;
+    tracker->flags = flags;
+    if ( !change_tracker_reset( tracker, soa ) )
+    {
+        change_tracker_destroy( tracker );
+        return NULL;
+    }
+    change_tracker_clear( tracker, soa );
+    return tracker;
+}
+
+void
+change_tracker_destroy( ChangeTracker* tracker )
+{
+    if ( !tracker )
+        return;
+    release_shadow( tracker );
+    free( tracker->masks );
+    free( tracker->dirty );
+    free( tracker );
+}
+
+int
+change_tracker_reset( ChangeTracker* tracker, const SoaStorage* soa )
+{
+    // Column sizes may have changed: shadows are rebuilt from scratch
+    release_shadow( tracker );
+    free( tracker->masks );
+    free( tracker->dirty );
+    tracker->masks        = NULL;
+    tracker->dirty        = NULL;
+    tracker->capacity     = 0;
+    tracker->dirty_count  = 0;
+    tracker->type_hash    = soa->type_hash;
+    tracker->layout_hash  = delta_layout_hash( soa );
+    tracker->column_count = soa->column_count;
+    if ( !grow( tracker, soa, soa->count ? soa->count : 64 ) )
+        return 0;
+
+    tracker->count = soa->count;
+    for ( uint32_t i = 0; i < soa->count; i++ ) change_mark_object( tracker, i );
+    return 1;
+}
+
+// ============================================================================
+// Marking
+// ============================================================================
+
+void
+change_mark_object( ChangeTracker* tracker, uint32_t index )
+{
+    if ( index >= tracker->count )
+        return;    // Appended since the last sync, sent whole anyway
+    if ( !tracker->masks[ index ] )
+        tracker->dirty[ tracker->dirty_count++ ] = index;
+    tracker->masks[ index ] = all_columns( tracker->column_count );
+}
+
+void
+change_set( ChangeTracker* tracker, SoaStorage* soa, uint32_t index, int column, const void* value )
+{
+    const SoaColumn* c = &soa->columns[ column ];
+    memcpy( c->data + (size_t)index * c->size, value, c->size );
+    if ( index < tracker->count )
+        change_mark( tracker, index, column );
+}
+
+uint32_t
+change_scan( ChangeTracker* tracker, const SoaStorage* soa )
+{
+    if ( !( tracker->flags & CHANGE_SHADOW ) || !sync( tracker, soa ) )
+        return tracker->dirty_count;
+
+    for ( uint16_t c = 0; c < soa->column_count; c++ )
+    {
+        const char* now    = soa->columns[ c ].data;
+        const char* before = tracker->shadow[ c ];
+        size_t      size   = soa->columns[ c ].size;
+        for ( uint32_t first = 0; first < tracker->count; first += SCAN_BLOCK )
+        {
+            uint32_t last = first + SCAN_BLOCK < tracker->count ? first + SCAN_BLOCK : tracker->count;
+            if ( memcmp( now + first * size, before + first * size, ( last - first ) * size ) == 0 )
+                continue;
+            for ( uint32_t i = first; i < last; i++ )
+            {
+                if ( memcmp( now + i * size, before + i * size, size ) != 0 )
+                    change_mark( tracker, i, c );
+            }
+        }
+    }
+    return tracker->dirty_count;
+}
+
+void
+change_tracker_clear( ChangeTracker* tracker, const SoaStorage* soa )
+{
+    if ( !sync( tracker, soa ) )
+        return;
+
+    if ( tracker->flags & CHANGE_SHADOW )
+    {
+        // Every field dirty (first baseline, reset): whole columns at once
+        int whole = tracker->dirty_count == tracker->count;
+        for ( uint32_t i = 0; whole && i < tracker->count; i++ )
+            whole = tracker->masks[ i ] == all_columns( tracker->column_count );
+        for ( uint16_t c = 0; whole && c < soa->column_count; c++ )
+            memcpy( tracker->shadow[ c ], soa->columns[ c ].data, (size_t)tracker->count * soa->columns[ c ].size );
+
+        for ( uint32_t i = 0; !whole && i < tracker->dirty_count; i++ )
+        {
+            uint32_t index = tracker->dirty[ i ];
+            for ( uint64_t mask = tracker->masks[ index ]; mask; mask &= mask - 1 )
+            {
+                int              c      = bit_scan64( mask );
+                const SoaColumn* column = &soa->columns[ c ];
+                size_t           at     = (size_t)index * column->size;
+                memcpy( tracker->shadow[ c ] + at, column->data + at, column->size );
+            }
+        }
+    }
+
+    for ( uint32_t i = 0; i < tracker->dirty_count; i++ ) tracker->masks[ tracker->dirty[ i ] ] = 0;
+    tracker->dirty_count = 0;
+}
+
+// ============================================================================
+// Encode / apply
+// ============================================================================
+
+static int
+compare_index( const void* a, const void* b )
+{
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+    return ( x > y ) - ( x < y );
+}
+
+static uint8_t*
+put_varint( uint8_t* p, uint32_t value )
+{
+    while ( value >= 0x80 )
+    {
+        *p++ = (uint8_t)( value | 0x80 );
+        value >>= 7;
+    }
+    *p++ = (uint8_t)value;
+    return p;
+}
+
+static uint8_t*
+put_record( uint8_t* p, const SoaStorage* soa, uint32_t index, uint32_t gap, uint64_t mask )
+{
+    p    = put_varint( p, gap );
+    *p++ = (uint8_t)bit_count64( mask );
+    for ( ; mask; mask &= mask - 1 )
+    {
+        int              column = bit_scan64( mask );
+        const SoaColumn* c      = &soa->columns[ column ];
+        *p++                    = (uint8_t)column;
+        memcpy( p, c->data + (size_t)index * c->size, c->size );
+        p += c->size;
+    }
+    return p;
+}
+
+size_t
+delta_encode( ChangeTracker* tracker, const SoaStorage* soa, DeltaBuffer* out )
+{
+    if ( !sync( tracker, soa ) )
+        return 0;
+
+    // Worst case up front, the record loop then never checks for room
+    size_t need = sizeof( DeltaHeader ) + (size_t)tracker->dirty_count * ( 6 + soa->column_count + soa->object_size );
+    if ( out->length + need > out->capacity )
+    {
+        size_t   capacity = out->capacity * 2 > out->length + need ? out->capacity * 2 : out->length + need;
+        uint8_t* data     = (uint8_t*)realloc( out->data, capacity );
+        if ( !data )
+            return 0;
+        out->data     = data;
+        out->capacity = capacity;
+    }
+
+    DeltaHeader header = {
+        .magic        = DELTA_MAGIC,
+        .type_hash    = soa->type_hash,
+        .layout_hash  = tracker->layout_hash,
+        .object_count = soa->count,
+        .record_count = tracker->dirty_count,
+    };
+    uint8_t* start = out->data + out->length;
+    uint8_t* p     = start + sizeof( header );
+    memcpy( start, &header, sizeof( header ) );
+
+    // Records go out in index order: a sorted dirty list when sparse, a mask walk when dense
+    uint32_t next = 0;
+    if ( (uint64_t)tracker->dirty_count * 8 < tracker->count )
+    {
+        qsort( tracker->dirty, tracker->dirty_count, sizeof( uint32_t ), compare_index );
+        for ( uint32_t i = 0; i < tracker->dirty_count; i++ )
+        {
+            uint32_t index = tracker->dirty[ i ];
+            p              = put_record( p, soa, index, index - next, tracker->masks[ index ] );
+            next           = index + 1;
+        }
+    }
+    else
+    {
+        for ( uint32_t index = 0; index < tracker->count; index++ )
+        {
+            if ( !tracker->masks[ index ] )
+                continue;
+            p    = put_record( p, soa, index, index - next, tracker->masks[ index ] );
+            next = index + 1;
+        }
+    }
+
+    out->length += (size_t)( p - start );
+    return (size_t)( p - start );
+}
+
+size_t
+delta_apply( SoaStorage* soa, const void* data, size_t size )
+{
+    const uint8_t* p   = (const uint8_t*)data;
+    const uint8_t* end = p + size;
+
+    DeltaHeader header;
+    if ( size < sizeof( header ) )
+        return 0;
+    memcpy( &header, p, sizeof( header ) );
+    p += sizeof( header );
+    if ( header.magic != DELTA_MAGIC || header.type_hash != soa->type_hash ||
+         header.layout_hash != delta_layout_hash( soa ) )
+    {
+        printf( "ERROR: Delta does not match the storage layout\n" );
+        return 0;
+    }
+
+    if ( header.object_count > soa->capacity && !soa_reserve( soa, header.object_count ) )
+        return 0;
+    for ( uint16_t c = 0; header.object_count > soa->count && c < soa->column_count; c++ )
+    {
+        SoaColumn* column = &soa->columns[ c ];
+        memset( column->data + (size_t)soa->count * column->size, 0,
+                (size_t)( header.object_count - soa->count ) * column->size );
+    }
+    soa->count = header.object_count;
+
+    uint32_t next = 0;
+    for ( uint32_t r = 0; r < header.record_count; r++ )
+    {
+        uint32_t gap = 0;
+        for ( int shift = 0;; shift += 7 )
+        {
+            if ( p == end || shift > 28 )
+                return 0;
+            gap |= (uint32_t)( *p & 0x7F ) << shift;
+            if ( !( *p++ & 0x80 ) )
+                break;
+        }
+        if ( p == end || gap >= header.object_count - next )
+            return 0;
+
+        uint32_t index  = next + gap;
+        uint8_t  fields = *p++;
+        for ( uint8_t f = 0; f < fields; f++ )
+        {
+            if ( p == end || *p >= soa->column_count )
+                return 0;
+            SoaColumn* column = &soa->columns[ *p++ ];
+            if ( (size_t)( end - p ) < column->size )
+                return 0;
+            memcpy( column->data + (size_t)index * column->size, p, column->size );
+            p += column->size;
+        }
+        next = index + 1;
+    }
+    return (size_t)( p - (const uint8_t*)data );
+}
+
+void
+delta_buffer_free( DeltaBuffer* buffer )
+{
+    free( buffer->data );
+    buffer->data     = NULL;
+    buffer->length   = 0;
+    buffer->capacity = 0;
+}
+
+// ============================================================================
@@ -0,0 +1,104 @@
+// ============================================================================
+// delta.h - Per-field change tracking and delta encoding for column storage
+// ============================================================================
+//
+// A ChangeTracker follows one SoaStorage and keeps a 64-bit mask of changed
+// columns (flattened leaf fields, the Field table order) per object plus a
+// list of the objects that have any. Changes get in two ways:
+//
+//   - written through change_set / marked with change_mark: cost is per
+//     change, the encoder then only visits dirty objects
+//   - written straight into the columns (update kernels): change_scan diffs
+//     every column against a shadow copy, skipping unchanged 64-object runs
+//     with one memcmp. Needs CHANGE_SHADOW and reads the whole storage twice.
+//
+// delta_encode emits only the dirty fields as records
+//
+//   varint object gap | u8 field count | ( u8 column, column size bytes ) ...
+//
+// after a DeltaHeader naming the type, its column layout and the object
+// count. delta_apply replays them onto storage with the same layout.
+// Objects appended since the last clear are sent whole; after remove_swap
+// mark the moved object with change_mark_object.
+
+#ifndef DELTA_H
+#define DELTA_H
+
+#include "reflection_core.h"
+#include "soa_storage.h"
+
+#define DELTA_MAGIC   0x4C444643u    // "CFDL"
+#define CHANGE_SHADOW 0x01           // Keep a baseline copy for change_scan
+
+_Static_assert( SOA_MAX_COLUMNS <= 64, "dirty masks are one uint64_t per object" );
+
+typedef struct DeltaHeader
+{
+    uint32_t magic;
+    TypeHash type_hash;
+    uint32_t layout_hash;     // Column paths and sizes, must match on apply
+    uint32_t object_count;    // Storage count after apply
+    uint32_t record_count;    // Objects with changes
+
+} DeltaHeader;
+
+typedef struct DeltaBuffer
+{
+    uint8_t* data;
+    size_t   length;
+    size_t   capacity;
+
+} DeltaBuffer;
+
+typedef struct ChangeTracker
+{
+    TypeHash  type_hash;       // Layout the masks refer to
+    uint32_t  layout_hash;
+    uint16_t  column_count;
+    uint8_t   flags;
+    uint32_t  count;           // Objects the tracker has seen
+    uint32_t  capacity;
+    uint64_t* masks;           // Per object, bit c = column c changed
+    uint32_t* dirty;           // Objects with a non-zero mask, in marking order
+    uint32_t  dirty_count;
+    char*     shadow[ SOA_MAX_COLUMNS ];    // CHANGE_SHADOW: column values at the last clear
+
+} ChangeTracker;
+
+// Starts clean: the storage as it is now is the baseline
+ChangeTracker* change_tracker_create( const SoaStorage* soa, uint8_t flags );
+void           change_tracker_destroy( ChangeTracker* tracker );
+
+// Everything dirty, e.g. for a first full save or after the layout changed
+int change_tracker_reset( ChangeTracker* tracker, const SoaStorage* soa );
+
+// index < tracker->count: objects appended since the last encode / clear are sent whole
+static inline void
+change_mark( ChangeTracker* tracker, uint32_t index, int column )
+{
+    if ( !tracker->masks[ index ] )
+        tracker->dirty[ tracker->dirty_count++ ] = index;
+    tracker->masks[ index ] |= (uint64_t)1 << column;
+}
+
+void change_mark_object( ChangeTracker* tracker, uint32_t index );
+
+// Writes one leaf of one object and marks it, index < tracker->count
+void change_set( ChangeTracker* tracker, SoaStorage* soa, uint32_t index, int column, const void* value );
+
+// Shadow diff, marks whatever changed behind the tracker's back. Returns dirty objects.
+uint32_t change_scan( ChangeTracker* tracker, const SoaStorage* soa );
+
+// New baseline: masks cleared, shadow caught up with the dirty fields only
+void change_tracker_clear( ChangeTracker* tracker, const SoaStorage* soa );
+
+// Appends a delta of everything dirty (tracker unchanged). Returns bytes added, 0 on error.
+size_t delta_encode( ChangeTracker* tracker, const SoaStorage* soa, DeltaBuffer* out );
+
+// Replays a delta, growing or shrinking storage to its object count. Returns bytes consumed, 0 on error.
+size_t delta_apply( SoaStorage* soa, const void* data, size_t size );
+
+uint32_t delta_layout_hash( const SoaStorage* soa );
+void     delta_buffer_free( DeltaBuffer* buffer );
+
+#endif    // DELTA_H
@@ -0,0 +1,180 @@
+// ============================================================================
+// display_list.c - Flattened property editor layouts and incremental refresh
+// ============================================================================
+
+#include "display_list.h"
+#include "type_ops.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static DisplayList* s_lists[ MAX_TYPES ];
+
+// ============================================================================
+// Compile
+// ============================================================================
+
+// Same walk draw_property_editor used to make every frame: only editable
+// structs open up, and a header starts every type. Returns the item count
+// (may exceed DISPLAY_MAX_ITEMS).
+static uint16_t
+display_flatten( const Type* type, uint16_t base, uint8_t depth, DisplayItem* out, uint16_t count )
+{
+    if ( count < DISPLAY_MAX_ITEMS )
+        out[ count ] = ( DisplayItem ){ type_name( type ), base, 0, DISPLAY_HEADER, depth };
+    count++;
+
+    for ( uint16_t i = 0; i < type->field_count; i++ )
+    {
+        const Field* field  = type_field( type, i );
+        uint16_t     offset = (uint16_t)( base + field->offset );
+        Type*        nested = NULL;
+        DisplayItem  item   = { field->name, offset, field->size, DISPLAY_READ_ONLY, depth };
+        if ( field->flags & FIELD_EDITABLE )
+        {
+            if ( field_kind( field ) == FIELD_KIND_FLOAT )
+            {
+                item.widget = DISPLAY_FLOAT;
+            }
+            else if ( field->type_id && ( nested = type_get( field->type_id ) ) != NULL )
+            {
+                item.widget = DISPLAY_NESTED;
+                item.size   = 0;    // Its own items follow
+            }
+            else
+            {
+                item.widget = DISPLAY_EDITABLE;
+            }
+        }
+
+        if ( count < DISPLAY_MAX_ITEMS )
+            out[ count ] = item;
+        count++;
+        if ( nested )
+            count = display_flatten( nested, item.offset, (uint8_t)( depth + 1 ), out, count );
+    }
+    return count;
+}
+
+DisplayList*
+display_list_compile( const Type* type )
+{
+    DisplayItem items[ DISPLAY_MAX_ITEMS ];
+    uint16_t    item_count = display_flatten( type, 0, 0, items, 0 );
+    if ( item_count > DISPLAY_MAX_ITEMS )
+    {
+        printf( "ERROR: %s has too many fields to display\n", type_name( type ) );
+        return NULL;
+    }
+
+    DisplayList* list = (DisplayList*)malloc( sizeof( DisplayList ) + item_count * sizeof( DisplayItem ) );
+    list->type_hash   = type->hash;
+    list->generation  = g_registry.generation;
+    list->object_size = type->size;
+    list->item_count  = item_count;
+    memcpy( list->items, items, item_count * sizeof( DisplayItem ) );
+    return list;
+}
+
+// Any registry change rebuilds: nested types and flags may have moved too
+const DisplayList*
+display_list_get( const Type* type )
+{
+    DisplayList* list = s_lists[ type->id ];
+    if ( list && list->type_hash == type->hash && list->generation == g_registry.generation )
+        return list;
+
+    free( list );
+    s_lists[ type->id ] = display_list_compile( type );
+    return s_lists[ type->id ];
+}
+
+// ============================================================================
+// Views
+// ============================================================================
+
+void
+display_view_init( DisplayView* view, const Type* type, const void* objects, size_t count )
+{
+    memset( view, 0, sizeof( *view ) );
+    view->type    = ( TypeHandle ){ type_name( type ), type->hash, 0, NULL };
+    view->objects = objects;
+    view->count   = count;
+}
+
+void
+display_view_free( DisplayView* view )
+{
+    free( view->shadow );
+    free( view->changed );
+    memset( view, 0, sizeof( *view ) );
+}
+
+// Every item of every object, then the shadow starts over
+static size_t
+display_view_redraw( DisplayView* view, const DisplayList* list, DisplayDrawFunc draw, void* ctx )
+{
+    size_t      size    = list->object_size;
+    const char* objects = (const char*)view->objects;
+    if ( view->count > view->capacity || view->object_size != size )
+    {
+        free( view->shadow );
+        free( view->changed );
+        view->shadow      = (uint8_t*)malloc( view->count * size );
+        view->changed     = (uint32_t*)malloc( view->count * sizeof( uint32_t ) );
+        view->capacity    = view->shadow && view->changed ? view->count : 0;
+        view->object_size = (uint16_t)size;
+        if ( !view->capacity )
+            return 0;
+    }
+
+    for ( size_t i = 0; i < view->count; i++ )
+    {
+        const char* object = objects + i * size;
+        for ( uint16_t k = 0; k < list->item_count; k++ ) draw( ctx, i, &list->items[ k ], object );
+    }
+    memcpy( view->shadow, objects, view->count * size );
+    view->generation = list->generation;
+    view->drawn      = 1;
+    return view->count * list->item_count;
+}
+
+size_t
+display_view_refresh( DisplayView* view, DisplayDrawFunc draw, void* ctx )
+{
+    const Type* type = type_handle_get( &view->type );
+    if ( !type )
+        return 0;
+
+    const DisplayList* list = display_list_get( type );
+    const TypeOps*     ops  = type_ops_get( type );
+    if ( !list || !ops )
+        return 0;
+
+    if ( !view->drawn || view->generation != list->generation || view->count > view->capacity )
+        return display_view_redraw( view, list, draw, ctx );
+
+    // Changed objects first (unchanged blocks are one memcmp), then the items over changed bytes
+    size_t      size    = list->object_size;
+    const char* objects = (const char*)view->objects;
+    size_t      changed = type_ops_diff( ops, objects, view->shadow, view->count, view->changed );
+    size_t      drawn   = 0;
+    for ( size_t c = 0; c < changed; c++ )
+    {
+        size_t      i      = view->changed[ c ];
+        const char* now    = objects + i * size;
+        uint8_t*    before = view->shadow + i * size;
+        for ( uint16_t k = 0; k < list->item_count; k++ )
+        {
+            const DisplayItem* item = &list->items[ k ];
+            if ( item->size && memcmp( now + item->offset, before + item->offset, item->size ) != 0 )
+            {
+                draw( ctx, i, item, now );
+                drawn++;
+            }
+        }
+        type_ops_copy( ops, before, now );
+    }
+    return drawn;
+}
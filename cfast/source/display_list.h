@@ -0,0 +1,82 @@
+// ============================================================================
+// display_list.h - Flattened property editor layouts and incremental refresh
+// ============================================================================
+//
+// A DisplayList is what draw_property_editor walks: the type's fields in
+// drawing order, nested editable structs expanded in place under a header,
+// each item with its widget decided and its offset from the root object.
+// It is built once per Type and rebuilt only after the registry generation
+// moves, so a frame never calls type_get or field_kind.
+//
+// A DisplayView draws count objects (an inspector, or a table of them) from a
+// shadow of their bytes as last drawn. It holds its type by name, so after a
+// reload it draws the layout the type has now. The first refresh, and the
+// first after a type change, draws every item; later ones find the changed objects with
+// type_ops_diff and draw only the items whose bytes differ - a field's line
+// redraws when its value does, whether or not the widget can edit it.
+
+#ifndef DISPLAY_LIST_H
+#define DISPLAY_LIST_H
+
+#include "reflection_core.h"
+
+#define DISPLAY_MAX_ITEMS 256    // Per type, nested items included
+
+typedef enum DisplayWidget
+{
+    DISPLAY_HEADER    = 0,    // Start of a type's items, label is the type name
+    DISPLAY_FLOAT     = 1,    // Editable float
+    DISPLAY_NESTED    = 2,    // Editable struct, its header and items follow
+    DISPLAY_EDITABLE  = 3,    // Editable, no widget for its kind
+    DISPLAY_READ_ONLY = 4,
+
+} DisplayWidget;
+
+typedef struct DisplayItem
+{
+    const char* label;     // Interned field or type name
+    uint16_t    offset;    // From the root object
+    uint16_t    size;      // Field bytes the item stands for, 0 for headers and nested structs
+    uint8_t     widget;    // DisplayWidget
+    uint8_t     depth;     // Nesting level, 0 for the root type
+
+} DisplayItem;
+
+typedef struct DisplayList
+{
+    TypeHash    type_hash;
+    uint32_t    generation;    // Registry generation it was built in
+    uint16_t    object_size;
+    uint16_t    item_count;
+    DisplayItem items[];
+
+} DisplayList;
+
+// Cached per TypeID, NULL if the type has too many items
+DisplayList*       display_list_compile( const Type* type );
+const DisplayList* display_list_get( const Type* type );
+
+// Called per item drawn: object indexes the view's array, base is that object
+typedef void ( *DisplayDrawFunc )( void* ctx, size_t object, const DisplayItem* item, const void* base );
+
+typedef struct DisplayView
+{
+    TypeHandle  type;           // Resolved again on refresh once the registry changed
+    const void* objects;        // count objects, the type's size apart - both may change between refreshes
+    size_t      count;
+    uint8_t*    shadow;         // Objects as last drawn
+    uint32_t*   changed;        // Scratch, one entry per object
+    size_t      capacity;       // Objects the buffers hold
+    uint32_t    generation;     // Display list the shadow was drawn with
+    uint16_t    object_size;    // Shadow stride
+    uint8_t     drawn;          // 0 until the first full draw
+
+} DisplayView;
+
+void display_view_init( DisplayView* view, const Type* type, const void* objects, size_t count );
+void display_view_free( DisplayView* view );
+
+// Draws what changed since the last refresh, returns the number of items drawn
+size_t display_view_refresh( DisplayView* view, DisplayDrawFunc draw, void* ctx );
+
+#endif    // DISPLAY_LIST_H
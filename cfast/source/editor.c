@@ -4,52 +4,108 @@
 
 
 #include "reflection_core.h"    // reflection data Type defintion
+#include "display_list.h"
+#include "field_batch.h"
+#include "json_writer.h"
+#include "json_reader.h"
+#include "query.h"
+#include "trace.h"
+#include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 // ============================================================================
 // Generic property editor using reflection
 // ============================================================================
 
-void
-draw_property_editor( void* obj, Type* type )
+// One display list item; base is the object the list was built for
+static void
+draw_item( const DisplayItem* item, const void* base )
 {
-    printf( "=== %s Editor ===\n", type->name );
-
-    for ( uint8_t i = 0; i < type->field_count; i++ )
+    switch ( item->widget )
     {
-        Field* field     = &type->fields[ i ];
-        void*  field_ptr = field_get_ptr( obj, type, i );
-
-        // Check if field is editable
-        if ( field->flags & 1 )
-        {    // Editable flag
-            printf( "  %s: ", field->name );
-
-            if ( field->type_id == 0 && field->size == sizeof( float ) )
-            {
-                // Float field
-                float* value = (float*)field_ptr;
-                printf( "%.2f [editable]\n", *value );
-                // In real editor: ImGui::DragFloat(field->name, value);
-            }
-            else if ( field->type_id != 0 )
-            {
-                // Nested type - recurse
-                Type* field_type = type_get( field->type_id );
-                if ( field_type )
-                {
-                    printf( "\n" );
-                    draw_property_editor( field_ptr, field_type );
-                }
-            }
-        }
-        else
+        case DISPLAY_HEADER: printf( "=== %s Editor ===\n", item->label ); break;
+        case DISPLAY_FLOAT:
         {
-            printf( "  %s: [read-only]\n", field->name );
+            float value;
+            memcpy( &value, (const char*)base + item->offset, sizeof( float ) );
+            printf( "  %s: %.2f [editable]\n", item->label, value );
+            // In real editor: ImGui::DragFloat(item->label, value);
+            break;
         }
+        case DISPLAY_NESTED: printf( "  %s: \n", item->label ); break;
+        case DISPLAY_EDITABLE: printf( "  %s: ", item->label ); break;    // No widget, the next item follows
+        case DISPLAY_READ_ONLY: printf( "  %s: [read-only]\n", item->label ); break;
     }
 }
 
+// Layout comes from the type's cached display list, rebuilt only after a reload
+void
+draw_property_editor( void* obj, Type* type )
+{
+    TRACE_BEGIN( zone, "draw_property_editor" );
+    const DisplayList* list = display_list_get( type );
+    for ( uint16_t i = 0; list && i < list->item_count; i++ ) draw_item( &list->items[ i ], obj );
+    TRACE_END( zone );
+}
+
+// Tables prefix each line with the object's row. A refresh draws items on their
+// own, so an item with no widget ends its line here.
+static void
+draw_view_item( void* ctx, size_t object, const DisplayItem* item, const void* base )
+{
+    if ( ( (const DisplayView*)ctx )->count > 1 )
+        printf( "[%zu] ", object );
+    draw_item( item, base );
+    if ( item->widget == DISPLAY_EDITABLE )
+        printf( "\n" );
+}
+
+// Inspector or table refresh: everything on the first call and after a reload,
+// then only the fields whose bytes changed. Returns the lines drawn.
+size_t
+draw_property_view( DisplayView* view )
+{
+    TRACE_BEGIN( zone, "draw_property_view" );
+    size_t drawn = display_view_refresh( view, draw_view_item, view );
+    TRACE_END( zone );
+    return drawn;
+}
+
+// ============================================================================
+// Multi-select editing - one batched write across every selected object
+// ============================================================================
+
+int
+edit_selection_set( void* objects, Type* type, const uint32_t* selection, size_t count, const char* path,
+                    const void* value )
+{
+    FieldPath field;
+    if ( !field_path_resolve( type, path, &field ) || !( field.field->flags & FIELD_EDITABLE ) )
+        return 0;
+
+    field_fill_indexed( objects, type->size, selection, count, &field, value );
+    return 1;
+}
+
+// Select by predicate, "health.current < 20 && speed > 3" - fills selection
+// (count entries at most) for edit_selection_set, returns how many matched
+size_t
+edit_select_where( const void* objects, Type* type, size_t count, const char* where, uint32_t* selection )
+{
+    Query query;
+    if ( !query_compile( &query, type, where ) )
+        return 0;
+
+    uint64_t* bitmap = (uint64_t*)malloc( QUERY_WORDS( count ) * sizeof( uint64_t ) );
+    if ( !bitmap )
+        return 0;
+    query_select_parallel( &query, objects, type->size, count, bitmap );
+    size_t selected = query_bitmap_indices( bitmap, count, selection );
+    free( bitmap );
+    return selected;
+}
+
 // ============================================================================
 // Serialize any object to JSON using reflection
 // ============================================================================
@@ -57,44 +113,36 @@ draw_property_editor( void* obj, Type* type )
 void
 serialize_to_json( void* obj, Type* type, FILE* file )
 {
-    fprintf( file, "{\n" );
-    fprintf( file, "  \"_type\": \"%s\",\n", type->name );
+    TRACE_BEGIN( zone, "serialize_to_json" );
+    JsonWriter writer;
+    json_writer_init( &writer, file, JSON_TYPE_NAMES );
+    json_write_object( &writer, type, obj );
+    json_writer_finish( &writer );
+    json_writer_free( &writer );
+    TRACE_END( zone );
+}
 
-    for ( uint8_t i = 0; i < type->field_count; i++ )
+// Fields present in the file overwrite obj, the rest keep their values
+int
+deserialize_from_json( void* obj, Type* type, FILE* file )
+{
+    TRACE_BEGIN( zone, "deserialize_from_json" );
+    size_t length;
+    char*  text = json_read_file( file, &length );
+    if ( !text )
     {
-        Field* field     = &type->fields[ i ];
-        void*  field_ptr = field_get_ptr( obj, type, i );
-
-        fprintf( file, "  \"%s\": ", field->name );
-
-        if ( field->type_id == 0 )
-        {
-            // Primitive type
-            if ( field->size == sizeof( float ) )
-            {
-                fprintf( file, "%.3f", *(float*)field_ptr );
-            }
-            else if ( field->size == sizeof( uint32_t ) )
-            {
-                fprintf( file, "%u", *(uint32_t*)field_ptr );
-            }
-            else
-            {
-                fprintf( file, "\"<binary>\"" );
-            }
-        }
-        else
-        {
-            // Nested object
-            Type* field_type = type_get( field->type_id );
-            serialize_to_json( field_ptr, field_type, file );
-        }
-
-        if ( i < type->field_count - 1 )
-            fprintf( file, "," );
-        fprintf( file, "\n" );
+        TRACE_END( zone );
+        return 0;
     }
-    fprintf( file, "}" );
+
+    JsonReader reader;
+    json_reader_init( &reader, text, length );
+    int ok = json_read_object( &reader, type, obj );
+    if ( !ok )
+        printf( "ERROR: JSON for %s at byte %zu: %s\n", type_name( type ), reader.error_at, reader.error );
+    free( text );
+    TRACE_END( zone );
+    return ok;
 }
 
 // ============================================================================
\ No newline at end of file
@@ -0,0 +1,81 @@
+// ============================================================================
+// editor_main.c - Editor entry point, live-edits the game module
+// ============================================================================
+
+#include "reflection_core.h"
+#include "game_types.h"
+#include "trace.h"
+
+#include <stdio.h>
+
+#ifdef HOT_RELOAD_ENABLED
+#    include "hot_reload.h"
+#    ifdef _WIN32
+#        include <windows.h>
+#    endif
+#endif
+
+void draw_property_editor( void* obj, Type* type );
+
+// ============================================================================
+
+int
+main( int argc, char** argv )
+{
+    printf( "=== Reflection Editor ===\n\n" );
+
+    Player player = {
+        .id        = 1,
+        .name      = "Hero",
+        .transform = { { 0, 0, 0 }, { 0, 0, 0 }, 1.0f },
+        .health    = { 100, 100, 1.0f },
+        .speed     = 5.0f,
+        .flags     = 0,
+    };
+
+#ifdef HOT_RELOAD_ENABLED
+    const char* path = argc > 1 ? argv[ 1 ] : GAME_MODULE_PATH;
+    Module*     game = module_open( path );
+    if ( !game )
+    {
+        printf( "Could not load %s\n", path );
+        return 1;
+    }
+
+    // Redraw whenever the game module is rebuilt; each reload's phases go to editor_trace.json
+    trace_thread_name( "Editor" );
+    trace_enable( 1 );
+    printf( "Watching %s (Ctrl+C to quit)\n\n", path );
+    TypeHandle player_handle = TYPE_HANDLE( "Player" );    // Follows Player across reloads
+    for ( ;; )
+    {
+        Type* player_type = type_handle_get( &player_handle );
+        if ( player_type )
+        {
+            draw_property_editor( &player, player_type );
+        }
+
+#    ifdef _WIN32
+        while ( !check_module_changed( game ) ) Sleep( 100 );
+#    else
+        while ( !check_module_changed( game ) ) hot_reload_wait( -1 );
+#    endif
+        reload_module( game );
+
+        FILE* trace = fopen( "editor_trace.json", "w" );
+        if ( trace )
+        {
+            trace_export_chrome( trace );
+            fclose( trace );
+        }
+    }
+#else
+    (void)argc;
+    (void)argv;
+    (void)player;
+    printf( "Built without hot reload - nothing to edit\n" );
+    return 0;
+#endif
+}
+
+// ============================================================================
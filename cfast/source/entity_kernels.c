@@ -0,0 +1,191 @@
+// ============================================================================
+// entity_kernels.c - Vectorized per-entity update passes over SoA columns
+// ============================================================================
+
+#include "entity_kernels.h"
+
+// ============================================================================
+// Scalar fallback - also handles the tails of the vector loops
+// ============================================================================
+
+static void
+regen_clamp_scalar( float* current, const float* regen_rate, const float* maximum, float dt, size_t count )
+{
+    for ( size_t i = 0; i < count; i++ )
+    {
+        float value  = current[ i ] + regen_rate[ i ] * dt;
+        current[ i ] = value > maximum[ i ] ? maximum[ i ] : value;
+    }
+}
+
+static void
+integrate_scalar( float* position, const float* speed, float dt, size_t count )
+{
+    for ( size_t i = 0; i < count; i++ ) position[ i ] += speed[ i ] * dt;
+}
+
+static void
+lerp_scalar( float* out, const float* a, const float* b, float t, size_t count )
+{
+    for ( size_t i = 0; i < count; i++ ) out[ i ] = a[ i ] + ( b[ i ] - a[ i ] ) * t;
+}
+
+#if SIMD_X86
+
+// ============================================================================
+// SSE2 - 4 lanes
+// ============================================================================
+
+// min_ps( max, value ) picks value when value is NaN, same as the scalar compare
+static void
+regen_clamp_sse2( float* current, const float* regen_rate, const float* maximum, float dt, size_t count )
+{
+    __m128 vdt = _mm_set1_ps( dt );
+    size_t i   = 0;
+    for ( ; i + 4 <= count; i += 4 )
+    {
+        __m128 value = _mm_add_ps( _mm_loadu_ps( current + i ), _mm_mul_ps( _mm_loadu_ps( regen_rate + i ), vdt ) );
+        _mm_storeu_ps( current + i, _mm_min_ps( _mm_loadu_ps( maximum + i ), value ) );
+    }
+    regen_clamp_scalar( current + i, regen_rate + i, maximum + i, dt, count - i );
+}
+
+static void
+integrate_sse2( float* position, const float* speed, float dt, size_t count )
+{
+    __m128 vdt = _mm_set1_ps( dt );
+    size_t i   = 0;
+    for ( ; i + 4 <= count; i += 4 )
+    {
+        __m128 value = _mm_add_ps( _mm_loadu_ps( position + i ), _mm_mul_ps( _mm_loadu_ps( speed + i ), vdt ) );
+        _mm_storeu_ps( position + i, value );
+    }
+    integrate_scalar( position + i, speed + i, dt, count - i );
+}
+
+static void
+lerp_sse2( float* out, const float* a, const float* b, float t, size_t count )
+{
+    __m128 vt = _mm_set1_ps( t );
+    size_t i  = 0;
+    for ( ; i + 4 <= count; i += 4 )
+    {
+        __m128 va = _mm_loadu_ps( a + i );
+        _mm_storeu_ps( out + i, _mm_add_ps( va, _mm_mul_ps( _mm_sub_ps( _mm_loadu_ps( b + i ), va ), vt ) ) );
+    }
+    lerp_scalar( out + i, a + i, b + i, t, count - i );
+}
+
+// ============================================================================
+// AVX2 - 8 lanes, two vectors per iteration to hide add latency
+// ============================================================================
+
+SIMD_TARGET_AVX2 static void
+regen_clamp_avx2( float* current, const float* regen_rate, const float* maximum, float dt, size_t count )
+{
+    __m256 vdt = _mm256_set1_ps( dt );
+    size_t i   = 0;
+    for ( ; i + 16 <= count; i += 16 )
+    {
+        __m256 a = _mm256_add_ps( _mm256_loadu_ps( current + i ),
+                                  _mm256_mul_ps( _mm256_loadu_ps( regen_rate + i ), vdt ) );
+        __m256 b = _mm256_add_ps( _mm256_loadu_ps( current + i + 8 ),
+                                  _mm256_mul_ps( _mm256_loadu_ps( regen_rate + i + 8 ), vdt ) );
+        _mm256_storeu_ps( current + i, _mm256_min_ps( _mm256_loadu_ps( maximum + i ), a ) );
+        _mm256_storeu_ps( current + i + 8, _mm256_min_ps( _mm256_loadu_ps( maximum + i + 8 ), b ) );
+    }
+    for ( ; i + 8 <= count; i += 8 )
+    {
+        __m256 a = _mm256_add_ps( _mm256_loadu_ps( current + i ),
+                                  _mm256_mul_ps( _mm256_loadu_ps( regen_rate + i ), vdt ) );
+        _mm256_storeu_ps( current + i, _mm256_min_ps( _mm256_loadu_ps( maximum + i ), a ) );
+    }
+    regen_clamp_scalar( current + i, regen_rate + i, maximum + i, dt, count - i );
+}
+
+SIMD_TARGET_AVX2 static void
+integrate_avx2( float* position, const float* speed, float dt, size_t count )
+{
+    __m256 vdt = _mm256_set1_ps( dt );
+    size_t i   = 0;
+    for ( ; i + 16 <= count; i += 16 )
+    {
+        __m256 a = _mm256_add_ps( _mm256_loadu_ps( position + i ), _mm256_mul_ps( _mm256_loadu_ps( speed + i ), vdt ) );
+        __m256 b = _mm256_add_ps( _mm256_loadu_ps( position + i + 8 ),
+                                  _mm256_mul_ps( _mm256_loadu_ps( speed + i + 8 ), vdt ) );
+        _mm256_storeu_ps( position + i, a );
+        _mm256_storeu_ps( position + i + 8, b );
+    }
+    for ( ; i + 8 <= count; i += 8 )
+    {
+        __m256 a = _mm256_add_ps( _mm256_loadu_ps( position + i ), _mm256_mul_ps( _mm256_loadu_ps( speed + i ), vdt ) );
+        _mm256_storeu_ps( position + i, a );
+    }
+    integrate_scalar( position + i, speed + i, dt, count - i );
+}
+
+SIMD_TARGET_AVX2 static void
+lerp_avx2( float* out, const float* a, const float* b, float t, size_t count )
+{
+    __m256 vt = _mm256_set1_ps( t );
+    size_t i  = 0;
+    for ( ; i + 16 <= count; i += 16 )
+    {
+        __m256 a0 = _mm256_loadu_ps( a + i );
+        __m256 a1 = _mm256_loadu_ps( a + i + 8 );
+        __m256 d0 = _mm256_sub_ps( _mm256_loadu_ps( b + i ), a0 );
+        __m256 d1 = _mm256_sub_ps( _mm256_loadu_ps( b + i + 8 ), a1 );
+        _mm256_storeu_ps( out + i, _mm256_add_ps( a0, _mm256_mul_ps( d0, vt ) ) );
+        _mm256_storeu_ps( out + i + 8, _mm256_add_ps( a1, _mm256_mul_ps( d1, vt ) ) );
+    }
+    for ( ; i + 8 <= count; i += 8 )
+    {
+        __m256 a0 = _mm256_loadu_ps( a + i );
+        __m256 d0 = _mm256_sub_ps( _mm256_loadu_ps( b + i ), a0 );
+        _mm256_storeu_ps( out + i, _mm256_add_ps( a0, _mm256_mul_ps( d0, vt ) ) );
+    }
+    lerp_sse2( out + i, a + i, b + i, t, count - i );
+}
+
+#endif    // SIMD_X86
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+
+static const EntityKernels s_kernels[] = {
+    { SIMD_SCALAR, regen_clamp_scalar, integrate_scalar, lerp_scalar },
+#if SIMD_X86
+    { SIMD_SSE2, regen_clamp_sse2, integrate_sse2, lerp_sse2 },
+    { SIMD_AVX2, regen_clamp_avx2, integrate_avx2, lerp_avx2 },
+#endif
+};
+
+const EntityKernels*
+entity_kernels_for( SimdLevel level )
+{
+    if ( level > simd_level() )
+        return NULL;
+    for ( size_t i = 0; i < sizeof( s_kernels ) / sizeof( s_kernels[ 0 ] ); i++ )
+    {
+        if ( s_kernels[ i ].level == level )
+            return &s_kernels[ i ];
+    }
+    return NULL;
+}
+
+const EntityKernels*
+entity_kernels( void )
+{
+    static const EntityKernels* best = NULL;
+    if ( !best )
+    {
+        for ( int level = simd_level(); !best && level >= SIMD_SCALAR; level-- )
+        {
+            best = entity_kernels_for( (SimdLevel)level );
+        }
+    }
+    return best;
+}
+
+// ============================================================================
@@ -0,0 +1,38 @@
+// ============================================================================
+// entity_kernels.h - Vectorized per-entity update passes over SoA columns
+// ============================================================================
+//
+// Each pass takes plain float columns (see soa_storage.h), any alignment,
+// any count. Every variant gives bit-identical results: no FMA contraction,
+// so replays and replication don't depend on which CPU ran the tick.
+
+#ifndef ENTITY_KERNELS_H
+#define ENTITY_KERNELS_H
+
+#include "simd.h"
+
+#include <stddef.h>
+
+// current = min( current + regen_rate * dt, maximum )
+typedef void ( *RegenClampFunc )( float* current, const float* regen_rate, const float* maximum, float dt,
+                                  size_t count );
+
+// position += speed * dt
+typedef void ( *IntegrateFunc )( float* position, const float* speed, float dt, size_t count );
+
+// out = a + ( b - a ) * t, out may be a or b
+typedef void ( *LerpFunc )( float* out, const float* a, const float* b, float t, size_t count );
+
+typedef struct EntityKernels
+{
+    SimdLevel      level;
+    RegenClampFunc regen_clamp;
+    IntegrateFunc  integrate;
+    LerpFunc       lerp;
+
+} EntityKernels;
+
+const EntityKernels* entity_kernels( void );                   // Best variant for this CPU
+const EntityKernels* entity_kernels_for( SimdLevel level );    // NULL if the CPU lacks it
+
+#endif    // ENTITY_KERNELS_H
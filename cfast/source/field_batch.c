@@ -0,0 +1,312 @@
+// ============================================================================
+// field_batch.c - Bulk strided gather / scatter of one field over many objects
+// ============================================================================
+
+#include "field_batch.h"
+
+#include <limits.h>
+
+// Lane offsets are 32-bit; past this stride the vector kernels defer to scalar
+#define BATCH_MAX_STRIDE ( (size_t)INT32_MAX / 16 )
+
+// ============================================================================
+// Scalar - any field size, and the tails of the vector loops
+// ============================================================================
+
+// Constant sizes let memcpy become a single load / store
+#define BATCH_COPY_LOOP( n, dst_at, src_at )                                  \
+    for ( size_t i = 0; i < count; i++ ) memcpy( dst_at, src_at, n )
+
+#define BATCH_COPY( size, dst_at, src_at )                                    \
+    switch ( size )                                                          \
+    {                                                                        \
+        case 1: BATCH_COPY_LOOP( 1, dst_at, src_at ); break;                  \
+        case 2: BATCH_COPY_LOOP( 2, dst_at, src_at ); break;                  \
+        case 4: BATCH_COPY_LOOP( 4, dst_at, src_at ); break;                  \
+        case 8: BATCH_COPY_LOOP( 8, dst_at, src_at ); break;                  \
+        default: BATCH_COPY_LOOP( size, dst_at, src_at ); break;              \
+    }
+
+static void
+gather_scalar( const char* base, size_t stride, size_t count, size_t size, char* out )
+{
+    BATCH_COPY( size, out + i * size, base + i * stride );
+}
+
+static void
+scatter_scalar( char* base, size_t stride, size_t count, size_t size, const char* in )
+{
+    BATCH_COPY( size, base + i * stride, in + i * size );
+}
+
+static void
+gather_indexed_scalar( const char* base, size_t stride, const uint32_t* indices, size_t count, size_t size, char* out )
+{
+    BATCH_COPY( size, out + i * size, base + indices[ i ] * stride );
+}
+
+static void
+scatter_indexed_scalar( char* base, size_t stride, const uint32_t* indices, size_t count, size_t size, const char* in )
+{
+    BATCH_COPY( size, base + indices[ i ] * stride, in + i * size );
+}
+
+static void
+gather32_scalar( const char* base, size_t stride, size_t count, uint32_t* out )
+{
+    gather_scalar( base, stride, count, 4, (char*)out );
+}
+
+static void
+scatter32_scalar( char* base, size_t stride, size_t count, const uint32_t* in )
+{
+    scatter_scalar( base, stride, count, 4, (const char*)in );
+}
+
+static void
+gather32_indexed_scalar( const char* base, size_t stride, const uint32_t* indices, size_t count, uint32_t* out )
+{
+    gather_indexed_scalar( base, stride, indices, count, 4, (char*)out );
+}
+
+static void
+scatter32_indexed_scalar( char* base, size_t stride, const uint32_t* indices, size_t count, const uint32_t* in )
+{
+    scatter_indexed_scalar( base, stride, indices, count, 4, (const char*)in );
+}
+
+#if SIMD_X86
+
+// ============================================================================
+// AVX2 - 8-lane gathers. No scatter instruction, so stores stay scalar
+// ============================================================================
+
+// Dense: constant lane offsets { 0, s, 2s, ... }, base advanced per block so
+// the offsets never grow with the element index
+SIMD_TARGET_AVX2 static void
+gather32_avx2( const char* base, size_t stride, size_t count, uint32_t* out )
+{
+    size_t i = 0;
+    if ( stride <= BATCH_MAX_STRIDE )
+    {
+        int    s     = (int)stride;
+        __m256i lanes = _mm256_setr_epi32( 0, s, 2 * s, 3 * s, 4 * s, 5 * s, 6 * s, 7 * s );
+        for ( ; i + 8 <= count; i += 8 )
+        {
+            __m256i v = _mm256_i32gather_epi32( (const int*)( base + i * stride ), lanes, 1 );
+            _mm256_storeu_si256( (__m256i*)( out + i ), v );
+        }
+    }
+    gather32_scalar( base + i * stride, stride, count - i, out + i );
+}
+
+// Selections: 64-bit offsets ( index * stride ) so any index is reachable
+SIMD_TARGET_AVX2 static void
+gather32_indexed_avx2( const char* base, size_t stride, const uint32_t* indices, size_t count, uint32_t* out )
+{
+    size_t i = 0;
+    if ( stride <= UINT32_MAX )
+    {
+        __m256i vstride = _mm256_set1_epi64x( (long long)stride );
+        for ( ; i + 4 <= count; i += 4 )
+        {
+            __m256i idx     = _mm256_cvtepu32_epi64( _mm_loadu_si128( (const __m128i*)( indices + i ) ) );
+            __m256i offsets = _mm256_mul_epu32( idx, vstride );
+            __m128i v       = _mm256_i64gather_epi32( (const int*)base, offsets, 1 );
+            _mm_storeu_si128( (__m128i*)( out + i ), v );
+        }
+    }
+    gather32_indexed_scalar( base, stride, indices + i, count - i, out + i );
+}
+
+// ============================================================================
+// AVX-512 - 16-lane gathers and hardware scatters
+// ============================================================================
+
+SIMD_TARGET_AVX512 static void
+gather32_avx512( const char* base, size_t stride, size_t count, uint32_t* out )
+{
+    size_t i = 0;
+    if ( stride <= BATCH_MAX_STRIDE )
+    {
+        __m512i lanes = _mm512_mullo_epi32( _mm512_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 ),
+                                            _mm512_set1_epi32( (int)stride ) );
+        for ( ; i + 16 <= count; i += 16 )
+        {
+            __m512i v = _mm512_i32gather_epi32( lanes, base + i * stride, 1 );
+            _mm512_storeu_si512( out + i, v );
+        }
+    }
+    gather32_scalar( base + i * stride, stride, count - i, out + i );
+}
+
+// Overlapping lanes resolve in lane order, so stride < 4 still matches scalar
+SIMD_TARGET_AVX512 static void
+scatter32_avx512( char* base, size_t stride, size_t count, const uint32_t* in )
+{
+    size_t i = 0;
+    if ( stride <= BATCH_MAX_STRIDE )
+    {
+        __m512i lanes = _mm512_mullo_epi32( _mm512_setr_epi32( 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 ),
+                                            _mm512_set1_epi32( (int)stride ) );
+        for ( ; i + 16 <= count; i += 16 )
+        {
+            __m512i v = _mm512_loadu_si512( in + i );
+            _mm512_i32scatter_epi32( base + i * stride, lanes, v, 1 );
+        }
+    }
+    scatter32_scalar( base + i * stride, stride, count - i, in + i );
+}
+
+SIMD_TARGET_AVX512 static void
+gather32_indexed_avx512( const char* base, size_t stride, const uint32_t* indices, size_t count, uint32_t* out )
+{
+    size_t i = 0;
+    if ( stride <= UINT32_MAX )
+    {
+        __m512i vstride = _mm512_set1_epi64( (long long)stride );
+        for ( ; i + 8 <= count; i += 8 )
+        {
+            __m512i idx     = _mm512_cvtepu32_epi64( _mm256_loadu_si256( (const __m256i*)( indices + i ) ) );
+            __m512i offsets = _mm512_mul_epu32( idx, vstride );
+            __m256i v       = _mm512_i64gather_epi32( offsets, base, 1 );
+            _mm256_storeu_si256( (__m256i*)( out + i ), v );
+        }
+    }
+    gather32_indexed_scalar( base, stride, indices + i, count - i, out + i );
+}
+
+// Duplicate indices: the highest lane wins, same as the scalar loop order
+SIMD_TARGET_AVX512 static void
+scatter32_indexed_avx512( char* base, size_t stride, const uint32_t* indices, size_t count, const uint32_t* in )
+{
+    size_t i = 0;
+    if ( stride <= UINT32_MAX )
+    {
+        __m512i vstride = _mm512_set1_epi64( (long long)stride );
+        for ( ; i + 8 <= count; i += 8 )
+        {
+            __m512i idx     = _mm512_cvtepu32_epi64( _mm256_loadu_si256( (const __m256i*)( indices + i ) ) );
+            __m512i offsets = _mm512_mul_epu32( idx, vstride );
+            __m256i v       = _mm256_loadu_si256( (const __m256i*)( in + i ) );
+            _mm512_i64scatter_epi32( base, offsets, v, 1 );
+        }
+    }
+    scatter32_indexed_scalar( base, stride, indices + i, count - i, in + i );
+}
+
+#endif    // SIMD_X86
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+
+static const FieldBatchKernels s_kernels[] = {
+    { SIMD_SCALAR, gather32_scalar, scatter32_scalar, gather32_indexed_scalar, scatter32_indexed_scalar },
+#if SIMD_X86
+    { SIMD_AVX2, gather32_avx2, scatter32_scalar, gather32_indexed_avx2, scatter32_indexed_scalar },
+    { SIMD_AVX512, gather32_avx512, scatter32_avx512, gather32_indexed_avx512, scatter32_indexed_avx512 },
+#endif
+};
+
+const FieldBatchKernels*
+field_batch_kernels_for( SimdLevel level )
+{
+    if ( level > simd_level() )
+        return NULL;
+    for ( size_t i = 0; i < sizeof( s_kernels ) / sizeof( s_kernels[ 0 ] ); i++ )
+    {
+        if ( s_kernels[ i ].level == level )
+            return &s_kernels[ i ];
+    }
+    return NULL;
+}
+
+const FieldBatchKernels*
+field_batch_kernels( void )
+{
+    static const FieldBatchKernels* best = NULL;
+    if ( !best )
+    {
+        for ( int level = simd_level(); !best && level >= SIMD_SCALAR; level-- )
+        {
+            best = field_batch_kernels_for( (SimdLevel)level );
+        }
+    }
+    return best;
+}
+
+// ============================================================================
+// Public API - 4-byte fields go to the vector kernels, the rest stay scalar
+// ============================================================================
+
+void
+field_gather( const void* objects, size_t stride, size_t count, const FieldPath* field, void* out )
+{
+    const char* base = (const char*)objects + field->offset;
+    if ( field->size == 4 )
+        field_batch_kernels()->gather32( base, stride, count, (uint32_t*)out );
+    else
+        gather_scalar( base, stride, count, field->size, (char*)out );
+}
+
+void
+field_scatter( void* objects, size_t stride, size_t count, const FieldPath* field, const void* in )
+{
+    char* base = (char*)objects + field->offset;
+    if ( field->size == 4 )
+        field_batch_kernels()->scatter32( base, stride, count, (const uint32_t*)in );
+    else
+        scatter_scalar( base, stride, count, field->size, (const char*)in );
+}
+
+void
+field_fill( void* objects, size_t stride, size_t count, const FieldPath* field, const void* value )
+{
+    char* base = (char*)objects + field->offset;
+    BATCH_COPY( field->size, base + i * stride, value );
+}
+
+void
+field_gather_indexed( const void*      objects,
+                      size_t           stride,
+                      const uint32_t*  indices,
+                      size_t           count,
+                      const FieldPath* field,
+                      void*            out )
+{
+    const char* base = (const char*)objects + field->offset;
+    if ( field->size == 4 )
+        field_batch_kernels()->gather32_indexed( base, stride, indices, count, (uint32_t*)out );
+    else
+        gather_indexed_scalar( base, stride, indices, count, field->size, (char*)out );
+}
+
+void
+field_scatter_indexed( void*            objects,
+                       size_t           stride,
+                       const uint32_t*  indices,
+                       size_t           count,
+                       const FieldPath* field,
+                       const void*      in )
+{
+    char* base = (char*)objects + field->offset;
+    if ( field->size == 4 )
+        field_batch_kernels()->scatter32_indexed( base, stride, indices, count, (const uint32_t*)in );
+    else
+        scatter_indexed_scalar( base, stride, indices, count, field->size, (const char*)in );
+}
+
+void
+field_fill_indexed( void*            objects,
+                    size_t           stride,
+                    const uint32_t*  indices,
+                    size_t           count,
+                    const FieldPath* field,
+                    const void*      value )
+{
+    char* base = (char*)objects + field->offset;
+    BATCH_COPY( field->size, base + indices[ i ] * stride, value );
+}
+
+// ============================================================================
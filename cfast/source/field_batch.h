@@ -0,0 +1,57 @@
+// ============================================================================
+// field_batch.h - Bulk strided gather / scatter of one field over many objects
+// ============================================================================
+//
+// Objects are N records laid out stride bytes apart (an AoS array). Instead of
+// field_get_ptr per object, a resolved FieldPath is applied to all of them in
+// one pass: 4-byte fields use hardware gathers (AVX2 / AVX-512) and
+// scatters (AVX-512), other sizes a fixed-size copy loop.
+
+#ifndef FIELD_BATCH_H
+#define FIELD_BATCH_H
+
+#include "reflection_core.h"
+#include "simd.h"
+
+// Dense ranges: element i lives at objects + i * stride
+void field_gather( const void* objects, size_t stride, size_t count, const FieldPath* field, void* out );
+void field_scatter( void* objects, size_t stride, size_t count, const FieldPath* field, const void* in );
+void field_fill( void* objects, size_t stride, size_t count, const FieldPath* field, const void* value );
+
+// Selections (multi-select): element i lives at objects + indices[ i ] * stride
+void field_gather_indexed( const void*      objects,
+                           size_t           stride,
+                           const uint32_t*  indices,
+                           size_t           count,
+                           const FieldPath* field,
+                           void*            out );
+void field_scatter_indexed( void*            objects,
+                            size_t           stride,
+                            const uint32_t*  indices,
+                            size_t           count,
+                            const FieldPath* field,
+                            const void*      in );
+void field_fill_indexed( void*            objects,
+                         size_t           stride,
+                         const uint32_t*  indices,
+                         size_t           count,
+                         const FieldPath* field,
+                         const void*      value );
+
+// 4-byte kernels per SIMD level, base already offset to the field
+typedef struct FieldBatchKernels
+{
+    SimdLevel level;
+    void ( *gather32 )( const char* base, size_t stride, size_t count, uint32_t* out );
+    void ( *scatter32 )( char* base, size_t stride, size_t count, const uint32_t* in );
+    void ( *gather32_indexed )( const char* base, size_t stride, const uint32_t* indices, size_t count,
+                                uint32_t* out );
+    void ( *scatter32_indexed )( char* base, size_t stride, const uint32_t* indices, size_t count,
+                                 const uint32_t* in );
+
+} FieldBatchKernels;
+
+const FieldBatchKernels* field_batch_kernels( void );                   // Best variant for this CPU
+const FieldBatchKernels* field_batch_kernels_for( SimdLevel level );    // NULL if the CPU lacks it
+
+#endif    // FIELD_BATCH_H
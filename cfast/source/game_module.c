@@ -4,101 +4,103 @@
 
 #include "reflection_core.h"    // reflection data Type defintion
 #include "game_types.h"         // reflected game module types defintion
+#include "soa_storage.h"        // column storage for entities
+#include "entity_kernels.h"     // vectorized update passes
+#include "snapshot.h"           // save / restore of the whole state
+#include "type_pool.h"          // handle-addressed objects of any type
+#include "job_system.h"         // per-entity passes split across cores
+#include "trace.h"              // frame time breakdown
 
 #include <stdio.h>
+#include <stdlib.h>
 
 // Module state - survives hot reload
 typedef struct GameState
 {
-    Player*  players;
-    uint32_t player_count;
-    float    game_time;
+    SoaStorage* players;     // One column per flattened Player field
+    Snapshot*   snapshot;    // Mapping restored columns may still borrow from
+    float       game_time;
 
 } GameState;
 
 static GameState* g_state = NULL;
 
+// Resolved once per registry change, not hashed and probed every frame
+static TypeHandle s_player_type = TYPE_HANDLE( "Player" );
+
+// Columns game_update streams, in UpdateColumn order
+typedef enum UpdateColumn
+{
+    UPDATE_CURRENT,
+    UPDATE_MAXIMUM,
+    UPDATE_REGEN_RATE,
+    UPDATE_SPEED,
+    UPDATE_POSITION_X,
+    UPDATE_COLUMN_COUNT,
+
+} UpdateColumn;
+
+static const char* const k_update_columns[ UPDATE_COLUMN_COUNT ] = {
+    "health.current",
+    "health.maximum",
+    "health.regen_rate",
+    "speed",
+    "transform.position.x",
+};
+
+// Column indices into g_state->players, looked up whenever the storage is built or
+// re-laid out (init, reload, snapshot load) instead of by path every frame
+static int s_update_columns[ UPDATE_COLUMN_COUNT ];
+static int s_update_ready;
+
+static void
+resolve_update_columns( const Type* player_type )
+{
+    s_update_ready = player_type && g_state && g_state->players;
+    for ( int i = 0; i < UPDATE_COLUMN_COUNT && s_update_ready; i++ )
+    {
+        s_update_columns[ i ] = soa_column_index( g_state->players, player_type, k_update_columns[ i ] );
+        s_update_ready        = s_update_columns[ i ] >= 0;
+    }
+}
+
 // ============================================================================
 // Register our types when DLL loads
 // ============================================================================
 
+// Field tables live in .rodata, built from the lists in game_types.h
+TYPE_TABLE( Vec3, VEC3_FIELDS );
+TYPE_TABLE( Transform, TRANSFORM_FIELDS );
+TYPE_TABLE( Health, HEALTH_FIELDS );
+TYPE_TABLE( Player, PLAYER_FIELDS );
+
+static const FieldQuant k_transform_quants[] = { TRANSFORM_QUANTS };
+static const FieldQuant k_health_quants[]    = { HEALTH_QUANTS };
+_Static_assert( sizeof( k_transform_quants ) / sizeof( FieldQuant ) == TYPE_FIELD_COUNT_Transform, "one quant per field" );
+_Static_assert( sizeof( k_health_quants ) / sizeof( FieldQuant ) == TYPE_FIELD_COUNT_Health, "one quant per field" );
+
+#define GAME_MODULE_ID 1
+
+// In dependency order - nested types are looked up by name as each registers
+static const TypeDesc k_game_types[] = {
+    TYPE_DESC( Vec3, NULL, GAME_MODULE_ID, 1 ),
+    TYPE_DESC( Transform, k_transform_quants, GAME_MODULE_ID, 1 ),
+    TYPE_DESC( Health, k_health_quants, GAME_MODULE_ID, 1 ),
+    TYPE_DESC( Player, NULL, GAME_MODULE_ID, 2 ),    // Increment version when struct changes
+};
+
 void
 game_register_types( Registry* reg )
 {
-    // Register Vec3
-    Type vec3_type = {
-        .hash        = hash_string( "Vec3" ),
-        .name        = "Vec3",
-        .size        = sizeof( Vec3 ),
-        .alignment   = _Alignof( Vec3 ),
-        .field_count = 3,
-        .fields =
-            {
-                { "x", offsetof( Vec3, x ), sizeof( float ), 0, 0 },
-                { "y", offsetof( Vec3, y ), sizeof( float ), 0, 0 },
-                { "z", offsetof( Vec3, z ), sizeof( float ), 0, 0 },
-            },
-        .module_id = 1,    // This module's ID
-        .version   = 1,
-    };
-    TypeID vec3_id = type_register( &vec3_type );
-
-    // Register Transform
-    Type transform_type = {
-        .hash        = hash_string( "Transform" ),
-        .name        = "Transform",
-        .size        = sizeof( Transform ),
-        .alignment   = _Alignof( Transform ),
-        .field_count = 3,
-        .fields =
-            {
-                { "position", offsetof( Transform, position ), sizeof( Vec3 ), vec3_id, 0 },
-                { "rotation", offsetof( Transform, rotation ), sizeof( Vec3 ), vec3_id, 0 },
-                { "scale", offsetof( Transform, scale ), sizeof( float ), 0, 0 },
-            },
-        .module_id = 1,
-        .version   = 1,
-    };
-    TypeID transform_id = type_register( &transform_type );
-
-    // Register Health
-    Type health_type = {
-        .hash        = hash_string( "Health" ),
-        .name        = "Health",
-        .size        = sizeof( Health ),
-        .alignment   = _Alignof( Health ),
-        .field_count = 3,
-        .fields =
-            {
-                { "current", offsetof( Health, current ), sizeof( float ), 0, 0 },
-                { "maximum", offsetof( Health, maximum ), sizeof( float ), 0, 0 },
-                { "regen_rate", offsetof( Health, regen_rate ), sizeof( float ), 0, 0 },
-            },
-        .module_id = 1,
-        .version   = 1,
-    };
-    TypeID health_id = type_register( &health_type );
-
-    // Register Player
-    Type player_type = {
-        .hash        = hash_string( "Player" ),
-        .name        = "Player",
-        .size        = sizeof( Player ),
-        .alignment   = _Alignof( Player ),
-        .field_count = 6,
-        .fields =
-            {
-                { "id", offsetof( Player, id ), sizeof( uint32_t ), 0, 0 },
-                { "name", offsetof( Player, name ), 32, 0, 0 },
-                { "transform", offsetof( Player, transform ), sizeof( Transform ), transform_id, 0 },
-                { "health", offsetof( Player, health ), sizeof( Health ), health_id, 0 },
-                { "speed", offsetof( Player, speed ), sizeof( float ), 0, 1 },    // Flag: editable
-                { "flags", offsetof( Player, flags ), sizeof( uint32_t ), 0, 0 },
-            },
-        .module_id = 1,
-        .version   = 2,    // Increment when struct changes
-    };
-    type_register( &player_type );
+    for ( size_t i = 0; i < sizeof( k_game_types ) / sizeof( k_game_types[ 0 ] ); i++ ) { type_register( &k_game_types[ i ] ); }
+}
+
+// Reload unregisters, then the new build registers in the same batch: types it
+// registers again keep their TypeID, only changed ones get a new record
+void
+game_unregister_types( Registry* reg )
+{
+    type_unregister_module( GAME_MODULE_ID );
 }
 
 // ============================================================================
@@ -113,55 +115,185 @@ game_hot_reload_fixup( Registry* reg, void* old_state )
         g_state = (GameState*)old_state;
         printf( "Hot reload: Restored game state (time=%.2f)\n", g_state->game_time );
 
-        // Fix up any pointers if needed.
-        // Re-register types with new function pointers.
-        game_register_types( reg );
+        // Types were registered by the new build just before this, with its function pointers
+
+        // Player may have been reordered, retyped or resized in this build: re-lay the
+        // columns out to match. GameState itself must keep its layout across reloads.
+        Type* player_type = type_handle_get( &s_player_type );
+        if ( player_type && g_state->players && !soa_migrate( g_state->players, player_type ) )
+            printf( "ERROR: Hot reload: could not migrate players to the new layout\n" );
+        resolve_update_columns( player_type );
+
+        // Pooled objects follow their types too, handles held across the reload stay valid
+        type_pools_migrate();
     }
 }
 
 // ============================================================================
-// Game update - can access types by ID for speed
+// State creation
 // ============================================================================
 
-void
+MODULE_EXPORT void
+game_init( uint32_t player_capacity )
+{
+    if ( g_state )
+        return;
+
+    Type* player_type = type_handle_get( &s_player_type );
+    if ( !player_type )
+        return;
+
+    g_state          = (GameState*)calloc( 1, sizeof( GameState ) );
+    g_state->players = soa_create( player_type, player_capacity );
+    resolve_update_columns( player_type );
+}
+
+MODULE_EXPORT uint32_t
+game_spawn_player( const Player* player )
+{
+    return g_state ? soa_push( g_state->players, player ) : UINT32_MAX;
+}
+
+// Players first: their columns may borrow from the snapshot
+MODULE_EXPORT void
+game_shutdown( void )
+{
+    if ( !g_state )
+        return;
+
+    soa_destroy( g_state->players );
+    snapshot_close( g_state->snapshot );
+    free( g_state );
+    g_state        = NULL;
+    s_update_ready = 0;
+}
+
+// ============================================================================
+// Snapshots - players and game time, restored in place from a mapped file
+// ============================================================================
+
+MODULE_EXPORT int
+game_save_snapshot( const char* path )
+{
+    Type* player_type = type_handle_get( &s_player_type );
+    if ( !g_state || !player_type )
+        return 0;
+
+    SnapshotWriter* writer = snapshot_writer_create();
+    if ( !writer )
+        return 0;
+
+    int ok = snapshot_add_soa( writer, "players", player_type, g_state->players ) &&
+             snapshot_add_blob( writer, "game_time", &g_state->game_time, sizeof( g_state->game_time ) ) &&
+             snapshot_write( writer, path );
+    snapshot_writer_free( writer );
+    return ok;
+}
+
+MODULE_EXPORT int
+game_load_snapshot( const char* path )
+{
+    Type* player_type = type_handle_get( &s_player_type );
+    if ( !g_state || !player_type )
+        return 0;
+
+    Snapshot* snap = snapshot_open( path );
+    if ( !snap )
+        return 0;
+
+    size_t      time_size = 0;
+    const void* game_time = snapshot_blob( snap, "game_time", &time_size );
+    SoaStorage* players   = snapshot_load_soa( snap, "players", player_type );
+    if ( !players || !game_time || time_size != sizeof( float ) )
+    {
+        printf( "ERROR: Snapshot %s has no game state\n", path );
+        soa_destroy( players );
+        snapshot_close( snap );
+        return 0;
+    }
+
+    // Old columns may borrow from the previous snapshot, so it closes after them
+    soa_destroy( g_state->players );
+    snapshot_close( g_state->snapshot );
+    g_state->players  = players;
+    g_state->snapshot = snap;
+    memcpy( &g_state->game_time, game_time, sizeof( float ) );
+    resolve_update_columns( player_type );
+    return 1;
+}
+
+// ============================================================================
+// Game update - streams only the columns it touches
+// ============================================================================
+
+#define UPDATE_MIN_GRAIN 4096    // Players per job: 16 KB per column, well above the split overhead
+
+typedef struct UpdateRange
+{
+    float*               current;
+    const float*         maximum;
+    const float*         regen_rate;
+    const float*         speed;
+    float*               position_x;
+    float                dt;
+    const EntityKernels* kernels;
+
+} UpdateRange;
+
+// Players are independent, so any split gives the same result as one pass
+static void
+update_players( void* data, uint32_t begin, uint32_t end )
+{
+    TRACE_BEGIN( zone, "update_players" );
+    UpdateRange* r     = (UpdateRange*)data;
+    size_t       count = end - begin;
+    r->kernels->regen_clamp( r->current + begin, r->regen_rate + begin, r->maximum + begin, r->dt, count );
+    r->kernels->integrate( r->position_x + begin, r->speed + begin, r->dt, count );
+    TRACE_END( zone );
+}
+
+MODULE_EXPORT void
 game_update( float dt )
 {
     if ( !g_state )
         return;
 
+    TRACE_BEGIN( zone, "game_update" );
     g_state->game_time += dt;
 
-    Type* player_type = type_find_by_hash( hash_string( "Player" ) );
-
-    for ( uint32_t i = 0; i < g_state->player_count; i++ )
+    if ( !s_update_ready )
     {
-        Player* p = &g_state->players[ i ];
-
-        // Fast path - direct access
-        p->health.current += p->health.regen_rate * dt;
-        if ( p->health.current > p->health.maximum )
-        {
-            p->health.current = p->health.maximum;
-        }
-
-        // Or via reflection for tools
-        float* speed = (float*)field_get_ptr( p, player_type, PLAYER_SPEED );
-        p->transform.position.x += *speed * dt;
+        TRACE_END( zone );
+        return;
     }
+
+    // SSE2 / AVX2 picked once at runtime, scalar elsewhere; ranges spread over the job threads
+    SoaStorage* players = g_state->players;
+    UpdateRange range   = {
+        .current    = (float*)soa_column_data( players, s_update_columns[ UPDATE_CURRENT ] ),
+        .maximum    = (const float*)soa_column_data( players, s_update_columns[ UPDATE_MAXIMUM ] ),
+        .regen_rate = (const float*)soa_column_data( players, s_update_columns[ UPDATE_REGEN_RATE ] ),
+        .speed      = (const float*)soa_column_data( players, s_update_columns[ UPDATE_SPEED ] ),
+        .position_x = (float*)soa_column_data( players, s_update_columns[ UPDATE_POSITION_X ] ),
+        .dt         = dt,
+        .kernels    = entity_kernels(),
+    };
+    job_parallel_for( players->count, UPDATE_MIN_GRAIN, update_players, &range );
+    TRACE_END( zone );
 }
 
 // ============================================================================
 // Export module info
 // ============================================================================
 
-__declspec( dllexport ) ModuleInfo*
+MODULE_EXPORT ModuleInfo*
 get_module_info( void )
 {
     static ModuleInfo info = {
         .name             = "GameModule",
         .version          = 1,
         .register_types   = game_register_types,
-        .unregister_types = NULL,
+        .unregister_types = game_unregister_types,
         .hot_reload_fixup = game_hot_reload_fixup,
     };
     return &info;
@@ -171,7 +303,7 @@ get_module_info( void )
 // Export state for hot reload
 // ============================================================================
 
-__declspec( dllexport ) void*
+MODULE_EXPORT void*
 get_module_state( void )
 {
     return g_state;
@@ -7,38 +7,51 @@
 
 #include <stdint.h>
 
-// Actual C structs - shared between modules
-typedef struct Vec3
-{
-    float x, y, z;
-} Vec3;
+#include "type_table.h"
 
-typedef struct Transform
-{
-    Vec3  position;
-    Vec3  rotation;
-    float scale;
+// Reflected structs - shared between modules. Each list is the single source
+// for the struct, its field indices and the field table game_module.c registers
+// (see type_table.h). Flags are expanded where reflection_core.h is included.
+#define VEC3_FIELDS( S, FIELD, NESTED ) \
+    FIELD( S, float, x, , 0 )           \
+    FIELD( S, float, y, , 0 )           \
+    FIELD( S, float, z, , 0 )
 
-} Transform;
+#define TRANSFORM_FIELDS( S, FIELD, NESTED )         \
+    NESTED( S, Vec3, position, FIELD_QUANTIZED )     \
+    NESTED( S, Vec3, rotation, FIELD_QUANTIZED )     \
+    FIELD( S, float, scale, , 0 )
 
-typedef struct Health
-{
-    float current;
-    float maximum;
-    float regen_rate;
+#define HEALTH_FIELDS( S, FIELD, NESTED )            \
+    FIELD( S, float, current, , FIELD_QUANTIZED )    \
+    FIELD( S, float, maximum, , FIELD_QUANTIZED )    \
+    FIELD( S, float, regen_rate, , FIELD_QUANTIZED )
 
-} Health;
+#define PLAYER_FIELDS( S, FIELD, NESTED )                                   \
+    FIELD( S, uint32_t, id, , FIELD_KIND_FLAG( FIELD_KIND_UINT32 ) )        \
+    FIELD( S, char, name, [ 32 ], FIELD_KIND_FLAG( FIELD_KIND_BYTES ) )     \
+    NESTED( S, Transform, transform, 0 )                                    \
+    NESTED( S, Health, health, 0 )                                          \
+    FIELD( S, float, speed, , FIELD_EDITABLE )                              \
+    FIELD( S, uint32_t, flags, , FIELD_KIND_FLAG( FIELD_KIND_UINT32 ) )
 
-typedef struct Player
-{
-    uint32_t  id;
-    char      name[ 32 ];
-    Transform transform;
-    Health    health;
-    float     speed;
-    uint32_t  flags;
+// Replication precision, one { min, max, bits } row per field - the body of a
+// FieldQuant table wherever reflection_core.h is included. Transform replicates
+// at world precision: 1/128 unit, 0.1 degree.
+#define TRANSFORM_QUANTS                   \
+    { -4096.0f, 4096.0f, 20 },             \
+    { -3.14159265f, 3.14159265f, 12 },     \
+    { 0, 0, 0 }
+
+#define HEALTH_QUANTS           \
+    { 0.0f, 1000.0f, 14 },      \
+    { 0.0f, 1000.0f, 10 },      \
+    { 0.0f, 100.0f, 10 }
 
-} Player;
+TYPE_STRUCT( Vec3, VEC3_FIELDS );
+TYPE_STRUCT( Transform, TRANSFORM_FIELDS );
+TYPE_STRUCT( Health, HEALTH_FIELDS );
+TYPE_STRUCT( Player, PLAYER_FIELDS );
 
 // Field indices - the "contract" for fast access
 enum
@@ -51,4 +64,13 @@ enum
     PLAYER_FLAGS     = 5,
 };
 
+// Reordering PLAYER_FIELDS without updating the contract is a compile error
+_Static_assert( (int)PLAYER_ID == (int)TYPE_FIELD_Player_id, "PLAYER_ID out of step with Player" );
+_Static_assert( (int)PLAYER_NAME == (int)TYPE_FIELD_Player_name, "PLAYER_NAME out of step with Player" );
+_Static_assert( (int)PLAYER_TRANSFORM == (int)TYPE_FIELD_Player_transform, "PLAYER_TRANSFORM out of step with Player" );
+_Static_assert( (int)PLAYER_HEALTH == (int)TYPE_FIELD_Player_health, "PLAYER_HEALTH out of step with Player" );
+_Static_assert( (int)PLAYER_SPEED == (int)TYPE_FIELD_Player_speed, "PLAYER_SPEED out of step with Player" );
+_Static_assert( (int)PLAYER_FLAGS == (int)TYPE_FIELD_Player_flags, "PLAYER_FLAGS out of step with Player" );
+_Static_assert( TYPE_FIELD_COUNT_Player == 6, "Player field added without a PLAYER_ index" );
+
 #endif    // GAME_TYPES_H
\ No newline at end of file
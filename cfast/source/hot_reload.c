@@ -2,23 +2,31 @@
 // hot_reload.c - Hot reload system
 // ============================================================================
 #define _CRT_SECURE_NO_WARNINGS
+#define _GNU_SOURCE    // memfd_create, inotify, dlopen
 
-#include "reflection_core.h"    // reflection data ModuleInfo defintion
+#include "hot_reload.h"          // reflection data ModuleInfo defintion
+#include "serialize_binary.h"    // copy plans are stale once types re-register
+#include "trace.h"               // per-phase zones
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef void* ( *GetStateFunc )( void );
+typedef ModuleInfo* ( *GetInfoFunc )( void );
 
 #ifdef _WIN32
 #    include <windows.h>
 
 // ============================================================================
 
-typedef struct Module
+struct Module
 {
     HMODULE     handle;
     ModuleInfo* info;
     void*       state;
     const char* path;
     FILETIME    last_write_time;
-} Module;
+};
 
 int
 check_module_changed( Module* mod )
@@ -41,57 +49,569 @@ void
 reload_module( Module* mod )
 {
     printf( "Reloading %s...\n", mod->path );
+    TRACE_BEGIN( reload, "reload_module" );
 
     // Get current state
-    typedef void* ( *GetStateFunc )( void );
     GetStateFunc get_state = (GetStateFunc)GetProcAddress( mod->handle, "get_module_state" );
     if ( get_state )
     {
         mod->state = get_state();
     }
 
+    // Readers on other threads keep seeing the old types until the new ones are all in
+    registry_write_begin();
+
     // Unregister old types
+    TRACE_BEGIN( unregister, "module/unregister" );
     if ( mod->info && mod->info->unregister_types )
     {
         mod->info->unregister_types( &g_registry );
     }
+    TRACE_END( unregister );
 
     // Unload old DLL
+    TRACE_BEGIN( unload, "module/unload" );
     FreeLibrary( mod->handle );
+    TRACE_END( unload );
 
     // Copy DLL to temp file (so we can rebuild while running)
+    TRACE_BEGIN( copy, "module/copy" );
     char temp_path[ 256 ];
     sprintf( temp_path, "%s.tmp", mod->path );
     CopyFile( mod->path, temp_path, FALSE );
+    TRACE_END( copy );
 
     // Load new DLL
+    TRACE_BEGIN( load, "module/load" );
     mod->handle = LoadLibrary( temp_path );
+    TRACE_END( load );
     if ( mod->handle == NULL )
     {
         printf( "Module failed to load %s...\n", mod->path );
+        registry_write_end();
+        TRACE_END( reload );
         return;
     }
 
     // Get module info
-    typedef ModuleInfo* ( *GetInfoFunc )( void );
     GetInfoFunc get_info = (GetInfoFunc)GetProcAddress( mod->handle, "get_module_info" );
     if ( get_info )
     {
         mod->info = get_info();
 
         // Register new types
+        TRACE_BEGIN( register_types, "module/register" );
         if ( mod->info->register_types )
         {
             mod->info->register_types( &g_registry );
         }
+        copy_plan_flush();
+        TRACE_END( register_types );
 
         // Restore state
+        TRACE_BEGIN( fixup, "module/fixup" );
         if ( mod->info->hot_reload_fixup )
         {
             mod->info->hot_reload_fixup( &g_registry, mod->state );
         }
+        TRACE_END( fixup );
     }
+    registry_write_end();
+    TRACE_END( reload );
 }
 
+Module*
+module_open( const char* path )
+{
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if ( !GetFileAttributesEx( path, GetFileExInfoStandard, &data ) )
+    {
+        printf( "Module not found %s...\n", path );
+        return NULL;
+    }
+
+    Module* mod          = (Module*)calloc( 1, sizeof( Module ) );
+    mod->path            = path;
+    mod->last_write_time = data.ftLastWriteTime;
+
+    char temp_path[ 256 ];
+    sprintf( temp_path, "%s.tmp", path );
+    CopyFile( path, temp_path, FALSE );
+
+    mod->handle = LoadLibrary( temp_path );
+    if ( mod->handle == NULL )
+    {
+        printf( "Module failed to load %s...\n", path );
+        free( mod );
+        return NULL;
+    }
+
+    GetInfoFunc get_info = (GetInfoFunc)GetProcAddress( mod->handle, "get_module_info" );
+    if ( get_info )
+    {
+        mod->info = get_info();
+        if ( mod->info->register_types )
+        {
+            registry_write_begin();    // The module's types appear all at once
+            mod->info->register_types( &g_registry );
+            registry_write_end();
+        }
+    }
+    return mod;
+}
+
+void
+module_close( Module* mod )
+{
+    if ( !mod )
+        return;
+    if ( mod->info && mod->info->unregister_types )
+    {
+        registry_write_begin();
+        mod->info->unregister_types( &g_registry );
+        registry_write_end();
+    }
+    FreeLibrary( mod->handle );
+    free( mod );
+}
+
+void*
+module_get_symbol( Module* mod, const char* name )
+{
+    return (void*)GetProcAddress( mod->handle, name );
+}
+
+// ============================================================================
+#else    // Linux: dlopen + inotify
+#    include <dlfcn.h>
+#    include <errno.h>
+#    include <fcntl.h>
+#    include <limits.h>
+#    include <poll.h>
+#    include <sys/inotify.h>
+#    include <sys/mman.h>
+#    include <time.h>
+#    include <unistd.h>
+
+// ============================================================================
+
+struct Module
+{
+    void*       handle;       // dlopen handle of the shadow copy
+    ModuleInfo* info;
+    void*       state;
+    const char* path;         // Points into path_buf
+    const char* file_name;    // Basename of path, matched against inotify events
+
+    int      shadow_fd;       // memfd backing the loaded copy (-1 for the file fallback)
+    int      watch;           // inotify watch on the containing directory
+    int      pending;         // File events seen since last reload
+    uint64_t last_event_ns;
+    uint32_t generation;      // Successful loads, names fallback shadow files
+
+    char path_buf[ PATH_MAX ];
+    char shadow_path[ PATH_MAX ];
+};
+
+// One inotify instance for every module, so per-frame cost does not grow with module count
+static int     s_inotify_fd = -1;
+static Module* s_modules[ MAX_MODULES ];
+static int     s_module_count;
+
+static uint64_t
+now_ns( void )
+{
+    struct timespec ts;
+    clock_gettime( CLOCK_MONOTONIC, &ts );    // vDSO, no syscall
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// ============================================================================
+// Shadow copy - dlopen the bytes, never the file the linker is rewriting
 // ============================================================================
-#endif
\ No newline at end of file
+
+static int
+copy_fd( int src, int dst )
+{
+    char    buffer[ 64 * 1024 ];
+    ssize_t n;
+    while ( ( n = read( src, buffer, sizeof( buffer ) ) ) > 0 )
+    {
+        for ( ssize_t done = 0; done < n; )
+        {
+            ssize_t w = write( dst, buffer + done, (size_t)( n - done ) );
+            if ( w < 0 && errno != EINTR )
+                return 0;
+            if ( w > 0 )
+                done += w;
+        }
+    }
+    return n == 0;
+}
+
+static void
+shadow_release( Module* mod )
+{
+    if ( mod->shadow_fd >= 0 )
+        close( mod->shadow_fd );
+    else if ( mod->shadow_path[ 0 ] )
+        unlink( mod->shadow_path );
+    mod->shadow_fd        = -1;
+    mod->shadow_path[ 0 ] = 0;
+}
+
+// Copy the module into an anonymous memfd (fallback: a uniquely named temp
+// file) and dlopen that. The memfd stays open while loaded so its
+// /proc/self/fd name can't alias a newer copy still in the dlopen cache.
+static void*
+shadow_load( Module* mod, int* out_fd, char* out_path )
+{
+    int src = open( mod->path, O_RDONLY | O_CLOEXEC );
+    if ( src < 0 )
+        return NULL;
+
+    int dst      = memfd_create( mod->file_name, MFD_CLOEXEC );
+    int is_memfd = dst >= 0;
+    if ( is_memfd )
+    {
+        snprintf( out_path, PATH_MAX, "/proc/self/fd/%d", dst );
+    }
+    else
+    {
+        snprintf( out_path, PATH_MAX, "%s.%u.tmp", mod->path, mod->generation );
+        dst = open( out_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0755 );
+    }
+
+    TRACE_BEGIN( copy, "module/copy" );
+    int copied = dst >= 0 && copy_fd( src, dst );
+    close( src );
+    TRACE_END( copy );
+
+    TRACE_BEGIN( load, "module/load" );
+    void* handle = copied ? dlopen( out_path, RTLD_NOW | RTLD_LOCAL ) : NULL;
+    TRACE_END( load );
+    if ( !handle )
+    {
+        printf( "Module failed to load %s: %s\n", mod->path, copied ? dlerror() : strerror( errno ) );
+    }
+
+    if ( dst >= 0 && !( handle && is_memfd ) )
+    {
+        // Failed load, or the temp file fallback: the mapping keeps the code alive
+        close( dst );
+        dst = -1;
+        if ( !handle && !is_memfd )
+            unlink( out_path );
+    }
+    if ( !handle )
+        out_path[ 0 ] = 0;
+
+    *out_fd = dst;
+    return handle;
+}
+
+// ============================================================================
+// File watching
+// ============================================================================
+
+static int
+watch_module( Module* mod )
+{
+    if ( s_inotify_fd < 0 )
+    {
+        s_inotify_fd = inotify_init1( IN_NONBLOCK | IN_CLOEXEC );
+        if ( s_inotify_fd < 0 )
+            return 0;
+    }
+
+    // Watch the directory, not the file: linkers typically unlink and recreate
+    // their output, which would silently drop a watch on the old inode.
+    char   dir[ PATH_MAX ] = ".";
+    size_t dir_len         = (size_t)( mod->file_name - mod->path_buf );
+    if ( dir_len > 1 )
+    {
+        memcpy( dir, mod->path_buf, dir_len - 1 );
+        dir[ dir_len - 1 ] = 0;
+    }
+    else if ( dir_len == 1 )
+    {
+        strcpy( dir, "/" );
+    }
+
+    mod->watch =
+        inotify_add_watch( s_inotify_fd, dir, IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_MOVED_TO );
+    return mod->watch >= 0;
+}
+
+// Watches are per directory and inotify hands every module in one directory the
+// same descriptor, so a watch goes only once no open module shares it
+static void
+unwatch_module( Module* mod )
+{
+    if ( s_inotify_fd < 0 )
+        return;
+
+    if ( s_module_count == 0 )
+    {
+        close( s_inotify_fd );
+        s_inotify_fd = -1;
+        return;
+    }
+    if ( mod->watch < 0 )
+        return;
+
+    for ( int i = 0; i < s_module_count; i++ )
+    {
+        if ( s_modules[ i ] != mod && s_modules[ i ]->watch == mod->watch )
+            return;
+    }
+    inotify_rm_watch( s_inotify_fd, mod->watch );
+    mod->watch = -1;
+}
+
+int
+hot_reload_fd( void )
+{
+    return s_inotify_fd;
+}
+
+int
+hot_reload_poll( void )
+{
+    if ( s_inotify_fd < 0 )
+        return 0;
+
+    _Alignas( struct inotify_event ) char buffer[ 4096 ];
+    for ( ;; )
+    {
+        ssize_t len = read( s_inotify_fd, buffer, sizeof( buffer ) );
+        if ( len <= 0 )
+            break;    // EAGAIN: drained
+
+        uint64_t now = now_ns();
+        for ( char* p = buffer; p < buffer + len; )
+        {
+            struct inotify_event* ev = (struct inotify_event*)p;
+            p += sizeof( struct inotify_event ) + ev->len;
+            if ( !ev->len )
+                continue;
+
+            for ( int i = 0; i < s_module_count; i++ )
+            {
+                Module* mod = s_modules[ i ];
+                if ( mod->watch == ev->wd && strcmp( mod->file_name, ev->name ) == 0 )
+                {
+                    // Every event of the burst just pushes the deadline out
+                    mod->pending       = 1;
+                    mod->last_event_ns = now;
+                }
+            }
+        }
+    }
+
+    int pending = 0;
+    for ( int i = 0; i < s_module_count; i++ ) pending += s_modules[ i ]->pending;
+    return pending;
+}
+
+int
+hot_reload_wait( int timeout_ms )
+{
+    if ( s_inotify_fd < 0 )
+        return 0;
+
+    // Never sleep past the moment a pending burst settles
+    uint64_t now = now_ns();
+    for ( int i = 0; i < s_module_count; i++ )
+    {
+        Module* mod = s_modules[ i ];
+        if ( mod->pending )
+        {
+            uint64_t deadline = mod->last_event_ns + HOT_RELOAD_SETTLE_MS * 1000000ull;
+            int      left     = deadline > now ? (int)( ( deadline - now ) / 1000000ull ) + 1 : 0;
+            if ( timeout_ms < 0 || left < timeout_ms )
+                timeout_ms = left;
+        }
+    }
+
+    struct pollfd pfd = { .fd = s_inotify_fd, .events = POLLIN };
+    poll( &pfd, 1, timeout_ms );
+    return hot_reload_poll();
+}
+
+int
+check_module_changed( Module* mod )
+{
+    if ( !mod->pending )
+        return 0;
+    if ( now_ns() - mod->last_event_ns < HOT_RELOAD_SETTLE_MS * 1000000ull )
+        return 0;
+
+    mod->pending = 0;
+    return 1;
+}
+
+// ============================================================================
+// Load / reload
+// ============================================================================
+
+static void
+bind_module_info( Module* mod )
+{
+    GetInfoFunc get_info;
+    *(void**)&get_info = dlsym( mod->handle, "get_module_info" );    // POSIX dlsym idiom
+    mod->info          = get_info ? get_info() : NULL;
+}
+
+void
+reload_module( Module* mod )
+{
+    printf( "Reloading %s...\n", mod->path );
+    TRACE_BEGIN( reload, "reload_module" );
+
+    // Load the new copy first - if the build is broken, keep running the old code
+    int   new_fd;
+    char  new_path[ PATH_MAX ];
+    void* new_handle = shadow_load( mod, &new_fd, new_path );
+    if ( !new_handle )
+    {
+        TRACE_END( reload );
+        return;
+    }
+
+    // Get current state
+    GetStateFunc get_state;
+    *(void**)&get_state = dlsym( mod->handle, "get_module_state" );
+    if ( get_state )
+    {
+        mod->state = get_state();
+    }
+
+    // Readers on other threads keep seeing the old types until the new ones are all in
+    registry_write_begin();
+
+    // Unregister old types
+    TRACE_BEGIN( unregister, "module/unregister" );
+    if ( mod->info && mod->info->unregister_types )
+    {
+        mod->info->unregister_types( &g_registry );
+    }
+    TRACE_END( unregister );
+
+    // Unload old copy
+    TRACE_BEGIN( unload, "module/unload" );
+    dlclose( mod->handle );
+    shadow_release( mod );
+    TRACE_END( unload );
+
+    mod->handle    = new_handle;
+    mod->shadow_fd = new_fd;
+    memcpy( mod->shadow_path, new_path, sizeof( new_path ) );
+    mod->generation++;
+
+    bind_module_info( mod );
+    if ( mod->info )
+    {
+        // Register new types
+        TRACE_BEGIN( register_types, "module/register" );
+        if ( mod->info->register_types )
+        {
+            mod->info->register_types( &g_registry );
+        }
+        copy_plan_flush();
+        TRACE_END( register_types );
+
+        // Restore state
+        TRACE_BEGIN( fixup, "module/fixup" );
+        if ( mod->info->hot_reload_fixup )
+        {
+            mod->info->hot_reload_fixup( &g_registry, mod->state );
+        }
+        TRACE_END( fixup );
+    }
+    registry_write_end();
+    TRACE_END( reload );
+}
+
+Module*
+module_open( const char* path )
+{
+    if ( s_module_count >= MAX_MODULES || strlen( path ) >= PATH_MAX )
+        return NULL;
+
+    Module* mod    = (Module*)calloc( 1, sizeof( Module ) );
+    mod->shadow_fd = -1;
+    mod->watch     = -1;
+    strcpy( mod->path_buf, path );
+    mod->path = mod->path_buf;
+
+    const char* slash = strrchr( mod->path_buf, '/' );
+    mod->file_name    = slash ? slash + 1 : mod->path_buf;
+
+    if ( !watch_module( mod ) )
+    {
+        printf( "Module watch failed %s: %s\n", path, strerror( errno ) );
+    }
+
+    mod->handle = shadow_load( mod, &mod->shadow_fd, mod->shadow_path );
+    if ( !mod->handle )
+    {
+        unwatch_module( mod );
+        free( mod );
+        return NULL;
+    }
+    mod->generation++;
+    s_modules[ s_module_count++ ] = mod;
+
+    bind_module_info( mod );
+    if ( mod->info && mod->info->register_types )
+    {
+        registry_write_begin();    // The module's types appear all at once
+        mod->info->register_types( &g_registry );
+        registry_write_end();
+    }
+    return mod;
+}
+
+void
+module_close( Module* mod )
+{
+    if ( !mod )
+        return;
+
+    if ( mod->info && mod->info->unregister_types )
+    {
+        registry_write_begin();
+        mod->info->unregister_types( &g_registry );
+        registry_write_end();
+    }
+    dlclose( mod->handle );
+    shadow_release( mod );
+
+    for ( int i = 0; i < s_module_count; i++ )
+    {
+        if ( s_modules[ i ] == mod )
+        {
+            s_modules[ i ] = s_modules[ --s_module_count ];
+            break;
+        }
+    }
+
+    unwatch_module( mod );
+    free( mod );
+}
+
+void*
+module_get_symbol( Module* mod, const char* name )
+{
+    return dlsym( mod->handle, name );
+}
+
+// ============================================================================
+#endif
+
+ModuleInfo*
+module_get_info( Module* mod )
+{
+    return mod->info;
+}
@@ -0,0 +1,38 @@
+// ============================================================================
+// hot_reload.h - Hot reload system
+// ============================================================================
+
+#ifndef HOT_RELOAD_H
+#define HOT_RELOAD_H
+
+#include "reflection_core.h"    // reflection data ModuleInfo defintion
+
+// Quiet period after the last file event before a reload fires. A linker
+// writes its output in many chunks (and may rename it into place), so every
+// event inside this window collapses into a single reload.
+#define HOT_RELOAD_SETTLE_MS 150
+
+// Loaded module - platform fields live in hot_reload.c
+typedef struct Module Module;
+
+// Load a module from path and register its types.
+Module* module_open( const char* path );
+void    module_close( Module* mod );
+
+// Returns 1 once the module file changed (and, on Linux, the write burst settled).
+int  check_module_changed( Module* mod );
+void reload_module( Module* mod );
+
+ModuleInfo* module_get_info( Module* mod );
+void*       module_get_symbol( Module* mod, const char* name );
+
+#ifndef _WIN32
+// Linux: one inotify descriptor is shared by every open module. Call
+// hot_reload_poll once per frame (a single non-blocking read for all modules),
+// or block in hot_reload_wait when idle. check_module_changed never syscalls.
+int hot_reload_fd( void );
+int hot_reload_poll( void );              // Returns number of modules with pending changes
+int hot_reload_wait( int timeout_ms );    // Blocks until an event or timeout, then polls
+#endif
+
+#endif    // HOT_RELOAD_H
@@ -0,0 +1,497 @@
+// ============================================================================
+// job_system.c - Work-stealing job scheduler for per-entity passes
+// ============================================================================
+#ifndef _WIN32
+#    define _POSIX_C_SOURCE 200809L    // sysconf
+#endif
+
+#include "job_system.h"
+#include "sync.h"
+#include "trace.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#    include <windows.h>
+#else
+#    include <pthread.h>
+#    include <unistd.h>
+#endif
+
+#define JOB_DEQUE_MASK  ( JOB_DEQUE_SIZE - 1 )
+#define JOB_SPIN_ROUNDS 2048    // Failed steal rounds before a worker sleeps
+
+_Static_assert( ( JOB_DEQUE_SIZE & JOB_DEQUE_MASK ) == 0, "deque size must be a power of two" );
+_Static_assert( ( JOB_SPLIT_ALIGN & ( JOB_SPLIT_ALIGN - 1 ) ) == 0, "split alignment must be a power of two" );
+
+// ============================================================================
+// Scheduler state
+// ============================================================================
+
+// Chase-Lev deque (Le, Pop, Cohen, Zappa Nardelli 2013), fixed size
+typedef struct JobDeque
+{
+    volatile int64_t top;       // Thieves take from here
+    char             pad0[ 56 ];
+    volatile int64_t bottom;    // The owner pushes and pops here
+    char             pad1[ 56 ];
+    uint32_t         rng;       // Victim choice, owner only
+    Job              jobs[ JOB_DEQUE_SIZE ];
+
+} JobDeque;
+
+static JobDeque*        s_deques;          // One per thread, slot 0 is the init thread
+static volatile int32_t s_thread_count;    // 0 when not running
+static volatile int32_t s_stop;
+static volatile int32_t s_wake;            // Bumped on every push, sleepers compare against it
+static volatile int32_t s_sleepers;
+
+#ifdef _WIN32
+static HANDLE             s_threads[ JOB_MAX_THREADS ];
+static SRWLOCK            s_sleep_lock = SRWLOCK_INIT;
+static CONDITION_VARIABLE s_sleep_cond = CONDITION_VARIABLE_INIT;
+#else
+static pthread_t       s_threads[ JOB_MAX_THREADS ];
+static pthread_mutex_t s_sleep_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  s_sleep_cond = PTHREAD_COND_INITIALIZER;
+#endif
+
+static SYNC_THREAD_LOCAL int t_slot = -1;    // This thread's deque, -1 = runs jobs inline
+
+// ============================================================================
+// Deque
+// ============================================================================
+
+static int
+deque_push( JobDeque* d, const Job* job )
+{
+    int64_t b = d->bottom;
+    int64_t t = sync_load64( &d->top );
+    if ( b - t >= JOB_DEQUE_SIZE )
+        return 0;
+    d->jobs[ b & JOB_DEQUE_MASK ] = *job;
+    sync_store64( &d->bottom, b + 1 );
+    return 1;
+}
+
+static int
+deque_pop( JobDeque* d, Job* out )
+{
+    int64_t b = d->bottom - 1;
+    sync_store64( &d->bottom, b );
+    sync_fence();
+    int64_t t = sync_load64( &d->top );
+    if ( t > b )
+    {
+        sync_store64( &d->bottom, b + 1 );
+        return 0;
+    }
+
+    *out = d->jobs[ b & JOB_DEQUE_MASK ];
+    if ( t < b )
+        return 1;
+
+    // Last job: race the thieves for it
+    int won = sync_cas64( &d->top, t, t + 1 );
+    sync_store64( &d->bottom, b + 1 );
+    return won;
+}
+
+static int
+deque_steal( JobDeque* d, Job* out )
+{
+    int64_t t = sync_load64( &d->top );
+    sync_fence();
+    int64_t b = sync_load64( &d->bottom );
+    if ( t >= b )
+        return 0;
+    *out = d->jobs[ t & JOB_DEQUE_MASK ];
+    return sync_cas64( &d->top, t, t + 1 );
+}
+
+// ============================================================================
+// Running jobs
+// ============================================================================
+
+static void job_execute( Job job );
+
+static void
+job_wake( void )
+{
+    sync_add32( &s_wake, 1 );
+    if ( sync_load32( &s_sleepers ) == 0 )
+        return;
+#ifdef _WIN32
+    AcquireSRWLockExclusive( &s_sleep_lock );
+    WakeConditionVariable( &s_sleep_cond );
+    ReleaseSRWLockExclusive( &s_sleep_lock );
+#else
+    pthread_mutex_lock( &s_sleep_lock );
+    pthread_cond_signal( &s_sleep_cond );
+    pthread_mutex_unlock( &s_sleep_lock );
+#endif
+}
+
+// Onto this thread's deque; 0 if it has none or it is full
+static int
+job_push( const Job* job )
+{
+    if ( t_slot < 0 || !deque_push( &s_deques[ t_slot ], job ) )
+        return 0;
+    job_wake();
+    return 1;
+}
+
+static void
+job_push_or_run( const Job* job )
+{
+    if ( !job_push( job ) )
+        job_execute( *job );
+}
+
+// Own deque first, then one pass over the others from a random victim
+static int
+job_take( int slot, Job* out )
+{
+    JobDeque* self = &s_deques[ slot ];
+    if ( deque_pop( self, out ) )
+        return 1;
+
+    int thread_count = sync_load32( &s_thread_count );
+    self->rng ^= self->rng << 13;
+    self->rng ^= self->rng >> 17;
+    self->rng ^= self->rng << 5;
+    for ( int i = 0; i < thread_count; i++ )
+    {
+        int victim = (int)( ( self->rng + (uint32_t)i ) % (uint32_t)thread_count );
+        if ( victim != slot && deque_steal( &s_deques[ victim ], out ) )
+            return 1;
+    }
+    return 0;
+}
+
+static void
+counter_lock( JobCounter* counter )
+{
+    while ( !sync_cas32( &counter->lock, 0, 1 ) ) sync_pause();
+}
+
+static void
+counter_unlock( JobCounter* counter )
+{
+    sync_store32( &counter->lock, 0 );
+}
+
+// The drop to zero happens under the lock, so job_wait can tell when the finisher is done with the counter
+static void
+job_finish( JobCounter* counter )
+{
+    if ( !counter )
+        return;
+
+    Job      ready[ JOB_MAX_CONTINUATIONS ];
+    uint32_t ready_count = 0;
+    counter_lock( counter );
+    if ( sync_add32( &counter->pending, -1 ) == 0 )
+    {
+        ready_count = counter->continuation_count;
+        memcpy( ready, counter->continuations, ready_count * sizeof( Job ) );
+        counter->continuation_count = 0;
+    }
+    counter_unlock( counter );
+
+    // Their own counters were raised by job_submit_after
+    for ( uint32_t i = 0; i < ready_count; i++ ) job_push_or_run( &ready[ i ] );
+}
+
+// Keeps the lower half of a range and pushes the upper, so thieves find the biggest pieces.
+// The grain rounds up to JOB_SPLIT_ALIGN, so the aligned half of a longer range stays inside it.
+static void
+job_execute( Job job )
+{
+    job.grain = ( job.grain + JOB_SPLIT_ALIGN - 1 ) & ~( JOB_SPLIT_ALIGN - 1u );
+    while ( job.grain && job.end - job.begin > job.grain )
+    {
+        uint32_t half  = ( ( job.end - job.begin ) / 2 + JOB_SPLIT_ALIGN - 1 ) & ~( JOB_SPLIT_ALIGN - 1u );
+        Job      upper = job;
+        upper.begin    = job.begin + half;
+        if ( upper.counter )
+            sync_add32( &upper.counter->pending, 1 );
+        if ( !job_push( &upper ) )
+        {
+            if ( upper.counter )
+                sync_add32( &upper.counter->pending, -1 );
+            break;
+        }
+        job.end = upper.begin;
+    }
+
+    job.func( job.data, job.begin, job.end );
+    job_finish( job.counter );
+}
+
+// ============================================================================
+// Workers
+// ============================================================================
+
+static void
+job_worker_loop( int slot )
+{
+    t_slot               = slot;
+    s_deques[ slot ].rng = 0x9E3779B9u * (uint32_t)( slot + 1 );
+    int idle             = 0;
+    trace_thread_name( "Job worker" );
+    while ( !sync_load32( &s_stop ) )
+    {
+        int32_t wake = sync_load32( &s_wake );
+        Job     job;
+        if ( job_take( slot, &job ) )
+        {
+            job_execute( job );
+            idle = 0;
+            continue;
+        }
+        if ( ++idle < JOB_SPIN_ROUNDS )
+        {
+            sync_pause();
+            continue;
+        }
+
+        // Sleepers is raised before wake is checked again: a push either sees it or bumped wake first
+#ifdef _WIN32
+        AcquireSRWLockExclusive( &s_sleep_lock );
+        sync_add32( &s_sleepers, 1 );
+        if ( sync_load32( &s_wake ) == wake && !sync_load32( &s_stop ) )
+            SleepConditionVariableSRW( &s_sleep_cond, &s_sleep_lock, INFINITE, 0 );
+        sync_add32( &s_sleepers, -1 );
+        ReleaseSRWLockExclusive( &s_sleep_lock );
+#else
+        pthread_mutex_lock( &s_sleep_lock );
+        sync_add32( &s_sleepers, 1 );
+        if ( sync_load32( &s_wake ) == wake && !sync_load32( &s_stop ) )
+            pthread_cond_wait( &s_sleep_cond, &s_sleep_lock );
+        sync_add32( &s_sleepers, -1 );
+        pthread_mutex_unlock( &s_sleep_lock );
+#endif
+        idle = 0;
+    }
+    t_slot = -1;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI
+job_worker_thread( LPVOID arg )
+{
+    job_worker_loop( (int)(intptr_t)arg );
+    return 0;
+}
+#else
+static void*
+job_worker_thread( void* arg )
+{
+    job_worker_loop( (int)(intptr_t)arg );
+    return NULL;
+}
+#endif
+
+static int
+job_core_count( void )
+{
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo( &info );
+    return (int)info.dwNumberOfProcessors;
+#else
+    long cores = sysconf( _SC_NPROCESSORS_ONLN );
+    return cores > 0 ? (int)cores : 1;
+#endif
+}
+
+// ============================================================================
+// Init / shutdown
+// ============================================================================
+
+int
+job_system_init( int worker_count )
+{
+    if ( s_thread_count )
+        return s_thread_count;
+    if ( worker_count <= 0 )
+        worker_count = job_core_count() - 1;
+    if ( worker_count > JOB_MAX_THREADS - 1 )
+        worker_count = JOB_MAX_THREADS - 1;
+    if ( worker_count < 0 )
+        worker_count = 0;
+
+    s_deques = (JobDeque*)calloc( (size_t)worker_count + 1, sizeof( JobDeque ) );
+    if ( !s_deques )
+        return 1;
+    s_stop            = 0;
+    s_deques[ 0 ].rng = 0x9E3779B9u;
+    t_slot            = 0;
+
+    // Workers read the count to pick victims; it only grows while they start
+    int started = 1;
+    sync_store32( &s_thread_count, 1 );
+    for ( int slot = 1; slot <= worker_count; slot++ )
+    {
+#ifdef _WIN32
+        s_threads[ slot ] = CreateThread( NULL, 0, job_worker_thread, (LPVOID)(intptr_t)slot, 0, NULL );
+        if ( !s_threads[ slot ] )
+            break;
+#else
+        if ( pthread_create( &s_threads[ slot ], NULL, job_worker_thread, (void*)(intptr_t)slot ) != 0 )
+            break;
+#endif
+        sync_store32( &s_thread_count, ++started );
+    }
+    return started;
+}
+
+void
+job_system_shutdown( void )
+{
+    int thread_count = s_thread_count;
+    if ( !thread_count )
+        return;
+
+    sync_store32( &s_stop, 1 );
+#ifdef _WIN32
+    AcquireSRWLockExclusive( &s_sleep_lock );
+    WakeAllConditionVariable( &s_sleep_cond );
+    ReleaseSRWLockExclusive( &s_sleep_lock );
+    for ( int slot = 1; slot < thread_count; slot++ )
+    {
+        WaitForSingleObject( s_threads[ slot ], INFINITE );
+        CloseHandle( s_threads[ slot ] );
+    }
+#else
+    pthread_mutex_lock( &s_sleep_lock );
+    pthread_cond_broadcast( &s_sleep_cond );
+    pthread_mutex_unlock( &s_sleep_lock );
+    for ( int slot = 1; slot < thread_count; slot++ ) pthread_join( s_threads[ slot ], NULL );
+#endif
+
+    free( s_deques );
+    s_deques       = NULL;
+    s_thread_count = 0;
+    t_slot         = -1;
+}
+
+int
+job_thread_count( void )
+{
+    int thread_count = sync_load32( &s_thread_count );
+    return thread_count ? thread_count : 1;
+}
+
+// ============================================================================
+// Submit / wait
+// ============================================================================
+
+void
+job_submit( const Job* job )
+{
+    if ( job->counter )
+        sync_add32( &job->counter->pending, 1 );
+    job_push_or_run( job );
+}
+
+int
+job_submit_after( const Job* job, JobCounter* dependency )
+{
+    counter_lock( dependency );
+    if ( sync_load32( &dependency->pending ) == 0 )
+    {
+        counter_unlock( dependency );
+        job_submit( job );
+        return 1;
+    }
+    if ( dependency->continuation_count == JOB_MAX_CONTINUATIONS )
+    {
+        counter_unlock( dependency );
+        return 0;
+    }
+    if ( job->counter )
+        sync_add32( &job->counter->pending, 1 );
+    dependency->continuations[ dependency->continuation_count++ ] = *job;
+    counter_unlock( dependency );
+    return 1;
+}
+
+void
+job_wait( JobCounter* counter )
+{
+    while ( sync_load32( &counter->pending ) > 0 )
+    {
+        Job job;
+        if ( t_slot >= 0 && job_take( t_slot, &job ) )
+            job_execute( job );
+        else
+            sync_pause();
+    }
+
+    // The last finisher may still hold the lock; after this the counter can go away
+    while ( sync_load32( &counter->lock ) ) sync_pause();
+}
+
+// ============================================================================
+// Parallel for
+// ============================================================================
+
+static uint32_t
+job_grain( uint32_t count, uint32_t min_grain )
+{
+    uint32_t grain = count / ( 8u * (uint32_t)job_thread_count() );
+    if ( grain < min_grain )
+        grain = min_grain;
+    grain = ( grain + JOB_SPLIT_ALIGN - 1 ) & ~( JOB_SPLIT_ALIGN - 1u );
+    return grain ? grain : JOB_SPLIT_ALIGN;
+}
+
+// Nobody to share with: no deque on this thread, no workers, or a single chunk
+static int
+job_run_inline( uint32_t count, uint32_t grain )
+{
+    return t_slot < 0 || sync_load32( &s_thread_count ) < 2 || count <= grain;
+}
+
+void
+job_parallel_for_async( uint32_t count, uint32_t min_grain, JobFunc func, void* data, JobCounter* counter )
+{
+    uint32_t grain = job_grain( count, min_grain );
+    if ( count == 0 )
+        return;
+    if ( job_run_inline( count, grain ) )
+    {
+        func( data, 0, count );
+        return;
+    }
+
+    Job root = { func, data, 0, count, grain, counter };
+    job_submit( &root );
+}
+
+void
+job_parallel_for( uint32_t count, uint32_t min_grain, JobFunc func, void* data )
+{
+    uint32_t grain = job_grain( count, min_grain );
+    if ( count == 0 )
+        return;
+    if ( job_run_inline( count, grain ) )
+    {
+        func( data, 0, count );
+        return;
+    }
+
+    // The caller splits and works on the range itself, the other threads steal halves
+    JobCounter counter;
+    memset( &counter, 0, sizeof( counter ) );
+    counter.pending = 1;
+    Job root        = { func, data, 0, count, grain, &counter };
+    job_execute( root );
+    job_wait( &counter );
+}
+
+// ============================================================================
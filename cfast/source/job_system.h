@@ -0,0 +1,70 @@
+// ============================================================================
+// job_system.h - Work-stealing job scheduler for per-entity passes
+// ============================================================================
+//
+// One deque per thread: the thread that called job_system_init (slot 0) plus
+// the workers. A thread pushes and pops the bottom of its own deque (newest
+// first, still in cache); idle threads steal from the top of another's (the
+// oldest, i.e. the biggest piece of a split range). Workers that find
+// nothing spin briefly, then sleep until the next submit.
+//
+// job_parallel_for hands a range out as one job that keeps halving itself
+// down to a grain of about count / ( 8 * threads ), so there is no chunk size
+// to tune and a thief always takes the largest piece left. Split points are
+// multiples of JOB_SPLIT_ALIGN elements: no two chunks of a float column
+// share a cache line, and the SIMD kernels see whole vectors.
+//
+// A JobCounter tracks jobs submitted against it. job_wait runs other jobs
+// until it drops to zero; job_submit_after queues a job to start when it
+// does, so dependency chains do not block a thread.
+//
+// Submit from the init thread or from inside jobs. Other threads, and every
+// thread before job_system_init, run jobs inline - code written against this
+// header works unchanged in tools and tests.
+
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <stdint.h>
+
+#define JOB_MAX_THREADS       64      // Init thread included
+#define JOB_DEQUE_SIZE        1024    // Per thread, power of two; a full deque runs jobs inline
+#define JOB_MAX_CONTINUATIONS 8       // Jobs waiting on one counter
+#define JOB_SPLIT_ALIGN       64      // Elements, range split granularity
+
+typedef void ( *JobFunc )( void* data, uint32_t begin, uint32_t end );
+
+typedef struct Job
+{
+    JobFunc             func;
+    void*               data;
+    uint32_t            begin;
+    uint32_t            end;
+    uint32_t            grain;      // Split in halves while longer, rounded up to JOB_SPLIT_ALIGN. 0 = run whole
+    struct JobCounter*  counter;    // Decremented when the job (and its splits) finish, may be NULL
+
+} Job;
+
+typedef struct JobCounter
+{
+    volatile int32_t pending;    // Jobs submitted against the counter, not yet finished
+    volatile int32_t lock;       // Guards the continuations and the drop to zero
+    uint32_t         continuation_count;
+    Job              continuations[ JOB_MAX_CONTINUATIONS ];
+
+} JobCounter;
+
+// 0 starts one worker per core beside the caller. Returns threads in use (workers + caller).
+int  job_system_init( int worker_count );
+void job_system_shutdown( void );    // Call with no jobs in flight
+int  job_thread_count( void );       // 1 when not initialized
+
+void job_submit( const Job* job );
+int  job_submit_after( const Job* job, JobCounter* dependency );    // 0 if the dependency has no room left
+void job_wait( JobCounter* counter );                               // Runs jobs meanwhile
+
+// func( data, begin, end ) over [ 0, count ) in chunks of at least min_grain, returns when all are done
+void job_parallel_for( uint32_t count, uint32_t min_grain, JobFunc func, void* data );
+void job_parallel_for_async( uint32_t count, uint32_t min_grain, JobFunc func, void* data, JobCounter* counter );
+
+#endif    // JOB_SYSTEM_H
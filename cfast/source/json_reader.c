@@ -0,0 +1,730 @@
+// ============================================================================
+// json_reader.c - Streaming JSON reader that fills reflected objects
+// ============================================================================
+
+#include "json_reader.h"
+#include "json_writer.h"    // JSON_MAX_DEPTH, JSON_BYTES_PLACEHOLDER
+
+#include <stdlib.h>
+#include <string.h>
+
+#define JSON_KEY_SCRATCH 64    // Escaped keys longer than this cannot name a field
+#define JSON_NUMBER_MAX  19    // Significant digits that fit a uint64_t
+
+// ============================================================================
+// Scanning
+// ============================================================================
+
+static void
+json_fail( JsonReader* r, const char* message )
+{
+    if ( !r->error )
+    {
+        r->error    = message;
+        r->error_at = (size_t)( r->cursor - r->begin );
+    }
+    r->cursor = r->end;    // Every later read sees end of input and stops
+}
+
+static inline void
+json_skip_ws( JsonReader* r )
+{
+    const char* p = r->cursor;
+    while ( p < r->end && ( *p == ' ' || *p == '\n' || *p == '\r' || *p == '\t' ) ) p++;
+    r->cursor = p;
+}
+
+// Next non-whitespace character without consuming it, 0 at end of input
+static inline char
+json_peek( JsonReader* r )
+{
+    json_skip_ws( r );
+    return r->cursor < r->end ? *r->cursor : 0;
+}
+
+static inline int
+json_expect( JsonReader* r, char c, const char* message )
+{
+    if ( json_peek( r ) != c )
+    {
+        json_fail( r, message );
+        return 0;
+    }
+    r->cursor++;
+    return 1;
+}
+
+static int
+json_literal( JsonReader* r, const char* word, size_t length )
+{
+    if ( (size_t)( r->end - r->cursor ) < length || memcmp( r->cursor, word, length ) != 0 )
+    {
+        json_fail( r, "invalid literal" );
+        return 0;
+    }
+    r->cursor += length;
+    return 1;
+}
+
+// ============================================================================
+// Strings
+// ============================================================================
+
+static int
+json_hex4( const char* p, uint32_t* out )
+{
+    uint32_t value = 0;
+    for ( int i = 0; i < 4; i++ )
+    {
+        char     c     = p[ i ];
+        uint32_t digit = c >= '0' && c <= '9'   ? (uint32_t)( c - '0' )
+                         : c >= 'a' && c <= 'f' ? (uint32_t)( c - 'a' + 10 )
+                         : c >= 'A' && c <= 'F' ? (uint32_t)( c - 'A' + 10 )
+                                                : 16u;
+        if ( digit > 15 )
+            return 0;
+        value = value << 4 | digit;
+    }
+    *out = value;
+    return 1;
+}
+
+static size_t
+json_utf8( uint32_t cp, char* out )
+{
+    if ( cp < 0x80 )
+    {
+        out[ 0 ] = (char)cp;
+        return 1;
+    }
+    if ( cp < 0x800 )
+    {
+        out[ 0 ] = (char)( 0xC0 | cp >> 6 );
+        out[ 1 ] = (char)( 0x80 | ( cp & 0x3F ) );
+        return 2;
+    }
+    if ( cp < 0x10000 )
+    {
+        out[ 0 ] = (char)( 0xE0 | cp >> 12 );
+        out[ 1 ] = (char)( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+        out[ 2 ] = (char)( 0x80 | ( cp & 0x3F ) );
+        return 3;
+    }
+    out[ 0 ] = (char)( 0xF0 | cp >> 18 );
+    out[ 1 ] = (char)( 0x80 | ( ( cp >> 12 ) & 0x3F ) );
+    out[ 2 ] = (char)( 0x80 | ( ( cp >> 6 ) & 0x3F ) );
+    out[ 3 ] = (char)( 0x80 | ( cp & 0x3F ) );
+    return 4;
+}
+
+// Cursor on the opening quote. Without escapes the result is a span of the
+// input; otherwise it is decoded into scratch, and bytes beyond capacity are
+// dropped (*truncated set). scratch may be NULL when only skipping.
+static int
+json_read_string( JsonReader* r, char* scratch, size_t capacity, const char** out, size_t* out_length,
+                  int* truncated )
+{
+    const char* start = ++r->cursor;
+    const char* p     = start;
+
+    // Fast path: find the closing quote, bail to decoding at the first escape
+    while ( p < r->end && *p != '"' && *p != '\\' )
+    {
+        if ( (unsigned char)*p < 0x20 )
+        {
+            r->cursor = p;
+            json_fail( r, "control character in string" );
+            return 0;
+        }
+        p++;
+    }
+    if ( p < r->end && *p == '"' )
+    {
+        *out        = start;
+        *out_length = (size_t)( p - start );
+        *truncated  = 0;
+        r->cursor   = p + 1;
+        return 1;
+    }
+
+    size_t length = (size_t)( p - start );
+    size_t kept   = length < capacity ? length : capacity;
+    if ( scratch )
+        memcpy( scratch, start, kept );
+
+    while ( p < r->end && *p != '"' )
+    {
+        char   bytes[ 4 ];
+        size_t count = 1;
+        if ( *p == '\\' )
+        {
+            if ( ++p >= r->end )
+                break;
+            switch ( *p )
+            {
+                case '"': bytes[ 0 ] = '"'; break;
+                case '\\': bytes[ 0 ] = '\\'; break;
+                case '/': bytes[ 0 ] = '/'; break;
+                case 'b': bytes[ 0 ] = '\b'; break;
+                case 'f': bytes[ 0 ] = '\f'; break;
+                case 'n': bytes[ 0 ] = '\n'; break;
+                case 'r': bytes[ 0 ] = '\r'; break;
+                case 't': bytes[ 0 ] = '\t'; break;
+                case 'u':
+                {
+                    uint32_t cp;
+                    if ( r->end - p < 5 || !json_hex4( p + 1, &cp ) )
+                    {
+                        r->cursor = p;
+                        json_fail( r, "invalid \\u escape" );
+                        return 0;
+                    }
+                    p += 4;
+
+                    // Surrogate pair, a lone half becomes U+FFFD
+                    if ( cp >= 0xD800 && cp < 0xDC00 )
+                    {
+                        uint32_t low;
+                        if ( r->end - p >= 7 && p[ 1 ] == '\\' && p[ 2 ] == 'u' && json_hex4( p + 3, &low ) &&
+                             low >= 0xDC00 && low < 0xE000 )
+                        {
+                            cp = 0x10000 + ( ( cp - 0xD800 ) << 10 ) + ( low - 0xDC00 );
+                            p += 6;
+                        }
+                        else
+                            cp = 0xFFFD;
+                    }
+                    else if ( cp >= 0xDC00 && cp < 0xE000 )
+                        cp = 0xFFFD;
+                    count = json_utf8( cp, bytes );
+                    break;
+                }
+                default:
+                    r->cursor = p;
+                    json_fail( r, "invalid escape" );
+                    return 0;
+            }
+        }
+        else if ( (unsigned char)*p < 0x20 )
+        {
+            r->cursor = p;
+            json_fail( r, "control character in string" );
+            return 0;
+        }
+        else
+            bytes[ 0 ] = *p;
+        p++;
+
+        for ( size_t i = 0; i < count; i++, length++ )
+        {
+            if ( length < capacity && scratch )
+                scratch[ length ] = bytes[ i ];
+        }
+    }
+    if ( p >= r->end )
+    {
+        r->cursor = p;
+        json_fail( r, "unterminated string" );
+        return 0;
+    }
+
+    *out        = scratch;
+    *out_length = length < capacity ? length : capacity;
+    *truncated  = length > capacity;
+    r->cursor   = p + 1;
+    return 1;
+}
+
+// ============================================================================
+// Numbers
+// ============================================================================
+
+typedef struct JsonNumber
+{
+    const char* start;
+    const char* end;
+    uint64_t    mantissa;    // First JSON_NUMBER_MAX significant digits
+    int32_t     exponent;    // value = mantissa * 10^exponent
+    uint8_t     negative;
+    uint8_t     inexact;     // Digits were dropped from mantissa
+    uint8_t     integer;     // No fraction or exponent in the text
+
+} JsonNumber;
+
+static int
+json_scan_number( JsonReader* r, JsonNumber* n )
+{
+    const char* p      = r->cursor;
+    int         digits = 0;
+    int32_t     dropped = 0;
+
+    memset( n, 0, sizeof( *n ) );
+    n->start   = p;
+    n->integer = 1;
+    if ( p < r->end && *p == '-' )
+    {
+        n->negative = 1;
+        p++;
+    }
+    if ( p >= r->end || *p < '0' || *p > '9' )
+    {
+        r->cursor = p;
+        json_fail( r, "invalid number" );
+        return 0;
+    }
+
+    // Integer part, no leading zeros
+    if ( *p == '0' )
+        p++;
+    else
+    {
+        for ( ; p < r->end && *p >= '0' && *p <= '9'; p++ )
+        {
+            if ( digits < JSON_NUMBER_MAX )
+            {
+                n->mantissa = n->mantissa * 10 + (uint64_t)( *p - '0' );
+                digits++;
+            }
+            else
+            {
+                dropped++;
+                n->inexact |= *p != '0';
+            }
+        }
+    }
+
+    if ( p < r->end && *p == '.' )
+    {
+        n->integer = 0;
+        if ( ++p >= r->end || *p < '0' || *p > '9' )
+        {
+            r->cursor = p;
+            json_fail( r, "invalid number" );
+            return 0;
+        }
+        for ( ; p < r->end && *p >= '0' && *p <= '9'; p++ )
+        {
+            if ( digits == 0 && *p == '0' )
+                n->exponent--;    // Leading zeros of 0.000x shift, not count
+            else if ( digits < JSON_NUMBER_MAX )
+            {
+                n->mantissa = n->mantissa * 10 + (uint64_t)( *p - '0' );
+                n->exponent--;
+                digits++;
+            }
+            else
+                n->inexact |= *p != '0';
+        }
+    }
+
+    if ( p < r->end && ( *p == 'e' || *p == 'E' ) )
+    {
+        n->integer   = 0;
+        int negative = 0;
+        p++;
+        if ( p < r->end && ( *p == '+' || *p == '-' ) )
+            negative = *p++ == '-';
+        if ( p >= r->end || *p < '0' || *p > '9' )
+        {
+            r->cursor = p;
+            json_fail( r, "invalid number" );
+            return 0;
+        }
+        int32_t exponent = 0;
+        for ( ; p < r->end && *p >= '0' && *p <= '9'; p++ )
+        {
+            if ( exponent < 100000 )
+                exponent = exponent * 10 + ( *p - '0' );
+        }
+        n->exponent += negative ? -exponent : exponent;
+    }
+
+    n->exponent += dropped;
+    n->end    = p;
+    r->cursor = p;
+    return 1;
+}
+
+static const double k_pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+// Clinger's fast path: mantissa and 10^e are exact doubles, so one multiply or
+// divide gives the correctly rounded double. Narrowing that to float rounds
+// twice, which only goes wrong when the double sits exactly on a float
+// midpoint without the decimal being there - those go to strtof.
+static float
+json_number_float( const JsonNumber* n )
+{
+    if ( !n->inexact && n->mantissa <= ( 1ull << 53 ) && n->exponent >= -22 && n->exponent <= 22 )
+    {
+        double value = (double)n->mantissa;
+        int    exact = 1;
+        if ( n->exponent < 0 )
+        {
+            value /= k_pow10[ -n->exponent ];
+            exact = n->mantissa == 0;
+        }
+        else
+        {
+            value *= k_pow10[ n->exponent ];
+            exact = value <= 9007199254740992.0;    // Product still an integer below 2^53
+        }
+
+        float result = (float)value;
+        if ( !exact && (double)result != value )
+        {
+            uint32_t bits;
+            memcpy( &bits, &result, sizeof( bits ) );
+            bits += (double)result < value ? 1 : -1;    // Neighbour on value's side (value >= 0)
+            float neighbour;
+            memcpy( &neighbour, &bits, sizeof( neighbour ) );
+            exact = ( (double)result + (double)neighbour ) * 0.5 != value;
+        }
+        if ( exact )
+            return n->negative ? -result : result;
+    }
+
+    char   local[ 64 ];
+    size_t length = (size_t)( n->end - n->start );
+    char*  text   = length < sizeof( local ) ? local : (char*)malloc( length + 1 );
+    if ( !text )
+        return 0.0f;
+    memcpy( text, n->start, length );
+    text[ length ] = 0;
+    float result   = strtof( text, NULL );
+    if ( text != local )
+        free( text );
+    return result;
+}
+
+// ============================================================================
+// Values
+// ============================================================================
+
+static void
+json_skip_value( JsonReader* r )
+{
+    const char* span;
+    size_t      length;
+    int         truncated;
+    JsonNumber  number;
+
+    switch ( json_peek( r ) )
+    {
+        case '"': json_read_string( r, NULL, 0, &span, &length, &truncated ); break;
+        case 't': json_literal( r, "true", 4 ); break;
+        case 'f': json_literal( r, "false", 5 ); break;
+        case 'n': json_literal( r, "null", 4 ); break;
+        case '{':
+        case '[':
+        {
+            char close = *r->cursor == '{' ? '}' : ']';
+            if ( ++r->depth > JSON_MAX_DEPTH )
+            {
+                json_fail( r, "nesting too deep" );
+                return;
+            }
+            r->cursor++;
+            if ( json_peek( r ) == close )
+                r->cursor++;
+            else
+            {
+                for ( ;; )
+                {
+                    if ( close == '}' )
+                    {
+                        if ( json_peek( r ) != '"' )
+                        {
+                            json_fail( r, "expected key" );
+                            return;
+                        }
+                        json_read_string( r, NULL, 0, &span, &length, &truncated );
+                        if ( !json_expect( r, ':', "expected ':'" ) )
+                            return;
+                    }
+                    json_skip_value( r );
+                    if ( r->error )
+                        return;
+
+                    char c = json_peek( r );
+                    r->cursor++;
+                    if ( c == close )
+                        break;
+                    if ( c != ',' )
+                    {
+                        r->cursor--;
+                        json_fail( r, close == '}' ? "expected ',' or '}'" : "expected ',' or ']'" );
+                        return;
+                    }
+                }
+            }
+            r->depth--;
+            break;
+        }
+        case '-':
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9': json_scan_number( r, &number ); break;
+        default: json_fail( r, "unexpected character" ); break;
+    }
+}
+
+// A value of the wrong JSON type for its field
+static void
+json_skip_mistyped( JsonReader* r )
+{
+    r->skipped++;
+    json_skip_value( r );
+}
+
+static int json_read_fields( JsonReader* r, const Type* type, char* base );
+
+static void
+json_read_field( JsonReader* r, const Field* field, char* ptr )
+{
+    char c = json_peek( r );
+    if ( c == 'n' )
+    {
+        json_literal( r, "null", 4 );    // Nothing to store, the field keeps its value
+        return;
+    }
+
+    JsonNumber number;
+    switch ( field_kind( field ) )
+    {
+        case FIELD_KIND_FLOAT:
+        {
+            if ( c != '-' && ( c < '0' || c > '9' ) )
+                break;
+            if ( json_scan_number( r, &number ) )
+            {
+                float value = json_number_float( &number );
+                memcpy( ptr, &value, sizeof( value ) );
+            }
+            return;
+        }
+        case FIELD_KIND_UINT32:
+        case FIELD_KIND_INT32:
+        {
+            if ( c != '-' && ( c < '0' || c > '9' ) )
+                break;
+            if ( !json_scan_number( r, &number ) )
+                return;
+
+            int      is_signed = field_kind( field ) == FIELD_KIND_INT32;
+            uint64_t limit     = is_signed ? ( number.negative ? 0x80000000ull : 0x7FFFFFFFull ) : 0xFFFFFFFFull;
+            if ( !number.integer || number.exponent != 0 || number.mantissa > limit ||
+                 ( number.negative && !is_signed && number.mantissa != 0 ) )
+            {
+                r->skipped++;    // Fraction or out of range, already consumed
+                return;
+            }
+            uint32_t value = (uint32_t)number.mantissa;
+            if ( number.negative )
+                value = 0u - value;
+            memcpy( ptr, &value, sizeof( value ) );
+            return;
+        }
+        case FIELD_KIND_STRUCT:
+        {
+            const Type* nested = field_nested_type( field );
+            if ( c != '{' || !nested )
+                break;
+            json_read_fields( r, nested, ptr );
+            return;
+        }
+        default:
+        {
+            if ( c != '"' )
+                break;
+
+            // A blob the writer had no string for: the field keeps its value
+            static const char placeholder[] = "\"" JSON_BYTES_PLACEHOLDER "\"";
+            size_t            skip          = sizeof( placeholder ) - 1;
+            if ( (size_t)( r->end - r->cursor ) >= skip && memcmp( r->cursor, placeholder, skip ) == 0 )
+            {
+                r->cursor += skip;
+                return;
+            }
+
+            // Decodes straight into the field, the rest is zero filled
+            const char* span;
+            size_t      length;
+            int         truncated;
+            if ( json_read_string( r, ptr, field->size, &span, &length, &truncated ) )
+            {
+                if ( span != ptr )
+                    memcpy( ptr, span, length < field->size ? length : field->size );
+                if ( length < field->size )
+                    memset( ptr + length, 0, field->size - length );
+            }
+            return;
+        }
+    }
+    json_skip_mistyped( r );
+}
+
+static int
+json_read_fields( JsonReader* r, const Type* type, char* base )
+{
+    if ( !json_expect( r, '{', "expected '{'" ) )
+        return 0;
+    if ( ++r->depth > JSON_MAX_DEPTH )
+    {
+        json_fail( r, "nesting too deep" );
+        return 0;
+    }
+
+    if ( json_peek( r ) == '}' )
+        r->cursor++;
+    else
+    {
+        for ( ;; )
+        {
+            char        scratch[ JSON_KEY_SCRATCH ];
+            const char* key;
+            size_t      length;
+            int         truncated;
+            if ( json_peek( r ) != '"' )
+            {
+                json_fail( r, "expected key" );
+                return 0;
+            }
+            if ( !json_read_string( r, scratch, sizeof( scratch ), &key, &length, &truncated ) ||
+                 !json_expect( r, ':', "expected ':'" ) )
+                return 0;
+
+            int index = truncated ? -1 : type_field_index( type, key, length );
+            if ( index >= 0 )
+            {
+                const Field* field = type_field( type, (uint16_t)index );
+                json_read_field( r, field, base + field->offset );
+            }
+            else
+            {
+                if ( length != 5 || memcmp( key, "_type", 5 ) != 0 )    // Written by JSON_TYPE_NAMES
+                    r->skipped++;
+                json_skip_value( r );
+            }
+            if ( r->error )
+                return 0;
+
+            char c = json_peek( r );
+            if ( c == '}' )
+            {
+                r->cursor++;
+                break;
+            }
+            if ( !json_expect( r, ',', "expected ',' or '}'" ) )
+                return 0;
+        }
+    }
+    r->depth--;
+    return 1;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+void
+json_reader_init( JsonReader* r, const char* text, size_t length )
+{
+    memset( r, 0, sizeof( *r ) );
+    r->begin  = text;
+    r->cursor = text;
+    r->end    = text + length;
+}
+
+int
+json_read_object( JsonReader* r, const Type* type, void* obj )
+{
+    return json_read_fields( r, type, (char*)obj ) && !r->error;
+}
+
+size_t
+json_read_array( JsonReader* r, const Type* type, void* objects, size_t max_count )
+{
+    char*  base  = (char*)objects;
+    size_t count = 0;
+
+    if ( !json_expect( r, '[', "expected '['" ) )
+        return 0;
+    if ( json_peek( r ) == ']' )
+    {
+        r->cursor++;
+        return 0;
+    }
+
+    for ( ;; )
+    {
+        if ( count < max_count )
+        {
+            if ( !json_read_fields( r, type, base + count * type->size ) )
+                return 0;
+            count++;
+        }
+        else
+        {
+            json_skip_value( r );    // No room, but the text must still parse
+            if ( r->error )
+                return 0;
+        }
+
+        char c = json_peek( r );
+        if ( c == ']' )
+        {
+            r->cursor++;
+            return count;
+        }
+        if ( !json_expect( r, ',', "expected ',' or ']'" ) )
+            return 0;
+    }
+}
+
+char*
+json_read_file( FILE* file, size_t* out_length )
+{
+    size_t capacity = 64 * 1024;
+    size_t length   = 0;
+    char*  text     = (char*)malloc( capacity );
+    if ( !text )
+        return NULL;
+
+    for ( ;; )
+    {
+        length += fread( text + length, 1, capacity - length - 1, file );
+        if ( length < capacity - 1 )
+            break;
+
+        char* grown = (char*)realloc( text, capacity * 2 );
+        if ( !grown )
+        {
+            free( text );
+            return NULL;
+        }
+        text = grown;
+        capacity *= 2;
+    }
+    if ( ferror( file ) )
+    {
+        free( text );
+        return NULL;
+    }
+
+    text[ length ] = 0;
+    if ( out_length )
+        *out_length = length;
+    return text;
+}
+
+// ============================================================================
@@ -0,0 +1,42 @@
+// ============================================================================
+// json_reader.h - Streaming JSON reader that fills reflected objects
+// ============================================================================
+//
+// No document tree: the text is scanned once and each value is written
+// straight into the field its key names. Keys go through the type's perfect
+// hash (type_field_index), nested objects recurse into the field's type.
+// Unknown keys and values of the wrong JSON type are skipped and counted;
+// fields missing from the text keep whatever the object already held.
+
+#ifndef JSON_READER_H
+#define JSON_READER_H
+
+#include "reflection_core.h"
+
+#include <stdio.h>
+
+typedef struct JsonReader
+{
+    const char* begin;
+    const char* cursor;
+    const char* end;
+    const char* error;       // First syntax error, NULL while fine
+    size_t      error_at;    // Byte offset of the error
+    uint32_t    skipped;     // Unknown keys and mistyped values passed over
+    int         depth;
+
+} JsonReader;
+
+void json_reader_init( JsonReader* r, const char* text, size_t length );
+
+// One object into obj. Returns 1 on success, 0 on a syntax error.
+int json_read_object( JsonReader* r, const Type* type, void* obj );
+
+// An array of objects into consecutive elements of type->size. Elements past
+// max_count are parsed and dropped. Returns objects written, 0 on error.
+size_t json_read_array( JsonReader* r, const Type* type, void* objects, size_t max_count );
+
+// Entire file into a NUL terminated heap buffer (free() it), NULL on failure
+char* json_read_file( FILE* file, size_t* out_length );
+
+#endif    // JSON_READER_H
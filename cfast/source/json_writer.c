@@ -0,0 +1,877 @@
+// ============================================================================
+// json_writer.c - Buffered streaming JSON writer driven by reflection
+// ============================================================================
+
+#include "json_writer.h"
+#include "job_system.h"
+
+#include <stdlib.h>
+
+#define JSON_MAX_CHUNKS         16
+#define JSON_PARALLEL_MIN_CHUNK 256    // Objects per chunk below which splitting costs more than it saves
+
+// ============================================================================
+// Shortest round-trip float digits (Ryu, Ulf Adams 2018, float32 variant)
+// ============================================================================
+//
+// The float's rounding interval is scaled by a power of ten using 64-bit
+// fixed point approximations of 5^q, then digits are stripped while the
+// interval still holds a unique decimal. Exact for every float.
+
+#define FLOAT_MANTISSA_BITS     23
+#define FLOAT_BIAS              127
+#define FLOAT_POW5_INV_BITCOUNT 59
+#define FLOAT_POW5_BITCOUNT     61
+
+// ceil( 2^( pow5bits( i ) - 1 + 59 ) / 5^i )
+static const uint64_t k_pow5_inv_split[ 31 ] = {
+    576460752303423489u, 461168601842738791u, 368934881474191033u, 295147905179352826u, 472236648286964522u,
+    377789318629571618u, 302231454903657294u, 483570327845851670u, 386856262276681336u, 309485009821345069u,
+    495176015714152110u, 396140812571321688u, 316912650057057351u, 507060240091291761u, 405648192073033409u,
+    324518553658426727u, 519229685853482763u, 415383748682786211u, 332306998946228969u, 531691198313966350u,
+    425352958651173080u, 340282366920938464u, 544451787073501542u, 435561429658801234u, 348449143727040987u,
+    557518629963265579u, 446014903970612463u, 356811923176489971u, 570899077082383953u, 456719261665907162u,
+    365375409332725730u,
+};
+
+// floor( 5^i / 2^( pow5bits( i ) - 61 ) )
+static const uint64_t k_pow5_split[ 48 ] = {
+    1152921504606846976u, 1441151880758558720u, 1801439850948198400u, 2251799813685248000u,
+    1407374883553280000u, 1759218604441600000u, 2199023255552000000u, 1374389534720000000u,
+    1717986918400000000u, 2147483648000000000u, 1342177280000000000u, 1677721600000000000u,
+    2097152000000000000u, 1310720000000000000u, 1638400000000000000u, 2048000000000000000u,
+    1280000000000000000u, 1600000000000000000u, 2000000000000000000u, 1250000000000000000u,
+    1562500000000000000u, 1953125000000000000u, 1220703125000000000u, 1525878906250000000u,
+    1907348632812500000u, 1192092895507812500u, 1490116119384765625u, 1862645149230957031u,
+    1164153218269348144u, 1455191522836685180u, 1818989403545856475u, 2273736754432320594u,
+    1421085471520200371u, 1776356839400250464u, 2220446049250313080u, 1387778780781445675u,
+    1734723475976807094u, 2168404344971008868u, 1355252715606880542u, 1694065894508600678u,
+    2117582368135750847u, 1323488980084844279u, 1654361225106055349u, 2067951531382569187u,
+    1292469707114105741u, 1615587133892632177u, 2019483917365790221u, 1262177448353618888u,
+};
+
+static inline int32_t
+pow5bits( int32_t e )    // ceil( log2( 5^e ) ), 1 for e == 0
+{
+    return (int32_t)( ( (uint32_t)e * 1217359 ) >> 19 ) + 1;
+}
+
+static inline uint32_t
+log10_pow2( int32_t e )
+{
+    return ( (uint32_t)e * 78913 ) >> 18;
+}
+
+static inline uint32_t
+log10_pow5( int32_t e )
+{
+    return ( (uint32_t)e * 732923 ) >> 20;
+}
+
+static inline int
+multiple_of_pow5( uint32_t value, uint32_t p )
+{
+    uint32_t count = 0;
+    while ( value % 5 == 0 )
+    {
+        value /= 5;
+        count++;
+    }
+    return count >= p;
+}
+
+static inline int
+multiple_of_pow2( uint32_t value, uint32_t p )
+{
+    return ( value & ( ( 1u << p ) - 1 ) ) == 0;
+}
+
+static inline uint32_t
+mul_shift32( uint32_t m, uint64_t factor, int32_t shift )
+{
+    uint64_t bits0 = (uint64_t)m * (uint32_t)factor;
+    uint64_t bits1 = (uint64_t)m * (uint32_t)( factor >> 32 );
+    uint64_t sum   = ( bits0 >> 32 ) + bits1;
+    return (uint32_t)( sum >> ( shift - 32 ) );
+}
+
+// value = mantissa * 10^exponent, mantissa with the fewest digits that rounds back
+static void
+float_to_decimal( uint32_t ieee_mantissa, uint32_t ieee_exponent, uint32_t* out_mantissa, int32_t* out_exponent )
+{
+    int32_t  e2;
+    uint32_t m2;
+    if ( ieee_exponent == 0 )
+    {
+        e2 = 1 - FLOAT_BIAS - FLOAT_MANTISSA_BITS - 2;    // Subnormal
+        m2 = ieee_mantissa;
+    }
+    else
+    {
+        e2 = (int32_t)ieee_exponent - FLOAT_BIAS - FLOAT_MANTISSA_BITS - 2;
+        m2 = ( 1u << FLOAT_MANTISSA_BITS ) | ieee_mantissa;
+    }
+    int accept_bounds = ( m2 & 1 ) == 0;    // Round half to even on parse
+
+    // Interval of values that round to this float, times 4
+    uint32_t mv       = 4 * m2;
+    uint32_t mp       = 4 * m2 + 2;
+    uint32_t mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+    uint32_t mm       = 4 * m2 - 1 - mm_shift;
+
+    uint32_t vr, vp, vm;
+    int32_t  e10;
+    int      vm_trailing_zeros = 0, vr_trailing_zeros = 0;
+    uint8_t  last_removed      = 0;
+    if ( e2 >= 0 )
+    {
+        uint32_t q = log10_pow2( e2 );
+        int32_t  k = FLOAT_POW5_INV_BITCOUNT + pow5bits( (int32_t)q ) - 1;
+        int32_t  i = -e2 + (int32_t)q + k;
+        e10        = (int32_t)q;
+        vr         = mul_shift32( mv, k_pow5_inv_split[ q ], i );
+        vp         = mul_shift32( mp, k_pow5_inv_split[ q ], i );
+        vm         = mul_shift32( mm, k_pow5_inv_split[ q ], i );
+        if ( q != 0 && ( vp - 1 ) / 10 <= vm / 10 )
+        {
+            // The loop below may not run, but rounding needs one removed digit
+            int32_t l    = FLOAT_POW5_INV_BITCOUNT + pow5bits( (int32_t)( q - 1 ) ) - 1;
+            last_removed = (uint8_t)( mul_shift32( mv, k_pow5_inv_split[ q - 1 ], -e2 + (int32_t)q - 1 + l ) % 10 );
+        }
+        if ( q <= 9 )
+        {
+            // At most one of mp, mv, mm is a multiple of 5
+            if ( mv % 5 == 0 )
+                vr_trailing_zeros = multiple_of_pow5( mv, q );
+            else if ( accept_bounds )
+                vm_trailing_zeros = multiple_of_pow5( mm, q );
+            else
+                vp -= multiple_of_pow5( mp, q );
+        }
+    }
+    else
+    {
+        uint32_t q = log10_pow5( -e2 );
+        int32_t  i = -e2 - (int32_t)q;
+        int32_t  k = pow5bits( i ) - FLOAT_POW5_BITCOUNT;
+        int32_t  j = (int32_t)q - k;
+        e10        = (int32_t)q + e2;
+        vr         = mul_shift32( mv, k_pow5_split[ i ], j );
+        vp         = mul_shift32( mp, k_pow5_split[ i ], j );
+        vm         = mul_shift32( mm, k_pow5_split[ i ], j );
+        if ( q != 0 && ( vp - 1 ) / 10 <= vm / 10 )
+        {
+            j            = (int32_t)q - 1 - ( pow5bits( i + 1 ) - FLOAT_POW5_BITCOUNT );
+            last_removed = (uint8_t)( mul_shift32( mv, k_pow5_split[ i + 1 ], j ) % 10 );
+        }
+        if ( q <= 1 )
+        {
+            // mv = 4 * m2 always has two trailing zero bits
+            vr_trailing_zeros = 1;
+            if ( accept_bounds )
+                vm_trailing_zeros = mm_shift == 1;
+            else
+                --vp;
+        }
+        else if ( q < 31 )
+        {
+            vr_trailing_zeros = multiple_of_pow2( mv, q - 1 );
+        }
+    }
+
+    // Strip digits while the interval still contains a shorter decimal
+    int32_t  removed = 0;
+    uint32_t output;
+    if ( vm_trailing_zeros || vr_trailing_zeros )
+    {
+        // Rare (~4%): exact ties need the full bookkeeping
+        while ( vp / 10 > vm / 10 )
+        {
+            vm_trailing_zeros &= vm % 10 == 0;
+            vr_trailing_zeros &= last_removed == 0;
+            last_removed = (uint8_t)( vr % 10 );
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        if ( vm_trailing_zeros )
+        {
+            while ( vm % 10 == 0 )
+            {
+                vr_trailing_zeros &= last_removed == 0;
+                last_removed = (uint8_t)( vr % 10 );
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                removed++;
+            }
+        }
+        if ( vr_trailing_zeros && last_removed == 5 && vr % 2 == 0 )
+            last_removed = 4;    // Exactly .5 - round to even
+        output = vr + ( ( vr == vm && ( !accept_bounds || !vm_trailing_zeros ) ) || last_removed >= 5 );
+    }
+    else
+    {
+        while ( vp / 10 > vm / 10 )
+        {
+            last_removed = (uint8_t)( vr % 10 );
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        output = vr + ( vr == vm || last_removed >= 5 );
+    }
+
+    *out_mantissa = output;
+    *out_exponent = e10 + removed;
+}
+
+static inline int
+decimal_length( uint32_t v )    // v < 10^9
+{
+    int length = 1;
+    while ( v >= 10 )
+    {
+        v /= 10;
+        length++;
+    }
+    return length;
+}
+
+// Plain notation for 1e-5 <= |value| < 1e9, scientific ("1.5e-7") outside
+int
+json_format_float( float value, char* out )
+{
+    uint32_t bits;
+    memcpy( &bits, &value, sizeof( bits ) );
+    uint32_t ieee_mantissa = bits & ( ( 1u << FLOAT_MANTISSA_BITS ) - 1 );
+    uint32_t ieee_exponent = ( bits >> FLOAT_MANTISSA_BITS ) & 0xFF;
+
+    char* p = out;
+    if ( bits >> 31 )
+        *p++ = '-';
+    if ( ieee_exponent == 0 && ieee_mantissa == 0 )
+    {
+        *p++ = '0';
+        return (int)( p - out );
+    }
+
+    uint32_t mantissa;
+    int32_t  exponent;
+    float_to_decimal( ieee_mantissa, ieee_exponent, &mantissa, &exponent );
+
+    char digits[ 10 ];
+    int  length = decimal_length( mantissa );
+    for ( int i = length - 1; i >= 0; i-- )
+    {
+        digits[ i ] = (char)( '0' + mantissa % 10 );
+        mantissa /= 10;
+    }
+
+    int scientific = exponent + length - 1;    // value = d.ddd * 10^scientific
+    if ( scientific >= -5 && scientific <= 8 )
+    {
+        if ( scientific < 0 )
+        {
+            *p++ = '0';
+            *p++ = '.';
+            for ( int i = -1; i > scientific; i-- ) *p++ = '0';
+            memcpy( p, digits, length );
+            p += length;
+        }
+        else if ( scientific + 1 >= length )
+        {
+            memcpy( p, digits, length );
+            p += length;
+            for ( int i = length; i <= scientific; i++ ) *p++ = '0';
+        }
+        else
+        {
+            memcpy( p, digits, scientific + 1 );
+            p += scientific + 1;
+            *p++ = '.';
+            memcpy( p, digits + scientific + 1, length - scientific - 1 );
+            p += length - scientific - 1;
+        }
+    }
+    else
+    {
+        *p++ = digits[ 0 ];
+        if ( length > 1 )
+        {
+            *p++ = '.';
+            memcpy( p, digits + 1, length - 1 );
+            p += length - 1;
+        }
+        *p++ = 'e';
+        if ( scientific < 0 )
+        {
+            *p++       = '-';
+            scientific = -scientific;
+        }
+        if ( scientific >= 10 )
+            *p++ = (char)( '0' + scientific / 10 );
+        *p++ = (char)( '0' + scientific % 10 );
+    }
+    return (int)( p - out );
+}
+
+// ============================================================================
+// Buffer
+// ============================================================================
+
+void
+json_writer_init( JsonWriter* w, FILE* file, uint32_t flags )
+{
+    memset( w, 0, sizeof( JsonWriter ) );
+    w->file  = file;
+    w->flags = flags;
+}
+
+static void
+json_flush( JsonWriter* w )
+{
+    if ( w->length && fwrite( w->buffer, 1, w->length, w->file ) != w->length )
+        w->error = 1;
+    w->written += w->length;
+    w->length = 0;
+}
+
+// Room for bytes more - file writers flush, memory writers grow
+static int
+json_reserve( JsonWriter* w, size_t bytes )
+{
+    if ( w->length + bytes <= w->capacity )
+        return 1;
+    if ( w->file && w->length )
+    {
+        json_flush( w );
+        if ( bytes <= w->capacity )
+            return 1;
+    }
+
+    size_t capacity = w->capacity ? w->capacity : JSON_WRITER_BUFFER;
+    while ( capacity < w->length + bytes ) capacity *= 2;
+    char* grown = (char*)realloc( w->buffer, capacity );
+    if ( !grown )
+    {
+        w->error = 1;
+        return 0;
+    }
+    w->buffer   = grown;
+    w->capacity = capacity;
+    return 1;
+}
+
+static void
+json_raw( JsonWriter* w, const char* data, size_t size )
+{
+    if ( !size )
+        return;
+
+    // Large blocks bypass the buffer entirely
+    if ( w->file && size >= JSON_WRITER_BUFFER )
+    {
+        json_flush( w );
+        if ( fwrite( data, 1, size, w->file ) != size )
+            w->error = 1;
+        w->written += size;
+        return;
+    }
+    if ( json_reserve( w, size ) )
+    {
+        memcpy( w->buffer + w->length, data, size );
+        w->length += size;
+    }
+}
+
+int
+json_writer_finish( JsonWriter* w )
+{
+    if ( w->file )
+    {
+        json_flush( w );
+        if ( fflush( w->file ) != 0 )
+            w->error = 1;
+    }
+    return !w->error && w->depth == 0;
+}
+
+void
+json_writer_free( JsonWriter* w )
+{
+    free( w->buffer );
+    w->buffer   = NULL;
+    w->length   = 0;
+    w->capacity = 0;
+}
+
+size_t
+json_writer_size( const JsonWriter* w )
+{
+    return w->written + w->length;
+}
+
+// ============================================================================
+// Structure
+// ============================================================================
+
+static void json_quoted( JsonWriter* w, const char* str, size_t max_len );
+
+static void
+json_newline( JsonWriter* w )
+{
+    if ( ( w->flags & JSON_COMPACT ) || !json_reserve( w, 1 + 2 * (size_t)w->depth ) )
+        return;
+    char* p = w->buffer + w->length;
+    *p++    = '\n';
+    memset( p, ' ', 2 * (size_t)w->depth );
+    w->length += 1 + 2 * (size_t)w->depth;
+}
+
+// Comma and indentation before a value or key
+static void
+json_separator( JsonWriter* w )
+{
+    if ( w->after_key )
+    {
+        w->after_key = 0;
+        return;
+    }
+    if ( w->depth > 0 )
+    {
+        if ( w->has_items[ w->depth - 1 ] )
+            json_raw( w, ",", 1 );
+        w->has_items[ w->depth - 1 ] = 1;
+        json_newline( w );
+    }
+}
+
+static void
+json_open( JsonWriter* w, char bracket )
+{
+    json_separator( w );
+    if ( w->depth == JSON_MAX_DEPTH )
+    {
+        w->error = 1;
+        return;
+    }
+    json_raw( w, &bracket, 1 );
+    w->has_items[ w->depth++ ] = 0;
+}
+
+static void
+json_close( JsonWriter* w, char bracket )
+{
+    if ( w->depth == 0 )
+    {
+        w->error = 1;
+        return;
+    }
+    if ( w->has_items[ --w->depth ] )
+        json_newline( w );
+    json_raw( w, &bracket, 1 );
+}
+
+void
+json_begin_object( JsonWriter* w )
+{
+    json_open( w, '{' );
+}
+
+void
+json_end_object( JsonWriter* w )
+{
+    json_close( w, '}' );
+}
+
+void
+json_begin_array( JsonWriter* w )
+{
+    json_open( w, '[' );
+}
+
+void
+json_end_array( JsonWriter* w )
+{
+    json_close( w, ']' );
+}
+
+void
+json_key( JsonWriter* w, const char* key )
+{
+    json_separator( w );
+    w->after_key = 1;
+
+    // Field names rarely need escaping - copy them in one go
+    size_t length = 0;
+    while ( key[ length ] && (unsigned char)key[ length ] >= 0x20 && key[ length ] != '"' && key[ length ] != '\\' )
+        length++;
+    if ( !key[ length ] && json_reserve( w, length + 4 ) )
+    {
+        char* p = w->buffer + w->length;
+        *p++    = '"';
+        memcpy( p, key, length );
+        p += length;
+        *p++ = '"';
+        *p++ = ':';
+        if ( !( w->flags & JSON_COMPACT ) )
+            *p++ = ' ';
+        w->length = (size_t)( p - w->buffer );
+        return;
+    }
+
+    json_quoted( w, key, SIZE_MAX );
+    json_raw( w, ": ", ( w->flags & JSON_COMPACT ) ? 1 : 2 );
+}
+
+// ============================================================================
+// Values
+// ============================================================================
+
+void
+json_float( JsonWriter* w, float value )
+{
+    uint32_t bits;
+    memcpy( &bits, &value, sizeof( bits ) );
+    if ( ( ( bits >> FLOAT_MANTISSA_BITS ) & 0xFF ) == 0xFF )
+    {
+        json_null( w );    // JSON has no NaN / Inf
+        return;
+    }
+
+    // Whole numbers (counters, health, scale) skip the digit search
+    if ( value > -16777216.0f && value < 16777216.0f && value == (float)(int32_t)value && !( value == 0 && bits >> 31 ) )
+    {
+        json_int( w, (int32_t)value );
+        return;
+    }
+
+    json_separator( w );
+    if ( json_reserve( w, 16 ) )
+        w->length += json_format_float( value, w->buffer + w->length );
+}
+
+static const char k_digit_pairs[ 201 ] = "00010203040506070809"
+                                         "10111213141516171819"
+                                         "20212223242526272829"
+                                         "30313233343536373839"
+                                         "40414243444546474849"
+                                         "50515253545556575859"
+                                         "60616263646566676869"
+                                         "70717273747576777879"
+                                         "80818283848586878889"
+                                         "90919293949596979899";
+
+static void
+json_digits( JsonWriter* w, uint64_t value, int negative )
+{
+    char  tmp[ 21 ];
+    char* p = tmp + sizeof( tmp );
+    while ( value >= 100 )
+    {
+        uint32_t pair = (uint32_t)( value % 100 ) * 2;
+        value /= 100;
+        *--p = k_digit_pairs[ pair + 1 ];
+        *--p = k_digit_pairs[ pair ];
+    }
+    if ( value >= 10 )
+    {
+        *--p = k_digit_pairs[ value * 2 + 1 ];
+        *--p = k_digit_pairs[ value * 2 ];
+    }
+    else
+    {
+        *--p = (char)( '0' + value );
+    }
+    if ( negative )
+        *--p = '-';
+
+    json_separator( w );
+    json_raw( w, p, (size_t)( tmp + sizeof( tmp ) - p ) );
+}
+
+void
+json_uint( JsonWriter* w, uint64_t value )
+{
+    json_digits( w, value, 0 );
+}
+
+void
+json_int( JsonWriter* w, int64_t value )
+{
+    json_digits( w, value < 0 ? 0 - (uint64_t)value : (uint64_t)value, value < 0 );
+}
+
+// Exact for scaled integers (timestamps, money) where a float would round
+void
+json_fixed( JsonWriter* w, uint64_t value, int decimals )
+{
+    char  tmp[ 42 ];
+    char* p = tmp + sizeof( tmp );
+    for ( int i = 0; i < decimals && i < 20; i++ )
+    {
+        *--p = (char)( '0' + value % 10 );
+        value /= 10;
+    }
+    if ( p < tmp + sizeof( tmp ) )
+        *--p = '.';
+    do
+    {
+        *--p = (char)( '0' + value % 10 );
+        value /= 10;
+    } while ( value );
+
+    json_separator( w );
+    json_raw( w, p, (size_t)( tmp + sizeof( tmp ) - p ) );
+}
+
+void
+json_null( JsonWriter* w )
+{
+    json_separator( w );
+    json_raw( w, "null", 4 );
+}
+
+// Bytes >= 0x80 pass through (UTF-8), quotes / backslashes / controls are escaped
+static void
+json_quoted( JsonWriter* w, const char* str, size_t max_len )
+{
+    static const char hex[] = "0123456789abcdef";
+
+    json_raw( w, "\"", 1 );
+
+    size_t run = 0;    // Start of the pending unescaped span
+    size_t i   = 0;
+    for ( ; i < max_len && str[ i ]; i++ )
+    {
+        unsigned char c = (unsigned char)str[ i ];
+        if ( c >= 0x20 && c != '"' && c != '\\' )
+            continue;
+
+        json_raw( w, str + run, i - run );
+        run = i + 1;
+
+        char escape[ 6 ] = { '\\', 0 };
+        switch ( c )
+        {
+            case '"': escape[ 1 ] = '"'; break;
+            case '\\': escape[ 1 ] = '\\'; break;
+            case '\n': escape[ 1 ] = 'n'; break;
+            case '\r': escape[ 1 ] = 'r'; break;
+            case '\t': escape[ 1 ] = 't'; break;
+            default:
+                memcpy( escape + 1, "u00", 3 );
+                escape[ 4 ] = hex[ c >> 4 ];
+                escape[ 5 ] = hex[ c & 15 ];
+                json_raw( w, escape, 6 );
+                continue;
+        }
+        json_raw( w, escape, 2 );
+    }
+    json_raw( w, str + run, i - run );
+    json_raw( w, "\"", 1 );
+}
+
+void
+json_string( JsonWriter* w, const char* str, size_t max_len )
+{
+    json_separator( w );
+    json_quoted( w, str, max_len );
+}
+
+// ============================================================================
+// Reflection
+// ============================================================================
+
+// UTF-8 up to a terminator, then only zeros: exactly what the reader stores back
+// from the string. Overlong forms, surrogates and truncated sequences are not text.
+static int
+json_bytes_are_text( const unsigned char* p, size_t size )
+{
+    size_t i = 0;
+    while ( i < size && p[ i ] )
+    {
+        unsigned char c    = p[ i ];
+        size_t        tail = c < 0x80 ? 0 : c < 0xC2 ? 4 : c < 0xE0 ? 1 : c < 0xF0 ? 2 : c < 0xF5 ? 3 : 4;
+        if ( tail > 3 || i + tail >= size )
+            return 0;
+
+        unsigned char low  = c == 0xE0 ? 0xA0 : c == 0xF0 ? 0x90 : 0x80;
+        unsigned char high = c == 0xED ? 0x9F : c == 0xF4 ? 0x8F : 0xBF;
+        for ( size_t k = 1; k <= tail; k++ )
+        {
+            if ( p[ i + k ] < low || p[ i + k ] > high )
+                return 0;
+            low  = 0x80;
+            high = 0xBF;
+        }
+        i += tail + 1;
+    }
+    for ( ; i < size; i++ )
+    {
+        if ( p[ i ] )
+            return 0;
+    }
+    return 1;
+}
+
+void
+json_write_object( JsonWriter* w, const Type* type, const void* obj )
+{
+    const char* base = (const char*)obj;
+
+    json_begin_object( w );
+    if ( w->flags & JSON_TYPE_NAMES )
+    {
+        json_key( w, "_type" );
+        json_string( w, type_name( type ), SIZE_MAX );
+    }
+
+    for ( uint16_t i = 0; i < type->field_count; i++ )
+    {
+        const Field* field = type_field( type, i );
+        const char*  ptr   = base + field->offset;
+        json_key( w, field->name );
+
+        switch ( field_kind( field ) )
+        {
+            case FIELD_KIND_FLOAT:
+            {
+                float value;
+                memcpy( &value, ptr, sizeof( value ) );
+                json_float( w, value );
+                break;
+            }
+            case FIELD_KIND_UINT32:
+            {
+                uint32_t value;
+                memcpy( &value, ptr, sizeof( value ) );
+                json_uint( w, value );
+                break;
+            }
+            case FIELD_KIND_INT32:
+            {
+                int32_t value;
+                memcpy( &value, ptr, sizeof( value ) );
+                json_int( w, value );
+                break;
+            }
+            case FIELD_KIND_STRUCT:
+            {
+                const Type* nested = field_nested_type( field );
+                if ( nested )
+                    json_write_object( w, nested, ptr );
+                else
+                    json_null( w );
+                break;
+            }
+            default:
+                if ( json_bytes_are_text( (const unsigned char*)ptr, field->size ) )
+                    json_string( w, ptr, field->size );    // char arrays up to their terminator
+                else
+                    json_string( w, JSON_BYTES_PLACEHOLDER, SIZE_MAX );
+                break;
+        }
+    }
+    json_end_object( w );
+}
+
+void
+json_write_array( JsonWriter* w, const Type* type, const void* objects, size_t count )
+{
+    const char* base = (const char*)objects;
+
+    json_begin_array( w );
+    for ( size_t i = 0; i < count; i++ ) json_write_object( w, type, base + i * type->size );
+    json_end_array( w );
+}
+
+// ============================================================================
+// Parallel arrays - each job renders a contiguous chunk into memory
+// ============================================================================
+
+typedef struct JsonChunk
+{
+    JsonWriter  writer;
+    const Type* type;
+    const char* objects;
+    size_t      count;
+
+} JsonChunk;
+
+static void
+json_render_chunks( void* data, uint32_t begin, uint32_t end )
+{
+    JsonChunk* chunks = (JsonChunk*)data;
+    for ( uint32_t c = begin; c < end; c++ )
+    {
+        JsonChunk* chunk = &chunks[ c ];
+        for ( size_t i = 0; i < chunk->count; i++ )
+        {
+            json_write_object( &chunk->writer, chunk->type, chunk->objects + i * chunk->type->size );
+        }
+    }
+}
+
+void
+json_write_array_parallel( JsonWriter* w, const Type* type, const void* objects, size_t count, int thread_count )
+{
+    size_t max_chunks = count / JSON_PARALLEL_MIN_CHUNK;
+    if ( thread_count > job_thread_count() )
+        thread_count = job_thread_count();
+    if ( thread_count > JSON_MAX_CHUNKS )
+        thread_count = JSON_MAX_CHUNKS;
+    if ( (size_t)thread_count > max_chunks )
+        thread_count = (int)max_chunks;
+    if ( thread_count < 2 )
+    {
+        json_write_array( w, type, objects, count );
+        return;
+    }
+
+    json_begin_array( w );
+
+    // Each chunk continues the array at the same depth, so separators and
+    // indentation come out identical to the serial writer
+    JsonChunk chunks[ JSON_MAX_CHUNKS ];
+    size_t    per_chunk = ( count + thread_count - 1 ) / thread_count;
+    for ( int t = 0; t < thread_count; t++ )
+    {
+        JsonChunk* chunk = &chunks[ t ];
+        size_t     first = (size_t)t * per_chunk;
+        size_t     left  = first < count ? count - first : 0;
+        json_writer_init( &chunk->writer, NULL, w->flags );
+        chunk->writer.depth                     = w->depth;
+        chunk->writer.has_items[ w->depth - 1 ] = t > 0;
+        chunk->type                             = type;
+        chunk->objects                          = (const char*)objects + first * type->size;
+        chunk->count                            = left < per_chunk ? left : per_chunk;
+    }
+
+    // One job per chunk, grain 0 so none is split further; the caller runs some too
+    JobCounter counter;
+    memset( &counter, 0, sizeof( counter ) );
+    for ( int t = 0; t < thread_count; t++ )
+    {
+        Job job = { json_render_chunks, chunks, (uint32_t)t, (uint32_t)t + 1, 0, &counter };
+        job_submit( &job );
+    }
+    job_wait( &counter );
+
+    // Concatenate in order
+    for ( int t = 0; t < thread_count; t++ )
+    {
+        JsonWriter* chunk_writer = &chunks[ t ].writer;
+        json_raw( w, chunk_writer->buffer, chunk_writer->length );
+        w->error |= chunk_writer->error;
+        json_writer_free( chunk_writer );
+    }
+    w->has_items[ w->depth - 1 ] = 1;
+
+    json_end_array( w );
+}
+
+// ============================================================================
@@ -0,0 +1,77 @@
+// ============================================================================
+// json_writer.h - Buffered streaming JSON writer driven by reflection
+// ============================================================================
+//
+// Output goes into the writer's own buffer and reaches the FILE* in large
+// fwrites (or stays in memory). Numbers are formatted without stdio: floats
+// use the shortest digits that parse back to the same value (Ryu), so output
+// is exact and locale independent. Arrays of objects can be split across
+// the job system, each chunk rendered into its own buffer and appended in order.
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include "reflection_core.h"
+
+#include <stdio.h>
+
+#define JSON_WRITER_BUFFER ( 64 * 1024 )    // Flush threshold for file output
+#define JSON_MAX_DEPTH     32
+
+// Written for a bytes field that is not text (see json_write_object); the reader
+// leaves the field as it is when it meets it
+#define JSON_BYTES_PLACEHOLDER "<binary>"
+
+// Writer flags
+#define JSON_COMPACT    0x01    // No whitespace at all
+#define JSON_TYPE_NAMES 0x02    // "_type" as the first key of every object
+
+typedef struct JsonWriter
+{
+    FILE*    file;        // NULL = memory only, buffer grows
+    char*    buffer;
+    size_t   length;
+    size_t   capacity;
+    size_t   written;     // Bytes already flushed to file
+    uint32_t flags;
+    int      depth;
+    int      after_key;    // Next value belongs to a key, no separator
+    int      error;        // Sticky: allocation failure, short write, bad nesting
+    uint8_t  has_items[ JSON_MAX_DEPTH ];
+
+} JsonWriter;
+
+void   json_writer_init( JsonWriter* w, FILE* file, uint32_t flags );
+int    json_writer_finish( JsonWriter* w );    // Flushes to file, returns 0 on error
+void   json_writer_free( JsonWriter* w );
+size_t json_writer_size( const JsonWriter* w );    // Total bytes produced
+
+// Structure
+void json_begin_object( JsonWriter* w );
+void json_end_object( JsonWriter* w );
+void json_begin_array( JsonWriter* w );
+void json_end_array( JsonWriter* w );
+void json_key( JsonWriter* w, const char* key );
+
+// Values
+void json_float( JsonWriter* w, float value );    // NaN / Inf become null
+void json_uint( JsonWriter* w, uint64_t value );
+void json_int( JsonWriter* w, int64_t value );
+void json_fixed( JsonWriter* w, uint64_t value, int decimals );    // value / 10^decimals, every decimal written
+void json_string( JsonWriter* w, const char* str, size_t max_len );    // Stops at NUL or max_len
+void json_null( JsonWriter* w );
+
+// Reflection - one object, or an array of count objects stride type->size. Bytes
+// fields are written as strings when they hold UTF-8 text up to a terminator with
+// only zeros after it, otherwise as JSON_BYTES_PLACEHOLDER.
+void json_write_object( JsonWriter* w, const Type* type, const void* obj );
+void json_write_array( JsonWriter* w, const Type* type, const void* objects, size_t count );
+
+// Same output as json_write_array, split into up to thread_count chunks run as jobs
+// (no more than job_thread_count), serial when that leaves one
+void json_write_array_parallel( JsonWriter* w, const Type* type, const void* objects, size_t count, int thread_count );
+
+// Shortest round-trip digits for a finite float, no terminator. Returns length (<= 16).
+int json_format_float( float value, char* out );
+
+#endif    // JSON_WRITER_H
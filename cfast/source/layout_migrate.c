@@ -0,0 +1,396 @@
+// ============================================================================
+// layout_migrate.c - Transcode live objects when a type's layout changes
+// ============================================================================
+
+#include "layout_migrate.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// ============================================================================
+// Leaf classification
+// ============================================================================
+
+static int
+numeric_width_ok( uint8_t kind, uint16_t size )
+{
+    switch ( kind )
+    {
+        case FIELD_KIND_FLOAT: return size == 4 || size == 8;
+        case FIELD_KIND_UINT32:
+        case FIELD_KIND_INT32: return size == 1 || size == 2 || size == 4 || size == 8;
+        default: return 0;
+    }
+}
+
+MigrateCode
+migrate_classify( uint8_t src_kind, uint16_t src_size, uint8_t dst_kind, uint16_t dst_size )
+{
+    if ( src_kind == dst_kind && src_size == dst_size )
+        return MIGRATE_COPY;
+    if ( numeric_width_ok( src_kind, src_size ) && numeric_width_ok( dst_kind, dst_size ) )
+        return MIGRATE_CONVERT;
+    if ( src_kind == FIELD_KIND_BYTES && dst_kind == FIELD_KIND_BYTES )
+        return MIGRATE_RESIZE;
+    return MIGRATE_DEFAULT;
+}
+
+// ============================================================================
+// Numeric conversion - one value through double / int64 / uint64
+// ============================================================================
+
+typedef struct Numeric
+{
+    uint8_t  kind;
+    double   f;
+    int64_t  i;
+    uint64_t u;
+
+} Numeric;
+
+static uint64_t
+load_unsigned( const char* src, uint16_t size )
+{
+    uint8_t  u8;
+    uint16_t u16;
+    uint32_t u32;
+    uint64_t u64;
+    switch ( size )
+    {
+        case 1: memcpy( &u8, src, 1 ); return u8;
+        case 2: memcpy( &u16, src, 2 ); return u16;
+        case 4: memcpy( &u32, src, 4 ); return u32;
+        default: memcpy( &u64, src, 8 ); return u64;
+    }
+}
+
+static int64_t
+load_signed( const char* src, uint16_t size )
+{
+    int8_t  i8;
+    int16_t i16;
+    int32_t i32;
+    int64_t i64;
+    switch ( size )
+    {
+        case 1: memcpy( &i8, src, 1 ); return i8;
+        case 2: memcpy( &i16, src, 2 ); return i16;
+        case 4: memcpy( &i32, src, 4 ); return i32;
+        default: memcpy( &i64, src, 8 ); return i64;
+    }
+}
+
+// Low size bytes, the same for signed and unsigned two's complement values
+static void
+store_bits( char* dst, uint16_t size, uint64_t value )
+{
+    uint8_t  u8  = (uint8_t)value;
+    uint16_t u16 = (uint16_t)value;
+    uint32_t u32 = (uint32_t)value;
+    switch ( size )
+    {
+        case 1: memcpy( dst, &u8, 1 ); break;
+        case 2: memcpy( dst, &u16, 2 ); break;
+        case 4: memcpy( dst, &u32, 4 ); break;
+        default: memcpy( dst, &value, 8 ); break;
+    }
+}
+
+static Numeric
+numeric_load( const char* src, uint8_t kind, uint16_t size )
+{
+    Numeric n = { kind, 0, 0, 0 };
+    if ( kind == FIELD_KIND_FLOAT && size == 4 )
+    {
+        float f;
+        memcpy( &f, src, 4 );
+        n.f = f;
+    }
+    else if ( kind == FIELD_KIND_FLOAT )
+        memcpy( &n.f, src, 8 );
+    else if ( kind == FIELD_KIND_INT32 )
+        n.i = load_signed( src, size );
+    else
+        n.u = load_unsigned( src, size );
+    return n;
+}
+
+// Narrowing saturates, float to integer rounds to nearest and NaN becomes 0
+static void
+numeric_store( char* dst, uint8_t kind, uint16_t size, Numeric n )
+{
+    if ( kind == FIELD_KIND_FLOAT )
+    {
+        double d = n.kind == FIELD_KIND_FLOAT ? n.f : n.kind == FIELD_KIND_INT32 ? (double)n.i : (double)n.u;
+        float  f = (float)d;
+        if ( size == 4 )
+            memcpy( dst, &f, 4 );
+        else
+            memcpy( dst, &d, 8 );
+        return;
+    }
+
+    unsigned bits = size * 8u;
+    if ( kind == FIELD_KIND_INT32 )
+    {
+        int64_t max = (int64_t)( ( 1ull << ( bits - 1 ) ) - 1 );
+        int64_t min = -max - 1;
+        int64_t v;
+        if ( n.kind == FIELD_KIND_FLOAT )
+        {
+            double d = n.f;
+            if ( d != d )
+                v = 0;
+            else if ( d <= (double)min )
+                v = min;
+            else if ( d >= (double)max )
+                v = max;
+            else
+                v = (int64_t)( d < 0 ? d - 0.5 : d + 0.5 );
+        }
+        else if ( n.kind == FIELD_KIND_INT32 )
+            v = n.i < min ? min : n.i > max ? max : n.i;
+        else
+            v = n.u > (uint64_t)max ? max : (int64_t)n.u;
+        store_bits( dst, size, (uint64_t)v );
+        return;
+    }
+
+    uint64_t max = bits == 64 ? UINT64_MAX : ( 1ull << bits ) - 1;
+    uint64_t v;
+    if ( n.kind == FIELD_KIND_FLOAT )
+    {
+        double d = n.f;
+        if ( !( d > 0 ) )    // Negative and NaN
+            v = 0;
+        else if ( d >= (double)max )
+            v = max;
+        else
+            v = (uint64_t)( d + 0.5 );
+    }
+    else if ( n.kind == FIELD_KIND_INT32 )
+        v = n.i < 0 ? 0 : (uint64_t)n.i > max ? max : (uint64_t)n.i;
+    else
+        v = n.u > max ? max : n.u;
+    store_bits( dst, size, v );
+}
+
+// ============================================================================
+// Strided loops
+// ============================================================================
+
+// Constant size memcpy so the compiler emits plain loads and stores
+#define MIGRATE_COPY_LOOP( bytes )                                                                             \
+    for ( size_t i = 0; i < count; i++ ) memcpy( dst + i * dst_stride, src + i * src_stride, bytes )
+
+static void
+copy_strided( const char* src, size_t src_stride, char* dst, size_t dst_stride, size_t size, size_t count )
+{
+    if ( src_stride == size && dst_stride == size )
+    {
+        memcpy( dst, src, size * count );    // Column to column
+        return;
+    }
+    switch ( size )
+    {
+        case 4: MIGRATE_COPY_LOOP( 4 ); break;
+        case 8: MIGRATE_COPY_LOOP( 8 ); break;
+        case 12: MIGRATE_COPY_LOOP( 12 ); break;
+        case 16: MIGRATE_COPY_LOOP( 16 ); break;
+        default: MIGRATE_COPY_LOOP( size ); break;
+    }
+}
+
+void
+migrate_apply( const MigrateOp* op, const char* src, size_t src_stride, char* dst, size_t dst_stride,
+               const char* fill, size_t count )
+{
+    switch ( op->code )
+    {
+        case MIGRATE_COPY: copy_strided( src, src_stride, dst, dst_stride, op->dst_size, count ); break;
+
+        case MIGRATE_CONVERT:
+            for ( size_t i = 0; i < count; i++ )
+            {
+                Numeric n = numeric_load( src + i * src_stride, op->src_kind, op->src_size );
+                numeric_store( dst + i * dst_stride, op->dst_kind, op->dst_size, n );
+            }
+            break;
+
+        case MIGRATE_RESIZE:
+        {
+            size_t keep = op->src_size < op->dst_size ? op->src_size : op->dst_size;
+            for ( size_t i = 0; i < count; i++ )
+            {
+                memcpy( dst + i * dst_stride, src + i * src_stride, keep );
+                memset( dst + i * dst_stride + keep, 0, op->dst_size - keep );
+            }
+            break;
+        }
+
+        default: copy_strided( fill, 0, dst, dst_stride, op->dst_size, count ); break;
+    }
+}
+
+void
+migrate_prototype( const Type* type, void* out )
+{
+    const TypeInfo* info = type_info( type );
+    void*           obj  = info->create ? info->create() : NULL;
+    if ( !obj )
+    {
+        memset( out, 0, type->size );
+        return;
+    }
+
+    memcpy( out, obj, type->size );
+    if ( info->destroy )
+        info->destroy( obj );
+    else
+        free( obj );
+}
+
+// ============================================================================
+// Compile - match leaves by path, merge runs that stay adjacent on both sides
+// ============================================================================
+
+uint16_t
+layout_leaves( const Type* type, LayoutLeaf* out, uint16_t max_count )
+{
+    FlatField flat[ MIGRATE_MAX_LEAVES ];
+    uint16_t  count = type_flatten( type, flat, MIGRATE_MAX_LEAVES );
+    for ( uint16_t i = 0; i < count && i < max_count && i < MIGRATE_MAX_LEAVES; i++ )
+    {
+        out[ i ].path_hash = flat[ i ].path_hash;
+        out[ i ].offset    = flat[ i ].offset;
+        out[ i ].size      = flat[ i ].size;
+        out[ i ].kind      = (uint8_t)field_kind( flat[ i ].field );
+    }
+    return count;
+}
+
+MigrationPlan*
+migration_compile( const Type* old_type, const Type* new_type )
+{
+    LayoutLeaf old_leaves[ MIGRATE_MAX_LEAVES ];
+    uint16_t   old_count = layout_leaves( old_type, old_leaves, MIGRATE_MAX_LEAVES );
+    if ( old_count > MIGRATE_MAX_LEAVES )
+    {
+        printf( "ERROR: %s has too many leaf fields to migrate\n", type_name( old_type ) );
+        return NULL;
+    }
+    return migration_compile_leaves( old_leaves, old_count, old_type->size, type_info( old_type )->version,
+                                     new_type );
+}
+
+MigrationPlan*
+migration_compile_leaves( const LayoutLeaf* old_leaves, uint16_t old_count, uint16_t old_size, uint8_t old_version,
+                          const Type* new_type )
+{
+    LayoutLeaf new_leaves[ MIGRATE_MAX_LEAVES ];
+    uint16_t   new_count = layout_leaves( new_type, new_leaves, MIGRATE_MAX_LEAVES );
+    if ( old_count > MIGRATE_MAX_LEAVES || new_count > MIGRATE_MAX_LEAVES )
+    {
+        printf( "ERROR: %s has too many leaf fields to migrate\n", type_name( new_type ) );
+        return NULL;
+    }
+
+    MigrateOp ops[ MIGRATE_MAX_LEAVES ];
+    uint8_t   matched[ MIGRATE_MAX_LEAVES ] = { 0 };
+    uint16_t  op_count                      = 0;
+    int       is_identity                   = old_size == new_type->size;
+    for ( uint16_t i = 0; i < new_count; i++ )
+    {
+        const LayoutLeaf* leaf = &new_leaves[ i ];
+        const LayoutLeaf* from = NULL;
+        for ( uint16_t j = 0; j < old_count && !from; j++ )
+        {
+            if ( !matched[ j ] && old_leaves[ j ].path_hash == leaf->path_hash )
+            {
+                matched[ j ] = 1;
+                from         = &old_leaves[ j ];
+            }
+        }
+
+        MigrateOp op = { MIGRATE_DEFAULT, FIELD_KIND_BYTES, leaf->kind, 0, 0, leaf->offset, leaf->size };
+        if ( from )
+        {
+            op.src_kind   = from->kind;
+            op.src_offset = from->offset;
+            op.src_size   = from->size;
+            op.code       = (uint8_t)migrate_classify( op.src_kind, op.src_size, op.dst_kind, op.dst_size );
+        }
+        is_identity &= op.code == MIGRATE_COPY && op.src_offset == op.dst_offset;
+
+        // Copies that stay adjacent on both sides, and back to back defaults, become one op
+        MigrateOp* last = op_count ? &ops[ op_count - 1 ] : NULL;
+        if ( last && last->code == op.code && last->dst_offset + last->dst_size == op.dst_offset &&
+             ( ( op.code == MIGRATE_COPY && last->src_offset + last->src_size == op.src_offset ) ||
+               op.code == MIGRATE_DEFAULT ) )
+        {
+            last->src_size = (uint16_t)( last->src_size + op.src_size );
+            last->dst_size = (uint16_t)( last->dst_size + op.dst_size );
+            last->src_kind = last->dst_kind = FIELD_KIND_BYTES;
+            continue;
+        }
+        ops[ op_count++ ] = op;
+    }
+
+    uint16_t dropped = 0;
+    for ( uint16_t j = 0; j < old_count; j++ ) dropped = (uint16_t)( dropped + !matched[ j ] );
+
+    size_t         ops_bytes = op_count * sizeof( MigrateOp );
+    MigrationPlan* plan      = (MigrationPlan*)malloc( sizeof( MigrationPlan ) + ops_bytes + new_type->size );
+    if ( !plan )
+        return NULL;
+
+    plan->type_hash   = new_type->hash;
+    plan->old_size    = old_size;
+    plan->new_size    = new_type->size;
+    plan->old_version = old_version;
+    plan->new_version = type_info( new_type )->version;
+    plan->is_identity = (uint8_t)( is_identity && dropped == 0 );
+    plan->dropped     = dropped;
+    plan->op_count    = op_count;
+    plan->defaults    = (char*)plan->ops + ops_bytes;
+    memcpy( plan->ops, ops, ops_bytes );
+    migrate_prototype( new_type, plan->defaults );
+
+    if ( !plan->is_identity && plan->old_version == plan->new_version )
+    {
+        printf( "WARNING: %s layout changed without a version bump (v%u)\n", type_name( new_type ),
+                plan->new_version );
+    }
+    return plan;
+}
+
+// ============================================================================
+// Run - op-major over blocks that stay in cache
+// ============================================================================
+
+void
+migration_run( const MigrationPlan* plan, const void* old_objects, void* new_objects, size_t count )
+{
+    const char* src = (const char*)old_objects;
+    char*       dst = (char*)new_objects;
+    if ( plan->is_identity )
+    {
+        memcpy( dst, src, (size_t)plan->new_size * count );
+        return;
+    }
+
+    for ( size_t done = 0; done < count; done += MIGRATE_BLOCK )
+    {
+        size_t      block     = count - done < MIGRATE_BLOCK ? count - done : MIGRATE_BLOCK;
+        const char* src_block = src + done * plan->old_size;
+        char*       dst_block = dst + done * plan->new_size;
+        for ( uint16_t i = 0; i < plan->op_count; i++ )
+        {
+            const MigrateOp* op = &plan->ops[ i ];
+            migrate_apply( op, src_block + op->src_offset, plan->old_size, dst_block + op->dst_offset,
+                           plan->new_size, plan->defaults + op->dst_offset, block );
+        }
+    }
+}
+
+// ============================================================================
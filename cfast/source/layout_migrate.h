@@ -0,0 +1,96 @@
+// ============================================================================
+// layout_migrate.h - Transcode live objects when a type's layout changes
+// ============================================================================
+//
+// A hot reload can hand back a Player with fields reordered, retyped, added or
+// removed. Old and new types are diffed leaf by leaf on the dotted path
+// ("transform.position.x") and compiled into a MigrationPlan: merged memcpy
+// runs for leaves that only moved, numeric conversions for retyped ones, and
+// defaults for new ones (the type's create() prototype, else zero). Leaves
+// that vanished are dropped. Running the plan is op-major over small blocks
+// of objects, so each op is a tight strided loop.
+//
+// Numeric leaves are classed by kind and size: FLOAT is float or double, UINT32
+// and INT32 cover 1, 2, 4 and 8 byte integers. Narrowing saturates, float to
+// integer rounds to nearest. BYTES keep their prefix and zero fill the rest.
+
+#ifndef LAYOUT_MIGRATE_H
+#define LAYOUT_MIGRATE_H
+
+#include "reflection_core.h"
+
+#define MIGRATE_MAX_LEAVES 256    // Flattened leaves per type
+#define MIGRATE_BLOCK      256    // Objects per op-major block
+
+typedef enum MigrateCode
+{
+    MIGRATE_COPY    = 0,    // Same kind and size, bytes move as they are
+    MIGRATE_CONVERT = 1,    // Numeric kind or width changed
+    MIGRATE_RESIZE  = 2,    // BYTES grew or shrank
+    MIGRATE_DEFAULT = 3,    // New leaf, or no sensible conversion
+
+} MigrateCode;
+
+typedef struct MigrateOp
+{
+    uint8_t  code;    // MigrateCode
+    uint8_t  src_kind;
+    uint8_t  dst_kind;
+    uint16_t src_offset;
+    uint16_t src_size;
+    uint16_t dst_offset;
+    uint16_t dst_size;
+
+} MigrateOp;
+
+// A flattened leaf as migration sees it - also how layouts are stored on disk
+typedef struct LayoutLeaf
+{
+    TypeHash path_hash;    // hash_string of the dotted path
+    uint16_t offset;
+    uint16_t size;
+    uint8_t  kind;         // FieldKind
+
+} LayoutLeaf;
+
+typedef struct MigrationPlan
+{
+    TypeHash  type_hash;
+    uint16_t  old_size;
+    uint16_t  new_size;
+    uint8_t   old_version;
+    uint8_t   new_version;
+    uint8_t   is_identity;    // Same bytes in the same places, nothing to do
+    uint16_t  dropped;        // Old leaves with no counterpart
+    uint16_t  op_count;
+    char*     defaults;       // new_size bytes, source of MIGRATE_DEFAULT
+    MigrateOp ops[];
+
+} MigrationPlan;
+
+// Leaves in declaration order, returns the total count (may exceed max_count)
+uint16_t layout_leaves( const Type* type, LayoutLeaf* out, uint16_t max_count );
+
+// Plan from old_type's layout to new_type's, NULL on error. free() when done.
+MigrationPlan* migration_compile( const Type* old_type, const Type* new_type );
+
+// Same, from a layout that is no longer registered (a file, an older session)
+MigrationPlan* migration_compile_leaves( const LayoutLeaf* old_leaves, uint16_t old_count, uint16_t old_size,
+                                         uint8_t old_version, const Type* new_type );
+
+// old_objects and new_objects must not overlap; new padding is left untouched
+void migration_run( const MigrationPlan* plan, const void* old_objects, void* new_objects, size_t count );
+
+// How a leaf of one kind and size becomes another
+MigrateCode migrate_classify( uint8_t src_kind, uint16_t src_size, uint8_t dst_kind, uint16_t dst_size );
+
+// One op over count elements. src and dst point at the leaf in the first
+// element, strides are the object size for arrays of structs and the element
+// size for columns. fill is the leaf's default value (MIGRATE_DEFAULT only).
+void migrate_apply( const MigrateOp* op, const char* src, size_t src_stride, char* dst, size_t dst_stride,
+                    const char* fill, size_t count );
+
+// A new object as the type's create() makes it (zeroed if it has none) into out
+void migrate_prototype( const Type* type, void* out );
+
+#endif    // LAYOUT_MIGRATE_H
@@ -4,9 +4,10 @@
 
 #include "reflection_core.h"
 #include "game_types.h"
+#include "job_system.h"
+#include "trace.h"
 
 #include <stdio.h>
-#include <time.h>
 
 extern void game_register_types( Registry* reg );
 void        draw_property_editor( void* obj, Type* type );
@@ -19,16 +20,23 @@ main( void )
 {
     printf( "=== Hybrid Reflection System ===\n\n" );
 
+    // Zones from every thread land in trace.json, open it in ui.perfetto.dev
+    trace_thread_name( "Main" );
+    trace_enable( 1 );
+
+    // Per-entity passes in the game module split across these
+    int job_threads = job_system_init( 0 );
+
     // Initialize core types (engine types that never change)
-    Type core_types[] = {
+    static const TypeDesc core_types[] = {
         {
-            .hash      = hash_string( "float" ),
+            .hash      = TYPE_NAME_HASH( "float" ),
             .name      = "float",
             .size      = sizeof( float ),
             .module_id = 0,    // Core module
         },
         {
-            .hash      = hash_string( "uint32" ),
+            .hash      = TYPE_NAME_HASH( "uint32" ),
             .name      = "uint32",
             .size      = sizeof( uint32_t ),
             .module_id = 0,
@@ -70,31 +78,26 @@ main( void )
         }
     }
 
-    // Fast path - direct access for game loop
-    clock_t start = clock();
-    for ( int i = 0; i < 1000000; i++ )
-    {
-        // Direct struct access - no reflection overhead
-        player.health.current = 100.0f;
-        player.transform.position.x += player.speed * 0.016f;
-    }
-    clock_t end = clock();
-    printf( "\n1M direct updates: %.3f seconds\n", (double)( end - start ) / CLOCKS_PER_SEC );
+    // Timings live in reflection_bench: warmed up, sampled, and kept
+    // honest with optimization barriers (update/direct vs update/field_*).
+    // Where time goes inside a frame or a reload: trace.json below.
 
-    // Reflection path - for tools
-    start = clock();
-    for ( int i = 0; i < 1000000; i++ )
+    printf( "\nRegistry stats:\n" );
+    printf( "  Types registered: %u\n", g_registry.id_count );
+    printf( "  Fields pooled: %u / %d\n", g_registry.field_count, MAX_FIELD_POOL );
+    printf( "  Memory used: %zu KB (hot types %zu KB)\n", sizeof( g_registry ) / 1024,
+            sizeof( g_registry.types ) / 1024 );
+    printf( "  Job threads: %d\n", job_threads );
+
+    job_system_shutdown();
+
+    FILE* trace = fopen( "trace.json", "w" );
+    if ( trace )
     {
-        // Reflection access - still pretty fast with static arrays!
-        float* health = (float*)field_get_ptr( &player, player_type, PLAYER_HEALTH );
-        *health       = 100.0f;
+        int events = trace_export_chrome( trace );
+        fclose( trace );
+        printf( "\nTrace: %d events in trace.json\n", events );
     }
-    end = clock();
-    printf( "1M reflection updates: %.3f seconds\n", (double)( end - start ) / CLOCKS_PER_SEC );
-
-    printf( "\nRegistry stats:\n" );
-    printf( "  Types registered: %u\n", g_registry.type_count );
-    printf( "  Memory used: %zu KB\n", sizeof( g_registry ) / 1024 );
 
     return 0;
 }
@@ -136,14 +139,12 @@ THE KEY INSIGHTS:
 PERFORMANCE:
 - Type lookup: O(1) with ID, O(1) average with hash
 - Field access: 1 indirection (pointer + offset)
-- Memory: ~1MB for 1000 types
+- Memory: ~390KB for 2048 types (16-byte hot records, shared field pool)
 - No allocations during runtime
 
 LIMITATIONS:
-- Fixed max types (but 1024 is plenty)
+- Fixed max types (but 2048 is plenty)
 - Types must be re-registered on reload
-- Can't remove types (only mark invalid)
-- Field names point to DLL memory (must be static strings)
 
 WHEN TO USE THIS:
 - Game with < 1000 types
@@ -199,8 +200,8 @@ LoadLibrary("editor.dll")
 
 // Tool path - still fast!
 
-    Type* t = &g_registry.types[PLAYER_TYPE_ID];  // Array index: 2 instructions
-    float* health = (char*)player + t->fields[3].offset;  // Add offset: 2 instructions
+    Type* t = type_get(PLAYER_TYPE_ID);  // Id to record: a few loads, cache it
+    float* health = (char*)player + type_field( t, 3 )->offset;  // Add offset: 2 instructions
     *health = 100;
 
 */
@@ -0,0 +1,491 @@
+// ============================================================================
+// query.c - Predicate scans over arrays of reflected objects
+// ============================================================================
+
+#include "query.h"
+#include "field_batch.h"
+#include "job_system.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined( _MSC_VER ) && !defined( __clang__ )
+#    include <intrin.h>
+#endif
+
+#define QUERY_PATH_LENGTH    128
+#define QUERY_PARALLEL_GRAIN 16    // Blocks, QUERY_BLOCK objects each
+#define QUERY_UINT_FLIP      0x80000000u
+
+static inline int
+bit_scan64( uint64_t mask )
+{
+#if defined( _MSC_VER ) && !defined( __clang__ )
+    unsigned long index;
+    _BitScanForward64( &index, mask );
+    return (int)index;
+#else
+    return __builtin_ctzll( mask );
+#endif
+}
+
+static inline int
+bit_count64( uint64_t mask )
+{
+#if defined( __GNUC__ ) || defined( __clang__ )
+    return __builtin_popcountll( mask );    // Selections are often dense, unlike dirty masks
+#else
+    int count = 0;
+    for ( ; mask; mask &= mask - 1 ) count++;
+    return count;
+#endif
+}
+
+// ============================================================================
+// Scalar - reference, and the tails of the vector loops
+// ============================================================================
+
+#define COMPARE_LOOP( test ) \
+    for ( size_t i = 0; i < count; i++ ) mask |= (uint64_t)( test ) << i
+
+static uint64_t
+compare_f32_scalar( const float* values, size_t count, QueryOp op, float value )
+{
+    uint64_t mask = 0;
+    switch ( op )
+    {
+        case QUERY_LT: COMPARE_LOOP( values[ i ] < value ); break;
+        case QUERY_LE: COMPARE_LOOP( values[ i ] <= value ); break;
+        case QUERY_GT: COMPARE_LOOP( values[ i ] > value ); break;
+        case QUERY_GE: COMPARE_LOOP( values[ i ] >= value ); break;
+        case QUERY_EQ: COMPARE_LOOP( values[ i ] == value ); break;
+        case QUERY_NE: COMPARE_LOOP( values[ i ] != value ); break;
+    }
+    return mask;
+}
+
+static uint64_t
+compare_i32_scalar( const uint32_t* values, size_t count, QueryOp op, uint32_t value, uint32_t flip )
+{
+    int32_t  v    = (int32_t)( value ^ flip );
+    uint64_t mask = 0;
+    switch ( op )
+    {
+        case QUERY_LT: COMPARE_LOOP( (int32_t)( values[ i ] ^ flip ) < v ); break;
+        case QUERY_LE: COMPARE_LOOP( (int32_t)( values[ i ] ^ flip ) <= v ); break;
+        case QUERY_GT: COMPARE_LOOP( (int32_t)( values[ i ] ^ flip ) > v ); break;
+        case QUERY_GE: COMPARE_LOOP( (int32_t)( values[ i ] ^ flip ) >= v ); break;
+        case QUERY_EQ: COMPARE_LOOP( values[ i ] == value ); break;
+        case QUERY_NE: COMPARE_LOOP( values[ i ] != value ); break;
+    }
+    return mask;
+}
+
+#if SIMD_X86
+
+// ============================================================================
+// SSE2 - 4 lanes, integer <= / >= / != as the inverse of > / < / ==
+// ============================================================================
+
+#define SSE2_LOOP_PS( cmp )                                                                          \
+    for ( ; i + 4 <= count; i += 4 )                                                                 \
+        mask |= (uint64_t)_mm_movemask_ps( cmp( _mm_loadu_ps( values + i ), v ) ) << i
+
+#define SSE2_LOOP_EPI32( cmp, invert )                                                               \
+    for ( ; i + 4 <= count; i += 4 )                                                                 \
+    {                                                                                                \
+        __m128i x = _mm_xor_si128( _mm_loadu_si128( (const __m128i*)( values + i ) ), vflip );       \
+        mask |= (uint64_t)( _mm_movemask_ps( _mm_castsi128_ps( cmp( x, v ) ) ) ^ ( invert ) ) << i; \
+    }
+
+static uint64_t
+compare_f32_sse2( const float* values, size_t count, QueryOp op, float value )
+{
+    __m128   v    = _mm_set1_ps( value );
+    uint64_t mask = 0;
+    size_t   i    = 0;
+    switch ( op )
+    {
+        case QUERY_LT: SSE2_LOOP_PS( _mm_cmplt_ps ); break;
+        case QUERY_LE: SSE2_LOOP_PS( _mm_cmple_ps ); break;
+        case QUERY_GT: SSE2_LOOP_PS( _mm_cmpgt_ps ); break;
+        case QUERY_GE: SSE2_LOOP_PS( _mm_cmpge_ps ); break;
+        case QUERY_EQ: SSE2_LOOP_PS( _mm_cmpeq_ps ); break;
+        case QUERY_NE: SSE2_LOOP_PS( _mm_cmpneq_ps ); break;
+    }
+    if ( i < count )
+        mask |= compare_f32_scalar( values + i, count - i, op, value ) << i;
+    return mask;
+}
+
+static uint64_t
+compare_i32_sse2( const uint32_t* values, size_t count, QueryOp op, uint32_t value, uint32_t flip )
+{
+    __m128i  vflip = _mm_set1_epi32( (int32_t)flip );
+    __m128i  v     = _mm_set1_epi32( (int32_t)( value ^ flip ) );
+    uint64_t mask  = 0;
+    size_t   i     = 0;
+    switch ( op )
+    {
+        case QUERY_LT: SSE2_LOOP_EPI32( _mm_cmplt_epi32, 0 ); break;
+        case QUERY_LE: SSE2_LOOP_EPI32( _mm_cmpgt_epi32, 0xF ); break;
+        case QUERY_GT: SSE2_LOOP_EPI32( _mm_cmpgt_epi32, 0 ); break;
+        case QUERY_GE: SSE2_LOOP_EPI32( _mm_cmplt_epi32, 0xF ); break;
+        case QUERY_EQ: SSE2_LOOP_EPI32( _mm_cmpeq_epi32, 0 ); break;
+        case QUERY_NE: SSE2_LOOP_EPI32( _mm_cmpeq_epi32, 0xF ); break;
+    }
+    if ( i < count )
+        mask |= compare_i32_scalar( values + i, count - i, op, value, flip ) << i;
+    return mask;
+}
+
+// ============================================================================
+// AVX2 - 8 lanes
+// ============================================================================
+
+#define AVX2_LOOP_PS( predicate )                                                                    \
+    for ( ; i + 8 <= count; i += 8 )                                                                 \
+    {                                                                                                \
+        __m256 x = _mm256_loadu_ps( values + i );                                                    \
+        mask |= (uint64_t)_mm256_movemask_ps( _mm256_cmp_ps( x, v, predicate ) ) << i;              \
+    }
+
+#define AVX2_CMPLT_EPI32( a, b ) _mm256_cmpgt_epi32( b, a )
+
+#define AVX2_LOOP_EPI32( cmp, invert )                                                                 \
+    for ( ; i + 8 <= count; i += 8 )                                                                   \
+    {                                                                                                  \
+        __m256i x = _mm256_xor_si256( _mm256_loadu_si256( (const __m256i*)( values + i ) ), vflip );   \
+        mask |= (uint64_t)( _mm256_movemask_ps( _mm256_castsi256_ps( cmp( x, v ) ) ) ^ ( invert ) ) << i; \
+    }
+
+SIMD_TARGET_AVX2 static uint64_t
+compare_f32_avx2( const float* values, size_t count, QueryOp op, float value )
+{
+    __m256   v    = _mm256_set1_ps( value );
+    uint64_t mask = 0;
+    size_t   i    = 0;
+    switch ( op )
+    {
+        case QUERY_LT: AVX2_LOOP_PS( _CMP_LT_OQ ); break;
+        case QUERY_LE: AVX2_LOOP_PS( _CMP_LE_OQ ); break;
+        case QUERY_GT: AVX2_LOOP_PS( _CMP_GT_OQ ); break;
+        case QUERY_GE: AVX2_LOOP_PS( _CMP_GE_OQ ); break;
+        case QUERY_EQ: AVX2_LOOP_PS( _CMP_EQ_OQ ); break;
+        case QUERY_NE: AVX2_LOOP_PS( _CMP_NEQ_UQ ); break;    // Unordered: NaN != x holds, as in C
+    }
+    if ( i < count )
+        mask |= compare_f32_sse2( values + i, count - i, op, value ) << i;
+    return mask;
+}
+
+SIMD_TARGET_AVX2 static uint64_t
+compare_i32_avx2( const uint32_t* values, size_t count, QueryOp op, uint32_t value, uint32_t flip )
+{
+    __m256i  vflip = _mm256_set1_epi32( (int32_t)flip );
+    __m256i  v     = _mm256_set1_epi32( (int32_t)( value ^ flip ) );
+    uint64_t mask  = 0;
+    size_t   i     = 0;
+    switch ( op )
+    {
+        case QUERY_LT: AVX2_LOOP_EPI32( AVX2_CMPLT_EPI32, 0 ); break;
+        case QUERY_LE: AVX2_LOOP_EPI32( _mm256_cmpgt_epi32, 0xFF ); break;
+        case QUERY_GT: AVX2_LOOP_EPI32( _mm256_cmpgt_epi32, 0 ); break;
+        case QUERY_GE: AVX2_LOOP_EPI32( AVX2_CMPLT_EPI32, 0xFF ); break;
+        case QUERY_EQ: AVX2_LOOP_EPI32( _mm256_cmpeq_epi32, 0 ); break;
+        case QUERY_NE: AVX2_LOOP_EPI32( _mm256_cmpeq_epi32, 0xFF ); break;
+    }
+    if ( i < count )
+        mask |= compare_i32_sse2( values + i, count - i, op, value, flip ) << i;
+    return mask;
+}
+
+#endif    // SIMD_X86
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+
+static const QueryKernels s_kernels[] = {
+    { SIMD_SCALAR, compare_f32_scalar, compare_i32_scalar },
+#if SIMD_X86
+    { SIMD_SSE2, compare_f32_sse2, compare_i32_sse2 },
+    { SIMD_AVX2, compare_f32_avx2, compare_i32_avx2 },
+#endif
+};
+
+const QueryKernels*
+query_kernels_for( SimdLevel level )
+{
+    if ( level > simd_level() )
+        return NULL;
+    for ( size_t i = 0; i < sizeof( s_kernels ) / sizeof( s_kernels[ 0 ] ); i++ )
+    {
+        if ( s_kernels[ i ].level == level )
+            return &s_kernels[ i ];
+    }
+    return NULL;
+}
+
+const QueryKernels*
+query_kernels( void )
+{
+    static const QueryKernels* best = NULL;
+    if ( !best )
+    {
+        for ( int level = simd_level(); !best && level >= SIMD_SCALAR; level-- )
+        {
+            best = query_kernels_for( (SimdLevel)level );
+        }
+    }
+    return best;
+}
+
+// ============================================================================
+// Compile
+// ============================================================================
+
+void
+query_clear( Query* query, const Type* type )
+{
+    query->type_hash  = type->hash;
+    query->generation = g_registry.generation;
+    query->term_count = 0;
+}
+
+int
+query_add( Query* query, const Type* type, const char* path, QueryOp op, double value )
+{
+    if ( query->term_count == QUERY_MAX_TERMS )
+    {
+        printf( "ERROR: Query on %s has more than %d terms\n", type_name( type ), QUERY_MAX_TERMS );
+        return 0;
+    }
+
+    FieldPath field;
+    if ( !field_path_resolve( type, path, &field ) )
+    {
+        printf( "ERROR: %s has no field %s\n", type_name( type ), path );
+        return 0;
+    }
+    int is_number = field.kind == FIELD_KIND_FLOAT || field.kind == FIELD_KIND_INT32 ||
+                    field.kind == FIELD_KIND_UINT32;
+    if ( field.size != 4 || !is_number )
+    {
+        printf( "ERROR: %s.%s is not a 4-byte number\n", type_name( type ), path );
+        return 0;
+    }
+
+    QueryTerm* term = &query->terms[ query->term_count ];
+    term->offset    = field.offset;
+    term->kind      = field.kind;
+    term->op        = (uint8_t)op;
+    if ( field.kind == FIELD_KIND_FLOAT )
+    {
+        term->value.f = (float)value;
+    }
+    else
+    {
+        double min = field.kind == FIELD_KIND_INT32 ? (double)INT32_MIN : 0.0;
+        double max = field.kind == FIELD_KIND_INT32 ? (double)INT32_MAX : (double)UINT32_MAX;
+        if ( !( value >= min && value <= max ) || value != (double)(int64_t)value )
+        {
+            printf( "ERROR: %s.%s cannot hold %g\n", type_name( type ), path, value );
+            return 0;
+        }
+        if ( field.kind == FIELD_KIND_INT32 )
+            term->value.i = (int32_t)value;
+        else
+            term->value.u = (uint32_t)value;
+    }
+    query->term_count++;
+    return 1;
+}
+
+static const char*
+skip_spaces( const char* at )
+{
+    while ( *at == ' ' || *at == '\t' ) at++;
+    return at;
+}
+
+// Length of the operator at text, 0 if there is none
+static size_t
+parse_op( const char* text, QueryOp* op )
+{
+    static const struct
+    {
+        const char* text;
+        QueryOp     op;
+    } k_ops[] = {
+        { "<=", QUERY_LE }, { ">=", QUERY_GE }, { "==", QUERY_EQ },
+        { "!=", QUERY_NE }, { "<", QUERY_LT },  { ">", QUERY_GT },
+    };
+    for ( size_t i = 0; i < sizeof( k_ops ) / sizeof( k_ops[ 0 ] ); i++ )
+    {
+        size_t length = strlen( k_ops[ i ].text );
+        if ( strncmp( text, k_ops[ i ].text, length ) == 0 )
+        {
+            *op = k_ops[ i ].op;
+            return length;
+        }
+    }
+    return 0;
+}
+
+static int
+is_path_char( char c )
+{
+    return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) || ( c >= '0' && c <= '9' ) || c == '_' ||
+           c == '.';
+}
+
+int
+query_compile( Query* query, const Type* type, const char* text )
+{
+    query_clear( query, type );
+    const char* at = skip_spaces( text );
+    for ( ;; )
+    {
+        char   path[ QUERY_PATH_LENGTH ];
+        size_t length = 0;
+        for ( ; is_path_char( *at ) && length < QUERY_PATH_LENGTH - 1; at++ ) path[ length++ ] = *at;
+        path[ length ] = 0;
+
+        QueryOp op;
+        at            = skip_spaces( at );
+        size_t symbol = length ? parse_op( at, &op ) : 0;
+        if ( !symbol )
+        {
+            printf( "ERROR: Query on %s: expected field and comparison at \"%s\"\n", type_name( type ), at );
+            return 0;
+        }
+
+        char*  end;
+        double value = strtod( at + symbol, &end );
+        if ( end == at + symbol )
+        {
+            printf( "ERROR: Query on %s: expected a number at \"%s\"\n", type_name( type ), at + symbol );
+            return 0;
+        }
+        if ( !query_add( query, type, path, op, value ) )
+            return 0;
+
+        at = skip_spaces( end );
+        if ( *at == 0 )
+            return 1;
+        if ( at[ 0 ] != '&' || at[ 1 ] != '&' )
+        {
+            printf( "ERROR: Query on %s: expected && at \"%s\"\n", type_name( type ), at );
+            return 0;
+        }
+        at = skip_spaces( at + 2 );
+    }
+}
+
+// ============================================================================
+// Scan
+// ============================================================================
+
+// Blocks from first (a multiple of QUERY_BLOCK) up to last, returns matches
+static size_t
+query_scan( const Query* query,
+            const char*  objects,
+            size_t       stride,
+            size_t       first,
+            size_t       last,
+            uint64_t*    bitmap )
+{
+    const FieldBatchKernels* batch   = field_batch_kernels();
+    const QueryKernels*      kernels = query_kernels();
+    size_t                   matches = 0;
+
+    union
+    {
+        uint32_t u[ QUERY_BLOCK ];
+        float    f[ QUERY_BLOCK ];
+    } values;
+
+    for ( size_t block = first; block < last; block += QUERY_BLOCK )
+    {
+        size_t      n    = last - block < QUERY_BLOCK ? last - block : QUERY_BLOCK;
+        uint64_t    mask = n == QUERY_BLOCK ? ~(uint64_t)0 : ( (uint64_t)1 << n ) - 1;
+        const char* base = objects + block * stride;
+        for ( uint16_t t = 0; mask && t < query->term_count; t++ )
+        {
+            const QueryTerm* term = &query->terms[ t ];
+            batch->gather32( base + term->offset, stride, n, values.u );
+            if ( term->kind == FIELD_KIND_FLOAT )
+            {
+                mask &= kernels->compare_f32( values.f, n, (QueryOp)term->op, term->value.f );
+            }
+            else
+            {
+                uint32_t flip = term->kind == FIELD_KIND_UINT32 ? QUERY_UINT_FLIP : 0;
+                mask &= kernels->compare_i32( values.u, n, (QueryOp)term->op, term->value.u, flip );
+            }
+        }
+        bitmap[ block / QUERY_BLOCK ] = mask;
+        matches += (size_t)bit_count64( mask );
+    }
+    return matches;
+}
+
+size_t
+query_select( const Query* query, const void* objects, size_t stride, size_t count, uint64_t* bitmap )
+{
+    return query_scan( query, (const char*)objects, stride, 0, count, bitmap );
+}
+
+typedef struct QueryScanJob
+{
+    const Query* query;
+    const char*  objects;
+    size_t       stride;
+    size_t       count;
+    uint64_t*    bitmap;
+
+} QueryScanJob;
+
+static void
+query_scan_range( void* data, uint32_t begin, uint32_t end )
+{
+    QueryScanJob* job   = (QueryScanJob*)data;
+    size_t        first = (size_t)begin * QUERY_BLOCK;
+    size_t        last  = (size_t)end * QUERY_BLOCK;
+    if ( last > job->count )
+        last = job->count;
+    query_scan( job->query, job->objects, job->stride, first, last, job->bitmap );
+}
+
+// Chunks own whole bitmap words, so no two threads write the same one
+size_t
+query_select_parallel( const Query* query,
+                       const void*  objects,
+                       size_t       stride,
+                       size_t       count,
+                       uint64_t*    bitmap )
+{
+    QueryScanJob job = { query, (const char*)objects, stride, count, bitmap };
+    job_parallel_for( (uint32_t)QUERY_WORDS( count ), QUERY_PARALLEL_GRAIN, query_scan_range, &job );
+
+    size_t matches = 0;
+    for ( size_t w = 0; w < QUERY_WORDS( count ); w++ ) matches += (size_t)bit_count64( bitmap[ w ] );
+    return matches;
+}
+
+size_t
+query_bitmap_indices( const uint64_t* bitmap, size_t count, uint32_t* indices )
+{
+    size_t written = 0;
+    for ( size_t w = 0; w < QUERY_WORDS( count ); w++ )
+    {
+        for ( uint64_t mask = bitmap[ w ]; mask; mask &= mask - 1 )
+        {
+            indices[ written++ ] = (uint32_t)( w * QUERY_BLOCK + (size_t)bit_scan64( mask ) );
+        }
+    }
+    return written;
+}
@@ -0,0 +1,101 @@
+// ============================================================================
+// query.h - Predicate scans over arrays of reflected objects
+// ============================================================================
+//
+// A Query is a conjunction of comparisons between 4-byte numeric fields and
+// constants, compiled from text against one Type:
+//
+//   health.current < 20 && speed > 3 && flags != 0
+//
+// Each path is resolved once at compile time. A scan then walks the objects
+// (AoS, any stride) 64 at a time: per term, the field is gathered for the
+// block (field_batch gather32) and compared with SIMD into a 64-bit mask, and
+// the masks are ANDed - terms after the first only run on blocks something
+// still matches. Each block's mask is one word of the selection bitmap.
+//
+// Floats compare as C does (NaN matches only !=), uint32 fields unsigned.
+// A query holds offsets: compile it again once the registry generation moves.
+
+#ifndef QUERY_H
+#define QUERY_H
+
+#include "reflection_core.h"
+#include "simd.h"
+
+#define QUERY_MAX_TERMS 8
+#define QUERY_BLOCK     64    // Objects per bitmap word
+#define QUERY_WORDS( count ) ( ( ( count ) + QUERY_BLOCK - 1 ) / QUERY_BLOCK )
+
+typedef enum QueryOp
+{
+    QUERY_LT = 0,
+    QUERY_LE = 1,
+    QUERY_GT = 2,
+    QUERY_GE = 3,
+    QUERY_EQ = 4,
+    QUERY_NE = 5,
+
+} QueryOp;
+
+typedef struct QueryTerm
+{
+    uint16_t offset;    // Absolute byte offset from the root object
+    uint8_t  kind;      // FIELD_KIND_FLOAT, _INT32 or _UINT32
+    uint8_t  op;        // QueryOp
+    union
+    {
+        float    f;
+        int32_t  i;
+        uint32_t u;
+    } value;
+
+} QueryTerm;
+
+typedef struct Query
+{
+    TypeHash  type_hash;
+    uint32_t  generation;    // Registry generation the paths were resolved in
+    uint16_t  term_count;
+    QueryTerm terms[ QUERY_MAX_TERMS ];
+
+} Query;
+
+// Returns 0 and prints the reason on a bad path, operator, or constant. query_add
+// ANDs one more term; a cleared query matches everything.
+int  query_compile( Query* query, const Type* type, const char* text );
+int  query_add( Query* query, const Type* type, const char* path, QueryOp op, double value );
+void query_clear( Query* query, const Type* type );
+
+static inline int
+query_is_stale( const Query* query )
+{
+    return query->generation != g_registry.generation;
+}
+
+// Bit i of bitmap[ i / 64 ] set when object i matches; writes QUERY_WORDS( count )
+// words, the last one zero past count. Returns the number of matches.
+size_t query_select( const Query* query, const void* objects, size_t stride, size_t count, uint64_t* bitmap );
+size_t query_select_parallel( const Query* query,
+                              const void*  objects,
+                              size_t       stride,
+                              size_t       count,
+                              uint64_t*    bitmap );    // Blocks spread over the job system
+
+// Set bits to ascending indices (count entries at most), returns how many
+size_t query_bitmap_indices( const uint64_t* bitmap, size_t count, uint32_t* indices );
+
+// Compare kernels per SIMD level: bit i set when values[ i ] op value, count <= 64.
+// Integers are compared signed after both sides are XORed with flip.
+typedef struct QueryKernels
+{
+    SimdLevel level;
+    uint64_t ( *compare_f32 )( const float* values, size_t count, QueryOp op, float value );
+    uint64_t ( *compare_i32 )( const uint32_t* values, size_t count, QueryOp op, uint32_t value,
+                               uint32_t flip );
+
+} QueryKernels;
+
+const QueryKernels* query_kernels( void );                   // Best variant for this CPU
+const QueryKernels* query_kernels_for( SimdLevel level );    // NULL if the CPU lacks it
+
+#endif    // QUERY_H
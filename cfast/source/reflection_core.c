@@ -2,52 +2,1079 @@
 // reflection_core.c - Implementation (in main.exe)
 // ============================================================================
 
+#ifndef _WIN32
+#    define _DEFAULT_SOURCE    // syscall
+#endif
+
 #include "reflection_core.h"
+#include "simd.h"
+#include "sync.h"
+#include "trace.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 
+#ifdef _WIN32
+#    include <windows.h>
+#else
+#    include <linux/membarrier.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
+
 // ============================================================================
 // The one global registry
 // ============================================================================
 
 Registry g_registry = { 0 };
 
+// ============================================================================
+// String interning - chunked arena (pointers never move) + open-addressed set
+// ============================================================================
+
+#define INTERN_CHUNK_SIZE ( 16 * 1024 )
+
+typedef struct InternChunk
+{
+    struct InternChunk* next;
+    size_t              used;
+    char                data[ INTERN_CHUNK_SIZE ];
+
+} InternChunk;
+
+static struct
+{
+    InternChunk* chunks;
+    const char** slots;    // Power of two, at most half full
+    uint32_t     capacity;
+    uint32_t     count;
+
+} s_intern;
+
+static const char*
+intern_store( const char* str, size_t len )
+{
+    InternChunk* chunk = s_intern.chunks;
+    if ( len + 1 > INTERN_CHUNK_SIZE )
+        return NULL;
+    if ( !chunk || chunk->used + len + 1 > INTERN_CHUNK_SIZE )
+    {
+        chunk = (InternChunk*)malloc( sizeof( InternChunk ) );
+        if ( !chunk )
+            return NULL;
+        chunk->next     = s_intern.chunks;
+        chunk->used     = 0;
+        s_intern.chunks = chunk;
+    }
+
+    char* copy = chunk->data + chunk->used;
+    memcpy( copy, str, len + 1 );
+    chunk->used += len + 1;
+    return copy;
+}
+
+static void
+intern_grow( void )
+{
+    uint32_t     capacity = s_intern.capacity ? s_intern.capacity * 2 : 1024;
+    const char** slots    = (const char**)calloc( capacity, sizeof( const char* ) );
+    for ( uint32_t i = 0; i < s_intern.capacity; i++ )
+    {
+        const char* str = s_intern.slots[ i ];
+        if ( !str )
+            continue;
+        uint32_t at = hash_string( str ) & ( capacity - 1 );
+        while ( slots[ at ] ) at = ( at + 1 ) & ( capacity - 1 );
+        slots[ at ] = str;
+    }
+    free( (void*)s_intern.slots );
+    s_intern.slots    = slots;
+    s_intern.capacity = capacity;
+}
+
+const char*
+string_intern( const char* str )
+{
+    if ( !str )
+        return NULL;
+    if ( ( s_intern.count + 1 ) * 2 > s_intern.capacity )
+        intern_grow();
+
+    uint32_t mask = s_intern.capacity - 1;
+    uint32_t at   = hash_string( str ) & mask;
+    for ( ; s_intern.slots[ at ]; at = ( at + 1 ) & mask )
+    {
+        if ( strcmp( s_intern.slots[ at ], str ) == 0 )
+            return s_intern.slots[ at ];
+    }
+
+    const char* copy = intern_store( str, strlen( str ) );
+    if ( copy )
+    {
+        s_intern.slots[ at ] = copy;
+        s_intern.count++;
+    }
+    return copy;
+}
+
+// ============================================================================
+// Hash map - control bytes probed 16 at a time
+// ============================================================================
+
+#define CTRL_EMPTY   0x00    // Zero so the static registry starts out empty
+#define CTRL_DELETED 0x01
+#define CTRL_FULL    0x80
+#define GROUP_COUNT  ( HASH_SIZE / HASH_GROUP )
+
+_Static_assert( ( GROUP_COUNT & ( GROUP_COUNT - 1 ) ) == 0, "HASH_SIZE / HASH_GROUP must be a power of two" );
+
+// djb2 is weak in its low bits; mix before splitting into group index + tag
+static inline uint32_t
+hash_mix( TypeHash hash )
+{
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+// Bit i set when ctrl[ i ] == value
+static inline uint32_t
+group_match( const uint8_t* ctrl, uint8_t value )
+{
+#if SIMD_X86
+    __m128i group = _mm_loadu_si128( (const __m128i*)ctrl );
+    return (uint32_t)_mm_movemask_epi8( _mm_cmpeq_epi8( group, _mm_set1_epi8( (char)value ) ) );
+#else
+    uint32_t mask = 0;
+    for ( int i = 0; i < HASH_GROUP; i++ ) mask |= (uint32_t)( ctrl[ i ] == value ) << i;
+    return mask;
+#endif
+}
+
+static inline int
+bit_scan( uint32_t mask )
+{
+#if defined( _MSC_VER ) && !defined( __clang__ )
+    unsigned long index;
+    _BitScanForward( &index, mask );
+    return (int)index;
+#else
+    return __builtin_ctz( mask );
+#endif
+}
+
+// Walk the probe sequence; returns the slot holding hash (and name, if given) or -1
+static int
+hash_find_slot( const TypeIndex* index, TypeHash hash, const char* name )
+{
+    uint32_t mixed = hash_mix( hash );
+    uint8_t  tag   = (uint8_t)( CTRL_FULL | ( mixed & 0x7F ) );
+    uint32_t group = ( mixed >> 7 ) & ( GROUP_COUNT - 1 );
+
+    for ( uint32_t step = 1; step <= GROUP_COUNT; step++ )
+    {
+        const uint8_t* ctrl = &index->ctrl[ group * HASH_GROUP ];
+        for ( uint32_t match = group_match( ctrl, tag ); match; match &= match - 1 )
+        {
+            int slot = (int)( group * HASH_GROUP ) + bit_scan( match );
+            if ( index->map[ slot ].hash != hash )
+                continue;
+
+            // Verify the full name - a 32-bit hash alone can collide
+            if ( name && strcmp( g_registry.infos[ index->map[ slot ].record ].name, name ) != 0 )
+                continue;
+            return slot;
+        }
+
+        // An empty byte means the key was never pushed past this group
+        if ( group_match( ctrl, CTRL_EMPTY ) )
+            return -1;
+        group = ( group + step ) & ( GROUP_COUNT - 1 );    // Triangular: visits every group
+    }
+    return -1;
+}
+
+static void
+hash_insert( TypeIndex* index, TypeHash hash, uint16_t record )
+{
+    uint32_t mixed = hash_mix( hash );
+    uint32_t group = ( mixed >> 7 ) & ( GROUP_COUNT - 1 );
+
+    for ( uint32_t step = 1; step <= GROUP_COUNT; step++ )
+    {
+        uint8_t* ctrl = &index->ctrl[ group * HASH_GROUP ];
+        uint32_t open = group_match( ctrl, CTRL_EMPTY ) | group_match( ctrl, CTRL_DELETED );
+        if ( open )
+        {
+            int slot = (int)( group * HASH_GROUP ) + bit_scan( open );
+            if ( index->ctrl[ slot ] == CTRL_DELETED )
+                index->tombstones--;
+
+            index->ctrl[ slot ]     = (uint8_t)( CTRL_FULL | ( mixed & 0x7F ) );
+            index->map[ slot ].hash   = hash;
+            index->map[ slot ].record = record;
+            index->live++;
+            return;
+        }
+        group = ( group + step ) & ( GROUP_COUNT - 1 );
+    }
+}
+
+static void
+hash_erase( TypeIndex* index, int slot )
+{
+    // A group that still has an empty byte was never full, so no probe
+    // sequence runs through it and the slot can go straight back to empty
+    const uint8_t* ctrl = &index->ctrl[ slot - slot % HASH_GROUP ];
+    if ( group_match( ctrl, CTRL_EMPTY ) )
+    {
+        index->ctrl[ slot ] = CTRL_EMPTY;
+    }
+    else
+    {
+        index->ctrl[ slot ] = CTRL_DELETED;
+        index->tombstones++;
+    }
+    index->live--;
+}
+
+// Reinsert the live entries to drop tombstones that lengthen probes
+static void
+hash_rebuild( TypeIndex* index )
+{
+    static TypeIndexEntry live[ HASH_SIZE ];
+    uint32_t              count = 0;
+
+    for ( uint32_t i = 0; i < HASH_SIZE; i++ )
+    {
+        if ( index->ctrl[ i ] & CTRL_FULL )
+        {
+            live[ count ] = index->map[ i ];
+            count++;
+        }
+    }
+
+    memset( index->ctrl, CTRL_EMPTY, sizeof( index->ctrl ) );
+    index->live       = 0;
+    index->tombstones = 0;
+    for ( uint32_t i = 0; i < count; i++ ) hash_insert( index, live[ i ].hash, live[ i ].record );
+}
+
+// Map hash to record, UINT16_MAX unmaps it. The same edits on equal copies leave them equal.
+static void
+index_apply( TypeIndex* index, TypeHash hash, uint16_t record )
+{
+    int slot = hash_find_slot( index, hash, NULL );
+    if ( record == UINT16_MAX )
+    {
+        if ( slot >= 0 )
+            hash_erase( index, slot );
+        return;
+    }
+    if ( slot >= 0 )
+    {
+        index->map[ slot ].record = record;    // A re-registered name points at the newest record
+        return;
+    }
+    if ( index->live + index->tombstones + 1 > HASH_SIZE * 7 / 8 )
+    {
+        hash_rebuild( index );
+    }
+    hash_insert( index, hash, record );
+}
+
+// ============================================================================
+// Snapshots - lock-free readers, epoch-based reuse of the writer's copy
+// ============================================================================
+//
+// A reader announces the epoch it saw in its own slot, then loads
+// index_published. A publish flips index_published and then bumps the epoch,
+// so a reader whose slot shows the new epoch (or later) cannot be probing the
+// old copy; one showing an older epoch might be. The writer checks this
+// lazily, when it next needs the old copy as its draft - by then the readers
+// are long gone and it rarely waits at all.
+//
+// The announce must be visible before the load, a store-load fence on every
+// pin. The writer, which is rare, pays for it instead: one process-wide
+// barrier before it reads the slots (membarrier / FlushProcessWriteBuffers).
+// Readers fence themselves only where that is unavailable. The draft catches
+// up by replaying index_log, the edits the other copy received.
+//
+// Records are never rewritten while the index reaches them: a changed type
+// gets a fresh record that the next publish points its name and TypeID at,
+// and the old record and pool ranges are only reused after a later draft
+// waited out the readers that could still be walking them.
+
+#define REGISTRY_MAX_READERS 64    // Threads with their own slot, the rest share s_overflow_readers
+
+typedef struct ReaderSlot
+{
+    int32_t epoch;    // Epoch seen + 1 while reading, 0 when idle
+    char    pad[ 60 ];
+
+} ReaderSlot;
+
+static ReaderSlot s_readers[ REGISTRY_MAX_READERS ];
+static int32_t    s_reader_claims;      // Slots handed out, may exceed REGISTRY_MAX_READERS
+static int32_t    s_overflow_readers;   // Slotless threads currently reading
+static int32_t    s_writer_barrier;     // 1 once the writer fences the readers, else they fence themselves (-1 unavailable)
+static int        s_write_depth;        // Writer thread only
+static int        s_draft_open;         // Writer thread only: draft differs from the published index
+
+static SYNC_THREAD_LOCAL int t_reader_slot = -1;    // -1 unclaimed, REGISTRY_MAX_READERS = overflow
+static SYNC_THREAD_LOCAL int t_read_depth;
+static SYNC_THREAD_LOCAL int t_read_index;         // Copy pinned by the outermost registry_read_begin
+static SYNC_THREAD_LOCAL int t_writer;              // Lookups on the writer thread see its draft
+
+// A full fence on every thread of the process, as if each had run sync_fence
+#ifdef _WIN32
+static int
+process_barrier_init( void )
+{
+    return 1;
+}
+
+static void
+process_barrier( void )
+{
+    FlushProcessWriteBuffers();
+}
+#else
+static int
+process_barrier_init( void )
+{
+    return syscall( SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0 ) == 0;
+}
+
+static void
+process_barrier( void )
+{
+    syscall( SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0 );
+}
+#endif
+
+void
+registry_read_begin( void )
+{
+    if ( t_read_depth++ )
+        return;
+    if ( t_reader_slot < 0 )
+    {
+        int claim     = sync_add32( &s_reader_claims, 1 ) - 1;
+        t_reader_slot = claim < REGISTRY_MAX_READERS ? claim : REGISTRY_MAX_READERS;
+    }
+    if ( t_reader_slot == REGISTRY_MAX_READERS )
+    {
+        sync_add32( &s_overflow_readers, 1 );
+    }
+    else
+    {
+        sync_store32_release( &s_readers[ t_reader_slot ].epoch, sync_load32( &g_registry.index_epoch ) + 1 );
+        if ( sync_load32( &s_writer_barrier ) > 0 )
+            sync_compiler_fence();
+        else
+            sync_fence();
+    }
+    t_read_index = sync_load32( &g_registry.index_published );
+}
+
+void
+registry_read_end( void )
+{
+    if ( --t_read_depth )
+        return;
+    if ( t_reader_slot == REGISTRY_MAX_READERS )
+        sync_add32( &s_overflow_readers, -1 );
+    else
+        sync_store32_release( &s_readers[ t_reader_slot ].epoch, 0 );
+}
+
+// The index lookups on this thread probe: the draft while this thread writes, else the pinned copy
+static inline const TypeIndex*
+index_for_read( void )
+{
+    return &g_registry.index[ t_writer ? g_registry.index_published ^ 1 : t_read_index ];
+}
+
+// Returns once no other thread can still be probing the unpublished copy
+static void
+index_wait_readers( void )
+{
+    if ( s_writer_barrier == 0 )
+        sync_store32( &s_writer_barrier, process_barrier_init() ? 1 : -1 );
+
+    int32_t epoch  = g_registry.index_epoch;
+    int32_t claims = sync_load32( &s_reader_claims );
+    if ( claims > ( t_reader_slot >= 0 ) )
+    {
+        // Threads that claim a slot after this load see the current index_published
+        if ( s_writer_barrier > 0 )
+            process_barrier();
+
+        int readers = claims < REGISTRY_MAX_READERS ? claims : REGISTRY_MAX_READERS;
+        for ( int i = 0; i < readers; i++ )
+        {
+            if ( i == t_reader_slot )
+                continue;    // The writer's own pin: it reads the draft from here on
+            for ( ;; )
+            {
+                int32_t seen = sync_load32( &s_readers[ i ].epoch );
+                if ( seen == 0 || seen - 1 - epoch >= 0 )
+                    break;
+                sync_pause();
+            }
+        }
+    }
+    while ( sync_load32( &s_overflow_readers ) > ( t_reader_slot == REGISTRY_MAX_READERS && t_read_depth ) )
+        sync_pause();
+}
+
+// Draft for the writer, brought up to date with the published index
+static TypeIndex*
+index_draft( void )
+{
+    TypeIndex* draft = &g_registry.index[ g_registry.index_published ^ 1 ];
+    if ( s_draft_open )
+        return draft;
+
+    index_wait_readers();
+    if ( g_registry.index_log_count > INDEX_LOG_SIZE )
+    {
+        memcpy( draft, &g_registry.index[ g_registry.index_published ], offsetof( TypeIndex, records ) );
+    }
+    else
+    {
+        for ( uint32_t i = 0; i < g_registry.index_log_count; i++ )
+            index_apply( draft, g_registry.index_log[ i ].hash, g_registry.index_log[ i ].record );
+    }
+
+    // type_get reads records without a pin, so they are copied one atomic store at a time
+    TypeIndex* published = &g_registry.index[ g_registry.index_published ];
+    int        all       = g_registry.index_record_log_count > INDEX_LOG_SIZE;
+    uint32_t   count     = all ? g_registry.id_count : g_registry.index_record_log_count;
+    for ( uint32_t i = 0; i < count; i++ )
+    {
+        TypeID id = all ? (TypeID)i : g_registry.index_record_log[ i ];
+        sync_store16( &draft->records[ id ], published->records[ id ] );
+    }
+    g_registry.index_log_count        = 0;
+    g_registry.index_record_log_count = 0;
+    s_draft_open               = 1;
+    t_writer                   = 1;
+    return draft;
+}
+
+// Edit the draft, remembering the edit for the copy that becomes the next draft
+static void
+index_edit( TypeIndex* draft, TypeHash hash, uint16_t record )
+{
+    index_apply( draft, hash, record );
+    if ( g_registry.index_log_count < INDEX_LOG_SIZE )
+    {
+        g_registry.index_log[ g_registry.index_log_count ].hash   = hash;
+        g_registry.index_log[ g_registry.index_log_count ].record = record;
+    }
+    if ( g_registry.index_log_count <= INDEX_LOG_SIZE )
+        g_registry.index_log_count++;
+}
+
+// Point id at record in the draft, remembered the same way. type_get reads it unpinned.
+static void
+index_edit_record( TypeIndex* draft, TypeID id, uint16_t record )
+{
+    sync_store16( &draft->records[ id ], record );
+    if ( g_registry.index_record_log_count < INDEX_LOG_SIZE )
+        g_registry.index_record_log[ g_registry.index_record_log_count ] = id;
+    if ( g_registry.index_record_log_count <= INDEX_LOG_SIZE )
+        g_registry.index_record_log_count++;
+}
+
+// Every change bumps the generation, so cached lookups on the writer thread see the draft.
+// Publishing bumps it again for everyone else.
+static void
+registry_changed( void )
+{
+    sync_add32( (int32_t*)&g_registry.generation, 1 );
+    if ( s_write_depth || !s_draft_open )
+        return;
+    sync_store32( &g_registry.index_published, g_registry.index_published ^ 1 );
+    sync_add32( &g_registry.index_epoch, 1 );
+    sync_add32( (int32_t*)&g_registry.generation, 1 );
+    s_draft_open = 0;
+    t_writer     = 0;
+    t_read_index = g_registry.index_published;    // A writer that is also pinned keeps seeing its own changes
+}
+
+static void retiring_flush( void );
+
+void
+registry_write_begin( void )
+{
+    s_write_depth++;
+}
+
+void
+registry_write_end( void )
+{
+    if ( s_write_depth > 0 && --s_write_depth == 0 )
+    {
+        if ( s_draft_open )
+            registry_changed();
+        retiring_flush();
+    }
+}
+
+// ============================================================================
+// Pool ranges - field, key and quant records of freed types are reused
+// ============================================================================
+//
+// Each pool hands out a free range (first fit) before it grows at the end.
+// Freed types give their ranges back when the write batch ends, and the next
+// range_alloc is always behind a draft that waited out the readers pinned
+// before that - the same rule that makes their slots safe to reuse.
+
+typedef struct PoolRange
+{
+    uint32_t first;
+    uint32_t count;
+
+} PoolRange;
+
+typedef struct RangePool
+{
+    PoolRange free[ MAX_TYPES ];    // Sorted, never adjacent - a live range sits between any two
+    uint32_t  free_count;
+    uint32_t* used;                 // The registry's count, the end of the highest range
+    uint32_t  capacity;
+
+} RangePool;
+
+static RangePool s_field_ranges = { .used = &g_registry.field_count, .capacity = MAX_FIELD_POOL };
+static RangePool s_key_ranges   = { .used = &g_registry.field_key_count, .capacity = MAX_FIELD_KEYS };
+static RangePool s_quant_ranges = { .used = &g_registry.field_quant_count, .capacity = MAX_FIELD_QUANTS };
+
+static int
+range_fits( const RangePool* pool, uint32_t count )
+{
+    for ( uint32_t i = 0; i < pool->free_count; i++ )
+    {
+        if ( pool->free[ i ].count >= count )
+            return 1;
+    }
+    return *pool->used + count <= pool->capacity;
+}
+
+// First record of count free ones, UINT32_MAX if the pool is full
+static uint32_t
+range_alloc( RangePool* pool, uint32_t count )
+{
+    if ( count == 0 )
+        return *pool->used;
+
+    for ( uint32_t i = 0; i < pool->free_count; i++ )
+    {
+        PoolRange* range = &pool->free[ i ];
+        if ( range->count < count )
+            continue;
+
+        uint32_t first = range->first;
+        range->first += count;
+        range->count -= count;
+        if ( range->count == 0 )
+        {
+            pool->free_count--;
+            memmove( range, range + 1, ( pool->free_count - i ) * sizeof( PoolRange ) );
+        }
+        return first;
+    }
+
+    if ( *pool->used + count > pool->capacity )
+        return UINT32_MAX;
+    uint32_t first = *pool->used;
+    *pool->used += count;
+    return first;
+}
+
+static void
+range_release( RangePool* pool, uint32_t first, uint32_t count )
+{
+    if ( count == 0 )
+        return;
+
+    uint32_t i = 0;
+    while ( i < pool->free_count && pool->free[ i ].first < first ) i++;
+
+    // Merge with the neighbours, or slot in between them
+    PoolRange* before = i > 0 ? &pool->free[ i - 1 ] : NULL;
+    PoolRange* after  = i < pool->free_count ? &pool->free[ i ] : NULL;
+    if ( before && before->first + before->count == first )
+    {
+        before->count += count;
+        if ( after && first + count == after->first )
+        {
+            before->count += after->count;
+            pool->free_count--;
+            memmove( after, after + 1, ( pool->free_count - i ) * sizeof( PoolRange ) );
+        }
+        i--;
+    }
+    else if ( after && first + count == after->first )
+    {
+        after->first = first;
+        after->count += count;
+    }
+    else
+    {
+        if ( pool->free_count >= MAX_TYPES )
+            return;    // Cannot happen, see PoolRange::free - leaked rather than overwrite one
+        memmove( &pool->free[ i + 1 ], &pool->free[ i ], ( pool->free_count - i ) * sizeof( PoolRange ) );
+        pool->free[ i ] = ( PoolRange ){ first, count };
+        pool->free_count++;
+    }
+
+    // A free range at the top shrinks the pool instead
+    PoolRange* last = &pool->free[ pool->free_count - 1 ];
+    if ( i == pool->free_count - 1 && last->first + last->count == *pool->used )
+    {
+        *pool->used = last->first;
+        pool->free_count--;
+    }
+}
+
+// ============================================================================
+// Field name lookup - perfect hash per type (hash and displace)
+// ============================================================================
+//
+// Each field name hashes to a bucket; every bucket gets a one byte seed chosen
+// so its names land in free slots of a table at most half full. A lookup is
+// then one hash, one seed, one slot and one name compare, hit or miss.
+
+static inline uint64_t
+field_key_hash( const char* name, size_t length )
+{
+    uint64_t hash = 0xcbf29ce484222325ull;    // FNV-1a
+    for ( size_t i = 0; i < length; i++ ) hash = ( hash ^ (uint8_t)name[ i ] ) * 0x100000001b3ull;
+    return hash;
+}
+
+static inline uint32_t
+field_key_bucket( uint64_t hash, uint32_t buckets )
+{
+    return (uint32_t)( ( ( hash >> 32 ) * buckets ) >> 32 );    // Range reduction without a divide
+}
+
+static inline uint32_t
+field_key_slot( uint64_t hash, uint8_t seed, uint32_t mask )
+{
+    uint64_t mixed = ( hash ^ ( seed * 0x9E3779B97F4A7C15ull ) ) * 0xBF58476D1CE4E5B9ull;
+    return (uint32_t)( mixed >> 40 ) & mask;
+}
+
+static inline int
+field_name_equals( const char* field_name, const char* name, size_t length )
+{
+    return strncmp( field_name, name, length ) == 0 && field_name[ length ] == 0;
+}
+
+// Leaves key_buckets at 0 (linear scan) if the pool is full or no seed works,
+// e.g. for duplicate field names
+static void
+field_keys_build( const Type* type, TypeInfo* info )
+{
+    info->key_bits    = 0;
+    info->key_buckets = 0;
+    uint16_t count    = type->field_count;
+    if ( count == 0 )
+        return;
+
+    uint32_t bits = 1;
+    while ( ( 1u << bits ) < 2u * count ) bits++;
+    uint32_t slots   = 1u << bits;
+    uint32_t buckets = ( count + 3u ) / 4u;
+    uint32_t first   = range_alloc( &s_key_ranges, buckets + slots );
+    if ( first == UINT32_MAX )
+        return;
+
+    uint64_t hashes[ MAX_FIELDS ];
+    uint16_t bucket_size[ MAX_FIELDS / 4 ] = { 0 };
+    for ( uint16_t i = 0; i < count; i++ )
+    {
+        const char* name = type_field( type, i )->name;
+        hashes[ i ]      = field_key_hash( name, strlen( name ) );
+        bucket_size[ field_key_bucket( hashes[ i ], buckets ) ]++;
+    }
+
+    uint8_t* seeds = &g_registry.field_keys[ first ];
+    uint8_t* table = seeds + buckets;
+    uint8_t  used[ 2 * MAX_FIELDS ] = { 0 };
+    memset( seeds, 0, buckets + slots );
+
+    // Biggest buckets first, while the table is emptiest
+    for ( uint32_t placed = 0; placed < buckets; placed++ )
+    {
+        uint32_t bucket = 0;
+        for ( uint32_t b = 1; b < buckets; b++ )
+        {
+            if ( bucket_size[ b ] > bucket_size[ bucket ] )
+                bucket = b;
+        }
+        if ( bucket_size[ bucket ] == 0 )
+            break;    // Only empty buckets left, their seed stays 0
+
+        int found = 0;
+        for ( uint32_t seed = 0; seed < 256 && !found; seed++ )
+        {
+            uint32_t taken[ MAX_FIELDS ];
+            uint32_t taken_count = 0;
+            found                = 1;
+            for ( uint16_t i = 0; i < count; i++ )
+            {
+                if ( field_key_bucket( hashes[ i ], buckets ) != bucket )
+                    continue;
+                uint32_t slot = field_key_slot( hashes[ i ], (uint8_t)seed, slots - 1 );
+                if ( used[ slot ] )
+                {
+                    found = 0;
+                    break;
+                }
+                used[ slot ]           = 1;
+                table[ slot ]          = (uint8_t)i;
+                taken[ taken_count++ ] = slot;
+            }
+            if ( found )
+            {
+                seeds[ bucket ] = (uint8_t)seed;
+                break;
+            }
+            for ( uint32_t t = 0; t < taken_count; t++ ) used[ taken[ t ] ] = 0;    // Undo, try the next seed
+        }
+        if ( !found )
+        {
+            range_release( &s_key_ranges, first, buckets + slots );
+            return;
+        }
+        bucket_size[ bucket ] = 0;    // Placed
+    }
+
+    info->key_bits    = (uint8_t)bits;
+    info->key_buckets = (uint8_t)buckets;
+    info->key_first   = first;
+}
+
+int
+type_field_index( const Type* type, const char* name, size_t length )
+{
+    const TypeInfo* info = type_info( type );
+    if ( info->key_buckets )
+    {
+        uint64_t       hash  = field_key_hash( name, length );
+        const uint8_t* seeds = &g_registry.field_keys[ info->key_first ];
+        uint8_t        seed  = seeds[ field_key_bucket( hash, info->key_buckets ) ];
+        uint8_t        index = seeds[ info->key_buckets + field_key_slot( hash, seed, ( 1u << info->key_bits ) - 1 ) ];
+
+        // Empty slots read as field 0, whose name then fails to match
+        return field_name_equals( type_field( type, index )->name, name, length ) ? index : -1;
+    }
+
+    for ( uint16_t i = 0; i < type->field_count; i++ )
+    {
+        if ( field_name_equals( type_field( type, i )->name, name, length ) )
+            return i;
+    }
+    return -1;
+}
+
 // ============================================================================
 // Register a type into the registry
 // ============================================================================
 
-TypeID
-type_register( const Type* type_info )
+// Reload rounds: records of types a module unregistered in the current write
+// batch. The ones it registers again unchanged stay as they are; a changed one
+// keeps its TypeID in a fresh record, and the old records are freed at the end
+// with the dropped ones.
+static uint16_t s_retiring[ MAX_TYPES ];      // Indexed until unregistered, candidates to keep
+static uint16_t s_retiring_count;
+static uint16_t s_superseded[ MAX_TYPES ];    // Older records of a name registered again, just freed
+static uint16_t s_superseded_count;
+static TypeID   s_changed[ MAX_TYPES ];       // Layouts changed this round, so are the types nesting them
+static uint16_t s_changed_count;
+
+static int
+type_changed( TypeID id )
 {
-    if ( g_registry.type_count >= MAX_TYPES )
+    for ( uint16_t i = 0; i < s_changed_count; i++ )
     {
-        printf( "ERROR: Type limit reached!\n" );
+        if ( s_changed[ i ] == id )
+            return 1;
+    }
+    return 0;
+}
+
+// Retired type of this module with this name, index in s_retiring or -1
+static int
+retiring_find( TypeHash hash, const char* name, uint8_t module_id )
+{
+    for ( int i = 0; i < s_retiring_count; i++ )
+    {
+        uint16_t record = s_retiring[ i ];
+        if ( g_registry.types[ record ].hash == hash && g_registry.infos[ record ].module_id == module_id &&
+             strcmp( g_registry.infos[ record ].name, name ) == 0 )
+            return i;
+    }
+    return -1;
+}
+
+// Fields, keys and quants of a freed record back to their pools
+static void
+type_release_ranges( uint16_t record )
+{
+    const Type*     type = &g_registry.types[ record ];
+    const TypeInfo* info = &g_registry.infos[ record ];
+    range_release( &s_field_ranges, type->field_first, type->field_count );
+    if ( info->key_buckets )
+        range_release( &s_key_ranges, info->key_first, info->key_buckets + ( 1u << info->key_bits ) );
+    if ( info->quant_first != UINT32_MAX )
+        range_release( &s_quant_ranges, info->quant_first, type->field_count );
+}
+
+// Called once the removals are published: no reader can find these any more,
+// and the next draft waits out readers still probing the copy that could.
+// A TypeID goes with its record unless it moved on to a fresh one.
+static void
+retiring_flush( void )
+{
+    const TypeIndex* published = &g_registry.index[ g_registry.index_published ];
+    for ( uint16_t i = 0; i < s_retiring_count + s_superseded_count; i++ )
+    {
+        uint16_t record = i < s_retiring_count ? s_retiring[ i ] : s_superseded[ i - s_retiring_count ];
+        TypeID   id     = g_registry.types[ record ].id;
+        type_release_ranges( record );
+        g_registry.infos[ record ].state                      = TYPE_FREE;
+        g_registry.free_types[ g_registry.free_type_count++ ] = record;
+        if ( published->records[ id ] == record )
+            g_registry.free_ids[ g_registry.free_id_count++ ] = id;
+    }
+    s_retiring_count   = 0;
+    s_superseded_count = 0;
+    s_changed_count    = 0;
+}
+
+// Would registering desc over this record leave it as it is
+static int
+type_layout_equal( uint16_t record, const TypeDesc* desc, const TypeID* nested, int quantized )
+{
+    const Type*     type = &g_registry.types[ record ];
+    const TypeInfo* info = &g_registry.infos[ record ];
+    if ( type->size != desc->size || type->alignment != desc->alignment || type->field_count != desc->field_count ||
+         ( info->quant_first != UINT32_MAX ) != quantized )
         return 0;
+
+    for ( uint16_t i = 0; i < desc->field_count; i++ )
+    {
+        const Field* old   = type_field( type, i );
+        const Field* field = &desc->fields[ i ];
+        if ( old->offset != field->offset || old->size != field->size || old->type_id != nested[ i ] ||
+             old->flags != field->flags || strcmp( old->name, field->name ) != 0 )
+            return 0;
+        if ( nested[ i ] && type_changed( nested[ i ] ) )
+            return 0;
+        if ( !quantized || !( field->flags & FIELD_QUANTIZED ) )
+            continue;
+
+        const FieldQuant* q = &g_registry.field_quants[ info->quant_first + i ];
+        if ( q->min != desc->quants[ i ].min || q->max != desc->quants[ i ].max || q->bits != desc->quants[ i ].bits )
+            return 0;
     }
+    return 1;
+}
 
-    // TODO: check if type already exists (but could be reload).
+// Layout records of a free record from desc, in ranges type_add checked fit.
+// No reader reaches the record until the index points the name and id at it.
+static void
+type_write( uint16_t record, TypeID id, TypeHash hash, const TypeDesc* desc, const TypeID* nested, int quantized )
+{
+    // Fields copied to the pool, names interned so they survive the module being unloaded
+    uint32_t first  = range_alloc( &s_field_ranges, desc->field_count );
+    Field*   fields = &g_registry.fields[ first ];
+    for ( uint16_t i = 0; i < desc->field_count; i++ )
+    {
+        fields[ i ]         = desc->fields[ i ];
+        fields[ i ].name    = string_intern( desc->fields[ i ].name );
+        fields[ i ].type_id = nested[ i ];
+    }
 
-    // Find or allocate type slot
-    TypeID id = g_registry.type_count++;
+    // Hot part
+    Type* type        = &g_registry.types[ record ];
+    type->hash        = hash;
+    type->id          = id;
+    type->size        = desc->size;
+    type->alignment   = desc->alignment;
+    type->field_count = desc->field_count;
+    type->field_first = first;
 
-    // Copy type info
-    g_registry.types[ id ]    = *type_info;
-    g_registry.types[ id ].id = id;
+    // Cold part - layout lookups
+    TypeInfo* info = &g_registry.infos[ record ];
+    field_keys_build( type, info );
 
-    // Update hash map for fast lookup (place in next++ index if used)
-    TypeHash hash       = type_info->hash;
-    size_t   hash_index = hash % ( MAX_TYPES * 2 );
-    while ( g_registry.hash_map[ hash_index ].hash != 0 )
+    info->quant_first = UINT32_MAX;
+    if ( quantized )
     {
-        hash_index = ( hash_index + 1 ) % ( MAX_TYPES * 2 );
+        uint32_t quant_first = range_alloc( &s_quant_ranges, desc->field_count );
+        memcpy( &g_registry.field_quants[ quant_first ], desc->quants, desc->field_count * sizeof( FieldQuant ) );
+        info->quant_first = quant_first;
+    }
+}
+
+static TypeID
+type_add( const TypeDesc* desc )
+{
+    if ( desc->field_count > MAX_FIELDS )
+    {
+        printf( "ERROR: Field limit reached registering %s!\n", desc->name );
+        return 0;
     }
-    g_registry.hash_map[ hash_index ].hash = hash;
-    g_registry.hash_map[ hash_index ].id   = id;
+
+    // Quantization rules are copied for every field, so a quantized type needs field_count slots
+    int quantized = 0;
+    for ( uint16_t i = 0; desc->quants && i < desc->field_count; i++ )
+    {
+        if ( !( desc->fields[ i ].flags & FIELD_QUANTIZED ) )
+            continue;
+        const FieldQuant* q = &desc->quants[ i ];
+        if ( q->bits == 0 || q->bits > FIELD_QUANT_MAX_BITS || !( q->max > q->min ) )
+        {
+            printf( "ERROR: Bad quantization on %s.%s!\n", desc->name, desc->fields[ i ].name );
+            return 0;
+        }
+        quantized = 1;
+    }
+
+    // Same hash, different name: refuse rather than let lookups return the wrong type
+    TypeHash   hash     = desc->hash ? desc->hash : hash_string( desc->name );
+    TypeIndex* draft    = index_draft();
+    int        existing = hash_find_slot( draft, hash, NULL );
+    if ( existing >= 0 )
+    {
+        const char* other = g_registry.infos[ draft->map[ existing ].record ].name;
+        if ( strcmp( other, desc->name ) != 0 )
+        {
+            printf( "ERROR: Type hash collision between %s and %s!\n", desc->name, other );
+            return 0;
+        }
+    }
+
+    // Nested field types named in the table resolve to whatever is registered now
+    TypeID nested[ MAX_FIELDS ];
+    for ( uint16_t i = 0; i < desc->field_count; i++ )
+    {
+        const char* name = desc->field_types ? desc->field_types[ i ] : NULL;
+        nested[ i ]      = desc->fields[ i ].type_id;
+        if ( !name || !name[ 0 ] )
+            continue;
+        int slot = hash_find_slot( draft, hash_string( name ), name );
+        if ( slot < 0 )
+        {
+            printf( "ERROR: Unknown type %s for %s.%s!\n", name, desc->name, desc->fields[ i ].name );
+            return 0;
+        }
+        nested[ i ] = g_registry.types[ draft->map[ slot ].record ].id;
+    }
+
+    // Registered again by the module that just retired it: same record if the layout is unchanged
+    int retired = retiring_find( hash, desc->name, desc->module_id );
+    int rewrite = retired < 0 || !type_layout_equal( s_retiring[ retired ], desc, nested, quantized );
+    if ( ( rewrite && g_registry.type_count >= MAX_TYPES && g_registry.free_type_count == 0 ) ||
+         ( retired < 0 && g_registry.id_count >= MAX_TYPES && g_registry.free_id_count == 0 ) )
+    {
+        printf( "ERROR: Type limit reached!\n" );
+        return 0;
+    }
+    if ( rewrite && !range_fits( &s_field_ranges, desc->field_count ) )
+    {
+        printf( "ERROR: Field limit reached registering %s!\n", desc->name );
+        return 0;
+    }
+    if ( rewrite && quantized && !range_fits( &s_quant_ranges, desc->field_count ) )
+    {
+        printf( "ERROR: Quantization limit reached registering %s!\n", desc->name );
+        return 0;
+    }
+
+    uint16_t record  = retired >= 0 ? s_retiring[ retired ] : 0;
+    TypeID   id      = 0;
+    uint8_t  version = desc->version;
+    if ( retired >= 0 )
+    {
+        s_retiring[ retired ] = s_retiring[ --s_retiring_count ];
+        id                    = g_registry.types[ record ].id;
+
+        const TypeInfo* old = &g_registry.infos[ record ];
+        if ( rewrite && version <= old->version )
+        {
+            printf( "WARNING: %s layout changed without a version bump (v%u)\n", desc->name, old->version );
+            version = (uint8_t)( old->version + 1 );
+        }
+        else if ( !rewrite && version < old->version )
+        {
+            version = old->version;    // Keep what an earlier rewrite bumped it to
+        }
+    }
+    else
+    {
+        id = g_registry.free_id_count ? g_registry.free_ids[ --g_registry.free_id_count ] : g_registry.id_count;
+    }
+
+    if ( rewrite )
+    {
+        // A freed record, else the next one - counted in once it is written. A changed
+        // type's old record stays as it is for readers until the batch end frees it.
+        uint16_t fresh = g_registry.free_type_count ? g_registry.free_types[ --g_registry.free_type_count ]
+                                                    : g_registry.type_count;
+        if ( retired >= 0 )
+        {
+            s_superseded[ s_superseded_count++ ] = record;
+            s_changed[ s_changed_count++ ]       = id;
+        }
+        record = fresh;
+        type_write( record, id, hash, desc, nested, quantized );
+    }
+
+    // Cold part - the hooks point into the module that registered last
+    TypeInfo* info  = &g_registry.infos[ record ];
+    info->name      = string_intern( desc->name );
+    info->create    = desc->create;
+    info->destroy   = desc->destroy;
+    info->serialize = desc->serialize;
+    info->module_id = desc->module_id;
+    info->version   = version;
+    info->state     = TYPE_LIVE;
+
+    if ( record == g_registry.type_count )
+        sync_store16( &g_registry.type_count, (uint16_t)( record + 1 ) );
+
+    // Update the draft index - the name and the id point at the newest record
+    if ( rewrite )
+        index_edit_record( draft, id, record );
+    if ( id == g_registry.id_count )
+        sync_store16( &g_registry.id_count, (uint16_t)( id + 1 ) );
+    index_edit( draft, hash, record );
+    registry_changed();
 
     return id;
 }
 
+TypeID
+type_register( const TypeDesc* desc )
+{
+    TRACE_BEGIN( zone, "type_register" );
+    TypeID id = type_add( desc );
+    TRACE_END( zone );
+    return id;
+}
+
 // ============================================================================
 // Type lookup
 // ============================================================================
@@ -55,25 +1082,42 @@ type_register( const Type* type_info )
 Type*
 type_find_by_hash( TypeHash hash )
 {
-    size_t hash_index = hash % ( HASH_SIZE );
-    while ( g_registry.hash_map[ hash_index ].hash != 0 )
-    {
-        if ( g_registry.hash_map[ hash_index ].hash == hash )
-        {
-            // get id stored at hash locaiton
-            return &g_registry.types[ g_registry.hash_map[ hash_index ].id ];
-        }
-        hash_index = ( hash_index + 1 ) % ( HASH_SIZE );
-    }
-    return NULL;
+    TRACE_BEGIN( zone, "type_find_by_hash" );
+    registry_read_begin();
+    const TypeIndex* index = index_for_read();
+    int              slot  = hash_find_slot( index, hash, NULL );
+    Type*            type  = slot >= 0 ? &g_registry.types[ index->map[ slot ].record ] : NULL;
+    registry_read_end();
+    TRACE_END( zone );
+    return type;
+}
+
+Type*
+type_find_by_name( const char* name )
+{
+    TRACE_BEGIN( zone, "type_find_by_name" );
+    registry_read_begin();
+    const TypeIndex* index = index_for_read();
+    int              slot  = hash_find_slot( index, hash_string( name ), name );
+    Type*            type  = slot >= 0 ? &g_registry.types[ index->map[ slot ].record ] : NULL;
+    registry_read_end();
+    TRACE_END( zone );
+    return type;
 }
 
 Type*
 type_get( TypeID id )
 {
-    if ( id >= g_registry.type_count )
+    if ( id >= sync_load16( &g_registry.id_count ) )
         return NULL;
-    return &g_registry.types[ id ];
+
+    // The copy index_for_read would probe, else the published one. A stale copy still
+    // names a whole record, if an older one; the id check drops ids not published yet.
+    int copy = t_read_depth ? t_read_index : sync_load32( &g_registry.index_published );
+    if ( t_writer )
+        copy = g_registry.index_published ^ 1;
+    Type* type = &g_registry.types[ sync_load16( &g_registry.index[ copy ].records[ id ] ) ];
+    return type->id == id ? type : NULL;
 }
 
 // ============================================================================
@@ -83,22 +1127,170 @@ type_get( TypeID id )
 void
 type_unregister_module( uint8_t module_id )
 {
-    // Mark types from this module as invalid
-    for ( TypeID i = 0; i < g_registry.type_count; i++ )
+    // Retire types from this module - freed when the write batch ends unless registered again
+    TRACE_BEGIN( zone, "type_unregister_module" );
+    TypeIndex* draft = index_draft();
+    for ( uint16_t i = 0; i < g_registry.type_count; i++ )
     {
-        if ( g_registry.types[ i ].module_id == module_id )
+        Type*     type = &g_registry.types[ i ];
+        TypeInfo* info = &g_registry.infos[ i ];
+        if ( info->module_id != module_id || info->state != TYPE_LIVE )
+            continue;
+
+        // Clear from the draft index (only if this is the record the name currently maps to)
+        info->state = TYPE_RETIRING;
+        int slot    = hash_find_slot( draft, type->hash, NULL );
+        if ( slot >= 0 && draft->map[ slot ].record == i )
         {
-            // Clear from hash map
-            TypeHash hash       = g_registry.types[ i ].hash;
-            size_t   hash_index = hash % ( HASH_SIZE );
-            while ( g_registry.hash_map[ hash_index ].hash != hash )
-            {
-                hash_index = ( hash_index + 1 ) % ( HASH_SIZE );
-            }
-            g_registry.hash_map[ hash_index ].hash = 0;
-            g_registry.hash_map[ hash_index ].id   = 0;
+            index_edit( draft, type->hash, UINT16_MAX );
+            s_retiring[ s_retiring_count++ ] = i;
+        }
+        else
+        {
+            s_superseded[ s_superseded_count++ ] = i;
         }
     }
+    registry_changed();
+    if ( !s_write_depth )
+        retiring_flush();
+    TRACE_END( zone );
 }
 
-// ============================================================================
\ No newline at end of file
+// ============================================================================
+// Flatten nested types into primitive leaves
+// ============================================================================
+
+Type*
+field_nested_type( const Field* field )
+{
+    if ( field->type_id == 0 )
+        return NULL;
+    Type* nested = type_get( field->type_id );
+    return ( nested && nested->field_count ) ? nested : NULL;
+}
+
+// Path hashes continue hash_string across "parent." so a leaf's hash is that of its full dotted path
+static TypeHash
+path_hash_append( TypeHash hash, const char* str )
+{
+    while ( *str ) hash = ( ( hash << 5 ) + hash ) + *str++;
+    return hash;
+}
+
+static uint16_t
+flatten_recursive( const Type* type, uint16_t base, TypeHash prefix, FlatField* out, uint16_t max_count,
+                   uint16_t count )
+{
+    for ( uint16_t i = 0; i < type->field_count; i++ )
+    {
+        const Field* field  = type_field( type, i );
+        Type*        nested = field_nested_type( field );
+        TypeHash     path   = path_hash_append( prefix, field->name );
+        if ( nested )
+        {
+            count = flatten_recursive( nested, (uint16_t)( base + field->offset ), path_hash_append( path, "." ), out,
+                                       max_count, count );
+            continue;
+        }
+
+        if ( count < max_count )
+        {
+            out[ count ].field     = field;
+            out[ count ].offset    = (uint16_t)( base + field->offset );
+            out[ count ].size      = field->size;
+            out[ count ].path_hash = path;
+        }
+        count++;
+    }
+    return count;
+}
+
+uint16_t
+type_flatten( const Type* type, FlatField* out, uint16_t max_count )
+{
+    return flatten_recursive( type, 0, hash_string( "" ), out, max_count, 0 );
+}
+
+// ============================================================================
+// Field kinds and paths
+// ============================================================================
+
+FieldKind
+field_kind( const Field* field )
+{
+    FieldKind kind = (FieldKind)( ( field->flags & FIELD_KIND_MASK ) >> FIELD_KIND_SHIFT );
+    if ( kind != FIELD_KIND_AUTO )
+        return kind;
+    if ( field_nested_type( field ) )
+        return FIELD_KIND_STRUCT;
+    return field->size == sizeof( float ) ? FIELD_KIND_FLOAT : FIELD_KIND_BYTES;
+}
+
+int
+field_path_resolve( const Type* type, const char* path, FieldPath* out )
+{
+    uint16_t offset = 0;
+    while ( type )
+    {
+        const char* dot = strchr( path, '.' );
+        size_t      len = dot ? (size_t)( dot - path ) : strlen( path );
+
+        const Field* found = NULL;
+        for ( uint16_t i = 0; i < type->field_count && !found; i++ )
+        {
+            const Field* field = type_field( type, i );
+            if ( strncmp( field->name, path, len ) == 0 && field->name[ len ] == 0 )
+                found = field;
+        }
+        if ( !found )
+            return 0;
+
+        offset       = (uint16_t)( offset + found->offset );
+        Type* nested = field_nested_type( found );
+        if ( !dot )
+        {
+            out->field   = found;
+            out->offset  = offset;
+            out->size    = found->size;
+            out->kind    = (uint8_t)field_kind( found );
+            out->type_id = nested ? nested->id : 0;
+            return 1;
+        }
+        type = nested;
+        path = dot + 1;
+    }
+    return 0;
+}
+
+int
+field_ref_resolve( FieldRef* ref )
+{
+    // Generation read first: a change racing the lookup resolves again next call.
+    // One pin covers the lookup and the walk over its fields.
+    uint32_t generation = sync_load32( (volatile int32_t*)&g_registry.generation );
+    registry_read_begin();
+    Type* type = type_find_by_name( ref->type_name );
+    ref->valid = type && field_path_resolve( type, ref->path, &ref->resolved );
+    registry_read_end();
+    ref->generation = generation;
+    return ref->valid;
+}
+
+Type*
+type_handle_resolve( TypeHandle* handle )
+{
+    if ( !handle->hash )
+        handle->hash = hash_string( handle->name );
+
+    // Generation read first: a change racing the probe resolves again next call
+    uint32_t generation = sync_load32( (volatile int32_t*)&g_registry.generation );
+    registry_read_begin();
+    const TypeIndex* index = index_for_read();
+    int              slot  = hash_find_slot( index, handle->hash, handle->name );
+    handle->type           = slot >= 0 ? &g_registry.types[ index->map[ slot ].record ] : NULL;
+    registry_read_end();
+    handle->generation = generation;
+    return handle->type;
+}
+
+// ============================================================================
@@ -9,18 +9,23 @@
 // Key Design: Fixed-size arrays, but dynamically populated
 // -----------------------------------------------------------------------------
 
-#define MAX_TYPES   1024                 // Fixed limit - but 1024 types is huge
-#define MAX_FIELDS  32                   // Max fields per type
-#define MAX_MODULES 16                   // Max loaded DLLs
-#define HASH_SIZE   ( MAX_TYPES * 2 )    // 2x size for good distribution
+#define MAX_TYPES        2048                      // Fixed limit - costs 16 hot + 48 cold bytes each
+#define MAX_FIELDS       256                       // Max fields per type (no per-type storage cost)
+#define MAX_FIELD_POOL   ( MAX_TYPES * 4 )         // Fields across all types, freed ranges reused
+#define MAX_FIELD_KEYS   ( MAX_FIELD_POOL * 4 )    // Bytes of per-type field name hash tables
+#define MAX_FIELD_QUANTS ( MAX_FIELD_POOL / 4 )    // Quantization rules, only types that declare any
+#define MAX_MODULES      16                        // Max loaded DLLs
+#define HASH_SIZE        ( MAX_TYPES * 2 )         // 2x size for good distribution
+#define HASH_GROUP       16                        // Control bytes probed per SIMD compare
+#define INDEX_LOG_SIZE   256                       // Index edits replayed onto the next draft, more copy it whole
 
 typedef uint32_t TypeHash;    // Simple hash for lookup
-typedef uint16_t TypeID;      // Index into type array
+typedef uint16_t TypeID;      // Stable id, mapped to the type's current record
 
 // Field descriptor - minimal but enough for editors
 typedef struct Field
 {
-    const char* name;       // Points to static string in DLL
+    const char* name;       // Interned by the registry, outlives the DLL
     uint16_t    offset;     // Byte offset in struct
     uint16_t    size;       // Size in bytes
     uint16_t    type_id;    // Type of this field
@@ -28,27 +33,63 @@ typedef struct Field
 
 } Field;
 
-// flag = 1     // editables
+// Field::flags - low byte holds behaviour bits, top nibble the primitive kind
+#define FIELD_EDITABLE      0x0001
+#define FIELD_QUANTIZED     0x0002    // TypeDesc::quants has this field's rule
+#define FIELD_KIND_SHIFT    12
+#define FIELD_KIND_MASK     0xF000
+#define FIELD_KIND_FLAG( k ) ( (uint16_t)( ( k ) << FIELD_KIND_SHIFT ) )
+
+typedef enum FieldKind
+{
+    FIELD_KIND_AUTO   = 0,    // Not tagged: nested type -> struct, 4 bytes -> float, else bytes
+    FIELD_KIND_FLOAT  = 1,
+    FIELD_KIND_UINT32 = 2,
+    FIELD_KIND_INT32  = 3,
+    FIELD_KIND_BYTES  = 4,    // char arrays, opaque blobs
+    FIELD_KIND_STRUCT = 5,    // Nested registered type
+
+} FieldKind;
+
+// Replication quantization: floats in [min, max] sent as bits-wide fixed point,
+// values outside clamp. On a struct field the rule covers every float leaf
+// below it, unless a nested field declares its own.
+#define FIELD_QUANT_MAX_BITS 24    // Grid steps still fit a float mantissa
+
+typedef struct FieldQuant
+{
+    float   min;
+    float   max;
+    uint8_t bits;    // 1..FIELD_QUANT_MAX_BITS
+
+} FieldQuant;
 
 // -----------------------------------------------------------------------------
-// Type descriptor - everything needed for tooling
+// Type descriptor - split so lookups and field access stay on one cache line
 // -----------------------------------------------------------------------------
 
+// Hot part - everything lookups and field access touch (4 per cache line)
 typedef struct Type
 {
-    // Identity
-    TypeHash    hash;    // Hash of name (for lookup)
-    const char* name;    // Human readable name
-
-    TypeID id;    // Index in array (stable across reloads, assigned a registration)
+    TypeHash hash;    // Hash of name (for lookup)
+    TypeID   id;      // Kept by reloads, a changed layout moves it to a new record
 
     // Layout
     uint16_t size;         // sizeof(Type)
     uint16_t alignment;    // alignof(Type)
 
-    // Fields (TODO: make union for type data)
-    Field   fields[ MAX_FIELDS ];
-    uint8_t field_count;
+    // Fields - a range in g_registry.fields
+    uint16_t field_count;
+    uint32_t field_first;
+
+} Type;
+
+_Static_assert( sizeof( Type ) == 16, "Type is the hot record, keep it small" );
+
+// Cold part - names, hooks and bookkeeping, same record index as Type
+typedef struct TypeInfo
+{
+    const char* name;    // Human readable name (interned)
 
     // Functions (optional)
     void* ( *create )( void );         // Allocator
@@ -59,24 +100,100 @@ typedef struct Type
     uint8_t module_id;    // Which DLL owns this type
     uint8_t version;      // Type version for hot reload
 
-} Type;
+    // Field name perfect hash in g_registry.field_keys: key_buckets seeds,
+    // then 2^key_bits slot -> field index bytes. key_buckets 0 = linear scan.
+    uint8_t  key_bits;
+    uint8_t  key_buckets;
+    uint32_t key_first;
+
+    uint32_t quant_first;    // g_registry.field_quants index of field 0, UINT32_MAX if none
+
+    uint8_t state;    // TYPE_LIVE, TYPE_RETIRING or TYPE_FREE
+
+} TypeInfo;
+
+// TypeInfo::state - a module's types retire when it unregisters them. Registering
+// a retired name again before the write batch ends keeps its TypeID, and its
+// record if unchanged; the rest are freed when the batch ends and their ids and
+// records go to later new types.
+#define TYPE_LIVE     0
+#define TYPE_RETIRING 1
+#define TYPE_FREE     2
+
+// Registration input - the field table is copied into the shared pool, so it
+// may live in a module's .rodata (see type_table.h). hash 0 = hash the name.
+typedef struct TypeDesc
+{
+    TypeHash     hash;
+    const char*  name;
+    uint16_t     size;
+    uint16_t     alignment;
+    const Field* fields;
+    uint16_t     field_count;
+
+    const FieldQuant*  quants;         // Optional, parallel to fields, read where FIELD_QUANTIZED is set
+    const char* const* field_types;    // Optional, parallel to fields: nested type name ("" none), sets type_id
+
+    void* ( *create )( void );
+    void ( *destroy )( void* obj );
+    void ( *serialize )( void* obj, void* stream );
+
+    uint8_t module_id;
+    uint8_t version;
+
+} TypeDesc;
 
 // -----------------------------------------------------------------------------
 // The global type registry - static array, no allocation!
 // -----------------------------------------------------------------------------
 
+// Fast lookup table - open addressing, probed a 16-slot group at a time.
+// Control byte: 0 = empty, 1 = deleted (tombstone), 0x80 | 7 hash bits = full.
+typedef struct TypeIndexEntry
+{
+    TypeHash hash;
+    uint16_t record;    // Index in g_registry.types / infos
+
+} TypeIndexEntry;
+
+typedef struct TypeIndex
+{
+    uint8_t        ctrl[ HASH_SIZE ];
+    TypeIndexEntry map[ HASH_SIZE ];    // 2x size for good distribution
+
+    uint16_t live;          // Full slots
+    uint16_t tombstones;    // Deleted slots, rebuilt away when they pile up
+
+    uint16_t records[ MAX_TYPES ];    // TypeID -> record, moved when a reload changes the layout. Last, see index_draft
+
+} TypeIndex;
+
 typedef struct Registry
 {
-    Type     types[ MAX_TYPES ];    // All types
-    uint16_t type_count;            // How many registered
+    Type     types[ MAX_TYPES ];    // Type records (hot), found through TypeIndex
+    TypeInfo infos[ MAX_TYPES ];    // Same index (cold)
+    uint16_t type_count;            // Records in use, freed ones wait in free_types
+    uint16_t id_count;              // TypeIDs handed out, freed ones wait in free_ids
 
-    // Fast lookup table
-    struct
-    {
-        TypeHash hash;
-        TypeID   id;
+    Field    fields[ MAX_FIELD_POOL ];    // Every type's fields, a range each
+    uint32_t field_count;                 // End of the highest range in use
+
+    uint8_t  field_keys[ MAX_FIELD_KEYS ];    // Field name hash tables, see TypeInfo
+    uint32_t field_key_count;
 
-    } hash_map[ HASH_SIZE ];    // 2x size for good distribution
+    FieldQuant field_quants[ MAX_FIELD_QUANTS ];    // Per field of types with quantized fields
+    uint32_t   field_quant_count;
+
+    // Readers probe the published index while the writer edits the other one
+    TypeIndex index[ 2 ];
+    int32_t   index_published;    // 0 or 1
+    int32_t   index_epoch;        // Bumped on every publish
+
+    // Edits in the published index the other copy lacks, record UINT16_MAX = erased
+    TypeIndexEntry index_log[ INDEX_LOG_SIZE ];
+    uint32_t       index_log_count;    // INDEX_LOG_SIZE + 1 once it overflowed
+    TypeID         index_record_log[ INDEX_LOG_SIZE ];    // Ids whose record moved, same rule
+    uint32_t       index_record_log_count;
 
     // Module tracking for hot reload
     struct
@@ -90,6 +207,13 @@ typedef struct Registry
 
     uint8_t module_count;    // Number of dll
 
+    uint16_t free_types[ MAX_TYPES ];    // Records of removed types, reused before type_count grows
+    uint16_t free_type_count;
+    TypeID   free_ids[ MAX_TYPES ];      // Ids of removed types, reused before id_count grows
+    uint16_t free_id_count;
+
+    uint32_t generation;    // Bumped on every register / unregister, invalidates cached lookups
+
 } Registry;
 
 // Global registry - single instance in main.exe
@@ -99,18 +223,186 @@ extern Registry g_registry;
 // Core API - Simple and fast
 // -----------------------------------------------------------------------------
 
+// Threads: one thread registers and unregisters, any thread may look types up
+// at the same time without locks. A lookup pins the index it probes with the
+// current epoch; the writer edits the other copy, publishes it by flipping
+// index_published and bumping the epoch, and only reuses the old copy once
+// no reader is pinned at an older epoch. Records the index reaches are never
+// rewritten; freed records and pool ranges wait for the same epochs.
+//
+// Reloads keep TypeIDs: a module unregisters its types and registers them again
+// in one write batch. A name registered again with the same layout keeps its
+// record as is. A changed one keeps its TypeID and gets a bumped version in a
+// fresh record, and so does every type nesting it; the index maps the id to it
+// from the publish at the batch end, so a pinned reader sees all of a reload or
+// none of it and never waits. Caches keyed by TypeID survive, checking the
+// record they compiled against. A Type* kept across the reload still shows the
+// old record until the next registration may reuse it - type_get the id again,
+// or use a TypeHandle. Types the module no longer registers, and the old
+// records of changed ones, are freed when the batch ends; their ids, records and
+// pool ranges go to later new types. Registering a live name outside such a
+// round still adds a new type superseding the old one.
+void registry_read_begin( void );     // Pin one snapshot across several lookups, nests
+void registry_read_end( void );
+void registry_write_begin( void );    // Batch changes, readers see none of them until the end. Nests.
+void registry_write_end( void );
+
 // Basic registration
-TypeID type_register( const Type* type_info );
+TypeID type_register( const TypeDesc* desc );
 void   type_unregister_module( uint8_t module_id );
 Type*  type_find_by_hash( TypeHash hash );
 Type*  type_find_by_name( const char* name );
-Type*  type_get( TypeID id );
+Type*  type_get( TypeID id );    // Current record, as of the pinned snapshot if any
+
+// Interned strings - one stable copy per distinct string, owned by the core so
+// names outlive the module that registered them. Equal strings share a pointer.
+// Registry writer thread only.
+const char* string_intern( const char* str );
+
+// Hot / cold accessors - the cold part sits at the same record index
+static inline uint16_t
+type_record( const Type* type )
+{
+    return (uint16_t)( type - g_registry.types );
+}
+
+static inline Field*
+type_field( const Type* type, uint16_t field_index )
+{
+    return &g_registry.fields[ type->field_first + field_index ];
+}
+
+static inline TypeInfo*
+type_info( const Type* type )
+{
+    return &g_registry.infos[ type_record( type ) ];
+}
+
+static inline const char*
+type_name( const Type* type )
+{
+    return g_registry.infos[ type_record( type ) ].name;
+}
+
+// Quantization rule declared on the field itself, NULL if none
+static inline const FieldQuant*
+type_field_quant( const Type* type, uint16_t field_index )
+{
+    const TypeInfo* info = type_info( type );
+    if ( info->quant_first == UINT32_MAX || !( type_field( type, field_index )->flags & FIELD_QUANTIZED ) )
+        return NULL;
+    return &g_registry.field_quants[ info->quant_first + field_index ];
+}
 
 // Fast field access - inlineable
 static inline void*
-field_get_ptr( void* obj, Type* type, uint8_t field_index )
+field_get_ptr( void* obj, Type* type, uint16_t field_index )
+{
+    return (char*)obj + g_registry.fields[ type->field_first + field_index ].offset;
+}
+
+// -----------------------------------------------------------------------------
+// Flattening - nested struct fields expanded to their primitive leaves
+// -----------------------------------------------------------------------------
+
+typedef struct FlatField
+{
+    const Field* field;        // Leaf field descriptor
+    uint16_t     offset;       // Absolute byte offset from the root object
+    uint16_t     size;
+    TypeHash     path_hash;    // hash_string of the dotted path, "transform.position.x"
+
+} FlatField;
+
+// Nested type of a field, or NULL for primitives (type_id 0 or a type with no fields)
+Type* field_nested_type( const Field* field );
+
+// Writes leaves in declaration order, returns total leaf count (may exceed max_count)
+uint16_t type_flatten( const Type* type, FlatField* out, uint16_t max_count );
+
+// Primitive kind, resolving FIELD_KIND_AUTO
+FieldKind field_kind( const Field* field );
+
+// Field index by name (need not be NUL terminated), -1 if absent. One hash and
+// one compare through the type's perfect hash, built at registration.
+int type_field_index( const Type* type, const char* name, size_t length );
+
+// -----------------------------------------------------------------------------
+// Field paths - "transform.position.x" flattened to one absolute offset
+// -----------------------------------------------------------------------------
+
+typedef struct FieldPath
+{
+    const Field* field;      // Target field descriptor
+    uint16_t     offset;     // Absolute byte offset from the root object
+    uint16_t     size;
+    uint8_t      kind;       // FieldKind of the target
+    TypeID       type_id;    // Nested type when kind is FIELD_KIND_STRUCT
+
+} FieldPath;
+
+// Returns 0 if any segment is missing
+int field_path_resolve( const Type* type, const char* path, FieldPath* out );
+
+static inline void*
+field_path_ptr( void* obj, const FieldPath* path )
 {
-    return (char*)obj + type->fields[ field_index ].offset;
+    return (char*)obj + path->offset;
+}
+
+// Cached binding for hot paths - resolved on first use and again only after
+// the registry generation moves (a module registered or reloaded types)
+typedef struct FieldRef
+{
+    const char* type_name;
+    const char* path;
+    uint32_t    generation;    // Registry generation of the cached result
+    uint8_t     valid;
+    FieldPath   resolved;
+
+} FieldRef;
+
+#define FIELD_REF( type_name, path ) { ( type_name ), ( path ), 0, 0, { 0 } }
+
+int field_ref_resolve( FieldRef* ref );    // Slow path, called by field_ref_get
+
+static inline const FieldPath*
+field_ref_get( FieldRef* ref )
+{
+    if ( ref->generation != g_registry.generation )
+        field_ref_resolve( ref );
+    return ref->valid ? &ref->resolved : NULL;
+}
+
+static inline void*
+field_ref_ptr( void* obj, FieldRef* ref )
+{
+    const FieldPath* path = field_ref_get( ref );
+    return path ? (char*)obj + path->offset : NULL;
+}
+
+// Cached type lookup for hot paths - the hash is folded at compile time where
+// TYPE_NAME_HASH can, and the index is probed again only after the registry
+// generation moves, e.g. a module reloaded and re-registered its types
+typedef struct TypeHandle
+{
+    const char* name;
+    TypeHash    hash;          // 0 = hash the name on first resolve
+    uint32_t    generation;    // Registry generation of the cached record
+    Type*       type;          // NULL if not registered
+
+} TypeHandle;
+
+#define TYPE_HANDLE( name ) { ( name ), TYPE_NAME_HASH( name ), 0, NULL }
+
+Type* type_handle_resolve( TypeHandle* handle );    // Slow path, called by type_handle_get
+
+static inline Type*
+type_handle_get( TypeHandle* handle )
+{
+    if ( handle->generation != g_registry.generation )
+        return type_handle_resolve( handle );
+    return handle->type;
 }
 
 // Hash function - simple and fast
@@ -122,6 +414,29 @@ hash_string( const char* str )
     return hash;
 }
 
+// hash_string of a string literal as a constant initializer, so const TypeDescs
+// carry their hash in .rodata. GCC folds indexing into a literal there; other
+// compilers get 0, which type_register replaces with hash_string( name ).
+// Names past 32 characters take the same route.
+#if defined( __GNUC__ ) && !defined( __clang__ )
+#    define TYPE_HASH_STEP( s, i, h ) \
+        ( ( h ) * ( ( i ) < sizeof( s ) - 1 ? 33u : 1u ) + ( ( i ) < sizeof( s ) - 1 ? (TypeHash)( s )[ ( i ) < sizeof( s ) ? ( i ) : 0 ] : 0u ) )
+#    define TYPE_HASH_8( s, i, h )                                                                                      \
+        TYPE_HASH_STEP( s, i + 7, TYPE_HASH_STEP( s, i + 6, TYPE_HASH_STEP( s, i + 5, TYPE_HASH_STEP( s, i + 4,    \
+        TYPE_HASH_STEP( s, i + 3, TYPE_HASH_STEP( s, i + 2, TYPE_HASH_STEP( s, i + 1, TYPE_HASH_STEP( s, i, h ) ) ) ) ) ) ) )
+#    define TYPE_NAME_HASH( s ) \
+        ( sizeof( s ) > 33 ? 0u : TYPE_HASH_8( s, 24, TYPE_HASH_8( s, 16, TYPE_HASH_8( s, 8, TYPE_HASH_8( s, 0, 5381u ) ) ) ) )
+#else
+#    define TYPE_NAME_HASH( s ) 0u
+#endif
+
+// Module entry points (get_module_info, get_module_state) must be exported
+#ifdef _WIN32
+#    define MODULE_EXPORT __declspec( dllexport )
+#else
+#    define MODULE_EXPORT __attribute__( ( visibility( "default" ) ) )
+#endif
+
 // Module interface - what each DLL exports
 typedef struct ModuleInfo
 {
@@ -0,0 +1,508 @@
+// ============================================================================
+// replicate.c - Quantized, bit-packed entity replication against acked baselines
+// ============================================================================
+
+#include "replicate.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// ============================================================================
+// Bit streams - LSB first, 64-bit accumulator
+// ============================================================================
+
+typedef struct BitWriter
+{
+    uint8_t* p;
+    uint8_t* end;
+    uint64_t acc;
+    uint32_t count;    // Bits waiting in acc
+    uint64_t total;
+    int      overflow;
+
+} BitWriter;
+
+typedef struct BitReader
+{
+    const uint8_t* p;
+    const uint8_t* end;
+    uint64_t       acc;
+    uint32_t       count;
+    uint64_t       left;    // Bits the stream still holds
+    int            overflow;
+
+} BitReader;
+
+// n <= 32, value already masked to n bits
+static inline void
+bits_put( BitWriter* w, uint32_t value, uint32_t n )
+{
+    w->acc |= (uint64_t)value << w->count;
+    w->count += n;
+    w->total += n;
+    if ( w->count < 32 )
+        return;
+    if ( w->end - w->p < 4 )
+    {
+        w->overflow = 1;
+        w->p        = w->end;
+    }
+    else
+    {
+        w->p[ 0 ] = (uint8_t)w->acc;
+        w->p[ 1 ] = (uint8_t)( w->acc >> 8 );
+        w->p[ 2 ] = (uint8_t)( w->acc >> 16 );
+        w->p[ 3 ] = (uint8_t)( w->acc >> 24 );
+        w->p += 4;
+    }
+    w->acc >>= 32;
+    w->count -= 32;
+}
+
+static void
+bits_flush( BitWriter* w )
+{
+    for ( ; w->count > 0; w->count = w->count > 8 ? w->count - 8 : 0 )
+    {
+        if ( w->p == w->end )
+        {
+            w->overflow = 1;
+            return;
+        }
+        *w->p++ = (uint8_t)w->acc;
+        w->acc >>= 8;
+    }
+}
+
+static inline uint32_t
+bits_get( BitReader* r, uint32_t n )
+{
+    if ( n > r->left )
+    {
+        r->overflow = 1;
+        return 0;
+    }
+    while ( r->count < n )
+    {
+        r->acc |= (uint64_t)( r->p < r->end ? *r->p++ : 0 ) << r->count;
+        r->count += 8;
+    }
+    uint32_t value = (uint32_t)( r->acc & ( ( (uint64_t)1 << n ) - 1 ) );
+    r->acc >>= n;
+    r->count -= n;
+    r->left -= n;
+    return value;
+}
+
+// ============================================================================
+// Leaves
+// ============================================================================
+
+static inline double
+leaf_read( const ReplicaLeaf* leaf, const char* object )
+{
+    if ( leaf->size == 8 )
+    {
+        double value;
+        memcpy( &value, object + leaf->offset, 8 );
+        return value;
+    }
+    float value;
+    memcpy( &value, object + leaf->offset, 4 );
+    return value;
+}
+
+static inline void
+leaf_write( const ReplicaLeaf* leaf, char* object, double value )
+{
+    if ( leaf->size == 8 )
+        memcpy( object + leaf->offset, &value, 8 );
+    else
+    {
+        float narrow = (float)value;
+        memcpy( object + leaf->offset, &narrow, 4 );
+    }
+}
+
+// Saturating, NaN to the bottom of the range
+static inline uint32_t
+leaf_quantize( const ReplicaLeaf* leaf, const char* object )
+{
+    double   t   = ( leaf_read( leaf, object ) - leaf->min ) * leaf->scale;
+    uint32_t top = ( 1u << leaf->bits ) - 1;
+    if ( !( t > 0.0 ) )
+        return 0;
+    return t >= top ? top : (uint32_t)( t + 0.5 );
+}
+
+static inline int
+leaf_changed( const ReplicaLeaf* leaf, const char* object, const char* base )
+{
+    if ( leaf->bits )
+        return leaf_quantize( leaf, object ) != leaf_quantize( leaf, base );
+    return memcmp( object + leaf->offset, base + leaf->offset, leaf->size ) != 0;
+}
+
+static void
+leaf_put( BitWriter* w, const ReplicaLeaf* leaf, const char* object )
+{
+    if ( leaf->bits )
+    {
+        bits_put( w, leaf_quantize( leaf, object ), leaf->bits );
+        return;
+    }
+
+    const uint8_t* p    = (const uint8_t*)object + leaf->offset;
+    uint16_t       left = leaf->size;
+    for ( ; left >= 4; left -= 4, p += 4 )
+    {
+        uint32_t value = (uint32_t)p[ 0 ] | (uint32_t)p[ 1 ] << 8 | (uint32_t)p[ 2 ] << 16 | (uint32_t)p[ 3 ] << 24;
+        bits_put( w, value, 32 );
+    }
+    for ( ; left > 0; left--, p++ ) bits_put( w, *p, 8 );
+}
+
+static void
+leaf_get( BitReader* r, const ReplicaLeaf* leaf, char* object )
+{
+    if ( leaf->bits )
+    {
+        leaf_write( leaf, object, leaf->min + bits_get( r, leaf->bits ) * leaf->step );
+        return;
+    }
+
+    uint8_t* p    = (uint8_t*)object + leaf->offset;
+    uint16_t left = leaf->size;
+    for ( ; left >= 4; left -= 4, p += 4 )
+    {
+        uint32_t value = bits_get( r, 32 );
+        p[ 0 ]         = (uint8_t)value;
+        p[ 1 ]         = (uint8_t)( value >> 8 );
+        p[ 2 ]         = (uint8_t)( value >> 16 );
+        p[ 3 ]         = (uint8_t)( value >> 24 );
+    }
+    for ( ; left > 0; left--, p++ ) *p = (uint8_t)bits_get( r, 8 );
+}
+
+// ============================================================================
+// Schema
+// ============================================================================
+
+// Leaves in declaration order; a rule on a struct field is inherited by its float leaves
+static uint16_t
+schema_walk( const Type* type, uint16_t base, const FieldQuant* inherited, ReplicaLeaf* out, uint16_t count )
+{
+    for ( uint16_t i = 0; i < type->field_count; i++ )
+    {
+        const Field*      field  = type_field( type, i );
+        const FieldQuant* quant  = type_field_quant( type, i );
+        Type*             nested = field_nested_type( field );
+        if ( !quant )
+            quant = inherited;
+        if ( nested )
+        {
+            count = schema_walk( nested, (uint16_t)( base + field->offset ), quant, out, count );
+            continue;
+        }
+        if ( count >= REPLICA_MAX_LEAVES )
+            return REPLICA_MAX_LEAVES + 1;
+
+        ReplicaLeaf* leaf = &out[ count++ ];
+        memset( leaf, 0, sizeof( *leaf ) );
+        leaf->offset = (uint16_t)( base + field->offset );
+        leaf->size   = field->size;
+        leaf->kind   = (uint8_t)field_kind( field );
+        if ( quant && leaf->kind == FIELD_KIND_FLOAT && ( leaf->size == 4 || leaf->size == 8 ) )
+        {
+            leaf->bits  = quant->bits;
+            leaf->min   = quant->min;
+            leaf->scale = ( ( 1u << quant->bits ) - 1 ) / ( (double)quant->max - quant->min );
+            leaf->step  = 1.0 / leaf->scale;
+        }
+    }
+    return count;
+}
+
+ReplicaSchema*
+replica_schema_compile( const Type* type )
+{
+    ReplicaLeaf leaves[ REPLICA_MAX_LEAVES ];
+    uint16_t    leaf_count = schema_walk( type, 0, NULL, leaves, 0 );
+    if ( leaf_count > REPLICA_MAX_LEAVES )
+    {
+        printf( "ERROR: %s has too many leaf fields to replicate\n", type_name( type ) );
+        return NULL;
+    }
+
+    size_t         leaves_bytes = leaf_count * sizeof( ReplicaLeaf );
+    ReplicaSchema* schema       = (ReplicaSchema*)calloc( 1, sizeof( ReplicaSchema ) + leaves_bytes + type->size );
+    if ( !schema )
+        return NULL;
+    schema->type_hash   = type->hash;
+    schema->object_size = type->size;
+    schema->leaf_count  = leaf_count;
+    schema->zero        = (char*)schema->leaves + leaves_bytes;
+    schema->object_bits = 1;
+    memcpy( schema->leaves, leaves, leaves_bytes );
+    for ( uint16_t i = 0; i < leaf_count; i++ )
+        schema->object_bits += 1 + ( leaves[ i ].bits ? leaves[ i ].bits : leaves[ i ].size * 8u );
+
+    // Snapped like every other baseline: a zero that is off the grid decodes as its grid point
+    replica_snap( schema, schema->zero, schema->zero, 1 );
+    return schema;
+}
+
+// ============================================================================
+// Codec
+// ============================================================================
+
+uint32_t
+replica_encode( const ReplicaSchema* schema,
+                const void*          objects,
+                uint32_t             count,
+                const void*          baseline,
+                uint32_t             baseline_count,
+                uint8_t*             out,
+                size_t               capacity )
+{
+    BitWriter w = { out, out + capacity, 0, 0, 0, 0 };
+    for ( uint32_t i = 0; i < count; i++ )
+    {
+        const char* object = (const char*)objects + (size_t)i * schema->object_size;
+        const char* base   = baseline && i < baseline_count
+                                 ? (const char*)baseline + (size_t)i * schema->object_size
+                                 : schema->zero;
+
+        uint64_t changed[ REPLICA_MAX_LEAVES / 64 ] = { 0 };
+        uint64_t any                                = 0;
+        for ( uint16_t l = 0; l < schema->leaf_count; l++ )
+        {
+            uint64_t bit = (uint64_t)leaf_changed( &schema->leaves[ l ], object, base ) << ( l & 63 );
+            changed[ l >> 6 ] |= bit;
+            any |= bit;
+        }
+
+        bits_put( &w, any != 0, 1 );
+        for ( uint16_t l = 0; any && l < schema->leaf_count; l++ )
+        {
+            uint32_t bit = (uint32_t)( changed[ l >> 6 ] >> ( l & 63 ) ) & 1;
+            bits_put( &w, bit, 1 );
+            if ( bit )
+                leaf_put( &w, &schema->leaves[ l ], object );
+        }
+    }
+    bits_flush( &w );
+    return w.overflow || w.total > UINT32_MAX ? 0 : (uint32_t)w.total;
+}
+
+int
+replica_decode( const ReplicaSchema* schema,
+                const uint8_t*       in,
+                uint32_t             bits,
+                const void*          baseline,
+                uint32_t             baseline_count,
+                void*                objects,
+                uint32_t             count )
+{
+    BitReader r = { in, in + ( bits + 7 ) / 8, 0, 0, bits, 0 };
+    for ( uint32_t i = 0; i < count && !r.overflow; i++ )
+    {
+        char*       object = (char*)objects + (size_t)i * schema->object_size;
+        const char* base   = baseline && i < baseline_count
+                                 ? (const char*)baseline + (size_t)i * schema->object_size
+                                 : schema->zero;
+        if ( object != base )
+            memcpy( object, base, schema->object_size );
+        if ( !bits_get( &r, 1 ) )
+            continue;
+
+        for ( uint16_t l = 0; l < schema->leaf_count; l++ )
+        {
+            if ( bits_get( &r, 1 ) )
+                leaf_get( &r, &schema->leaves[ l ], object );
+        }
+    }
+    return !r.overflow;
+}
+
+void
+replica_snap( const ReplicaSchema* schema, const void* objects, void* out, uint32_t count )
+{
+    if ( out != objects )
+        memcpy( out, objects, (size_t)count * schema->object_size );
+    for ( uint32_t i = 0; i < count; i++ )
+    {
+        char* object = (char*)out + (size_t)i * schema->object_size;
+        for ( uint16_t l = 0; l < schema->leaf_count; l++ )
+        {
+            const ReplicaLeaf* leaf = &schema->leaves[ l ];
+            if ( leaf->bits )
+                leaf_write( leaf, object, leaf->min + leaf_quantize( leaf, object ) * leaf->step );
+        }
+    }
+}
+
+// ============================================================================
+// Snapshot protocol
+// ============================================================================
+
+int
+replica_peer_init( ReplicaPeer* peer, const ReplicaSchema* schema, uint32_t max_objects )
+{
+    memset( peer, 0, sizeof( *peer ) );
+    peer->schema      = schema;
+    peer->max_objects = max_objects;
+    peer->sequence    = REPLICA_NONE;
+    peer->acked       = REPLICA_NONE;
+    for ( int i = 0; i < REPLICA_HISTORY; i++ )
+    {
+        peer->slot_sequence[ i ] = REPLICA_NONE;
+        peer->slots[ i ]         = (char*)malloc( (size_t)max_objects * schema->object_size + 1 );
+        if ( !peer->slots[ i ] )
+        {
+            replica_peer_free( peer );
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void
+replica_peer_free( ReplicaPeer* peer )
+{
+    for ( int i = 0; i < REPLICA_HISTORY; i++ )
+    {
+        free( peer->slots[ i ] );
+        peer->slots[ i ] = NULL;
+    }
+}
+
+// Slot holding sequence, NULL once it has been overwritten
+static const char*
+peer_state( const ReplicaPeer* peer, uint32_t sequence, uint32_t* count )
+{
+    uint32_t slot = sequence % REPLICA_HISTORY;
+    if ( sequence == REPLICA_NONE || peer->slot_sequence[ slot ] != sequence )
+        return NULL;
+    *count = peer->slot_count[ slot ];
+    return peer->slots[ slot ];
+}
+
+size_t
+replica_send( ReplicaPeer* sender, const void* objects, uint32_t count, uint8_t* packet, size_t capacity )
+{
+    if ( count > sender->max_objects || capacity < sizeof( ReplicaHeader ) )
+        return 0;
+
+    ReplicaHeader header = { sender->sequence + 1, sender->acked, count, 0 };
+    uint32_t      base_n = 0;
+    const char*   base   = peer_state( sender, sender->acked, &base_n );
+    if ( !base )
+        header.baseline = REPLICA_NONE;
+
+    header.bits = replica_encode( sender->schema, objects, count, base, base_n, packet + sizeof( header ),
+                                  capacity - sizeof( header ) );
+    if ( count && !header.bits )
+        return 0;
+    memcpy( packet, &header, sizeof( header ) );
+
+    // Remember what the receiver will rebuild, the baseline of later packets
+    uint32_t slot                 = header.sequence % REPLICA_HISTORY;
+    sender->slot_sequence[ slot ] = header.sequence;
+    sender->slot_count[ slot ]    = count;
+    sender->sequence              = header.sequence;
+    replica_snap( sender->schema, objects, sender->slots[ slot ], count );
+    return sizeof( header ) + ( header.bits + 7 ) / 8;
+}
+
+int
+replica_receive( ReplicaPeer* receiver, const uint8_t* packet, size_t size, void* objects, uint32_t* count )
+{
+    ReplicaHeader header;
+    if ( size < sizeof( header ) )
+        return 0;
+    memcpy( &header, packet, sizeof( header ) );
+    if ( header.count > receiver->max_objects || size < sizeof( header ) + ( header.bits + 7ull ) / 8 )
+        return 0;
+    if ( receiver->sequence != REPLICA_NONE && header.sequence <= receiver->sequence )
+        return 0;    // Older than what we have, or a duplicate
+
+    uint32_t    base_n = 0;
+    const char* base   = peer_state( receiver, header.baseline, &base_n );
+    if ( header.baseline != REPLICA_NONE && !base )
+        return 0;    // Baseline fell out of the history
+
+    // Decode into the slot the new sequence owns - it may be the baseline's own slot
+    uint32_t slot  = header.sequence % REPLICA_HISTORY;
+    char*    state = receiver->slots[ slot ];
+    if ( base == state )
+    {
+        memcpy( objects, base, (size_t)base_n * receiver->schema->object_size );
+        base = (const char*)objects;
+    }
+    if ( !replica_decode( receiver->schema, packet + sizeof( header ), header.bits, base, base_n, state,
+                          header.count ) )
+        return 0;
+
+    receiver->slot_sequence[ slot ] = header.sequence;
+    receiver->slot_count[ slot ]    = header.count;
+    receiver->sequence              = header.sequence;
+    memcpy( objects, state, (size_t)header.count * receiver->schema->object_size );
+    *count = header.count;
+    return 1;
+}
+
+void
+replica_ack( ReplicaPeer* sender, uint32_t sequence )
+{
+    if ( sequence == REPLICA_NONE || sequence > sender->sequence )
+        return;
+    if ( sender->acked == REPLICA_NONE || sequence > sender->acked )
+        sender->acked = sequence;
+}
+
+// ============================================================================
+// Loopback channel
+// ============================================================================
+
+Loopback*
+loopback_create( uint32_t drop_every )
+{
+    Loopback* channel = (Loopback*)calloc( 1, sizeof( Loopback ) );
+    if ( channel )
+        channel->drop_every = drop_every;
+    return channel;
+}
+
+void
+loopback_destroy( Loopback* channel )
+{
+    free( channel );
+}
+
+int
+loopback_send( Loopback* channel, const void* data, size_t size )
+{
+    if ( size > LOOPBACK_MTU || channel->tail - channel->head == LOOPBACK_SLOTS )
+        return 0;
+    if ( channel->drop_every && ++channel->sent % channel->drop_every == 0 )
+        return 1;    // Lost on the way, as far as the sender can tell it went out
+
+    uint32_t slot          = channel->tail++ % LOOPBACK_SLOTS;
+    channel->sizes[ slot ] = (uint32_t)size;
+    memcpy( channel->packets[ slot ], data, size );
+    return 1;
+}
+
+size_t
+loopback_receive( Loopback* channel, void* out, size_t capacity )
+{
+    if ( channel->head == channel->tail )
+        return 0;
+    uint32_t slot = channel->head++ % LOOPBACK_SLOTS;
+    size_t   size = channel->sizes[ slot ] < capacity ? channel->sizes[ slot ] : capacity;
+    memcpy( out, channel->packets[ slot ], size );
+    return size;
+}
+
+// ============================================================================
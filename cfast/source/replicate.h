@@ -0,0 +1,142 @@
+// ============================================================================
+// replicate.h - Quantized, bit-packed entity replication against acked baselines
+// ============================================================================
+//
+// A ReplicaSchema is a type's flattened leaves with their FieldQuant rules
+// resolved (a rule on a struct field covers the float leaves under it).
+// Objects are encoded against a baseline - the last state the receiver
+// confirmed - as a bit stream:
+//
+//   per object: 1 bit changed, and if set, per leaf: 1 bit changed + value
+//
+// Quantized floats are sent as bits-wide fixed point, everything else as its
+// raw bytes. "Changed" compares quantized values, so noise below the grid
+// costs nothing. Both ends keep states snapped to the grid (replica_snap),
+// which makes the baselines bit-identical on both sides.
+//
+// ReplicaPeer adds the snapshot protocol: the sender numbers snapshots and
+// keeps the last REPLICA_HISTORY of them, the receiver acks the newest one it
+// decoded, and the sender deltas against that. Lost packets just mean a
+// delta against an older baseline (or a full snapshot when none is left).
+// Loopback is an in-process channel with loss, for tests and the bench.
+
+#ifndef REPLICATE_H
+#define REPLICATE_H
+
+#include "reflection_core.h"
+
+#define REPLICA_MAX_LEAVES 256
+#define REPLICA_HISTORY    32            // Snapshots remembered per peer
+#define REPLICA_NONE       UINT32_MAX
+#define LOOPBACK_SLOTS     16            // Packets in flight
+#define LOOPBACK_MTU       ( 1 << 16 )    // Largest packet
+
+typedef struct ReplicaLeaf
+{
+    uint16_t offset;
+    uint16_t size;
+    uint8_t  kind;    // FieldKind
+    uint8_t  bits;    // Quantized width, 0 = raw bytes
+    double   min;
+    double   scale;    // Grid steps per unit
+    double   step;     // Units per grid step
+
+} ReplicaLeaf;
+
+typedef struct ReplicaSchema
+{
+    TypeHash    type_hash;
+    uint16_t    object_size;
+    uint16_t    leaf_count;
+    uint32_t    object_bits;    // One whole object, change flags included
+    char*       zero;           // Snapped all-zero object, baseline of new objects
+    ReplicaLeaf leaves[];
+
+} ReplicaSchema;
+
+// Packet = header + bit stream of count objects
+typedef struct ReplicaHeader
+{
+    uint32_t sequence;
+    uint32_t baseline;    // Sequence deltaed against, REPLICA_NONE = all zero
+    uint32_t count;
+    uint32_t bits;
+
+} ReplicaHeader;
+
+typedef struct ReplicaPeer
+{
+    const ReplicaSchema* schema;
+    uint32_t             max_objects;
+    uint32_t             sequence;    // Sender: last sent. Receiver: newest decoded, the ack to send.
+    uint32_t             acked;       // Sender: newest the receiver has, REPLICA_NONE before the first ack
+    uint32_t             slot_sequence[ REPLICA_HISTORY ];
+    uint32_t             slot_count[ REPLICA_HISTORY ];
+    char*                slots[ REPLICA_HISTORY ];    // Snapped states, max_objects each
+
+} ReplicaPeer;
+
+typedef struct Loopback
+{
+    uint32_t head;          // Next packet to receive
+    uint32_t tail;          // Next free slot
+    uint32_t sent;
+    uint32_t drop_every;    // Drop every Nth packet sent, 0 = lossless
+    uint32_t sizes[ LOOPBACK_SLOTS ];
+    uint8_t  packets[ LOOPBACK_SLOTS ][ LOOPBACK_MTU ];
+
+} Loopback;
+
+// ---------------------------------------------------------------------------
+// Codec
+// ---------------------------------------------------------------------------
+
+ReplicaSchema* replica_schema_compile( const Type* type );    // free() when done
+
+// Baseline objects past baseline_count (or all, if baseline is NULL) are zero.
+// Returns bits written, 0 if out is too small.
+uint32_t replica_encode( const ReplicaSchema* schema,
+                         const void*          objects,
+                         uint32_t             count,
+                         const void*          baseline,
+                         uint32_t             baseline_count,
+                         uint8_t*             out,
+                         size_t               capacity );
+
+// Rebuilds count objects from the stream and the same baseline. Returns 0 on a short stream.
+int replica_decode( const ReplicaSchema* schema,
+                    const uint8_t*       in,
+                    uint32_t             bits,
+                    const void*          baseline,
+                    uint32_t             baseline_count,
+                    void*                objects,
+                    uint32_t             count );
+
+// What the receiver will hold: quantized leaves moved onto their grid
+void replica_snap( const ReplicaSchema* schema, const void* objects, void* out, uint32_t count );
+
+// ---------------------------------------------------------------------------
+// Snapshot protocol
+// ---------------------------------------------------------------------------
+
+int  replica_peer_init( ReplicaPeer* peer, const ReplicaSchema* schema, uint32_t max_objects );
+void replica_peer_free( ReplicaPeer* peer );
+
+// Encodes the next snapshot against the newest acked one. Returns packet bytes, 0 on error.
+size_t replica_send( ReplicaPeer* sender, const void* objects, uint32_t count, uint8_t* packet, size_t capacity );
+
+// Decodes into objects (max_objects room). 0 for stale, out of order or unknown-baseline packets.
+int replica_receive( ReplicaPeer* receiver, const uint8_t* packet, size_t size, void* objects, uint32_t* count );
+
+void replica_ack( ReplicaPeer* sender, uint32_t sequence );
+
+// ---------------------------------------------------------------------------
+// Loopback channel
+// ---------------------------------------------------------------------------
+
+Loopback* loopback_create( uint32_t drop_every );
+void      loopback_destroy( Loopback* channel );
+int       loopback_send( Loopback* channel, const void* data, size_t size );    // 0 if full or too big
+size_t    loopback_receive( Loopback* channel, void* out, size_t capacity );    // 0 if nothing queued
+
+#endif    // REPLICATE_H
@@ -0,0 +1,262 @@
+// ============================================================================
+// serialize_binary.c - Compiled binary serializer
+// ============================================================================
+
+#include "serialize_binary.h"
+
+#include <stdlib.h>
+
+#define STAGING_SIZE ( 16 * 1024 )    // On the caller's stack, so job threads never share one
+
+static CopyPlan* s_plans[ MAX_TYPES ];
+
+// ============================================================================
+// Compile - flatten, then merge leaves that touch in memory
+// ============================================================================
+
+CopyPlan*
+copy_plan_compile( const Type* type )
+{
+    FlatField leaves[ COPY_PLAN_MAX_LEAVES ];
+    uint16_t  leaf_count = type_flatten( type, leaves, COPY_PLAN_MAX_LEAVES );
+    if ( leaf_count > COPY_PLAN_MAX_LEAVES )
+    {
+        printf( "ERROR: %s has too many leaf fields for a copy plan\n", type_name( type ) );
+        return NULL;
+    }
+
+    // Stream order is declaration order, so only forward-adjacent leaves merge
+    CopyRun  runs[ COPY_PLAN_MAX_LEAVES ];
+    uint16_t run_count   = 0;
+    uint32_t layout_hash = 5381;
+    uint16_t packed_size = 0;
+    for ( uint16_t i = 0; i < leaf_count; i++ )
+    {
+        const FlatField* leaf = &leaves[ i ];
+        uint32_t         kind = (uint32_t)field_kind( leaf->field );
+        layout_hash           = ( ( layout_hash << 5 ) + layout_hash ) ^ leaf->path_hash;
+        layout_hash           = ( ( layout_hash << 5 ) + layout_hash ) ^ ( kind << 16 | leaf->size );
+        packed_size           = (uint16_t)( packed_size + leaf->size );
+
+        CopyRun* last = run_count ? &runs[ run_count - 1 ] : NULL;
+        if ( last && last->offset + last->size == leaf->offset )
+        {
+            last->size = (uint16_t)( last->size + leaf->size );
+        }
+        else
+        {
+            runs[ run_count ].offset = leaf->offset;
+            runs[ run_count ].size   = leaf->size;
+            run_count++;
+        }
+    }
+
+    CopyPlan* plan    = (CopyPlan*)malloc( sizeof( CopyPlan ) + run_count * sizeof( CopyRun ) );
+    plan->type_hash   = type->hash;
+    plan->layout_hash = layout_hash;
+    plan->object_size = type->size;
+    plan->packed_size = packed_size;
+    plan->version     = type_info( type )->version;
+    plan->run_count   = run_count;
+    plan->is_dense    = run_count == 1 && runs[ 0 ].offset == 0 && runs[ 0 ].size == type->size;
+    memcpy( plan->runs, runs, run_count * sizeof( CopyRun ) );
+    return plan;
+}
+
+const CopyPlan*
+copy_plan_get( const Type* type )
+{
+    CopyPlan* plan = s_plans[ type->id ];
+    if ( plan && plan->type_hash == type->hash && plan->version == type_info( type )->version &&
+         plan->object_size == type->size )
+    {
+        return plan;
+    }
+
+    free( plan );
+    s_plans[ type->id ] = copy_plan_compile( type );
+    return s_plans[ type->id ];
+}
+
+void
+copy_plan_flush( void )
+{
+    for ( int i = 0; i < MAX_TYPES; i++ )
+    {
+        free( s_plans[ i ] );
+        s_plans[ i ] = NULL;
+    }
+}
+
+// ============================================================================
+// Execute
+// ============================================================================
+
+size_t
+copy_plan_pack( const CopyPlan* plan, const void* objects, size_t count, void* out )
+{
+    const char* src = (const char*)objects;
+    char*       dst = (char*)out;
+
+    if ( plan->is_dense )
+    {
+        memcpy( dst, src, count * plan->object_size );
+        return count * plan->packed_size;
+    }
+
+    for ( size_t i = 0; i < count; i++, src += plan->object_size )
+    {
+        for ( uint16_t r = 0; r < plan->run_count; r++ )
+        {
+            memcpy( dst, src + plan->runs[ r ].offset, plan->runs[ r ].size );
+            dst += plan->runs[ r ].size;
+        }
+    }
+    return count * plan->packed_size;
+}
+
+size_t
+copy_plan_unpack( const CopyPlan* plan, void* objects, size_t count, const void* in )
+{
+    char*       dst = (char*)objects;
+    const char* src = (const char*)in;
+
+    if ( plan->is_dense )
+    {
+        memcpy( dst, src, count * plan->object_size );
+        return count * plan->packed_size;
+    }
+
+    for ( size_t i = 0; i < count; i++, dst += plan->object_size )
+    {
+        for ( uint16_t r = 0; r < plan->run_count; r++ )
+        {
+            memcpy( dst + plan->runs[ r ].offset, src, plan->runs[ r ].size );
+            src += plan->runs[ r ].size;
+        }
+    }
+    return count * plan->packed_size;
+}
+
+// ============================================================================
+// File I/O
+// ============================================================================
+
+// Packed objects go through a stack buffer in batches; one too big for it gets a
+// heap buffer of its own and moves one object at a time
+static char*
+staging_begin( char* stack, uint16_t packed_size, size_t* batch )
+{
+    if ( packed_size <= STAGING_SIZE )
+    {
+        *batch = STAGING_SIZE / packed_size;
+        return stack;
+    }
+    *batch = 1;
+    return (char*)malloc( packed_size );
+}
+
+static void
+staging_end( char* staging, char* stack )
+{
+    if ( staging != stack )
+        free( staging );
+}
+
+int
+serialize_binary_write( FILE* file, const Type* type, const void* objects, size_t count )
+{
+    const CopyPlan* plan = copy_plan_get( type );
+    if ( !plan )
+        return 0;
+
+    BinaryHeader header = {
+        .magic       = BINARY_MAGIC,
+        .type_hash   = plan->type_hash,
+        .layout_hash = plan->layout_hash,
+        .packed_size = plan->packed_size,
+        .count       = (uint32_t)count,
+    };
+    if ( fwrite( &header, sizeof( header ), 1, file ) != 1 )
+        return 0;
+
+    if ( plan->packed_size == 0 )
+        return 1;
+    if ( plan->is_dense )
+    {
+        return fwrite( objects, plan->object_size, count, file ) == count;
+    }
+
+    // Pack through a staging buffer so stdio sees few large writes
+    char        stack[ STAGING_SIZE ];
+    size_t      batch;
+    char*       staging = staging_begin( stack, plan->packed_size, &batch );
+    const char* src     = (const char*)objects;
+    int         ok      = staging != NULL;
+    for ( size_t done = 0; ok && done < count; )
+    {
+        size_t n     = count - done < batch ? count - done : batch;
+        size_t bytes = copy_plan_pack( plan, src + done * plan->object_size, n, staging );
+        ok           = fwrite( staging, 1, bytes, file ) == bytes;
+        done += n;
+    }
+    staging_end( staging, stack );
+    return ok;
+}
+
+size_t
+deserialize_binary_read( FILE* file, const Type* type, void* objects, size_t max_count )
+{
+    const CopyPlan* plan = copy_plan_get( type );
+    BinaryHeader    header;
+    if ( !plan || fread( &header, sizeof( header ), 1, file ) != 1 )
+        return 0;
+
+    if ( header.magic != BINARY_MAGIC || header.type_hash != plan->type_hash ||
+         header.layout_hash != plan->layout_hash || header.packed_size != plan->packed_size )
+    {
+        printf( "ERROR: Binary data does not match layout of %s\n", type_name( type ) );
+        return 0;
+    }
+
+    size_t count = header.count < max_count ? header.count : max_count;
+    if ( plan->packed_size == 0 )
+        return count;
+
+    char   stack[ STAGING_SIZE ];
+    size_t batch;
+    char*  staging = staging_begin( stack, plan->packed_size, &batch );
+    if ( !staging )
+        return 0;
+
+    size_t done = 0;
+    if ( plan->is_dense )
+    {
+        done = fread( objects, plan->object_size, count, file );
+    }
+    else
+    {
+        char* dst = (char*)objects;
+        while ( done < count )
+        {
+            size_t n = count - done < batch ? count - done : batch;
+            if ( fread( staging, plan->packed_size, n, file ) != n )
+                break;
+            copy_plan_unpack( plan, dst + done * plan->object_size, n, staging );
+            done += n;
+        }
+    }
+
+    // Objects past max_count are read and dropped, so the stream ends up after the array
+    for ( size_t left = done == count ? header.count - count : 0; left; )
+    {
+        size_t n = left < batch ? left : batch;
+        if ( fread( staging, plan->packed_size, n, file ) != n )
+            break;
+        left -= n;
+    }
+    staging_end( staging, stack );
+    return done;
+}
+
+// ============================================================================
@@ -0,0 +1,67 @@
+// ============================================================================
+// serialize_binary.h - Compiled binary serializer
+// ============================================================================
+//
+// Each Type is compiled once into a CopyPlan: the flattened leaf fields with
+// adjacent ones merged into memcpy runs, padding left out. Saving an array of
+// objects is then a tight loop of memcpys (a single memcpy for padding-free
+// types) instead of per-field dispatch and formatted I/O.
+
+#ifndef SERIALIZE_BINARY_H
+#define SERIALIZE_BINARY_H
+
+#include "reflection_core.h"
+
+#include <stdio.h>
+
+#define COPY_PLAN_MAX_LEAVES 256    // Flattened leaf limit per type
+#define BINARY_MAGIC         0x4E424643u    // "CFBN"
+
+typedef struct CopyRun
+{
+    uint16_t offset;    // Source offset in the object
+    uint16_t size;      // Bytes, packed back to back in the stream
+
+} CopyRun;
+
+typedef struct CopyPlan
+{
+    TypeHash type_hash;
+    uint32_t layout_hash;    // Leaf paths, kinds and sizes in stream order
+    uint16_t object_size;    // Stride between objects in memory
+    uint16_t packed_size;    // Bytes per object in the stream
+    uint8_t  version;
+    uint8_t  is_dense;       // One run covering the whole object: arrays are a single memcpy
+    uint16_t run_count;
+    CopyRun  runs[];
+
+} CopyPlan;
+
+// Stream header written before every array
+typedef struct BinaryHeader
+{
+    uint32_t magic;
+    TypeHash type_hash;
+    uint32_t layout_hash;
+    uint32_t packed_size;
+    uint32_t count;
+
+} BinaryHeader;
+
+// Plans are cached per TypeID; flush after types are re-registered
+CopyPlan*       copy_plan_compile( const Type* type );
+const CopyPlan* copy_plan_get( const Type* type );
+void            copy_plan_flush( void );
+
+// Memory to memory, returns bytes produced / consumed
+size_t copy_plan_pack( const CopyPlan* plan, const void* objects, size_t count, void* out );
+size_t copy_plan_unpack( const CopyPlan* plan, void* objects, size_t count, const void* in );
+
+// File I/O - header + packed objects. Read returns objects loaded (0 on schema mismatch);
+// objects past max_count are skipped, so the stream is left after the array either way.
+// Staging is per call; plans are cached on first use, so get the plan once before
+// calling either from job threads.
+int    serialize_binary_write( FILE* file, const Type* type, const void* objects, size_t count );
+size_t deserialize_binary_read( FILE* file, const Type* type, void* objects, size_t max_count );
+
+#endif    // SERIALIZE_BINARY_H
@@ -0,0 +1,68 @@
+// ============================================================================
+// simd.c - CPU feature detection for runtime kernel dispatch
+// ============================================================================
+
+#include "simd.h"
+
+#if SIMD_X86 && defined( _MSC_VER ) && !defined( __clang__ )
+#    include <intrin.h>
+#endif
+
+static SimdLevel
+simd_detect( void )
+{
+#if SIMD_X86 && defined( _MSC_VER ) && !defined( __clang__ )
+    int regs[ 4 ];
+    __cpuid( regs, 1 );
+    int has_sse2    = ( regs[ 3 ] >> 26 ) & 1;
+    int has_osxsave = ( regs[ 2 ] >> 27 ) & 1;
+    int has_avx     = ( regs[ 2 ] >> 28 ) & 1;
+
+    // AVX state must be enabled by the OS, not just present in the CPU
+    int os_avx    = has_osxsave && has_avx && ( _xgetbv( 0 ) & 6 ) == 6;
+    int os_avx512 = os_avx && ( _xgetbv( 0 ) & 0xE6 ) == 0xE6;    // opmask + ZMM state
+    __cpuidex( regs, 7, 0 );
+    int has_avx2    = ( regs[ 1 ] >> 5 ) & 1;
+    int has_avx512f = ( regs[ 1 ] >> 16 ) & 1;
+
+    if ( os_avx512 && has_avx2 && has_avx512f )
+        return SIMD_AVX512;
+    if ( os_avx && has_avx2 )
+        return SIMD_AVX2;
+    return has_sse2 ? SIMD_SSE2 : SIMD_SCALAR;
+#elif SIMD_X86
+    __builtin_cpu_init();
+    if ( __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "avx512f" ) )
+        return SIMD_AVX512;
+    if ( __builtin_cpu_supports( "avx2" ) )    // Includes the OS XSAVE check
+        return SIMD_AVX2;
+    return __builtin_cpu_supports( "sse2" ) ? SIMD_SSE2 : SIMD_SCALAR;
+#else
+    return SIMD_SCALAR;
+#endif
+}
+
+SimdLevel
+simd_level( void )
+{
+    static int       detected = 0;
+    static SimdLevel level;
+    if ( !detected )
+    {
+        level    = simd_detect();
+        detected = 1;
+    }
+    return level;
+}
+
+const char*
+simd_level_name( SimdLevel level )
+{
+    switch ( level )
+    {
+        case SIMD_SSE2: return "sse2";
+        case SIMD_AVX2: return "avx2";
+        case SIMD_AVX512: return "avx512";
+        default: return "scalar";
+    }
+}
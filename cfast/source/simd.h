@@ -0,0 +1,37 @@
+// ============================================================================
+// simd.h - CPU feature detection for runtime kernel dispatch
+// ============================================================================
+
+#ifndef SIMD_H
+#define SIMD_H
+
+#if defined( __x86_64__ ) || defined( _M_X64 ) || defined( __i386__ ) || defined( _M_IX86 )
+#    define SIMD_X86 1
+#    include <immintrin.h>
+#else
+#    define SIMD_X86 0
+#endif
+
+// Per-function ISA enable, so one translation unit can hold every variant
+// and the default build flags stay at baseline x86-64
+#if SIMD_X86 && ( defined( __GNUC__ ) || defined( __clang__ ) )
+#    define SIMD_TARGET_AVX2   __attribute__( ( target( "avx2" ) ) )
+#    define SIMD_TARGET_AVX512 __attribute__( ( target( "avx512f" ) ) )
+#else
+#    define SIMD_TARGET_AVX2
+#    define SIMD_TARGET_AVX512
+#endif
+
+typedef enum SimdLevel
+{
+    SIMD_SCALAR = 0,
+    SIMD_SSE2   = 1,    // Baseline on x86-64
+    SIMD_AVX2   = 2,
+    SIMD_AVX512 = 3,    // AVX-512F: 16 lanes, hardware scatter
+
+} SimdLevel;
+
+SimdLevel   simd_level( void );    // Best level this CPU and OS support, detected once
+const char* simd_level_name( SimdLevel level );
+
+#endif    // SIMD_H
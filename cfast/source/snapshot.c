@@ -0,0 +1,627 @@
+// ============================================================================
+// snapshot.c - Memory-mapped state snapshots with an embedded schema
+// ============================================================================
+#ifdef _WIN32
+#    define _CRT_SECURE_NO_WARNINGS
+#else
+#    define _POSIX_C_SOURCE 200809L    // fileno, fsync
+#endif
+
+#include "snapshot.h"
+#include "layout_migrate.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#    include <windows.h>
+#else
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <unistd.h>
+#endif
+
+// ============================================================================
+// On-disk records
+// ============================================================================
+
+typedef enum SectionKind
+{
+    SECTION_ARRAY  = 1,    // count objects of a type, stride type size
+    SECTION_COLUMN = 2,    // count elements of one leaf of a type (one per SoA column)
+    SECTION_BLOB   = 3,    // Opaque bytes
+
+} SectionKind;
+
+typedef struct SnapshotHeader
+{
+    uint32_t magic;
+    uint16_t version;
+    uint16_t section_count;
+    uint32_t page_size;
+    uint16_t type_count;
+    uint16_t reserved;
+    uint32_t leaf_count;
+    uint32_t reserved2;
+    uint64_t file_size;    // Catches truncated files
+    uint64_t tables_offset;
+
+} SnapshotHeader;
+
+typedef struct SnapshotSection
+{
+    char     name[ SNAPSHOT_NAME_MAX ];
+    uint16_t kind;          // SectionKind
+    uint16_t type_index;    // Into the type table, unused for blobs
+    uint32_t leaf;          // SECTION_COLUMN: leaf index within the type
+    uint64_t count;
+    uint64_t offset;        // Page aligned
+    uint64_t size;
+
+} SnapshotSection;
+
+typedef struct SnapshotType
+{
+    char     name[ SNAPSHOT_NAME_MAX ];
+    TypeHash hash;
+    uint16_t size;
+    uint8_t  version;
+    uint8_t  reserved;
+    uint32_t leaf_first;
+    uint32_t leaf_count;
+
+} SnapshotType;
+
+typedef struct SnapshotLeaf
+{
+    TypeHash path_hash;
+    uint16_t offset;
+    uint16_t size;
+    uint8_t  kind;
+    uint8_t  reserved[ 3 ];
+
+} SnapshotLeaf;
+
+_Static_assert( sizeof( SnapshotHeader ) == 40, "snapshot header layout is part of the file format" );
+_Static_assert( sizeof( SnapshotSection ) == 80, "snapshot section layout is part of the file format" );
+_Static_assert( sizeof( SnapshotType ) == 64, "snapshot type layout is part of the file format" );
+_Static_assert( sizeof( SnapshotLeaf ) == 12, "snapshot leaf layout is part of the file format" );
+
+static uint64_t
+page_align( uint64_t offset )
+{
+    return ( offset + SNAPSHOT_PAGE - 1 ) & ~(uint64_t)( SNAPSHOT_PAGE - 1 );
+}
+
+static int
+copy_name( char* out, const char* name )
+{
+    size_t length = strlen( name );
+    if ( length >= SNAPSHOT_NAME_MAX )
+    {
+        printf( "ERROR: Snapshot name too long: %s\n", name );
+        return 0;
+    }
+    memset( out, 0, SNAPSHOT_NAME_MAX );
+    memcpy( out, name, length );
+    return 1;
+}
+
+// ============================================================================
+// Writer
+// ============================================================================
+
+struct SnapshotWriter
+{
+    SnapshotSection sections[ SNAPSHOT_MAX_SECTIONS ];
+    const void*     data[ SNAPSHOT_MAX_SECTIONS ];
+    uint16_t        section_count;
+
+    SnapshotType types[ SNAPSHOT_MAX_TYPES ];
+    uint16_t     type_count;
+
+    SnapshotLeaf leaves[ SNAPSHOT_MAX_TYPES * MIGRATE_MAX_LEAVES ];
+    uint32_t     leaf_count;
+};
+
+SnapshotWriter*
+snapshot_writer_create( void )
+{
+    return (SnapshotWriter*)calloc( 1, sizeof( SnapshotWriter ) );
+}
+
+void
+snapshot_writer_free( SnapshotWriter* w )
+{
+    free( w );
+}
+
+// Index of type in the schema table, added on first use. -1 when full.
+static int
+writer_type( SnapshotWriter* w, const Type* type )
+{
+    const TypeInfo* info = type_info( type );
+    for ( uint16_t i = 0; i < w->type_count; i++ )
+    {
+        const SnapshotType* t = &w->types[ i ];
+        if ( t->hash == type->hash && t->size == type->size && t->version == info->version )
+            return i;
+    }
+
+    LayoutLeaf leaves[ MIGRATE_MAX_LEAVES ];
+    uint16_t   leaf_count = layout_leaves( type, leaves, MIGRATE_MAX_LEAVES );
+    if ( w->type_count >= SNAPSHOT_MAX_TYPES || leaf_count > MIGRATE_MAX_LEAVES ||
+         !copy_name( w->types[ w->type_count ].name, type_name( type ) ) )
+    {
+        printf( "ERROR: Snapshot schema cannot hold %s\n", type_name( type ) );
+        return -1;
+    }
+
+    SnapshotType* t = &w->types[ w->type_count ];
+    t->hash         = type->hash;
+    t->size         = type->size;
+    t->version      = info->version;
+    t->reserved     = 0;
+    t->leaf_first   = w->leaf_count;
+    t->leaf_count   = leaf_count;
+    for ( uint16_t i = 0; i < leaf_count; i++ )
+    {
+        SnapshotLeaf* leaf = &w->leaves[ w->leaf_count++ ];
+        memset( leaf, 0, sizeof( *leaf ) );
+        leaf->path_hash = leaves[ i ].path_hash;
+        leaf->offset    = leaves[ i ].offset;
+        leaf->size      = leaves[ i ].size;
+        leaf->kind      = leaves[ i ].kind;
+    }
+    return w->type_count++;
+}
+
+static SnapshotSection*
+writer_section( SnapshotWriter* w, const char* name, uint16_t kind, const void* data, uint64_t size )
+{
+    if ( w->section_count >= SNAPSHOT_MAX_SECTIONS )
+    {
+        printf( "ERROR: Snapshot section limit reached at %s\n", name );
+        return NULL;
+    }
+
+    SnapshotSection* section = &w->sections[ w->section_count ];
+    memset( section, 0, sizeof( *section ) );
+    if ( !copy_name( section->name, name ) )
+        return NULL;
+    section->kind                  = kind;
+    section->size                  = size;
+    w->data[ w->section_count++ ] = data;
+    return section;
+}
+
+int
+snapshot_add_array( SnapshotWriter* w, const char* name, const Type* type, const void* objects, size_t count )
+{
+    int type_index = writer_type( w, type );
+    if ( type_index < 0 )
+        return 0;
+
+    SnapshotSection* section = writer_section( w, name, SECTION_ARRAY, objects, (uint64_t)count * type->size );
+    if ( !section )
+        return 0;
+    section->type_index = (uint16_t)type_index;
+    section->count      = count;
+    return 1;
+}
+
+int
+snapshot_add_soa( SnapshotWriter* w, const char* name, const Type* type, const SoaStorage* soa )
+{
+    int type_index = writer_type( w, type );
+    if ( type_index < 0 )
+        return 0;
+    if ( soa->type_hash != type->hash )
+    {
+        printf( "ERROR: Snapshot %s: storage does not hold %s\n", name, type_name( type ) );
+        return 0;
+    }
+
+    const SnapshotType* t = &w->types[ type_index ];
+    for ( uint16_t i = 0; i < soa->column_count; i++ )
+    {
+        const SoaColumn* column = &soa->columns[ i ];
+        uint32_t         leaf   = 0;
+        while ( leaf < t->leaf_count && w->leaves[ t->leaf_first + leaf ].path_hash != column->path_hash ) leaf++;
+        if ( leaf == t->leaf_count )
+        {
+            printf( "ERROR: Snapshot %s: column is not a leaf of %s\n", name, type_name( type ) );
+            return 0;
+        }
+
+        SnapshotSection* section =
+            writer_section( w, name, SECTION_COLUMN, column->data, (uint64_t)soa->count * column->size );
+        if ( !section )
+            return 0;
+        section->type_index = (uint16_t)type_index;
+        section->leaf       = leaf;
+        section->count      = soa->count;
+    }
+    return 1;
+}
+
+int
+snapshot_add_blob( SnapshotWriter* w, const char* name, const void* data, size_t size )
+{
+    SnapshotSection* section = writer_section( w, name, SECTION_BLOB, data, size );
+    if ( !section )
+        return 0;
+    section->count = size;
+    return 1;
+}
+
+static int
+write_padding( FILE* file, uint64_t from, uint64_t to )
+{
+    static const char zeros[ SNAPSHOT_PAGE ];
+    while ( from < to )
+    {
+        size_t chunk = to - from < SNAPSHOT_PAGE ? (size_t)( to - from ) : SNAPSHOT_PAGE;
+        if ( fwrite( zeros, 1, chunk, file ) != chunk )
+            return 0;
+        from += chunk;
+    }
+    return 1;
+}
+
+int
+snapshot_write( SnapshotWriter* w, const char* path )
+{
+    SnapshotHeader header = { 0 };
+    header.magic          = SNAPSHOT_MAGIC;
+    header.version        = SNAPSHOT_VERSION;
+    header.section_count  = w->section_count;
+    header.page_size      = SNAPSHOT_PAGE;
+    header.type_count     = w->type_count;
+    header.leaf_count     = w->leaf_count;
+    header.tables_offset  = sizeof( SnapshotHeader );
+
+    uint64_t tables_end = header.tables_offset + w->section_count * sizeof( SnapshotSection ) +
+                          w->type_count * sizeof( SnapshotType ) + w->leaf_count * sizeof( SnapshotLeaf );
+    uint64_t offset = page_align( tables_end );
+    for ( uint16_t i = 0; i < w->section_count; i++ )
+    {
+        w->sections[ i ].offset = offset;
+        offset                  = page_align( offset + w->sections[ i ].size );
+    }
+    header.file_size = offset;
+
+    char temp_path[ 1024 ];
+    if ( snprintf( temp_path, sizeof( temp_path ), "%s.tmp", path ) >= (int)sizeof( temp_path ) )
+        return 0;
+    FILE* file = fopen( temp_path, "wb" );
+    if ( !file )
+    {
+        printf( "ERROR: Cannot write snapshot %s\n", temp_path );
+        return 0;
+    }
+
+    int ok = fwrite( &header, sizeof( header ), 1, file ) == 1;
+    ok     = ok && fwrite( w->sections, sizeof( SnapshotSection ), w->section_count, file ) == w->section_count;
+    ok     = ok && fwrite( w->types, sizeof( SnapshotType ), w->type_count, file ) == w->type_count;
+    ok     = ok && fwrite( w->leaves, sizeof( SnapshotLeaf ), w->leaf_count, file ) == w->leaf_count;
+
+    uint64_t at = tables_end;
+    for ( uint16_t i = 0; i < w->section_count && ok; i++ )
+    {
+        const SnapshotSection* section = &w->sections[ i ];
+        ok = write_padding( file, at, section->offset ) &&
+             fwrite( w->data[ i ], 1, (size_t)section->size, file ) == section->size;
+        at = section->offset + section->size;
+    }
+    ok = ok && write_padding( file, at, header.file_size ) && fflush( file ) == 0;
+#ifndef _WIN32
+    ok = ok && fsync( fileno( file ) ) == 0;    // Data on disk before the rename makes it visible
+#endif
+    ok = fclose( file ) == 0 && ok;
+
+#ifdef _WIN32
+    ok = ok && MoveFileExA( temp_path, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH );
+#else
+    ok = ok && rename( temp_path, path ) == 0;
+#endif
+    if ( !ok )
+    {
+        printf( "ERROR: Writing snapshot %s failed\n", path );
+        remove( temp_path );
+    }
+    return ok;
+}
+
+// ============================================================================
+// Reader
+// ============================================================================
+
+struct Snapshot
+{
+    char*                  base;
+    size_t                 size;
+    const SnapshotHeader*  header;
+    const SnapshotSection* sections;
+    const SnapshotType*    types;
+    const SnapshotLeaf*    leaves;
+#ifdef _WIN32
+    HANDLE file;
+    HANDLE mapping;
+#endif
+};
+
+static void
+snapshot_unmap( Snapshot* snap )
+{
+#ifdef _WIN32
+    if ( snap->base )
+        UnmapViewOfFile( snap->base );
+    if ( snap->mapping )
+        CloseHandle( snap->mapping );
+    if ( snap->file && snap->file != INVALID_HANDLE_VALUE )
+        CloseHandle( snap->file );
+#else
+    if ( snap->base )
+        munmap( snap->base, snap->size );
+#endif
+}
+
+// Private copy-on-write view: restored state can be modified without touching the file
+static int
+snapshot_map( Snapshot* snap, const char* path )
+{
+#ifdef _WIN32
+    LARGE_INTEGER size;
+    snap->file = CreateFileA( path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, NULL );
+    if ( snap->file == INVALID_HANDLE_VALUE || !GetFileSizeEx( snap->file, &size ) || size.QuadPart == 0 )
+        return 0;
+    snap->size    = (size_t)size.QuadPart;
+    snap->mapping = CreateFileMappingA( snap->file, NULL, PAGE_WRITECOPY, 0, 0, NULL );
+    if ( !snap->mapping )
+        return 0;
+    snap->base = (char*)MapViewOfFile( snap->mapping, FILE_MAP_COPY, 0, 0, 0 );
+    return snap->base != NULL;
+#else
+    int fd = open( path, O_RDONLY | O_CLOEXEC );
+    if ( fd < 0 )
+        return 0;
+
+    struct stat info;
+    if ( fstat( fd, &info ) != 0 || info.st_size == 0 )
+    {
+        close( fd );
+        return 0;
+    }
+    snap->size = (size_t)info.st_size;
+    void* base = mmap( NULL, snap->size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0 );
+    close( fd );    // The mapping keeps the file alive
+    if ( base == MAP_FAILED )
+        return 0;
+    snap->base = (char*)base;
+    return 1;
+#endif
+}
+
+static int
+snapshot_validate( const Snapshot* snap )
+{
+    const SnapshotHeader* h = snap->header;
+    if ( snap->size < sizeof( SnapshotHeader ) || h->magic != SNAPSHOT_MAGIC || h->version != SNAPSHOT_VERSION ||
+         h->page_size != SNAPSHOT_PAGE || h->file_size != snap->size )
+    {
+        return 0;
+    }
+
+    uint64_t tables_end = h->tables_offset + h->section_count * sizeof( SnapshotSection ) +
+                          h->type_count * sizeof( SnapshotType ) + (uint64_t)h->leaf_count * sizeof( SnapshotLeaf );
+    if ( h->tables_offset < sizeof( SnapshotHeader ) || tables_end > snap->size )
+        return 0;
+
+    for ( uint16_t i = 0; i < h->type_count; i++ )
+    {
+        const SnapshotType* t = &snap->types[ i ];
+        if ( (uint64_t)t->leaf_first + t->leaf_count > h->leaf_count || t->leaf_count > MIGRATE_MAX_LEAVES )
+            return 0;
+    }
+    for ( uint16_t i = 0; i < h->section_count; i++ )
+    {
+        const SnapshotSection* s = &snap->sections[ i ];
+        if ( s->offset % SNAPSHOT_PAGE || s->offset < tables_end || s->size > snap->size - s->offset ||
+             s->name[ SNAPSHOT_NAME_MAX - 1 ] != 0 )
+            return 0;
+        if ( s->kind == SECTION_BLOB )
+            continue;
+        if ( s->type_index >= h->type_count )
+            return 0;
+
+        const SnapshotType* t = &snap->types[ s->type_index ];
+        uint64_t element      = s->kind == SECTION_ARRAY ? t->size
+                                : s->leaf < t->leaf_count ? snap->leaves[ t->leaf_first + s->leaf ].size
+                                                          : 0;
+        if ( ( s->kind != SECTION_ARRAY && s->kind != SECTION_COLUMN ) || element == 0 ||
+             s->count * element != s->size )
+            return 0;
+    }
+    return 1;
+}
+
+Snapshot*
+snapshot_open( const char* path )
+{
+    Snapshot* snap = (Snapshot*)calloc( 1, sizeof( Snapshot ) );
+    if ( !snap )
+        return NULL;
+
+    if ( !snapshot_map( snap, path ) )
+    {
+        snapshot_close( snap );
+        return NULL;
+    }
+
+    snap->header   = (const SnapshotHeader*)snap->base;
+    snap->sections = (const SnapshotSection*)( snap->base + snap->header->tables_offset );
+    snap->types    = (const SnapshotType*)( snap->sections + snap->header->section_count );
+    snap->leaves   = (const SnapshotLeaf*)( snap->types + snap->header->type_count );
+    if ( !snapshot_validate( snap ) )
+    {
+        printf( "ERROR: %s is not a valid snapshot\n", path );
+        snapshot_close( snap );
+        return NULL;
+    }
+    return snap;
+}
+
+void
+snapshot_close( Snapshot* snap )
+{
+    if ( !snap )
+        return;
+    snapshot_unmap( snap );
+    free( snap );
+}
+
+static const SnapshotSection*
+find_section( const Snapshot* snap, const char* name, uint16_t kind )
+{
+    for ( uint16_t i = 0; i < snap->header->section_count; i++ )
+    {
+        const SnapshotSection* section = &snap->sections[ i ];
+        if ( section->kind == kind && strcmp( section->name, name ) == 0 )
+            return section;
+    }
+    return NULL;
+}
+
+static uint16_t
+stored_leaves( const Snapshot* snap, const SnapshotType* t, LayoutLeaf* out )
+{
+    for ( uint32_t i = 0; i < t->leaf_count; i++ )
+    {
+        const SnapshotLeaf* leaf = &snap->leaves[ t->leaf_first + i ];
+        out[ i ].path_hash       = leaf->path_hash;
+        out[ i ].offset          = leaf->offset;
+        out[ i ].size            = leaf->size;
+        out[ i ].kind            = leaf->kind;
+    }
+    return (uint16_t)t->leaf_count;
+}
+
+// Stored layout byte for byte the registered one
+static int
+layout_matches( const Snapshot* snap, const SnapshotType* t, const Type* type )
+{
+    LayoutLeaf current[ MIGRATE_MAX_LEAVES ];
+    uint16_t   count = layout_leaves( type, current, MIGRATE_MAX_LEAVES );
+    if ( t->size != type->size || t->leaf_count != count )
+        return 0;
+
+    for ( uint16_t i = 0; i < count; i++ )
+    {
+        const SnapshotLeaf* leaf = &snap->leaves[ t->leaf_first + i ];
+        if ( leaf->path_hash != current[ i ].path_hash || leaf->offset != current[ i ].offset ||
+             leaf->size != current[ i ].size || leaf->kind != current[ i ].kind )
+            return 0;
+    }
+    return 1;
+}
+
+const void*
+snapshot_blob( const Snapshot* snap, const char* name, size_t* size )
+{
+    const SnapshotSection* section = find_section( snap, name, SECTION_BLOB );
+    if ( !section )
+        return NULL;
+    if ( size )
+        *size = (size_t)section->size;
+    return snap->base + section->offset;
+}
+
+void*
+snapshot_array( Snapshot* snap, const char* name, const Type* type, size_t* count )
+{
+    const SnapshotSection* section = find_section( snap, name, SECTION_ARRAY );
+    if ( !section || !layout_matches( snap, &snap->types[ section->type_index ], type ) )
+        return NULL;
+    if ( count )
+        *count = (size_t)section->count;
+    return snap->base + section->offset;
+}
+
+size_t
+snapshot_read_array( Snapshot* snap, const char* name, const Type* type, void* out, size_t max_count )
+{
+    const SnapshotSection* section = find_section( snap, name, SECTION_ARRAY );
+    if ( !section )
+        return 0;
+
+    const SnapshotType* t     = &snap->types[ section->type_index ];
+    size_t              count = section->count < max_count ? (size_t)section->count : max_count;
+    if ( layout_matches( snap, t, type ) )
+    {
+        memcpy( out, snap->base + section->offset, count * type->size );
+        return count;
+    }
+
+    LayoutLeaf     leaves[ MIGRATE_MAX_LEAVES ];
+    uint16_t       leaf_count = stored_leaves( snap, t, leaves );
+    MigrationPlan* plan       = migration_compile_leaves( leaves, leaf_count, t->size, t->version, type );
+    if ( !plan )
+        return 0;
+    migration_run( plan, snap->base + section->offset, out, count );
+    free( plan );
+    return count;
+}
+
+SoaStorage*
+snapshot_load_soa( Snapshot* snap, const char* name, const Type* type )
+{
+    const SnapshotSection* first = find_section( snap, name, SECTION_COLUMN );
+    if ( !first || first->count > UINT32_MAX )
+        return NULL;
+    if ( first->count == 0 )
+        return soa_create( type, 0 );
+
+    // The stored columns, exactly as written, borrowed from the mapping...
+    const SnapshotType* t   = &snap->types[ first->type_index ];
+    SoaStorage*         soa = (SoaStorage*)calloc( 1, sizeof( SoaStorage ) );
+    if ( !soa )
+        return NULL;
+    soa->type_hash   = t->hash;
+    soa->object_size = t->size;
+    soa->count       = (uint32_t)first->count;
+    soa->capacity    = (uint32_t)first->count;    // Growing copies out of the mapping
+    for ( uint16_t i = 0; i < snap->header->section_count; i++ )
+    {
+        const SnapshotSection* section = &snap->sections[ i ];
+        if ( section->kind != SECTION_COLUMN || strcmp( section->name, name ) != 0 )
+            continue;
+        if ( section->type_index != first->type_index || section->count != first->count ||
+             soa->column_count >= SOA_MAX_COLUMNS )
+        {
+            soa_destroy( soa );
+            return NULL;
+        }
+
+        const SnapshotLeaf* leaf   = &snap->leaves[ t->leaf_first + section->leaf ];
+        SoaColumn*          column = &soa->columns[ soa->column_count++ ];
+        column->offset             = leaf->offset;
+        column->size               = leaf->size;
+        column->path_hash          = leaf->path_hash;
+        column->kind               = leaf->kind;
+        column->data               = snap->base + section->offset;
+        column->borrowed           = 1;
+    }
+
+    // ...then brought to the registered layout. Unchanged columns stay borrowed.
+    if ( !soa_migrate( soa, type ) )
+    {
+        soa_destroy( soa );
+        return NULL;
+    }
+    return soa;
+}
+
+// ============================================================================
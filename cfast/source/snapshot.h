@@ -0,0 +1,72 @@
+// ============================================================================
+// snapshot.h - Memory-mapped state snapshots with an embedded schema
+// ============================================================================
+//
+// File layout (all offsets 64-bit, little endian, data sections page aligned):
+//
+//   SnapshotHeader | section table | type table | leaf table | pad
+//   section data, each starting on a page boundary
+//
+// The type table records every stored type's name, size, version and
+// flattened leaves (path hash, offset, size, kind) - the schema as it was when
+// the file was written. Opening a snapshot is one mmap (private, copy on
+// write) and a header check; sections whose stored layout matches the
+// registered type are used in place, so nothing is read until it is touched.
+// Only sections whose layout changed are converted, through layout_migrate.
+//
+// Restored data borrows from the mapping: keep the Snapshot open while it is
+// in use. Snapshots are written to "<path>.tmp" and renamed over the target,
+// so a crash mid-write never leaves a torn file and open mappings of the old
+// file stay intact.
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "reflection_core.h"
+#include "soa_storage.h"
+
+#define SNAPSHOT_MAGIC        0x4E534643u    // "CFSN"
+#define SNAPSHOT_VERSION      1
+#define SNAPSHOT_PAGE         4096           // Section alignment, also fine for 64K Windows views
+#define SNAPSHOT_NAME_MAX     48
+#define SNAPSHOT_MAX_SECTIONS 256
+#define SNAPSHOT_MAX_TYPES    64
+
+typedef struct SnapshotWriter SnapshotWriter;
+typedef struct Snapshot       Snapshot;
+
+// ---------------------------------------------------------------------------
+// Writing - sections reference caller memory until snapshot_write returns
+// ---------------------------------------------------------------------------
+
+SnapshotWriter* snapshot_writer_create( void );
+void            snapshot_writer_free( SnapshotWriter* w );
+
+int snapshot_add_array( SnapshotWriter* w, const char* name, const Type* type, const void* objects, size_t count );
+int snapshot_add_soa( SnapshotWriter* w, const char* name, const Type* type, const SoaStorage* soa );
+int snapshot_add_blob( SnapshotWriter* w, const char* name, const void* data, size_t size );
+
+// Returns 1 once the file is complete and renamed into place
+int snapshot_write( SnapshotWriter* w, const char* path );
+
+// ---------------------------------------------------------------------------
+// Reading
+// ---------------------------------------------------------------------------
+
+Snapshot* snapshot_open( const char* path );    // NULL if missing, truncated or not a snapshot
+void      snapshot_close( Snapshot* snap );
+
+// Raw bytes of a blob section, NULL if absent
+const void* snapshot_blob( const Snapshot* snap, const char* name, size_t* size );
+
+// Objects in place when the stored layout equals type's, else NULL (use snapshot_read_array)
+void* snapshot_array( Snapshot* snap, const char* name, const Type* type, size_t* count );
+
+// Copies up to max_count objects into out, migrating if the layout changed. Returns objects read.
+size_t snapshot_read_array( Snapshot* snap, const char* name, const Type* type, void* out, size_t max_count );
+
+// Column storage for type: unchanged columns borrow the mapping, others are converted.
+// Destroy with soa_destroy before closing the snapshot.
+SoaStorage* snapshot_load_soa( Snapshot* snap, const char* name, const Type* type );
+
+#endif    // SNAPSHOT_H
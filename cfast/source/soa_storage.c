@@ -0,0 +1,314 @@
+// ============================================================================
+// soa_storage.c - Struct-of-arrays storage built from a registered Type
+// ============================================================================
+
+#include "soa_storage.h"
+#include "layout_migrate.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#    include <malloc.h>
+#    define column_alloc( size ) _aligned_malloc( size, SOA_ALIGNMENT )
+#    define column_free( ptr )   _aligned_free( ptr )
+#else
+#    define column_alloc( size ) aligned_alloc( SOA_ALIGNMENT, size )
+#    define column_free( ptr )   free( ptr )
+#endif
+
+// aligned_alloc wants a multiple of the alignment
+static size_t
+column_bytes( const SoaColumn* column, uint32_t capacity )
+{
+    size_t bytes = (size_t)column->size * capacity;
+    return ( bytes + SOA_ALIGNMENT - 1 ) & ~(size_t)( SOA_ALIGNMENT - 1 );
+}
+
+static void
+column_release( SoaColumn* column )
+{
+    if ( !column->borrowed )
+        column_free( column->data );
+    column->data     = NULL;
+    column->borrowed = 0;
+}
+
+// ============================================================================
+// Create / destroy
+// ============================================================================
+
+SoaStorage*
+soa_create( const Type* type, uint32_t capacity )
+{
+    FlatField leaves[ SOA_MAX_COLUMNS ];
+    uint16_t  leaf_count = type_flatten( type, leaves, SOA_MAX_COLUMNS );
+    if ( leaf_count > SOA_MAX_COLUMNS )
+    {
+        printf( "ERROR: %s has too many leaf fields for SoA storage\n", type_name( type ) );
+        return NULL;
+    }
+
+    SoaStorage* soa   = (SoaStorage*)calloc( 1, sizeof( SoaStorage ) );
+    soa->type_hash    = type->hash;
+    soa->object_size  = type->size;
+    soa->column_count = leaf_count;
+    for ( uint16_t i = 0; i < leaf_count; i++ )
+    {
+        soa->columns[ i ].offset    = leaves[ i ].offset;
+        soa->columns[ i ].size      = leaves[ i ].size;
+        soa->columns[ i ].path_hash = leaves[ i ].path_hash;
+        soa->columns[ i ].kind      = (uint8_t)field_kind( leaves[ i ].field );
+    }
+
+    if ( !soa_reserve( soa, capacity ? capacity : 64 ) )
+    {
+        soa_destroy( soa );
+        return NULL;
+    }
+    return soa;
+}
+
+void
+soa_destroy( SoaStorage* soa )
+{
+    if ( !soa )
+        return;
+    for ( uint16_t i = 0; i < soa->column_count; i++ ) column_release( &soa->columns[ i ] );
+    free( soa );
+}
+
+int
+soa_reserve( SoaStorage* soa, uint32_t capacity )
+{
+    if ( capacity <= soa->capacity )
+        return 1;
+
+    char* grown[ SOA_MAX_COLUMNS ];
+    for ( uint16_t i = 0; i < soa->column_count; i++ )
+    {
+        grown[ i ] = (char*)column_alloc( column_bytes( &soa->columns[ i ], capacity ) );
+        if ( !grown[ i ] )
+        {
+            while ( i-- ) column_free( grown[ i ] );
+            return 0;
+        }
+    }
+
+    for ( uint16_t i = 0; i < soa->column_count; i++ )
+    {
+        SoaColumn* column = &soa->columns[ i ];
+        if ( column->data )
+        {
+            memcpy( grown[ i ], column->data, (size_t)column->size * soa->count );
+            column_release( column );
+        }
+        column->data = grown[ i ];
+    }
+    soa->capacity = capacity;
+    return 1;
+}
+
+// ============================================================================
+// Logical objects - gather / scatter one element across all columns
+// ============================================================================
+
+uint32_t
+soa_push( SoaStorage* soa, const void* object )
+{
+    if ( soa->count == soa->capacity && !soa_reserve( soa, soa->capacity * 2 ) )
+        return UINT32_MAX;
+
+    uint32_t index = soa->count++;
+    soa_set( soa, index, object );
+    return index;
+}
+
+void
+soa_remove_swap( SoaStorage* soa, uint32_t index )
+{
+    if ( index >= soa->count )
+        return;
+
+    uint32_t last = --soa->count;
+    if ( index == last )
+        return;
+
+    for ( uint16_t i = 0; i < soa->column_count; i++ )
+    {
+        SoaColumn* column = &soa->columns[ i ];
+        memcpy( column->data + (size_t)index * column->size, column->data + (size_t)last * column->size,
+                column->size );
+    }
+}
+
+void
+soa_get( const SoaStorage* soa, uint32_t index, void* out_object )
+{
+    char* dst = (char*)out_object;
+    for ( uint16_t i = 0; i < soa->column_count; i++ )
+    {
+        const SoaColumn* column = &soa->columns[ i ];
+        memcpy( dst + column->offset, column->data + (size_t)index * column->size, column->size );
+    }
+}
+
+void
+soa_set( SoaStorage* soa, uint32_t index, const void* object )
+{
+    const char* src = (const char*)object;
+    for ( uint16_t i = 0; i < soa->column_count; i++ )
+    {
+        SoaColumn* column = &soa->columns[ i ];
+        memcpy( column->data + (size_t)index * column->size, src + column->offset, column->size );
+    }
+}
+
+// ============================================================================
+// Columns
+// ============================================================================
+
+int
+soa_column_index( const SoaStorage* soa, const Type* type, const char* path )
+{
+    FieldPath leaf;
+    if ( type->hash != soa->type_hash || !field_path_resolve( type, path, &leaf ) ||
+         leaf.kind == FIELD_KIND_STRUCT )
+    {
+        return -1;    // Only leaves have columns
+    }
+
+    for ( uint16_t i = 0; i < soa->column_count; i++ )
+    {
+        if ( soa->columns[ i ].offset == leaf.offset )
+            return i;
+    }
+    return -1;
+}
+
+void*
+soa_column_data( SoaStorage* soa, int column )
+{
+    return soa->columns[ column ].data;
+}
+
+int
+soa_view( SoaStorage* soa, const Type* type, const char* const* paths, int path_count, SoaView* view )
+{
+    if ( path_count > SOA_VIEW_MAX )
+        return 0;
+
+    view->count = soa->count;
+    for ( int i = 0; i < path_count; i++ )
+    {
+        int column = soa_column_index( soa, type, paths[ i ] );
+        if ( column < 0 )
+            return 0;
+        view->columns[ i ] = soa->columns[ column ].data;
+    }
+    return 1;
+}
+
+// ============================================================================
+// Layout migration - columns move, convert or start from the default
+// ============================================================================
+
+int
+soa_migrate( SoaStorage* soa, const Type* new_type )
+{
+    FlatField leaves[ SOA_MAX_COLUMNS ];
+    uint16_t  leaf_count = type_flatten( new_type, leaves, SOA_MAX_COLUMNS );
+    if ( leaf_count > SOA_MAX_COLUMNS )
+    {
+        printf( "ERROR: %s has too many leaf fields for SoA storage\n", type_name( new_type ) );
+        return 0;
+    }
+
+    char* prototype = (char*)malloc( new_type->size );
+    if ( !prototype )
+        return 0;
+    migrate_prototype( new_type, prototype );
+
+    SoaColumn columns[ SOA_MAX_COLUMNS ];
+    int       source[ SOA_MAX_COLUMNS ];    // Old column per new one, -1 for new leaves
+    uint8_t   moved[ SOA_MAX_COLUMNS ] = { 0 };    // New column took the old one's data
+    uint8_t   kept[ SOA_MAX_COLUMNS ]  = { 0 };    // Old column's data lives on
+    uint16_t  built                    = 0;
+    int       ok                       = 1;
+    for ( ; built < leaf_count && ok; built++ )
+    {
+        uint16_t i = built;
+        SoaColumn* column = &columns[ i ];
+        column->offset    = leaves[ i ].offset;
+        column->size      = leaves[ i ].size;
+        column->path_hash = leaves[ i ].path_hash;
+        column->kind      = (uint8_t)field_kind( leaves[ i ].field );
+        column->data      = NULL;
+        column->borrowed  = 0;
+
+        source[ i ] = -1;
+        for ( uint16_t j = 0; j < soa->column_count && source[ i ] < 0; j++ )
+        {
+            if ( soa->columns[ j ].path_hash == column->path_hash )
+                source[ i ] = j;
+        }
+
+        // Unchanged leaf: the column itself moves over, no copy
+        const SoaColumn* old = source[ i ] >= 0 ? &soa->columns[ source[ i ] ] : NULL;
+        if ( old && old->kind == column->kind && old->size == column->size )
+        {
+            kept[ source[ i ] ] = 1;
+            moved[ i ]          = 1;
+            column->data        = old->data;
+            column->borrowed    = old->borrowed;
+            continue;
+        }
+
+        column->data = (char*)column_alloc( column_bytes( column, soa->capacity ) );
+        ok           = column->data != NULL;
+    }
+
+    if ( !ok )
+    {
+        for ( uint16_t i = 0; i < built; i++ )
+        {
+            if ( !moved[ i ] )
+                column_free( columns[ i ].data );
+        }
+        free( prototype );
+        return 0;
+    }
+
+    // Fill the fresh columns from the old ones (or the defaults) before any old column goes away
+    for ( uint16_t i = 0; i < leaf_count; i++ )
+    {
+        SoaColumn* column = &columns[ i ];
+        if ( moved[ i ] )
+            continue;
+
+        const SoaColumn* old = source[ i ] >= 0 ? &soa->columns[ source[ i ] ] : NULL;
+        MigrateOp        op  = { MIGRATE_DEFAULT, FIELD_KIND_BYTES, column->kind, 0, 0, 0, column->size };
+        if ( old )
+        {
+            op.src_kind = old->kind;
+            op.src_size = old->size;
+            op.code     = (uint8_t)migrate_classify( old->kind, old->size, column->kind, column->size );
+        }
+        migrate_apply( &op, old ? old->data : NULL, op.src_size, column->data, column->size,
+                       prototype + column->offset, soa->count );
+    }
+
+    for ( uint16_t j = 0; j < soa->column_count; j++ )
+    {
+        if ( !kept[ j ] )
+            column_release( &soa->columns[ j ] );
+    }
+    memcpy( soa->columns, columns, leaf_count * sizeof( SoaColumn ) );
+    soa->column_count = leaf_count;
+    soa->object_size  = new_type->size;
+    soa->type_hash    = new_type->hash;
+    free( prototype );
+    return 1;
+}
+
+// ============================================================================
@@ -0,0 +1,72 @@
+// ============================================================================
+// soa_storage.h - Struct-of-arrays storage built from a registered Type
+// ============================================================================
+//
+// Every flattened leaf field of the type becomes its own contiguous column,
+// so a pass that reads two floats streams exactly those two columns instead
+// of dragging whole objects through cache. Tools still see logical objects:
+// soa_get / soa_set gather and scatter one element by index.
+
+#ifndef SOA_STORAGE_H
+#define SOA_STORAGE_H
+
+#include "reflection_core.h"
+
+#define SOA_MAX_COLUMNS 64    // Flattened leaves per type
+#define SOA_VIEW_MAX    16    // Columns a single view can bind
+#define SOA_ALIGNMENT   64    // Column base alignment (cache line / AVX-512)
+
+typedef struct SoaColumn
+{
+    uint16_t offset;       // Leaf offset inside the AoS object
+    uint16_t size;         // Element size in bytes
+    TypeHash path_hash;    // Dotted leaf path, matches columns across layouts
+    char*    data;         // capacity * size bytes, SOA_ALIGNMENT aligned
+    uint8_t  kind;         // FieldKind of the leaf
+    uint8_t  borrowed;     // data belongs to someone else (a snapshot mapping), never freed here
+
+} SoaColumn;
+
+typedef struct SoaStorage
+{
+    TypeHash type_hash;
+    uint16_t object_size;
+    uint16_t column_count;
+    uint32_t count;
+    uint32_t capacity;
+    SoaColumn columns[ SOA_MAX_COLUMNS ];
+
+} SoaStorage;
+
+// Column base pointers for a pass, valid until the storage grows
+typedef struct SoaView
+{
+    uint32_t count;
+    void*    columns[ SOA_VIEW_MAX ];
+
+} SoaView;
+
+SoaStorage* soa_create( const Type* type, uint32_t capacity );
+void        soa_destroy( SoaStorage* soa );
+int         soa_reserve( SoaStorage* soa, uint32_t capacity );
+
+// Logical object access (editor / tools)
+uint32_t soa_push( SoaStorage* soa, const void* object );    // Returns index, UINT32_MAX when out of memory
+void     soa_remove_swap( SoaStorage* soa, uint32_t index );    // No-op past count
+void     soa_get( const SoaStorage* soa, uint32_t index, void* out_object );
+void     soa_set( SoaStorage* soa, uint32_t index, const void* object );
+
+// Columns by dotted field path ("health.current"), -1 if not a leaf of the type
+int   soa_column_index( const SoaStorage* soa, const Type* type, const char* path );
+void* soa_column_data( SoaStorage* soa, int column );
+
+// Bind several columns at once, returns 0 if any path is missing
+int soa_view( SoaStorage* soa, const Type* type, const char* const* paths, int path_count, SoaView* view );
+
+// Re-lay the storage out for a new version of its type (hot reload). Columns
+// whose leaf kept its kind and size are kept as they are, retyped ones are
+// converted and new ones filled with defaults - see layout_migrate.h.
+// Returns 0 (storage untouched) when out of memory or the type is too wide.
+int soa_migrate( SoaStorage* soa, const Type* new_type );
+
+#endif    // SOA_STORAGE_H
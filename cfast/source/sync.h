@@ -0,0 +1,202 @@
+// ============================================================================
+// sync.h - Atomics and thread-locals shared by the job system, registry and tracing
+// ============================================================================
+//
+// sync_load32 / sync_store32, read-modify-writes and sync_fence are
+// sequentially consistent; the other loads acquire, the other stores release.
+// Plain volatile accesses on MSVC: x86 and x64 give acquire / release for free
+// under /volatile:ms.
+
+#ifndef SYNC_H
+#define SYNC_H
+
+#include "simd.h"    // _mm_pause, _mm_mfence
+
+#include <stdint.h>
+
+#if defined( _MSC_VER ) && !defined( __clang__ )
+#    include <intrin.h>
+#    define SYNC_THREAD_LOCAL __declspec( thread )
+
+static inline int64_t
+sync_load64( volatile int64_t* p )
+{
+    return *p;
+}
+
+static inline void
+sync_store64( volatile int64_t* p, int64_t value )
+{
+    *p = value;
+}
+
+static inline int
+sync_cas64( volatile int64_t* p, int64_t expected, int64_t desired )
+{
+    return _InterlockedCompareExchange64( p, desired, expected ) == expected;
+}
+
+static inline int32_t
+sync_load32( volatile int32_t* p )
+{
+    return *p;
+}
+
+static inline void
+sync_store32( volatile int32_t* p, int32_t value )
+{
+    *p = value;
+}
+
+static inline void
+sync_store32_release( volatile int32_t* p, int32_t value )
+{
+    *p = value;
+}
+
+static inline int32_t
+sync_add32( volatile int32_t* p, int32_t value )    // Returns the new value
+{
+    return _InterlockedExchangeAdd( (volatile long*)p, value ) + value;
+}
+
+static inline int
+sync_cas32( volatile int32_t* p, int32_t expected, int32_t desired )
+{
+    return _InterlockedCompareExchange( (volatile long*)p, desired, expected ) == expected;
+}
+
+static inline uint16_t
+sync_load16( volatile uint16_t* p )
+{
+    return *p;
+}
+
+static inline void
+sync_store16( volatile uint16_t* p, uint16_t value )
+{
+    *p = value;
+}
+
+static inline void*
+sync_load_ptr( void* volatile* p )
+{
+    return *p;
+}
+
+static inline void
+sync_store_ptr( void* volatile* p, void* value )
+{
+    *p = value;
+}
+
+static inline void
+sync_fence( void )
+{
+    _ReadWriteBarrier();
+    _mm_mfence();
+}
+
+static inline void
+sync_compiler_fence( void )    // Orders the code, not the CPU
+{
+    _ReadWriteBarrier();
+}
+#else
+#    define SYNC_THREAD_LOCAL _Thread_local
+
+static inline int64_t
+sync_load64( volatile int64_t* p )
+{
+    return __atomic_load_n( p, __ATOMIC_ACQUIRE );
+}
+
+static inline void
+sync_store64( volatile int64_t* p, int64_t value )
+{
+    __atomic_store_n( p, value, __ATOMIC_RELEASE );
+}
+
+static inline int
+sync_cas64( volatile int64_t* p, int64_t expected, int64_t desired )
+{
+    return __atomic_compare_exchange_n( p, &expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST );
+}
+
+static inline int32_t
+sync_load32( volatile int32_t* p )
+{
+    return __atomic_load_n( p, __ATOMIC_SEQ_CST );
+}
+
+static inline void
+sync_store32( volatile int32_t* p, int32_t value )
+{
+    __atomic_store_n( p, value, __ATOMIC_SEQ_CST );
+}
+
+static inline void
+sync_store32_release( volatile int32_t* p, int32_t value )
+{
+    __atomic_store_n( p, value, __ATOMIC_RELEASE );
+}
+
+static inline int32_t
+sync_add32( volatile int32_t* p, int32_t value )    // Returns the new value
+{
+    return __atomic_add_fetch( p, value, __ATOMIC_SEQ_CST );
+}
+
+static inline int
+sync_cas32( volatile int32_t* p, int32_t expected, int32_t desired )
+{
+    return __atomic_compare_exchange_n( p, &expected, desired, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST );
+}
+
+static inline uint16_t
+sync_load16( volatile uint16_t* p )
+{
+    return __atomic_load_n( p, __ATOMIC_ACQUIRE );
+}
+
+static inline void
+sync_store16( volatile uint16_t* p, uint16_t value )
+{
+    __atomic_store_n( p, value, __ATOMIC_RELEASE );
+}
+
+static inline void*
+sync_load_ptr( void* volatile* p )
+{
+    return __atomic_load_n( p, __ATOMIC_ACQUIRE );
+}
+
+static inline void
+sync_store_ptr( void* volatile* p, void* value )
+{
+    __atomic_store_n( p, value, __ATOMIC_RELEASE );
+}
+
+static inline void
+sync_fence( void )
+{
+    __atomic_thread_fence( __ATOMIC_SEQ_CST );
+}
+
+static inline void
+sync_compiler_fence( void )    // Orders the code, not the CPU
+{
+    __atomic_signal_fence( __ATOMIC_SEQ_CST );
+}
+#endif
+
+// Spin-wait hint
+static inline void
+sync_pause( void )
+{
+#if SIMD_X86
+    _mm_pause();
+#endif
+}
+
+#endif    // SYNC_H
@@ -0,0 +1,2349 @@
+// ============================================================================
+// test_reflection.c - Basic reflection tests
+// ============================================================================
+#define _GNU_SOURCE    // mkdtemp
+
+#include "reflection_core.h"
+#include "serialize_binary.h"
+#include "soa_storage.h"
+#include "entity_kernels.h"
+#include "field_batch.h"
+#include "json_writer.h"
+#include "json_reader.h"
+#include "layout_migrate.h"
+#include "snapshot.h"
+#include "type_pool.h"
+#include "delta.h"
+#include "replicate.h"
+#include "job_system.h"
+#include "sync.h"
+#include "trace.h"
+#include "type_table.h"
+#include "type_ops.h"
+#include "query.h"
+#include "display_list.h"
+#include "game_types.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int s_failures = 0;
+
+#define CHECK( cond )                                                           \
+    do                                                                          \
+    {                                                                           \
+        if ( !( cond ) )                                                        \
+        {                                                                       \
+            printf( "  FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond );        \
+            s_failures++;                                                       \
+        }                                                                       \
+    } while ( 0 )
+
+// ============================================================================
+// Registry
+// ============================================================================
+
+static void
+test_register_and_find( void )
+{
+    TypeDesc uint32_type = {
+        .hash = hash_string( "uint32" ),
+        .name = "uint32",
+        .size = sizeof( uint32_t ),
+    };
+    TypeID id = type_register( &uint32_type );
+
+    Type* found = type_find_by_hash( hash_string( "uint32" ) );
+    CHECK( found != NULL );
+    CHECK( found == type_get( id ) );
+    CHECK( found->size == sizeof( uint32_t ) );
+    CHECK( type_find_by_hash( hash_string( "missing" ) ) == NULL );
+}
+
+static void
+test_find_by_name( void )
+{
+    TypeDesc aa = { .hash = hash_string( "Aa" ), .name = "Aa", .size = 1 };
+    TypeDesc bb = { .hash = hash_string( "B@" ), .name = "B@", .size = 2 };    // djb2 collides with "Aa"
+    CHECK( aa.hash == bb.hash );
+
+    char name[] = "Aa";    // Not the registered pointer: lookups compare contents
+    TypeID id   = type_register( &aa );
+    CHECK( type_find_by_name( name ) == type_get( id ) );
+    CHECK( type_name( type_get( id ) ) == string_intern( name ) );    // Interned copy
+
+    // Colliding name is refused instead of shadowing Aa
+    type_register( &bb );
+    CHECK( type_find_by_name( "B@" ) == NULL );
+    CHECK( type_find_by_name( "Aa" ) == type_get( id ) );
+    CHECK( type_find_by_name( "nope" ) == NULL );
+}
+
+static void
+test_unregister_keeps_probe_chains( void )
+{
+    // Survivors from one module interleaved with repeatedly erased types
+    // from another - erasing must never cut a survivor's probe chain
+    char names[ 64 ][ 16 ];
+    for ( int i = 0; i < 64; i++ )
+    {
+        snprintf( names[ i ], sizeof( names[ i ] ), "Keep%d", i );
+        TypeDesc keep = { .hash = hash_string( names[ i ] ), .name = names[ i ], .module_id = 9 };
+        type_register( &keep );
+    }
+
+    for ( int round = 0; round < 8; round++ )
+    {
+        for ( int i = 0; i < 40; i++ )
+        {
+            char name[ 32 ];
+            snprintf( name, sizeof( name ), "Temp%d_%d", round, i );
+            TypeDesc temp = { .hash = hash_string( name ), .name = name, .module_id = 10 };
+            type_register( &temp );
+        }
+        type_unregister_module( 10 );
+    }
+
+    int found = 0;
+    for ( int i = 0; i < 64; i++ ) found += type_find_by_name( names[ i ] ) != NULL;
+    CHECK( found == 64 );
+    CHECK( type_find_by_name( "Temp3_7" ) == NULL );
+    const TypeIndex* index = &g_registry.index[ g_registry.index_published ];
+    CHECK( index->live + index->tombstones <= HASH_SIZE );
+}
+
+static void
+test_reregister_keeps_ids( void )
+{
+    Field             a_fields[]    = { { "x", 0, 4, 0, 0 }, { "y", 4, 4, 0, 0 } };
+    Field             b_fields[]    = { { "a", 0, 8, 0, 0 } };
+    Field             b2_fields[]   = { { "a", 0, 8, 0, 0 }, { "b", 8, 4, 0, 0 } };
+    Field             nest_fields[] = { { "b", 0, 8, 0, 0 } };
+    const char* const nest_types[]  = { "TestKeepB" };
+
+    TypeDesc a    = { .name = "TestKeepA", .size = 8, .fields = a_fields, .field_count = 2, .module_id = 11 };
+    TypeDesc b    = { .name = "TestKeepB", .size = 8, .fields = b_fields, .field_count = 1, .module_id = 11 };
+    TypeDesc c    = { .name = "TestKeepC", .size = 4, .module_id = 11, .version = 3 };
+    TypeDesc nest = { .name = "TestKeepNest", .size = 8, .fields = nest_fields, .field_count = 1,
+                      .field_types = nest_types, .module_id = 11 };
+
+    registry_write_begin();
+    TypeID a_id    = type_register( &a );
+    TypeID b_id    = type_register( &b );
+    TypeID c_id    = type_register( &c );
+    TypeID nest_id = type_register( &nest );
+    registry_write_end();
+    uint32_t a_first  = type_get( a_id )->field_first;
+    Type*    b_old    = type_get( b_id );
+    Type*    nest_old = type_get( nest_id );
+
+    // Reload round: A unchanged, B grows a field (no version bump given), C dropped
+    b.size        = 12;
+    b.fields      = b2_fields;
+    b.field_count = 2;
+    registry_write_begin();
+    type_unregister_module( 11 );
+    CHECK( type_find_by_name( "TestKeepA" ) == NULL );
+    CHECK( type_register( &a ) == a_id );
+    CHECK( type_register( &b ) == b_id && type_register( &nest ) == nest_id );
+    CHECK( type_get( b_id ) != b_old && type_get( b_id )->size == 12 );    // The writer sees its draft
+    CHECK( b_old->size == 8 && b_old->field_count == 1 && b_old->id == b_id );    // Old record, for readers
+    registry_write_end();
+
+    CHECK( type_get( a_id )->field_first == a_first );    // Untouched
+    CHECK( type_find_by_name( "TestKeepB" ) == type_get( b_id ) );
+    CHECK( type_get( b_id )->size == 12 && type_get( b_id )->field_count == 2 );
+    CHECK( type_info( type_get( b_id ) )->version == 1 );                        // Bumped for it
+    CHECK( type_info( type_get( nest_id ) )->version == 1 );                     // Nests a changed type
+    CHECK( type_get( nest_id ) != nest_old && type_field( type_get( nest_id ), 0 )->type_id == b_id );
+    CHECK( type_info( b_old )->state == TYPE_FREE && type_info( nest_old )->state == TYPE_FREE );
+    CHECK( type_find_by_name( "TestKeepC" ) == NULL );
+    CHECK( type_info( type_get( c_id ) )->state == TYPE_FREE );
+
+    // Freed ids and records go to the next new types
+    uint16_t types = g_registry.type_count;
+    uint16_t ids   = g_registry.id_count;
+    TypeDesc d     = { .name = "TestKeepD", .size = 4, .module_id = 11 };
+    TypeID   d_id  = type_register( &d );
+    CHECK( d_id == c_id && type_find_by_name( "TestKeepD" ) == type_get( d_id ) );
+    CHECK( g_registry.type_count == types && g_registry.id_count == ids );
+
+    // Changing layouts back and forth reuses the freed records and pool ranges
+    uint32_t fields = 0, keys = 0;
+    for ( int round = 0; round < 64; round++ )
+    {
+        b.size        = round & 1 ? 12 : 8;
+        b.fields      = round & 1 ? b2_fields : b_fields;
+        b.field_count = round & 1 ? 2 : 1;
+        b.version = nest.version = (uint8_t)( round + 2 );
+        registry_write_begin();
+        type_unregister_module( 11 );
+        type_register( &a );
+        type_register( &b );
+        type_register( &nest );
+        type_register( &d );
+        registry_write_end();
+        if ( round == 1 )
+        {
+            fields = g_registry.field_count;
+            keys   = g_registry.field_key_count;
+        }
+    }
+    CHECK( g_registry.type_count == types && g_registry.id_count == ids );
+    CHECK( g_registry.field_count == fields && g_registry.field_key_count == keys );
+    CHECK( type_get( a_id )->field_first == a_first && type_find_by_name( "TestKeepB" )->size == 12 );
+    CHECK( type_find_by_name( "TestKeepB" )->id == b_id && type_find_by_name( "TestKeepNest" )->id == nest_id );
+
+    // Unbatched unregister frees at once
+    type_unregister_module( 11 );
+    CHECK( type_find_by_name( "TestKeepA" ) == NULL && type_info( type_get( a_id ) )->state == TYPE_FREE );
+}
+
+// ============================================================================
+// Test types - registered once, shared by the tests below
+// ============================================================================
+
+typedef struct TestInner
+{
+    float x, y, z;
+} TestInner;
+
+typedef struct TestPadded
+{
+    uint8_t   tag;      // 3 bytes padding after
+    TestInner inner;    // merges with tag2 below
+    uint8_t   tag2;     // padding up to the double
+    double    value;
+
+} TestPadded;
+
+static TypeID s_inner_id;
+static TypeID s_padded_id;
+
+static void
+register_test_types( void )
+{
+    // Core type first, like main.c - field type_id 0 means "primitive"
+    TypeDesc float_type = {
+        .hash = hash_string( "float" ),
+        .name = "float",
+        .size = sizeof( float ),
+    };
+    type_register( &float_type );
+
+    Field inner_fields[] = {
+        { "x", offsetof( TestInner, x ), sizeof( float ), 0, 0 },
+        { "y", offsetof( TestInner, y ), sizeof( float ), 0, 0 },
+        { "z", offsetof( TestInner, z ), sizeof( float ), 0, 0 },
+    };
+    TypeDesc inner_type = {
+        .hash        = hash_string( "TestInner" ),
+        .name        = "TestInner",
+        .size        = sizeof( TestInner ),
+        .fields      = inner_fields,
+        .field_count = 3,
+    };
+    s_inner_id = type_register( &inner_type );
+
+    Field padded_fields[] = {
+        { "tag", offsetof( TestPadded, tag ), 1, 0, 0 },
+        { "inner", offsetof( TestPadded, inner ), sizeof( TestInner ), s_inner_id, 0 },
+        { "tag2", offsetof( TestPadded, tag2 ), 1, 0, 0 },
+        { "value", offsetof( TestPadded, value ), sizeof( double ), 0, 0 },
+    };
+    TypeDesc padded_type = {
+        .hash        = hash_string( "TestPadded" ),
+        .name        = "TestPadded",
+        .size        = sizeof( TestPadded ),
+        .fields      = padded_fields,
+        .field_count = 4,
+    };
+    s_padded_id = type_register( &padded_type );
+}
+
+// ============================================================================
+// Field paths
+// ============================================================================
+
+static void
+test_field_paths( void )
+{
+    Type*     type = type_get( s_padded_id );
+    FieldPath path;
+    CHECK( field_path_resolve( type, "inner.y", &path ) );
+    CHECK( path.offset == offsetof( TestPadded, inner ) + offsetof( TestInner, y ) );
+    CHECK( path.kind == FIELD_KIND_FLOAT && path.size == sizeof( float ) );
+
+    CHECK( field_path_resolve( type, "inner", &path ) );
+    CHECK( path.kind == FIELD_KIND_STRUCT && path.type_id == s_inner_id );
+    CHECK( !field_path_resolve( type, "inner.w", &path ) );
+    CHECK( !field_path_resolve( type, "tag.x", &path ) );    // Primitive has no children
+    CHECK( !field_path_resolve( type, "in", &path ) );       // No prefix matches
+
+    TestPadded obj = { .inner = { 1, 2, 3 } };
+    CHECK( *(float*)field_path_ptr( &obj, &path ) == 1.0f );
+
+    // A cached ref follows a type re-registered with a new layout
+    Field    v1_fields[] = { { "a", 0, 4, 0, 0 }, { "b", 4, 4, 0, 0 } };
+    Field    v2_fields[] = { { "b", 0, 4, 0, 0 }, { "a", 8, 4, 0, 0 } };
+    TypeDesc moving      = { .hash = hash_string( "TestMoving" ), .name = "TestMoving", .size = 12 };
+    moving.fields        = v1_fields;
+    moving.field_count   = 2;
+    type_register( &moving );
+
+    FieldRef ref = FIELD_REF( "TestMoving", "a" );
+    CHECK( field_ref_get( &ref ) && field_ref_get( &ref )->offset == 0 );
+    CHECK( ref.generation == g_registry.generation );
+
+    moving.fields = v2_fields;
+    type_register( &moving );
+    CHECK( field_ref_get( &ref ) && field_ref_get( &ref )->offset == 8 );
+
+    FieldRef missing = FIELD_REF( "TestMoving", "c" );
+    CHECK( field_ref_ptr( &obj, &missing ) == NULL );
+
+    // Type handles: probe once, again only after the generation moves
+    TypeHandle handle = TYPE_HANDLE( "TestMoving" );
+    Type*      first  = type_handle_get( &handle );
+    CHECK( first && first == type_find_by_name( "TestMoving" ) );
+    CHECK( handle.hash == hash_string( "TestMoving" ) && handle.generation == g_registry.generation );
+
+    moving.fields = v1_fields;
+    type_register( &moving );
+    CHECK( handle.generation != g_registry.generation );
+    CHECK( type_handle_get( &handle ) == type_find_by_name( "TestMoving" ) && type_handle_get( &handle ) != first );
+
+    TypeHandle absent = TYPE_HANDLE( "TestNotRegistered" );
+    CHECK( type_handle_get( &absent ) == NULL && type_handle_get( &absent ) == NULL );
+}
+
+// ============================================================================
+// Type tables
+// ============================================================================
+
+#define TEST_TABLE_FIELDS( S, FIELD, NESTED )    \
+    FIELD( S, uint8_t, tag, , 0 )                \
+    NESTED( S, TestInner, inner, 0 )             \
+    FIELD( S, char, label, [ 6 ], FIELD_EDITABLE )
+
+TYPE_STRUCT( TestTable, TEST_TABLE_FIELDS );
+TYPE_TABLE( TestTable, TEST_TABLE_FIELDS );
+
+static const TypeDesc k_test_table = TYPE_DESC( TestTable, NULL, 0, 1 );
+
+static void
+test_type_table( void )
+{
+    CHECK( TYPE_FIELD_TestTable_label == 2 && TYPE_FIELD_COUNT_TestTable == 3 );
+    CHECK( k_TestTable_fields[ 1 ].offset == offsetof( TestTable, inner ) );
+    CHECK( k_TestTable_fields[ 2 ].size == 6 && k_TestTable_fields[ 2 ].flags == FIELD_EDITABLE );
+
+    // Nested names resolve at registration, the const table is left alone
+    TypeID id   = type_register( &k_test_table );
+    Type*  type = type_get( id );
+    CHECK( type != NULL && type == type_find_by_name( "TestTable" ) );
+    CHECK( type->hash == hash_string( "TestTable" ) );
+    CHECK( type->size == sizeof( TestTable ) && type->field_count == 3 );
+    CHECK( type_field( type, 1 )->type_id == s_inner_id );
+    CHECK( type_field( type, 0 )->type_id == 0 );
+    CHECK( k_TestTable_fields[ 1 ].type_id == 0 );
+#if defined( __GNUC__ ) && !defined( __clang__ )
+    CHECK( k_test_table.hash == hash_string( "TestTable" ) );
+#endif
+
+    // No hash given: the name is hashed at registration
+    TypeDesc unhashed    = { .name = "TestUnhashed", .size = 4 };
+    TypeID   unhashed_id = type_register( &unhashed );
+    CHECK( type_find_by_hash( hash_string( "TestUnhashed" ) ) == type_get( unhashed_id ) );
+
+    // A nested type that is not registered refuses the whole type
+    const char* const missing_types[] = { "", "TestNowhere", "" };
+    TypeDesc          dangling        = k_test_table;
+    dangling.name                     = "TestDangling";
+    dangling.hash                     = hash_string( "TestDangling" );
+    dangling.field_types              = missing_types;
+    uint16_t types                    = g_registry.type_count;
+    type_register( &dangling );
+    CHECK( g_registry.type_count == types );
+    CHECK( type_find_by_name( "TestDangling" ) == NULL );
+}
+
+// ============================================================================
+// Binary copy plans
+// ============================================================================
+
+static void
+test_copy_plan( void )
+{
+    TypeID inner_id  = s_inner_id;
+    TypeID padded_id = s_padded_id;
+
+    // Nested floats collapse to one run, whole-array copies become one memcpy
+    const CopyPlan* inner_plan = copy_plan_get( type_get( inner_id ) );
+    CHECK( inner_plan->run_count == 1 );
+    CHECK( inner_plan->is_dense );
+
+    // tag | inner.x..z + tag2 | value - padding never reaches the stream
+    const CopyPlan* plan = copy_plan_get( type_get( padded_id ) );
+    CHECK( plan == copy_plan_get( type_get( padded_id ) ) );
+    CHECK( plan->run_count == 3 );
+    CHECK( plan->packed_size == 1 + 12 + 1 + 8 );
+    CHECK( !plan->is_dense );
+
+    enum { N = 5000 };
+    static TestPadded src[ N ], dst[ N ];
+    memset( src, 0xAB, sizeof( src ) );    // Garbage in the padding must not matter
+    for ( int i = 0; i < N; i++ )
+    {
+        src[ i ].tag     = (uint8_t)i;
+        src[ i ].inner.x = (float)i;
+        src[ i ].inner.z = -(float)i;
+        src[ i ].tag2    = 7;
+        src[ i ].value   = i * 0.5;
+    }
+
+    FILE* f = tmpfile();
+    CHECK( serialize_binary_write( f, type_get( padded_id ), src, N ) );
+    rewind( f );
+    CHECK( deserialize_binary_read( f, type_get( padded_id ), dst, N ) == N );
+    fclose( f );
+
+    int same = 1;
+    for ( int i = 0; i < N; i++ )
+    {
+        same &= dst[ i ].tag == src[ i ].tag && dst[ i ].inner.x == src[ i ].inner.x &&
+                dst[ i ].inner.z == src[ i ].inner.z && dst[ i ].tag2 == 7 && dst[ i ].value == src[ i ].value;
+    }
+    CHECK( same );
+
+    // A short read skips the rest of the array, so the next one still lines up
+    f = tmpfile();
+    CHECK( serialize_binary_write( f, type_get( padded_id ), src, N ) );
+    CHECK( serialize_binary_write( f, type_get( padded_id ), src + 1, 2 ) );
+    CHECK( serialize_binary_write( f, type_get( inner_id ), &src[ 3 ].inner, 1 ) );
+    rewind( f );
+    CHECK( deserialize_binary_read( f, type_get( padded_id ), dst, 10 ) == 10 );
+    CHECK( deserialize_binary_read( f, type_get( padded_id ), dst, 1 ) == 1 );
+    CHECK( dst[ 0 ].tag == 1 && dst[ 0 ].value == 0.5 );
+    TestInner inner;
+    CHECK( deserialize_binary_read( f, type_get( inner_id ), &inner, 0 ) == 0 );
+    CHECK( fgetc( f ) == EOF );
+    fclose( f );
+
+    // A different layout is rejected instead of misread
+    f = tmpfile();
+    CHECK( serialize_binary_write( f, type_get( padded_id ), src, 1 ) );
+    rewind( f );
+    CHECK( deserialize_binary_read( f, type_get( inner_id ), dst, 1 ) == 0 );
+    fclose( f );
+
+    // So is one that swaps two members of the same shape, or retypes a leaf
+    Field     pair_fields[] = { { "a", 0, sizeof( TestInner ), inner_id, 0 },
+                                { "b", sizeof( TestInner ), sizeof( TestInner ), inner_id, 0 } };
+    TypeDesc  pair          = { .name = "TestPair", .size = 2 * sizeof( TestInner ), .fields = pair_fields,
+                                .field_count = 2 };
+    TestInner pair_src[ 2 ] = { { 1, 2, 3 }, { 4, 5, 6 } };
+    TestInner pair_dst[ 2 ];
+    f = tmpfile();
+    CHECK( serialize_binary_write( f, type_get( type_register( &pair ) ), pair_src, 1 ) );
+    pair_fields[ 0 ].name = "b";
+    pair_fields[ 1 ].name = "a";
+    rewind( f );
+    CHECK( deserialize_binary_read( f, type_get( type_register( &pair ) ), pair_dst, 1 ) == 0 );
+    fclose( f );
+
+    Field    one_float[] = { { "v", 0, 4, 0, FIELD_KIND_FLAG( FIELD_KIND_FLOAT ) } };
+    TypeDesc retyped     = { .name = "TestRetyped", .size = 4, .fields = one_float, .field_count = 1 };
+    uint32_t float_hash  = copy_plan_get( type_get( type_register( &retyped ) ) )->layout_hash;
+    one_float[ 0 ].flags = FIELD_KIND_FLAG( FIELD_KIND_INT32 );
+    CHECK( copy_plan_get( type_get( type_register( &retyped ) ) )->layout_hash != float_hash );
+}
+
+// ============================================================================
+// Memberwise type ops
+// ============================================================================
+
+static void
+test_type_ops( void )
+{
+    // Floats only: one run, arrays lerp as a single float array
+    const TypeOps* inner = type_ops_get( type_get( s_inner_id ) );
+    CHECK( inner != NULL && inner == type_ops_get( type_get( s_inner_id ) ) );
+    CHECK( inner->is_dense && inner->all_float );
+    CHECK( inner->run_count == 1 && inner->lerp_count == 1 );
+
+    // tag | inner + tag2 | value, split again where the floats end
+    const TypeOps* ops = type_ops_get( type_get( s_padded_id ) );
+    CHECK( !ops->is_dense && !ops->all_float );
+    CHECK( ops->run_count == 3 && ops->lerp_count == 4 );
+    CHECK( ops->runs[ ops->run_count + 1 ].is_float && ops->runs[ ops->run_count + 1 ].size == 12 );
+
+    // Padding is neither compared nor hashed
+    TestPadded a, b;
+    memset( &a, 0x11, sizeof( a ) );
+    memset( &b, 0xEE, sizeof( b ) );
+    a.tag = b.tag     = 3;
+    a.inner = b.inner = ( TestInner ){ 1.0f, 2.0f, 3.0f };
+    a.tag2 = b.tag2   = 9;
+    a.value = b.value = 0.25;
+    CHECK( memcmp( &a, &b, sizeof( a ) ) != 0 );
+    CHECK( type_ops_equal( ops, &a, &b ) );
+    CHECK( type_ops_hash( ops, &a ) == type_ops_hash( ops, &b ) );
+    b.tag2 = 8;
+    CHECK( !type_ops_equal( ops, &a, &b ) );
+    CHECK( type_ops_hash( ops, &a ) != type_ops_hash( ops, &b ) );
+
+    // Copy leaves the destination's padding alone
+    TestPadded c;
+    memset( &c, 0x77, sizeof( c ) );
+    type_ops_copy( ops, &c, &a );
+    CHECK( type_ops_equal( ops, &c, &a ) );
+    CHECK( ( (const uint8_t*)&c )[ 1 ] == 0x77 );
+
+    // Floats blend, everything else comes from the nearer end
+    b.tag     = 4;
+    b.inner.x = 3.0f;
+    b.value   = 1.0;
+    TestPadded mid;
+    type_ops_lerp( ops, &mid, &a, &b, 0.25f );
+    CHECK( mid.inner.x == 1.5f && mid.inner.y == 2.0f );
+    CHECK( mid.tag == 3 && mid.tag2 == 9 && mid.value == 0.25 );
+    type_ops_lerp( ops, &mid, &a, &b, 0.75f );
+    CHECK( mid.inner.x == 2.5f && mid.tag == 4 && mid.tag2 == 8 && mid.value == 1.0 );
+
+    // Arrays: diff reports changed objects only, padding garbage ignored
+    enum { N = 1000 };
+    static TestPadded before[ N ], after[ N ], blended[ N ];
+    static uint32_t   changed[ N ];
+    static uint64_t   hashes[ N ];
+    memset( before, 0x5A, sizeof( before ) );
+    for ( int i = 0; i < N; i++ )
+    {
+        before[ i ].tag   = (uint8_t)i;
+        before[ i ].inner = ( TestInner ){ (float)i, 0, -(float)i };
+        before[ i ].tag2  = 1;
+        before[ i ].value = i;
+    }
+    memset( after, 0xA5, sizeof( after ) );
+    type_ops_copy_array( ops, after, before, N );
+    CHECK( type_ops_diff( ops, before, after, N, changed ) == 0 );
+    after[ 17 ].inner.y = 1.0f;
+    after[ 999 ].value  = -1.0;
+    CHECK( type_ops_diff( ops, before, after, N, changed ) == 2 );
+    CHECK( changed[ 0 ] == 17 && changed[ 1 ] == 999 );
+
+    type_ops_hash_array( ops, before, N, hashes );
+    CHECK( hashes[ 5 ] == type_ops_hash( ops, &before[ 5 ] ) && hashes[ 5 ] != hashes[ 6 ] );
+
+    type_ops_lerp_array( ops, blended, before, after, N, 0.5f );
+    CHECK( blended[ 17 ].inner.y == 0.5f && blended[ 17 ].tag == 17 );
+    CHECK( blended[ 999 ].value == -1.0 );
+
+    // Dense types take the block and whole-array paths
+    static TestInner from[ N ], to[ N ], out[ N ];
+    for ( int i = 0; i < N; i++ )
+    {
+        from[ i ] = ( TestInner ){ (float)i, 1.0f, 2.0f };
+        to[ i ]   = from[ i ];
+    }
+    to[ 64 ].z = 4.0f;
+    CHECK( type_ops_diff( inner, from, to, N, changed ) == 1 && changed[ 0 ] == 64 );
+    type_ops_lerp_array( inner, out, from, to, N, 0.5f );
+    CHECK( out[ 64 ].z == 3.0f && out[ 63 ].x == 63.0f );
+    type_ops_lerp_array( inner, from, from, to, N, 1.0f );    // In place
+    CHECK( type_ops_diff( inner, from, to, N, changed ) == 0 );
+}
+
+// ============================================================================
+// SoA storage
+// ============================================================================
+
+static void
+test_soa_storage( void )
+{
+    Type*       type = type_get( s_padded_id );
+    SoaStorage* soa  = soa_create( type, 4 );
+    CHECK( soa != NULL );
+    CHECK( soa->column_count == 6 );    // tag, inner.x, inner.y, inner.z, tag2, value
+
+    for ( int i = 0; i < 100; i++ )    // Grows past the initial capacity
+    {
+        TestPadded p = { .tag = (uint8_t)i, .inner = { (float)i, 2.0f * i, 0 }, .value = i };
+        CHECK( soa_push( soa, &p ) == (uint32_t)i );
+    }
+    CHECK( soa->count == 100 );
+
+    // Columns are plain contiguous arrays
+    int y = soa_column_index( soa, type, "inner.y" );
+    CHECK( y >= 0 );
+    CHECK( soa_column_index( soa, type, "inner" ) < 0 );    // Not a leaf
+    CHECK( soa_column_index( soa, type, "inner.w" ) < 0 );
+    CHECK( ( (uintptr_t)soa_column_data( soa, y ) % SOA_ALIGNMENT ) == 0 );
+
+    float* ys = (float*)soa_column_data( soa, y );
+    CHECK( ys[ 10 ] == 20.0f );
+    ys[ 10 ] = -1.0f;
+
+    // Logical object view for tools
+    TestPadded p;
+    soa_get( soa, 10, &p );
+    CHECK( p.tag == 10 && p.inner.x == 10.0f && p.inner.y == -1.0f && p.value == 10.0 );
+
+    const char* paths[] = { "value", "tag" };
+    SoaView     view;
+    CHECK( soa_view( soa, type, paths, 2, &view ) );
+    CHECK( view.count == 100 && ( (double*)view.columns[ 0 ] )[ 99 ] == 99.0 );
+
+    soa_remove_swap( soa, 0 );
+    soa_get( soa, 0, &p );
+    CHECK( soa->count == 99 && p.tag == 99 );
+    soa_remove_swap( soa, 99 );    // Past the end, nothing moves
+    CHECK( soa->count == 99 );
+
+    SoaStorage* empty = soa_create( type, 4 );
+    soa_remove_swap( empty, 0 );
+    CHECK( empty->count == 0 );
+    soa_destroy( empty );
+
+    soa_destroy( soa );
+}
+
+// ============================================================================
+// Entity kernels - every SIMD level matches the scalar reference bit for bit
+// ============================================================================
+
+static void
+test_entity_kernels( void )
+{
+    enum { N = 1003 };    // Odd count exercises the tails
+    static float current[ N ], regen[ N ], maximum[ N ], expect[ N ];
+    static float position[ N ], speed[ N ], expect_pos[ N ];
+    static float blend[ N ], expect_blend[ N ];
+
+    const EntityKernels* scalar = entity_kernels_for( SIMD_SCALAR );
+    CHECK( scalar != NULL );
+    CHECK( entity_kernels() != NULL );
+    CHECK( entity_kernels()->level == ( simd_level() < SIMD_AVX2 ? simd_level() : SIMD_AVX2 ) );    // No AVX-512 variant
+
+    for ( int level = SIMD_SCALAR; level <= SIMD_AVX2; level++ )
+    {
+        const EntityKernels* k = entity_kernels_for( (SimdLevel)level );
+        if ( !k )
+            continue;
+
+        for ( int i = 0; i < N; i++ )
+        {
+            current[ i ] = expect[ i ] = (float)( i % 120 );
+            regen[ i ]                 = 0.5f + (float)( i % 7 );
+            maximum[ i ]               = 100.0f;
+            position[ i ] = expect_pos[ i ] = (float)i * 0.25f;
+            speed[ i ]                      = (float)( i % 11 ) - 5.0f;
+        }
+
+        // Offset by one element so the vector loads are unaligned
+        k->regen_clamp( current + 1, regen + 1, maximum + 1, 0.016f, N - 1 );
+        k->integrate( position + 1, speed + 1, 0.016f, N - 1 );
+        scalar->regen_clamp( expect + 1, regen + 1, maximum + 1, 0.016f, N - 1 );
+        scalar->integrate( expect_pos + 1, speed + 1, 0.016f, N - 1 );
+        k->lerp( blend + 1, current + 1, position + 1, 0.3f, N - 1 );
+        scalar->lerp( expect_blend + 1, current + 1, position + 1, 0.3f, N - 1 );
+
+        CHECK( memcmp( current, expect, sizeof( current ) ) == 0 );
+        CHECK( memcmp( position, expect_pos, sizeof( position ) ) == 0 );
+        CHECK( memcmp( blend, expect_blend, sizeof( blend ) ) == 0 );
+        CHECK( current[ 119 ] == 100.0f );    // Clamped
+    }
+}
+
+// ============================================================================
+// Batched field gather / scatter
+// ============================================================================
+
+static void
+test_field_batch( void )
+{
+    enum { N = 1003, SEL = 37 };
+    static TestPadded objs[ N ];
+    static float      got[ N ], want[ N ];
+    static double     values[ N ];
+    uint32_t          selection[ SEL ];
+
+    Type*     type = type_get( s_padded_id );
+    FieldPath y, value;
+    CHECK( field_path_resolve( type, "inner.y", &y ) );
+    CHECK( field_path_resolve( type, "value", &value ) );
+    for ( int i = 0; i < SEL; i++ ) selection[ i ] = (uint32_t)( ( i * 389 ) % N );    // Scattered, unsorted
+    selection[ SEL - 1 ] = selection[ 0 ];                                             // Duplicate: last write wins
+
+    for ( int level = SIMD_SCALAR; level <= SIMD_AVX512; level++ )
+    {
+        const FieldBatchKernels* k = field_batch_kernels_for( (SimdLevel)level );
+        if ( !k )
+            continue;
+
+        for ( int i = 0; i < N; i++ )
+        {
+            objs[ i ] = ( TestPadded ){ .tag = (uint8_t)i, .inner = { 0, (float)i * 0.5f, 0 }, .value = i };
+            want[ i ] = (float)i * 0.5f;
+        }
+
+        // Dense gather / scatter, base offset by one so the tails are exercised
+        const char* base = (const char*)( objs + 1 ) + y.offset;
+        memset( got, 0, sizeof( got ) );
+        k->gather32( base, sizeof( TestPadded ), N - 1, (uint32_t*)got );
+        CHECK( memcmp( got, want + 1, ( N - 1 ) * sizeof( float ) ) == 0 );
+
+        for ( int i = 0; i < N; i++ ) got[ i ] = -(float)i;
+        k->scatter32( (char*)objs + y.offset, sizeof( TestPadded ), N, (const uint32_t*)got );
+        CHECK( objs[ N - 1 ].inner.y == -(float)( N - 1 ) && objs[ N - 1 ].tag == (uint8_t)( N - 1 ) );
+
+        // Selection gather / scatter
+        k->gather32_indexed( (const char*)objs + y.offset, sizeof( TestPadded ), selection, SEL, (uint32_t*)got );
+        int ok = 1;
+        for ( int i = 0; i < SEL; i++ ) ok &= got[ i ] == -(float)selection[ i ];
+        CHECK( ok );
+
+        for ( int i = 0; i < SEL; i++ ) got[ i ] = 1000.0f + i;
+        k->scatter32_indexed( (char*)objs + y.offset, sizeof( TestPadded ), selection, SEL, (const uint32_t*)got );
+        CHECK( objs[ selection[ 1 ] ].inner.y == 1001.0f );
+        CHECK( objs[ selection[ 0 ] ].inner.y == 1000.0f + ( SEL - 1 ) );
+    }
+
+    // Public API: 8-byte fields take the scalar path, fill writes one value everywhere
+    field_gather( objs, sizeof( TestPadded ), N, &value, values );
+    CHECK( values[ 0 ] == 0.0 && values[ N - 1 ] == (double)( N - 1 ) );
+
+    float fill = 7.5f;
+    field_fill_indexed( objs, sizeof( TestPadded ), selection, SEL, &y, &fill );
+    field_gather_indexed( objs, sizeof( TestPadded ), selection, SEL, &y, got );
+    CHECK( got[ 0 ] == 7.5f && got[ SEL - 2 ] == 7.5f );
+
+    field_fill( objs, sizeof( TestPadded ), N, &value, &values[ 5 ] );
+    CHECK( objs[ 0 ].value == 5.0 && objs[ N - 1 ].value == 5.0 && objs[ 3 ].tag == 3 );
+}
+
+// ============================================================================
+// Predicate queries
+// ============================================================================
+
+#define TEST_QUERY_FIELDS( S, FIELD, NESTED )                                \
+    FIELD( S, int32_t, level, , FIELD_KIND_FLAG( FIELD_KIND_INT32 ) )        \
+    NESTED( S, TestInner, inner, 0 )                                         \
+    FIELD( S, uint32_t, mask, , FIELD_KIND_FLAG( FIELD_KIND_UINT32 ) )       \
+    FIELD( S, uint8_t, tag, , 0 )
+
+TYPE_STRUCT( TestQuery, TEST_QUERY_FIELDS );
+TYPE_TABLE( TestQuery, TEST_QUERY_FIELDS );
+
+static const TypeDesc k_test_query = TYPE_DESC( TestQuery, NULL, 0, 1 );
+
+static int
+test_query_match( const TestQuery* o )
+{
+    return o->inner.y < 20.0f && o->level >= -3 && o->mask > 2147483648u;
+}
+
+static void
+test_query( void )
+{
+    Type* type = type_get( type_register( &k_test_query ) );
+    CHECK( type != NULL );
+
+    Query query;
+    CHECK( query_compile( &query, type, "inner.y < 20 && level >= -3&&mask > 2147483648" ) );
+    CHECK( query.term_count == 3 && !query_is_stale( &query ) );
+    CHECK( query.terms[ 0 ].kind == FIELD_KIND_FLOAT && query.terms[ 0 ].op == QUERY_LT );
+    CHECK( query.terms[ 1 ].kind == FIELD_KIND_INT32 && query.terms[ 1 ].value.i == -3 );
+    CHECK( query.terms[ 2 ].kind == FIELD_KIND_UINT32 && query.terms[ 2 ].value.u == 2147483648u );
+
+    // Refused: unknown or non-numeric fields, integers that don't fit, bad syntax
+    Query bad;
+    CHECK( !query_compile( &bad, type, "inner.w < 1" ) );
+    CHECK( !query_compile( &bad, type, "inner < 1" ) );
+    CHECK( !query_compile( &bad, type, "tag == 1" ) );
+    CHECK( !query_compile( &bad, type, "level < 2.5" ) );
+    CHECK( !query_compile( &bad, type, "mask >= -1" ) );
+    CHECK( !query_compile( &bad, type, "level <" ) );
+    CHECK( !query_compile( &bad, type, "level < 1 || mask > 2" ) );
+    CHECK( !query_compile( &bad, type, "" ) );
+
+    // Every level matches the scalar reference, NaN and the unsigned range included
+    enum { LANES = 61 };    // Not a multiple of any vector width
+    float    floats[ LANES ];
+    uint32_t ints[ LANES ];
+    for ( int i = 0; i < LANES; i++ )
+    {
+        floats[ i ] = i % 9 == 0 ? NAN : (float)( i % 7 ) - 3.0f;
+        ints[ i ]   = (uint32_t)( i % 5 ) * 0x40000000u - 2u;
+    }
+    const QueryKernels* scalar = query_kernels_for( SIMD_SCALAR );
+    for ( int level = SIMD_SCALAR; level <= SIMD_AVX2; level++ )
+    {
+        const QueryKernels* k = query_kernels_for( (SimdLevel)level );
+        if ( !k )
+            continue;
+        for ( int op = QUERY_LT; op <= QUERY_NE; op++ )
+        {
+            CHECK( k->compare_f32( floats, LANES, (QueryOp)op, 1.0f ) ==
+                   scalar->compare_f32( floats, LANES, (QueryOp)op, 1.0f ) );
+            CHECK( k->compare_i32( ints, LANES, (QueryOp)op, 0x40000000u, 0 ) ==
+                   scalar->compare_i32( ints, LANES, (QueryOp)op, 0x40000000u, 0 ) );
+            CHECK( k->compare_i32( ints, LANES, (QueryOp)op, 0x40000000u, 0x80000000u ) ==
+                   scalar->compare_i32( ints, LANES, (QueryOp)op, 0x40000000u, 0x80000000u ) );
+        }
+    }
+    CHECK( scalar->compare_f32( floats, 9, QUERY_NE, 1.0f ) & 1 );    // NaN != 1
+    CHECK( !( scalar->compare_f32( floats, 9, QUERY_EQ, NAN ) & 1 ) );
+
+    // Serial and parallel scans agree with a plain loop, tail block included
+    enum { N = 10007 };
+    static TestQuery objs[ N ];
+    static uint64_t  bitmap[ QUERY_WORDS( N ) ], parallel[ QUERY_WORDS( N ) ];
+    static uint32_t  indices[ N ];
+    for ( int i = 0; i < N; i++ )
+    {
+        objs[ i ].level = i % 13 - 6;
+        objs[ i ].inner = ( TestInner ){ 0, (float)( i % 40 ), 0 };
+        objs[ i ].mask  = (uint32_t)i * 2654435761u;
+    }
+
+    size_t expect = 0;
+    for ( int i = 0; i < N; i++ ) expect += (size_t)test_query_match( &objs[ i ] );
+    CHECK( query_select( &query, objs, sizeof( TestQuery ), N, bitmap ) == expect );
+
+    int same = 1;
+    for ( int i = 0; i < N; i++ )
+    {
+        int bit = (int)( ( bitmap[ i / 64 ] >> ( i % 64 ) ) & 1 );
+        same &= bit == test_query_match( &objs[ i ] );
+    }
+    CHECK( same );
+    CHECK( bitmap[ QUERY_WORDS( N ) - 1 ] >> ( N % 64 ) == 0 );
+
+    job_system_init( 3 );
+    CHECK( query_select_parallel( &query, objs, sizeof( TestQuery ), N, parallel ) == expect );
+    job_system_shutdown();
+    CHECK( memcmp( bitmap, parallel, sizeof( bitmap ) ) == 0 );
+
+    size_t found = query_bitmap_indices( bitmap, N, indices );
+    CHECK( found == expect && expect > 0 );
+    CHECK( test_query_match( &objs[ indices[ 0 ] ] ) && test_query_match( &objs[ indices[ found - 1 ] ] ) );
+    CHECK( indices[ 0 ] < indices[ found - 1 ] );
+
+    // No terms: everything
+    query_clear( &query, type );
+    CHECK( query_select( &query, objs, sizeof( TestQuery ), N, bitmap ) == N );
+}
+
+// ============================================================================
+// Display lists
+// ============================================================================
+
+#define TEST_VIEW_FIELDS( S, FIELD, NESTED )                              \
+    FIELD( S, uint32_t, id, , FIELD_KIND_FLAG( FIELD_KIND_UINT32 ) )      \
+    NESTED( S, TestInner, inner, FIELD_EDITABLE )                         \
+    FIELD( S, float, speed, , FIELD_EDITABLE )                            \
+    FIELD( S, uint8_t, tag, , FIELD_EDITABLE )
+
+TYPE_STRUCT( TestView, TEST_VIEW_FIELDS );
+TYPE_TABLE( TestView, TEST_VIEW_FIELDS );
+
+static const TypeDesc k_test_view = TYPE_DESC( TestView, NULL, 0, 1 );
+
+typedef struct TestDrawLog
+{
+    size_t             calls;
+    size_t             last_object;
+    const DisplayItem* last_item;
+
+} TestDrawLog;
+
+static void
+test_draw_log( void* ctx, size_t object, const DisplayItem* item, const void* base )
+{
+    TestDrawLog* log = (TestDrawLog*)ctx;
+    log->calls++;
+    log->last_object = object;
+    log->last_item   = item;
+}
+
+static void
+test_display_list( void )
+{
+    Type* type = type_get( type_register( &k_test_view ) );
+    CHECK( type != NULL );
+
+    // Editable structs open in place under a header of their own
+    const DisplayList* list = display_list_get( type );
+    CHECK( list != NULL && list == display_list_get( type ) );
+    CHECK( list->item_count == 9 );
+    CHECK( list->items[ 0 ].widget == DISPLAY_HEADER && strcmp( list->items[ 0 ].label, "TestView" ) == 0 );
+    CHECK( list->items[ 1 ].widget == DISPLAY_READ_ONLY && list->items[ 1 ].size == 4 );
+    CHECK( list->items[ 2 ].widget == DISPLAY_NESTED && list->items[ 2 ].size == 0 );
+    CHECK( list->items[ 3 ].widget == DISPLAY_HEADER && list->items[ 3 ].depth == 1 );
+    CHECK( list->items[ 5 ].widget == DISPLAY_READ_ONLY && list->items[ 5 ].offset == offsetof( TestView, inner.y ) );
+    CHECK( list->items[ 7 ].widget == DISPLAY_FLOAT && list->items[ 7 ].size == 4 );
+    CHECK( list->items[ 8 ].widget == DISPLAY_EDITABLE && list->items[ 8 ].size == 1 );
+
+    enum { N = 300 };
+    static TestView objs[ N ];
+    for ( int i = 0; i < N; i++ ) objs[ i ] = ( TestView ){ .id = (uint32_t)i, .speed = 1.0f };
+
+    DisplayView view;
+    TestDrawLog log = { 0 };
+    display_view_init( &view, type, objs, N );
+    CHECK( display_view_refresh( &view, test_draw_log, &log ) == N * 9 && log.calls == N * 9 );
+
+    // Nothing changed, then only the field whose bytes did, widget or not
+    log.calls = 0;
+    CHECK( display_view_refresh( &view, test_draw_log, &log ) == 0 && log.calls == 0 );
+    objs[ 7 ].speed = 2.0f;
+    CHECK( display_view_refresh( &view, test_draw_log, &log ) == 1 );
+    CHECK( log.last_object == 7 && log.last_item == &list->items[ 7 ] );
+    objs[ 250 ].id = 9;
+    CHECK( display_view_refresh( &view, test_draw_log, &log ) == 1 );
+    CHECK( log.last_object == 250 && log.last_item == &list->items[ 1 ] );
+    objs[ 250 ].tag = 3;
+    CHECK( display_view_refresh( &view, test_draw_log, &log ) == 1 );
+    CHECK( log.last_object == 250 && log.last_item == &list->items[ 8 ] );
+    CHECK( display_view_refresh( &view, test_draw_log, &log ) == 0 );
+
+    // A registry change rebuilds the list and redraws everything once
+    TypeDesc bump = { .name = "TestViewBump", .size = 4 };
+    type_register( &bump );
+    CHECK( display_view_refresh( &view, test_draw_log, &log ) == N * 9 );
+    CHECK( display_view_refresh( &view, test_draw_log, &log ) == 0 );
+
+    // Fewer objects keep the shadow, no redraw
+    view.count = N - 1;
+    CHECK( display_view_refresh( &view, test_draw_log, &log ) == 0 );
+    display_view_free( &view );
+
+    // A reload that grows the type: the view draws the new layout, not the freed record
+    static uint32_t words[ 4 * 2 ];
+    Field           grown_fields[] = { { "a", 0, 4, 0, FIELD_EDITABLE }, { "b", 4, 4, 0, FIELD_EDITABLE } };
+    TypeDesc grown = { .name = "TestViewGrown", .size = 4, .fields = grown_fields, .field_count = 1, .module_id = 12 };
+    display_view_init( &view, type_get( type_register( &grown ) ), words, 4 );
+    CHECK( display_view_refresh( &view, test_draw_log, &log ) == 4 * 2 );
+
+    grown.size        = 8;
+    grown.field_count = 2;
+    grown.version     = 1;
+    registry_write_begin();
+    type_unregister_module( 12 );
+    type_register( &grown );
+    registry_write_end();
+    CHECK( display_view_refresh( &view, test_draw_log, &log ) == 4 * 3 && view.object_size == 8 );
+    words[ 7 ] = 1;
+    CHECK( display_view_refresh( &view, test_draw_log, &log ) == 1 && log.last_object == 3 );
+    display_view_free( &view );
+    type_unregister_module( 12 );
+}
+
+// ============================================================================
+// JSON writer
+// ============================================================================
+
+static int
+json_equals( const JsonWriter* w, const char* expect )
+{
+    return w->length == strlen( expect ) && memcmp( w->buffer, expect, w->length ) == 0;
+}
+
+static void
+test_json_writer( void )
+{
+    static const struct
+    {
+        float       value;
+        const char* text;
+    } k_floats[] = {
+        { 0.1f, "0.1" },     { 100.0f, "100" },     { 1e10f, "1e10" },   { 1.5e-7f, "1.5e-7" },
+        { -0.0f, "-0" },     { 0.016f, "0.016" },   { 1e-45f, "1e-45" }, { 3.4028235e38f, "3.4028235e38" },
+        { 0.00001f, "0.00001" }, { 123456789.0f, "123456790" },
+    };
+    char text[ 32 ];
+    for ( size_t i = 0; i < sizeof( k_floats ) / sizeof( k_floats[ 0 ] ); i++ )
+    {
+        text[ json_format_float( k_floats[ i ].value, text ) ] = 0;
+        CHECK( strcmp( text, k_floats[ i ].text ) == 0 );
+    }
+
+    // Every formatted float parses back bit-exact
+    int exact = 1;
+    for ( uint32_t bits = 1; bits < 0x7F800000u; bits += 0x1003 )
+    {
+        float value, parsed;
+        memcpy( &value, &bits, sizeof( value ) );
+        text[ json_format_float( value, text ) ] = 0;
+        parsed                                   = strtof( text, NULL );
+        exact &= memcmp( &value, &parsed, sizeof( value ) ) == 0;
+    }
+    CHECK( exact );
+
+    // Compact and pretty objects, escaping
+    Type*      inner = type_get( s_inner_id );
+    TestInner  v     = { 1.0f, 0.5f, -2.0f };
+    JsonWriter w;
+    json_writer_init( &w, NULL, JSON_COMPACT );
+    json_write_object( &w, inner, &v );
+    json_string( &w, "a\"b\\\n\x01", SIZE_MAX );
+    CHECK( json_writer_finish( &w ) );
+    CHECK( json_equals( &w, "{\"x\":1,\"y\":0.5,\"z\":-2}\"a\\\"b\\\\\\n\\u0001\"" ) );
+    json_writer_free( &w );
+
+    // Fixed point: every decimal, no rounding
+    json_writer_init( &w, NULL, JSON_COMPACT );
+    json_begin_array( &w );
+    json_fixed( &w, 1234567, 3 );
+    json_fixed( &w, 5, 3 );
+    json_fixed( &w, 42, 0 );
+    json_end_array( &w );
+    CHECK( json_equals( &w, "[1234.567,0.005,42]" ) );
+    json_writer_free( &w );
+
+    json_writer_init( &w, NULL, JSON_TYPE_NAMES );
+    json_write_object( &w, inner, &v );
+    CHECK( json_equals( &w, "{\n  \"_type\": \"TestInner\",\n  \"x\": 1,\n  \"y\": 0.5,\n  \"z\": -2\n}" ) );
+    json_writer_free( &w );
+
+    // Parallel chunks concatenate to exactly the serial output
+    job_system_init( 3 );
+    enum { N = 3001 };
+    static TestInner objs[ N ];
+    for ( int i = 0; i < N; i++ ) objs[ i ] = ( TestInner ){ (float)i, (float)i * 0.1f, -(float)i };
+
+    for ( uint32_t flags = 0; flags <= JSON_COMPACT; flags += JSON_COMPACT )
+    {
+        JsonWriter serial, parallel;
+        json_writer_init( &serial, NULL, flags );
+        json_writer_init( &parallel, NULL, flags );
+        json_begin_object( &serial );
+        json_begin_object( &parallel );
+        json_key( &serial, "items" );
+        json_key( &parallel, "items" );
+        json_write_array( &serial, inner, objs, N );
+        json_write_array_parallel( &parallel, inner, objs, N, 4 );
+        json_end_object( &serial );
+        json_end_object( &parallel );
+        CHECK( json_writer_finish( &serial ) && json_writer_finish( &parallel ) );
+        CHECK( serial.length == parallel.length && memcmp( serial.buffer, parallel.buffer, serial.length ) == 0 );
+
+        // File output flushes in buffer-sized pieces, same bytes
+        JsonWriter top_level, to_file;
+        FILE*      file = tmpfile();
+        json_writer_init( &top_level, NULL, flags );
+        json_writer_init( &to_file, file, flags );
+        json_write_array( &top_level, inner, objs, N );
+        json_write_array_parallel( &to_file, inner, objs, N, 3 );
+        CHECK( json_writer_finish( &to_file ) );
+        CHECK( json_writer_size( &to_file ) == top_level.length );
+
+        char* read_back = (char*)malloc( top_level.length );
+        rewind( file );
+        CHECK( fread( read_back, 1, top_level.length, file ) == top_level.length );
+        CHECK( memcmp( read_back, top_level.buffer, top_level.length ) == 0 );
+        free( read_back );
+        fclose( file );
+        json_writer_free( &to_file );
+        json_writer_free( &top_level );
+
+        json_writer_free( &serial );
+        json_writer_free( &parallel );
+    }
+    job_system_shutdown();
+}
+
+typedef struct TestRecord
+{
+    char      name[ 8 ];
+    uint32_t  id;
+    int32_t   delta;
+    TestInner pos;
+    float     speed;
+
+} TestRecord;
+
+static void
+test_json_reader( void )
+{
+    // Perfect hash over enough fields for several buckets, hits and misses
+    static char  names[ 40 ][ 8 ];
+    static Field wide_fields[ 40 ];
+    for ( int i = 0; i < 40; i++ )
+    {
+        snprintf( names[ i ], sizeof( names[ i ] ), "f%d", i );
+        wide_fields[ i ] = ( Field ){ names[ i ], (uint32_t)( i * 4 ), 4, 0, 0 };
+    }
+    TypeDesc wide_type = {
+        .hash        = hash_string( "TestWide" ),
+        .name        = "TestWide",
+        .size        = 160,
+        .fields      = wide_fields,
+        .field_count = 40,
+    };
+    Type* wide = type_get( type_register( &wide_type ) );
+    CHECK( wide && type_info( wide )->key_buckets > 1 );
+    int all_found = 1;
+    for ( int i = 0; i < 40; i++ ) all_found &= type_field_index( wide, names[ i ], strlen( names[ i ] ) ) == i;
+    CHECK( all_found );
+    CHECK( type_field_index( wide, "f40", 3 ) == -1 );
+    CHECK( type_field_index( wide, "f1", 1 ) == -1 );
+    CHECK( type_field_index( wide, "f12x", 3 ) == 12 );    // Length bounds the name
+
+    Type* inner  = type_get( s_inner_id );
+    Type* padded = type_get( s_padded_id );
+    CHECK( type_field_index( padded, "inner", 5 ) == 1 );
+    CHECK( type_field_index( padded, "tag", 3 ) == 0 && type_field_index( padded, "ta", 2 ) == -1 );
+
+    Field record_fields[] = {
+        { "name", offsetof( TestRecord, name ), 8, 0, FIELD_KIND_FLAG( FIELD_KIND_BYTES ) },
+        { "id", offsetof( TestRecord, id ), 4, 0, FIELD_KIND_FLAG( FIELD_KIND_UINT32 ) },
+        { "delta", offsetof( TestRecord, delta ), 4, 0, FIELD_KIND_FLAG( FIELD_KIND_INT32 ) },
+        { "pos", offsetof( TestRecord, pos ), sizeof( TestInner ), s_inner_id, 0 },
+        { "speed", offsetof( TestRecord, speed ), 4, 0, 0 },
+    };
+    TypeDesc record_type = {
+        .hash        = hash_string( "TestRecord" ),
+        .name        = "TestRecord",
+        .size        = sizeof( TestRecord ),
+        .fields      = record_fields,
+        .field_count = 5,
+    };
+    Type* record = type_get( type_register( &record_type ) );
+
+    // Writer output reads back bit-exact, compact and pretty
+    enum { N = 500 };
+    static TestRecord out[ N ], in[ N ];
+    for ( int i = 0; i < N; i++ )
+    {
+        uint32_t bits = 0x00800000u + (uint32_t)i * 0x1F3A5u;
+        memcpy( &out[ i ].speed, &bits, sizeof( float ) );
+        snprintf( out[ i ].name, sizeof( out[ i ].name ), "r\"%d", i );
+        out[ i ].id    = 0xFFFFFFFFu - (uint32_t)i;
+        out[ i ].delta = i * 7919 - 1000000;
+        out[ i ].pos   = ( TestInner ){ (float)i / 3.0f, 1e-30f * (float)i, -1e30f * (float)i };
+    }
+    for ( uint32_t flags = 0; flags <= ( JSON_COMPACT | JSON_TYPE_NAMES ); flags++ )
+    {
+        JsonWriter w;
+        json_writer_init( &w, NULL, flags );
+        json_write_array( &w, record, out, N );
+        CHECK( json_writer_finish( &w ) );
+
+        JsonReader r;
+        memset( in, 0, sizeof( in ) );
+        json_reader_init( &r, w.buffer, w.length );
+        CHECK( json_read_array( &r, record, in, N ) == N );
+        CHECK( r.error == NULL && r.skipped == 0 );
+        CHECK( memcmp( in, out, sizeof( in ) ) == 0 );
+        json_writer_free( &w );
+    }
+
+    // Bytes that a string cannot carry are a placeholder, which reads back as no change
+    static const char k_blobs[][ 8 ] = {
+        "a\0b",                  // Data after the terminator
+        "x\xC3",                 // Truncated sequence
+        "\xED\xA0\x80",          // Surrogate
+        "\xC3\xA9zzzzzz",        // Text up to the last byte, no terminator
+    };
+    for ( size_t i = 0; i < sizeof( k_blobs ) / sizeof( k_blobs[ 0 ] ); i++ )
+    {
+        TestRecord blob = out[ 0 ], back = out[ 1 ];
+        memcpy( blob.name, k_blobs[ i ], sizeof( blob.name ) );
+        JsonWriter w;
+        json_writer_init( &w, NULL, JSON_COMPACT );
+        json_write_object( &w, record, &blob );
+        CHECK( json_writer_finish( &w ) );
+        int is_text = i == 3;
+        const char prefix[] = "{\"name\":\"" JSON_BYTES_PLACEHOLDER "\"";
+        CHECK( ( memcmp( w.buffer, prefix, sizeof( prefix ) - 1 ) != 0 ) == is_text );
+
+        JsonReader r;
+        json_reader_init( &r, w.buffer, w.length );
+        CHECK( json_read_object( &r, record, &back ) && r.skipped == 0 );
+        CHECK( memcmp( back.name, is_text ? blob.name : out[ 1 ].name, sizeof( back.name ) ) == 0 );
+        CHECK( back.id == blob.id );
+        json_writer_free( &w );
+    }
+
+    // Unknown keys skipped, missing ones untouched, escapes decoded, extra elements dropped
+    const char* text = "[ { \"zz\": [1, {\"a\": null}], \"id\": 7, \"name\": \"\\u00e9\\ud83d\\ude00\\n\", "
+                       "\"pos\": { \"y\": 2.5e-3, \"w\": true }, \"delta\": -2147483648, \"speed\": \"fast\" },"
+                       " { \"id\": -1, \"delta\": 1.5, \"speed\": 1e39 }, {} ]";
+    TestRecord two[ 2 ];
+    memset( two, 0, sizeof( two ) );
+    two[ 0 ].speed = 9.0f;
+    two[ 0 ].pos.x = 4.0f;
+    two[ 1 ].id    = 3;
+    JsonReader r;
+    json_reader_init( &r, text, strlen( text ) );
+    CHECK( json_read_array( &r, record, two, 2 ) == 2 );
+    CHECK( r.error == NULL );
+    CHECK( r.skipped == 5 );    // zz, w, "fast", -1, 1.5
+    CHECK( two[ 0 ].id == 7 && two[ 0 ].delta == INT32_MIN && two[ 0 ].speed == 9.0f );
+    CHECK( memcmp( two[ 0 ].name, "\xc3\xa9\xf0\x9f\x98\x80\n", 8 ) == 0 );
+    CHECK( two[ 0 ].pos.x == 4.0f && two[ 0 ].pos.y == 2.5e-3f );
+    CHECK( two[ 1 ].id == 3 && two[ 1 ].delta == 0 && two[ 1 ].speed == HUGE_VALF );
+
+    // Single object with the writer's "_type" key
+    TestInner v = { 0 };
+    text        = "{\"_type\":\"TestInner\",\"z\":-0.1,\"x\":340282346638528859811704183484516925440}";
+    json_reader_init( &r, text, strlen( text ) );
+    CHECK( json_read_object( &r, inner, &v ) && r.skipped == 0 );
+    CHECK( v.z == -0.1f && v.x == 3.4028235e38f && v.y == 0.0f );
+
+    // Syntax errors stop with a position
+    static const char* k_bad[] = { "{\"x\" 1}", "{\"x\":1,}", "{\"x\":01}", "{\"x\":\"\\q\"}", "{\"x\":[1,2}", "{\"x\":1" };
+    for ( size_t i = 0; i < sizeof( k_bad ) / sizeof( k_bad[ 0 ] ); i++ )
+    {
+        json_reader_init( &r, k_bad[ i ], strlen( k_bad[ i ] ) );
+        CHECK( !json_read_object( &r, inner, &v ) && r.error != NULL && r.error_at <= strlen( k_bad[ i ] ) );
+    }
+
+}
+
+// ============================================================================
+// Layout migration
+// ============================================================================
+
+typedef struct TestMigrateV1
+{
+    uint32_t  id;
+    char      name[ 12 ];
+    TestInner pos;
+    float     hp;
+    int32_t   score;
+    float     speed;
+    double    legacy;
+
+} TestMigrateV1;
+
+// Reordered, retyped, shrunk, one field gone and one new
+typedef struct TestMigrateV2
+{
+    TestInner pos;
+    double    hp;
+    uint16_t  score;
+    char      name[ 6 ];
+    int32_t   speed;
+    uint32_t  level;
+    int64_t   id;
+
+} TestMigrateV2;
+
+static void*
+test_migrate_v2_create( void )
+{
+    TestMigrateV2* obj = (TestMigrateV2*)calloc( 1, sizeof( TestMigrateV2 ) );
+    obj->level         = 7;
+    return obj;
+}
+
+static void
+test_layout_migrate( void )
+{
+    Field v1_fields[] = {
+        { "id", offsetof( TestMigrateV1, id ), 4, 0, FIELD_KIND_FLAG( FIELD_KIND_UINT32 ) },
+        { "name", offsetof( TestMigrateV1, name ), 12, 0, FIELD_KIND_FLAG( FIELD_KIND_BYTES ) },
+        { "pos", offsetof( TestMigrateV1, pos ), sizeof( TestInner ), s_inner_id, 0 },
+        { "hp", offsetof( TestMigrateV1, hp ), 4, 0, 0 },
+        { "score", offsetof( TestMigrateV1, score ), 4, 0, FIELD_KIND_FLAG( FIELD_KIND_INT32 ) },
+        { "speed", offsetof( TestMigrateV1, speed ), 4, 0, 0 },
+        { "legacy", offsetof( TestMigrateV1, legacy ), 8, 0, 0 },
+    };
+    TypeDesc v1_desc = {
+        .hash        = hash_string( "TestMigrate" ),
+        .name        = "TestMigrate",
+        .size        = sizeof( TestMigrateV1 ),
+        .fields      = v1_fields,
+        .field_count = 7,
+        .version     = 1,
+    };
+    Type* v1 = type_get( type_register( &v1_desc ) );
+
+    enum { N = 1000 };
+    static TestMigrateV1 old_objs[ N ];
+    static TestMigrateV2 new_objs[ N ];
+    const float          speeds[] = { 2.5f, -2.5f, NAN, 1e20f, -0.4f };
+    const int32_t        scores[] = { 123, 70000, -5 };
+    for ( int i = 0; i < N; i++ )
+    {
+        old_objs[ i ] = ( TestMigrateV1 ){ (uint32_t)i, "abcdefghij", { (float)i, 1, 2 }, 0.1f * (float)i,
+                                          scores[ i % 3 ], speeds[ i % 5 ], 1.0 };
+    }
+
+    SoaStorage* soa = soa_create( v1, 16 );
+    for ( int i = 0; i < N; i++ ) soa_push( soa, &old_objs[ i ] );
+    void* pos_y = soa_column_data( soa, soa_column_index( soa, v1, "pos.y" ) );
+
+    // Same build again: nothing to do
+    MigrationPlan* plan = migration_compile( v1, v1 );
+    CHECK( plan && plan->is_identity && plan->dropped == 0 );
+    free( plan );
+
+    // The reloaded build
+    Field v2_fields[] = {
+        { "pos", offsetof( TestMigrateV2, pos ), sizeof( TestInner ), s_inner_id, 0 },
+        { "hp", offsetof( TestMigrateV2, hp ), 8, 0, FIELD_KIND_FLAG( FIELD_KIND_FLOAT ) },
+        { "score", offsetof( TestMigrateV2, score ), 2, 0, FIELD_KIND_FLAG( FIELD_KIND_UINT32 ) },
+        { "name", offsetof( TestMigrateV2, name ), 6, 0, FIELD_KIND_FLAG( FIELD_KIND_BYTES ) },
+        { "speed", offsetof( TestMigrateV2, speed ), 4, 0, FIELD_KIND_FLAG( FIELD_KIND_INT32 ) },
+        { "level", offsetof( TestMigrateV2, level ), 4, 0, FIELD_KIND_FLAG( FIELD_KIND_UINT32 ) },
+        { "id", offsetof( TestMigrateV2, id ), 8, 0, FIELD_KIND_FLAG( FIELD_KIND_INT32 ) },
+    };
+    TypeDesc v2_desc = {
+        .hash        = hash_string( "TestMigrate" ),
+        .name        = "TestMigrate",
+        .size        = sizeof( TestMigrateV2 ),
+        .create      = test_migrate_v2_create,
+        .fields      = v2_fields,
+        .field_count = 7,
+        .version     = 2,
+    };
+    Type* v2 = type_get( type_register( &v2_desc ) );
+    CHECK( type_find_by_name( "TestMigrate" ) == v2 );
+
+    plan = migration_compile( v1, v2 );
+    CHECK( plan && !plan->is_identity && plan->dropped == 1 );    // legacy
+    CHECK( plan && plan->ops[ 0 ].code == MIGRATE_COPY && plan->ops[ 0 ].dst_size == sizeof( TestInner ) );
+    if ( plan )
+        migration_run( plan, old_objs, new_objs, N );
+    free( plan );
+
+    const TestMigrateV2 expect[] = {    // hp checked on its own below
+        { { 0, 1, 2 }, 0, 123, "abcdef", 3, 7, 0 },   { { 1, 1, 2 }, 0, 65535, "abcdef", -3, 7, 1 },
+        { { 2, 1, 2 }, 0, 0, "abcdef", 0, 7, 2 },     { { 3, 1, 2 }, 0, 123, "abcdef", INT32_MAX, 7, 3 },
+        { { 4, 1, 2 }, 0, 65535, "abcdef", 0, 7, 4 },
+    };
+    int same = 1;
+    for ( int i = 0; i < 5; i++ )
+    {
+        const TestMigrateV2* a = &new_objs[ i ];
+        const TestMigrateV2* e = &expect[ i ];
+        same &= memcmp( &a->pos, &e->pos, sizeof( TestInner ) ) == 0 && a->hp == (double)( 0.1f * (float)i ) &&
+                a->score == e->score && memcmp( a->name, e->name, 6 ) == 0 && a->speed == e->speed &&
+                a->level == e->level && a->id == e->id;
+    }
+    CHECK( same );
+    CHECK( new_objs[ N - 1 ].id == N - 1 && new_objs[ N - 1 ].pos.x == (float)( N - 1 ) );
+
+    // Columns: unchanged leaves keep their arrays, the rest are rebuilt
+    CHECK( soa_migrate( soa, v2 ) );
+    CHECK( soa->column_count == 9 && soa->count == N && soa->object_size == sizeof( TestMigrateV2 ) );
+    CHECK( soa_column_data( soa, soa_column_index( soa, v2, "pos.y" ) ) == pos_y );
+    int columns_match = 1;
+    for ( int i = 0; i < N; i++ )
+    {
+        TestMigrateV2 obj;
+        memset( &obj, 0, sizeof( obj ) );
+        soa_get( soa, (uint32_t)i, &obj );
+        columns_match &= memcmp( &obj, &new_objs[ i ], sizeof( obj ) ) == 0;
+    }
+    CHECK( columns_match );
+    soa_destroy( soa );
+}
+
+// ============================================================================
+// Snapshots
+// ============================================================================
+
+typedef struct TestSnapV1
+{
+    uint32_t id;
+    float    hp;
+
+} TestSnapV1;
+
+typedef struct TestSnapV2
+{
+    double   hp;
+    uint32_t id;
+    uint32_t level;
+
+} TestSnapV2;
+
+static int
+truncate_copy( const char* from, const char* to, long keep )
+{
+    FILE* in  = fopen( from, "rb" );
+    FILE* out = fopen( to, "wb" );
+    int   ok  = in && out;
+    for ( long i = 0; ok && i < keep; i++ )
+    {
+        int c = fgetc( in );
+        ok    = c != EOF && fputc( c, out ) != EOF;
+    }
+    if ( in )
+        fclose( in );
+    if ( out )
+        fclose( out );
+    return ok;
+}
+
+static void
+test_snapshot( void )
+{
+    const char* path   = "test_snapshot.bin";
+    Type*       padded = type_get( s_padded_id );
+
+    enum { N = 300 };
+    static TestPadded objs[ N ];
+    memset( objs, 0, sizeof( objs ) );
+    SoaStorage* soa = soa_create( padded, 8 );
+    for ( int i = 0; i < N; i++ )
+    {
+        objs[ i ].tag   = (uint8_t)i;
+        objs[ i ].inner = ( TestInner ){ (float)i, -1, 0.5f };
+        objs[ i ].value = i * 0.25;
+        soa_push( soa, &objs[ i ] );
+    }
+    const char note[] = "hello snapshot";
+
+    Field v1_fields[] = {
+        { "id", offsetof( TestSnapV1, id ), 4, 0, FIELD_KIND_FLAG( FIELD_KIND_UINT32 ) },
+        { "hp", offsetof( TestSnapV1, hp ), 4, 0, 0 },
+    };
+    TypeDesc v1_desc = {
+        .hash        = hash_string( "TestSnap" ),
+        .name        = "TestSnap",
+        .size        = sizeof( TestSnapV1 ),
+        .fields      = v1_fields,
+        .field_count = 2,
+        .version     = 1,
+    };
+    Type*       v1 = type_get( type_register( &v1_desc ) );
+    TestSnapV1  olds[ N ];
+    SoaStorage* old_soa = soa_create( v1, N );
+    for ( int i = 0; i < N; i++ )
+    {
+        olds[ i ] = ( TestSnapV1 ){ (uint32_t)( i * 3 ), 0.5f * (float)i };
+        soa_push( old_soa, &olds[ i ] );
+    }
+
+    SnapshotWriter* w = snapshot_writer_create();
+    CHECK( snapshot_add_array( w, "objs", padded, objs, N ) );
+    CHECK( snapshot_add_soa( w, "cols", padded, soa ) );
+    CHECK( snapshot_add_blob( w, "note", note, sizeof( note ) ) );
+    CHECK( snapshot_add_array( w, "snap", v1, olds, N ) );
+    CHECK( snapshot_add_soa( w, "snap_cols", v1, old_soa ) );
+    CHECK( snapshot_write( w, path ) );
+    snapshot_writer_free( w );
+    soa_destroy( old_soa );
+
+    Snapshot* snap = snapshot_open( path );
+    CHECK( snap != NULL );
+    if ( !snap )
+        return;
+
+    size_t      size = 0;
+    const char* blob = (const char*)snapshot_blob( snap, "note", &size );
+    CHECK( blob && size == sizeof( note ) && memcmp( blob, note, size ) == 0 );
+    CHECK( snapshot_blob( snap, "missing", NULL ) == NULL );
+
+    // Same layout: objects used where they are mapped
+    size_t      count  = 0;
+    TestPadded* mapped = (TestPadded*)snapshot_array( snap, "objs", padded, &count );
+    CHECK( mapped && count == N && memcmp( mapped, objs, sizeof( objs ) ) == 0 );
+    CHECK( mapped && ( (uintptr_t)mapped & ( SNAPSHOT_PAGE - 1 ) ) == 0 );
+
+    // Columns borrow the mapping until they grow
+    SoaStorage* loaded = snapshot_load_soa( snap, "cols", padded );
+    CHECK( loaded && loaded->count == N && loaded->column_count == soa->column_count );
+    int borrowed = 1, equal = 1;
+    for ( uint16_t i = 0; loaded && i < loaded->column_count; i++ ) borrowed &= loaded->columns[ i ].borrowed;
+    for ( int i = 0; loaded && i < N; i++ )
+    {
+        TestPadded obj;
+        memset( &obj, 0, sizeof( obj ) );
+        soa_get( loaded, (uint32_t)i, &obj );
+        equal &= memcmp( &obj, &objs[ i ], sizeof( obj ) ) == 0;
+    }
+    CHECK( borrowed && equal );
+    CHECK( loaded && soa_push( loaded, &objs[ 7 ] ) == N && !loaded->columns[ 0 ].borrowed );
+    soa_destroy( loaded );
+    soa_destroy( soa );
+
+    // The type changed since the file was written
+    Field v2_fields[] = {
+        { "hp", offsetof( TestSnapV2, hp ), 8, 0, FIELD_KIND_FLAG( FIELD_KIND_FLOAT ) },
+        { "id", offsetof( TestSnapV2, id ), 4, 0, FIELD_KIND_FLAG( FIELD_KIND_UINT32 ) },
+        { "level", offsetof( TestSnapV2, level ), 4, 0, FIELD_KIND_FLAG( FIELD_KIND_UINT32 ) },
+    };
+    TypeDesc v2_desc = {
+        .hash        = hash_string( "TestSnap" ),
+        .name        = "TestSnap",
+        .size        = sizeof( TestSnapV2 ),
+        .fields      = v2_fields,
+        .field_count = 3,
+        .version     = 2,
+    };
+    Type* v2 = type_get( type_register( &v2_desc ) );
+    CHECK( snapshot_array( snap, "snap", v2, NULL ) == NULL );
+
+    static TestSnapV2 news[ N ];
+    CHECK( snapshot_read_array( snap, "snap", v2, news, N ) == N );
+    int migrated = 1;
+    for ( int i = 0; i < N; i++ )
+        migrated &= news[ i ].id == (uint32_t)( i * 3 ) && news[ i ].hp == 0.5 * i && news[ i ].level == 0;
+    CHECK( migrated );
+
+    SoaStorage* cols = snapshot_load_soa( snap, "snap_cols", v2 );
+    CHECK( cols && cols->count == N && cols->object_size == sizeof( TestSnapV2 ) );
+    if ( cols )
+    {
+        uint16_t id_column = (uint16_t)soa_column_index( cols, v2, "id" );
+        uint16_t hp_column = (uint16_t)soa_column_index( cols, v2, "hp" );
+        CHECK( cols->columns[ id_column ].borrowed && !cols->columns[ hp_column ].borrowed );
+        TestSnapV2 last;
+        soa_get( cols, N - 1, &last );
+        CHECK( memcmp( &last, &news[ N - 1 ], sizeof( last ) ) == 0 );
+    }
+    soa_destroy( cols );
+    snapshot_close( snap );
+
+    // Torn, foreign and missing files are refused
+    const char* torn = "test_snapshot_torn.bin";
+    CHECK( truncate_copy( path, torn, 3 * SNAPSHOT_PAGE ) );
+    CHECK( snapshot_open( torn ) == NULL );
+    FILE* junk = fopen( torn, "wb" );
+    fputs( "definitely not a snapshot, just some bytes that go on for a while", junk );
+    fclose( junk );
+    CHECK( snapshot_open( torn ) == NULL );
+    CHECK( snapshot_open( "no_such_snapshot.bin" ) == NULL );
+    remove( torn );
+    remove( path );
+}
+
+// ============================================================================
+// Type pools
+// ============================================================================
+
+static void*
+test_pooled_v2_create( void )
+{
+    TestSnapV2* obj = (TestSnapV2*)calloc( 1, sizeof( TestSnapV2 ) );
+    obj->level      = 5;
+    return obj;
+}
+
+static void
+test_type_pool( void )
+{
+    Type*     padded = type_get( s_padded_id );
+    TypePool* pool   = pool_create( padded, 10 );
+    CHECK( pool && pool->capacity == POOL_CHUNK_OBJECTS && pool->stride == sizeof( TestPadded ) );
+    if ( !pool )
+        return;
+
+    // Growth adds chunks, objects never move
+    enum { N = 1000 };
+    static Handle handles[ N ];
+    TestPadded*   first = NULL;
+    int           valid = 1;
+    for ( int i = 0; i < N; i++ )
+    {
+        handles[ i ]    = pool_alloc( pool );
+        TestPadded* obj = (TestPadded*)pool_get( pool, handles[ i ] );
+        valid &= handles[ i ] != HANDLE_NULL && obj && obj->tag == 0 && ( (uintptr_t)obj & 7 ) == 0;
+        if ( obj )
+            obj->value = i;
+        if ( i == 0 )
+            first = obj;
+    }
+    CHECK( valid && pool->count == N && pool_get( pool, handles[ 0 ] ) == first );
+    CHECK( ( (uintptr_t)first & ( POOL_ALIGNMENT - 1 ) ) == 0 );
+    CHECK( pool_get( pool, HANDLE_NULL ) == NULL );
+
+    // Freed slots are reused under a new generation, old handles go stale
+    Handle stale = handles[ 500 ];
+    CHECK( pool_free( pool, stale ) && !pool_free( pool, stale ) );
+    CHECK( pool_get( pool, stale ) == NULL && pool->count == N - 1 );
+    Handle again = pool_alloc( pool );
+    CHECK( again != stale && ( again & POOL_INDEX_MASK ) == ( stale & POOL_INDEX_MASK ) );
+    CHECK( pool_get( pool, stale ) == NULL && ( (TestPadded*)pool_get( pool, again ) )->value == 0 );
+    CHECK( pool_get( pool, 1u << POOL_INDEX_BITS | POOL_INDEX_MASK ) == NULL );    // Never handed out
+
+    // Steady state churn stays inside the reserved slots
+    uint32_t capacity = pool->capacity;
+    for ( int round = 0; round < 100; round++ )
+    {
+        for ( int i = 0; i < 64; i++ ) pool_free( pool, handles[ i ] );
+        for ( int i = 0; i < 64; i++ ) handles[ i ] = pool_alloc( pool );
+    }
+    CHECK( pool->capacity == capacity && pool->count == N );
+
+    int live = 0;
+    for ( uint32_t i = 0; i < pool->used; i++ ) live += pool_handle_at( pool, i ) != HANDLE_NULL;
+    CHECK( live == N );
+    pool_destroy( pool );
+
+    // Registry pool across a layout change: handles keep pointing at the same objects
+    Field v1_fields[] = {
+        { "id", offsetof( TestSnapV1, id ), 4, 0, FIELD_KIND_FLAG( FIELD_KIND_UINT32 ) },
+        { "hp", offsetof( TestSnapV1, hp ), 4, 0, 0 },
+    };
+    TypeDesc v1_desc = {
+        .hash        = hash_string( "TestPooled" ),
+        .name        = "TestPooled",
+        .size        = sizeof( TestSnapV1 ),
+        .alignment   = _Alignof( TestSnapV1 ),
+        .fields      = v1_fields,
+        .field_count = 2,
+        .version     = 1,
+    };
+    Type*     v1      = type_get( type_register( &v1_desc ) );
+    TypePool* v1_pool = type_pool( v1 );
+    CHECK( v1_pool && type_pool( v1 ) == v1_pool );
+    if ( !v1_pool )
+        return;
+    for ( int i = 0; i < N; i++ )
+    {
+        handles[ i ]    = pool_alloc( v1_pool );
+        TestSnapV1* obj = (TestSnapV1*)pool_get( v1_pool, handles[ i ] );
+        obj->id         = (uint32_t)i;
+        obj->hp         = 0.5f * (float)i;
+    }
+    pool_free( v1_pool, handles[ 3 ] );
+
+    Field v2_fields[] = {
+        { "hp", offsetof( TestSnapV2, hp ), 8, 0, FIELD_KIND_FLAG( FIELD_KIND_FLOAT ) },
+        { "id", offsetof( TestSnapV2, id ), 4, 0, FIELD_KIND_FLAG( FIELD_KIND_UINT32 ) },
+        { "level", offsetof( TestSnapV2, level ), 4, 0, FIELD_KIND_FLAG( FIELD_KIND_UINT32 ) },
+    };
+    TypeDesc v2_desc = {
+        .hash        = hash_string( "TestPooled" ),
+        .name        = "TestPooled",
+        .size        = sizeof( TestSnapV2 ),
+        .alignment   = _Alignof( TestSnapV2 ),
+        .create      = test_pooled_v2_create,
+        .fields      = v2_fields,
+        .field_count = 3,
+        .version     = 2,
+    };
+    type_register( &v2_desc );
+    CHECK( type_pools_migrate() == 1 && type_pools_migrate() == 0 );
+    CHECK( v1_pool->stride == sizeof( TestSnapV2 ) && v1_pool->count == N - 1 );
+
+    int migrated = 1;
+    for ( int i = 0; i < N; i++ )
+    {
+        TestSnapV2* obj = (TestSnapV2*)pool_get( v1_pool, handles[ i ] );
+        migrated &= i == 3 ? obj == NULL
+                           : obj && obj->id == (uint32_t)i && obj->hp == 0.5 * i && obj->level == 5;
+    }
+    CHECK( migrated );
+    TestSnapV2* fresh = (TestSnapV2*)pool_get( v1_pool, pool_alloc( v1_pool ) );
+    CHECK( fresh && fresh->level == 5 && fresh->id == 0 );
+    type_pools_release();
+}
+
+// ============================================================================
+// Change tracking and deltas
+// ============================================================================
+
+static int
+soa_equal( const SoaStorage* a, const SoaStorage* b, uint16_t object_size )
+{
+    if ( a->count != b->count )
+        return 0;
+    char x[ 256 ], y[ 256 ];
+    for ( uint32_t i = 0; i < a->count; i++ )
+    {
+        memset( x, 0, object_size );
+        memset( y, 0, object_size );
+        soa_get( a, i, x );
+        soa_get( b, i, y );
+        if ( memcmp( x, y, object_size ) != 0 )
+            return 0;
+    }
+    return 1;
+}
+
+static void
+test_delta( void )
+{
+    Type*       padded  = type_get( s_padded_id );
+    SoaStorage* live    = soa_create( padded, 16 );
+    SoaStorage* replica = soa_create( padded, 16 );
+    for ( int i = 0; i < 500; i++ )
+    {
+        TestPadded obj = { (uint8_t)i, { (float)i, 2, 3 }, 7, i * 0.5 };
+        soa_push( live, &obj );
+        soa_push( replica, &obj );
+    }
+
+    ChangeTracker* tracker = change_tracker_create( live, CHANGE_SHADOW );
+    DeltaBuffer    delta   = { 0 };
+    CHECK( tracker && tracker->dirty_count == 0 && change_scan( tracker, live ) == 0 );
+    if ( !tracker )
+        return;
+    CHECK( delta_encode( tracker, live, &delta ) == sizeof( DeltaHeader ) );
+
+    // One write through the tracker, one straight into the columns
+    int    value_column = soa_column_index( live, padded, "value" );
+    int    y_column     = soa_column_index( live, padded, "inner.y" );
+    double value        = -1.0;
+    change_set( tracker, live, 10, value_column, &value );
+    TestPadded obj;
+    soa_get( live, 20, &obj );
+    obj.inner.y = 99.0f;
+    soa_set( live, 20, &obj );
+    CHECK( change_scan( tracker, live ) == 2 );
+    CHECK( tracker->masks[ 10 ] == (uint64_t)1 << value_column && tracker->masks[ 20 ] == (uint64_t)1 << y_column );
+
+    delta.length = 0;
+    size_t bytes = delta_encode( tracker, live, &delta );
+    CHECK( bytes == sizeof( DeltaHeader ) + 2 * ( 1 + 1 + 1 ) + sizeof( double ) + sizeof( float ) );
+    CHECK( delta_apply( replica, delta.data, delta.length ) == bytes );
+    CHECK( soa_equal( live, replica, sizeof( TestPadded ) ) );
+
+    change_tracker_clear( tracker, live );
+    CHECK( tracker->dirty_count == 0 && change_scan( tracker, live ) == 0 );
+
+    // Appends go whole, a swap-removed slot is marked by the caller
+    for ( int i = 0; i < 3; i++ )
+    {
+        TestPadded extra = { 200, { -1, -2, -3 }, (uint8_t)i, 1e9 };
+        soa_push( live, &extra );
+    }
+    soa_remove_swap( live, 5 );
+    change_mark_object( tracker, 5 );
+    delta.length = 0;
+    bytes        = delta_encode( tracker, live, &delta );
+    CHECK( tracker->dirty_count == 3 );    // 5, and the two appends left after the swap
+    CHECK( delta_apply( replica, delta.data, delta.length ) == bytes );
+    CHECK( replica->count == 502 && soa_equal( live, replica, sizeof( TestPadded ) ) );
+    change_tracker_clear( tracker, live );
+
+    // Another layout, or a torn buffer, is refused
+    SoaStorage* other = soa_create( type_get( s_inner_id ), 4 );
+    CHECK( delta_apply( other, delta.data, delta.length ) == 0 );
+    CHECK( delta_apply( replica, delta.data, delta.length - 1 ) == 0 );
+
+    soa_destroy( other );
+    delta_buffer_free( &delta );
+    change_tracker_destroy( tracker );
+    soa_destroy( live );
+    soa_destroy( replica );
+}
+
+// ============================================================================
+// Replication
+// ============================================================================
+
+typedef struct TestRepEntity
+{
+    TestInner pos;
+    float     hp;
+    uint32_t  id;
+    char      tag[ 6 ];
+
+} TestRepEntity;
+
+static void
+test_replicate( void )
+{
+    Field rep_fields[] = {
+        { "pos", offsetof( TestRepEntity, pos ), sizeof( TestInner ), s_inner_id, FIELD_QUANTIZED },
+        { "hp", offsetof( TestRepEntity, hp ), 4, 0, FIELD_QUANTIZED },
+        { "id", offsetof( TestRepEntity, id ), 4, 0, FIELD_KIND_FLAG( FIELD_KIND_UINT32 ) },
+        { "tag", offsetof( TestRepEntity, tag ), 6, 0, FIELD_KIND_FLAG( FIELD_KIND_BYTES ) },
+    };
+    FieldQuant rep_quants[] = { { -100, 100, 16 }, { 0, 100, 7 }, { 0, 0, 0 }, { 0, 0, 0 } };
+    TypeDesc   rep_desc     = {
+              .hash        = hash_string( "TestRepEntity" ),
+              .name        = "TestRepEntity",
+              .size        = sizeof( TestRepEntity ),
+              .fields      = rep_fields,
+              .field_count = 4,
+              .quants      = rep_quants,
+    };
+    Type* type = type_get( type_register( &rep_desc ) );
+    CHECK( type && type_field_quant( type, 1 ) && type_field_quant( type, 1 )->bits == 7 );
+    CHECK( type && type_field_quant( type, 2 ) == NULL );
+    if ( !type )
+        return;
+
+    // pos.x/y/z inherit the struct rule, id and tag go raw
+    ReplicaSchema* schema = replica_schema_compile( type );
+    CHECK( schema && schema->leaf_count == 6 );
+    if ( !schema )
+        return;
+    CHECK( schema->leaves[ 0 ].bits == 16 && schema->leaves[ 2 ].bits == 16 && schema->leaves[ 3 ].bits == 7 );
+    CHECK( schema->leaves[ 4 ].bits == 0 && schema->leaves[ 5 ].bits == 0 );
+    CHECK( schema->object_bits == 1 + 6 + 3 * 16 + 7 + 32 + 48 );
+
+    enum { N = 64 };
+    static TestRepEntity objs[ N ], snapped[ N ], decoded[ N ], base[ N ];
+    memset( objs, 0, sizeof( objs ) );
+    for ( int i = 0; i < N; i++ )
+    {
+        objs[ i ].pos = ( TestInner ){ (float)i * 1.37f - 40.0f, 0.1f * (float)i, 99.99f };
+        objs[ i ].hp  = (float)( i % 100 );
+        objs[ i ].id  = (uint32_t)( 1000 + i );
+        snprintf( objs[ i ].tag, sizeof( objs[ i ].tag ), "e%d", i );
+    }
+    replica_snap( schema, objs, snapped, N );
+    CHECK( fabsf( snapped[ 7 ].pos.x - objs[ 7 ].pos.x ) <= 200.0f / 65535 && snapped[ 7 ].id == objs[ 7 ].id );
+
+    // Full state against nothing: smaller than the raw structs, decodes to the snapped state
+    static uint8_t packet[ N * sizeof( TestRepEntity ) * 2 ];
+    uint32_t       bits = replica_encode( schema, objs, N, NULL, 0, packet, sizeof( packet ) );
+    CHECK( bits > 0 && bits <= N * schema->object_bits && ( bits + 7 ) / 8 < sizeof( objs ) );
+    CHECK( replica_decode( schema, packet, bits, NULL, 0, decoded, N ) );
+    CHECK( memcmp( decoded, snapped, sizeof( snapped ) ) == 0 );
+    CHECK( replica_encode( schema, objs, N, NULL, 0, packet, 16 ) == 0 );
+    CHECK( !replica_decode( schema, packet, bits / 2, NULL, 0, decoded, N ) );
+
+    // Against a baseline only changes cost more than a bit; noise below the grid is free
+    memcpy( base, snapped, sizeof( base ) );
+    objs[ 3 ].hp = 50.0f;
+    objs[ 9 ].hp = 10.0f;
+    objs[ 20 ].pos.y += 0.0001f;
+    replica_snap( schema, objs, snapped, N );
+    bits = replica_encode( schema, objs, N, base, N, packet, sizeof( packet ) );
+    CHECK( bits == N + 2 * ( 6 + 7 ) );
+    CHECK( replica_decode( schema, packet, bits, base, N, decoded, N ) );
+    CHECK( memcmp( decoded, snapped, sizeof( snapped ) ) == 0 );
+
+    // Lossy loopback: the receiver always holds the state of the newest packet it got
+    Loopback*   wire = loopback_create( 3 );
+    ReplicaPeer sender, receiver;
+    CHECK( wire && replica_peer_init( &sender, schema, N ) && replica_peer_init( &receiver, schema, N ) );
+    if ( !wire )
+        return;
+    static uint8_t stale[ sizeof( packet ) ];
+    size_t         stale_size = 0;
+    int            received = 0, in_sync = 1;
+    for ( int frame = 0; frame < 40; frame++ )
+    {
+        for ( int i = 0; i < N; i += 5 ) objs[ i ].pos.x += 0.5f;
+        objs[ frame % N ].hp = (float)( frame % 50 );
+        size_t size = replica_send( &sender, objs, N, packet, sizeof( packet ) );
+        CHECK( size > 0 );
+        if ( frame == 10 )
+        {
+            memcpy( stale, packet, size );
+            stale_size = size;
+        }
+        loopback_send( wire, packet, size );
+
+        uint8_t  in[ sizeof( packet ) ];
+        uint32_t count = 0;
+        size_t   got   = loopback_receive( wire, in, sizeof( in ) );
+        if ( got && replica_receive( &receiver, in, got, decoded, &count ) )
+        {
+            received++;
+            replica_snap( schema, objs, snapped, N );
+            in_sync &= count == N && memcmp( decoded, snapped, sizeof( snapped ) ) == 0;
+            replica_ack( &sender, receiver.sequence );
+        }
+    }
+    CHECK( received > 20 && received < 40 && in_sync );
+    CHECK( sender.acked == receiver.sequence );
+
+    // Old and repeated packets are refused
+    uint32_t count = 0;
+    CHECK( stale_size && !replica_receive( &receiver, stale, stale_size, decoded, &count ) );
+
+    replica_peer_free( &sender );
+    replica_peer_free( &receiver );
+    loopback_destroy( wire );
+    free( schema );
+
+    // Rules out of range are refused
+    rep_quants[ 1 ].bits = 0;
+    rep_desc.hash        = hash_string( "TestRepBad" );
+    rep_desc.name        = "TestRepBad";
+    CHECK( type_register( &rep_desc ) == 0 );
+    rep_quants[ 1 ]      = ( FieldQuant ){ 5, 5, 8 };
+    CHECK( type_register( &rep_desc ) == 0 );
+}
+
+// ============================================================================
+// Job system
+// ============================================================================
+
+typedef struct TestJobData
+{
+    uint32_t* hits;           // Per element, +1 per visit, +100 for a misaligned split
+    uint32_t  results[ 16 ];
+    uint32_t  total;
+
+} TestJobData;
+
+static void
+test_job_count( void* data, uint32_t begin, uint32_t end )
+{
+    TestJobData* d = (TestJobData*)data;
+    for ( uint32_t i = begin; i < end; i++ ) d->hits[ i ] += 1 + ( begin % JOB_SPLIT_ALIGN ? 100 : 0 );
+}
+
+static void
+test_job_produce( void* data, uint32_t begin, uint32_t end )
+{
+    ( (TestJobData*)data )->results[ begin ] = begin + 1;
+}
+
+static void
+test_job_consume( void* data, uint32_t begin, uint32_t end )
+{
+    TestJobData* d = (TestJobData*)data;
+    for ( int i = 0; i < 16; i++ ) d->total += d->results[ i ];
+}
+
+// A job that waits on its own parallel-for over a quarter of the first 50000, from whichever thread runs it
+static void
+test_job_nested( void* data, uint32_t begin, uint32_t end )
+{
+    TestJobData quarter = { ( (TestJobData*)data )->hits + begin * 12500, { 0 }, 0 };
+    job_parallel_for( 12500, 64, test_job_count, &quarter );
+}
+
+static int
+test_job_hits( const uint32_t* hits, uint32_t count, uint32_t expected )
+{
+    for ( uint32_t i = 0; i < count; i++ )
+        if ( hits[ i ] != expected )
+            return 0;
+    return 1;
+}
+
+static void
+test_job_system( void )
+{
+    enum { N = 100000 };
+    static uint32_t hits[ N ];
+    TestJobData     d = { hits, { 0 }, 0 };
+
+    // Not initialized: inline on the caller
+    CHECK( job_thread_count() == 1 );
+    job_parallel_for( N, 64, test_job_count, &d );
+    CHECK( test_job_hits( hits, N, 1 ) );
+
+    CHECK( job_system_init( 3 ) == 4 && job_thread_count() == 4 );
+    for ( int round = 0; round < 20; round++ ) job_parallel_for( N, 64, test_job_count, &d );
+    CHECK( test_job_hits( hits, N, 21 ) );
+
+    // Dependencies: the consumer starts only after all 16 producers
+    JobCounter produced, consumed;
+    memset( &produced, 0, sizeof( produced ) );
+    memset( &consumed, 0, sizeof( consumed ) );
+    for ( uint32_t i = 0; i < 16; i++ )
+    {
+        Job job = { test_job_produce, &d, i, i + 1, 0, &produced };
+        job_submit( &job );
+    }
+    Job consume = { test_job_consume, &d, 0, 1, 0, &consumed };
+    CHECK( job_submit_after( &consume, &produced ) );
+    job_wait( &consumed );
+    CHECK( produced.pending == 0 && d.total == 16 * 17 / 2 );
+
+    // Nested waits inside jobs, and an async range next to them
+    memset( hits, 0, sizeof( hits ) );
+    JobCounter nested;
+    memset( &nested, 0, sizeof( nested ) );
+    for ( uint32_t i = 0; i < 4; i++ )
+    {
+        Job job = { test_job_nested, &d, i, i + 1, 0, &nested };
+        job_submit( &job );
+    }
+    job_wait( &nested );
+    TestJobData upper = { hits + 50000, { 0 }, 0 };
+    job_parallel_for_async( N - 50000, 64, test_job_count, &upper, &nested );
+    job_wait( &nested );
+    CHECK( test_job_hits( hits, N, 1 ) );
+
+    // A grain below JOB_SPLIT_ALIGN splits at aligned points and never past the end
+    memset( hits, 0, sizeof( hits ) );
+    Job small = { test_job_count, &d, 0, 200, 1, &nested };
+    job_submit( &small );
+    job_wait( &nested );
+    CHECK( test_job_hits( hits, 200, 1 ) && test_job_hits( hits + 200, N - 200, 0 ) );
+
+    job_system_shutdown();
+    CHECK( job_thread_count() == 1 );
+}
+
+// ============================================================================
+// Registry snapshots - lookups on workers while the main thread re-registers
+// ============================================================================
+
+typedef struct TestSnapshotData
+{
+    uint8_t*         torn;        // Per lookup, 1 if the pinned snapshot missed a type or mixed two batches
+    volatile int32_t progress;    // Lookups done so far
+    TypeID           a_id;        // Kept by every round, type_get maps it within the snapshot
+
+} TestSnapshotData;
+
+static void
+test_snapshot_read( void* data, uint32_t begin, uint32_t end )
+{
+    TestSnapshotData* d = (TestSnapshotData*)data;
+    for ( uint32_t i = begin; i < end; i++ )
+    {
+        registry_read_begin();
+        Type* a      = type_find_by_name( "TestSnapA" );
+        Type* b      = type_find_by_name( "TestSnapB" );
+        d->torn[ i ] = !a || !b || a->size != b->size || type_get( d->a_id ) != a;
+        registry_read_end();
+        sync_add32( &d->progress, 1 );
+    }
+}
+
+static void
+test_registry_snapshots( void )
+{
+    enum { LOOKUPS = 1 << 16, MAX_ROUNDS = 150 };
+    static uint8_t   torn[ LOOKUPS ];
+    TestSnapshotData d = { torn, 0, 0 };
+
+    TypeDesc a = { .hash = hash_string( "TestSnapA" ), .name = "TestSnapA", .size = 4, .module_id = 9 };
+    TypeDesc b = { .hash = hash_string( "TestSnapB" ), .name = "TestSnapB", .size = 4, .module_id = 9 };
+    d.a_id     = type_register( &a );
+    CHECK( d.a_id && type_register( &b ) );
+
+    CHECK( job_system_init( 3 ) == 4 );
+    JobCounter readers;
+    memset( &readers, 0, sizeof( readers ) );
+    job_parallel_for_async( LOOKUPS, 64, test_snapshot_read, &d, &readers );
+
+    // Reload-style batches: nothing in between is visible to the readers. Each
+    // round waits for a lookup first, so they interleave even on one core.
+    int rounds = 0;
+    while ( sync_load32( &readers.pending ) > 0 && rounds < MAX_ROUNDS )
+    {
+        int32_t seen = sync_load32( &d.progress );
+        while ( sync_load32( &d.progress ) == seen && sync_load32( &readers.pending ) > 0 ) sync_pause();
+        rounds++;
+        a.size = b.size = rounds & 1 ? 8 : 4;
+        a.version = b.version = (uint8_t)rounds;
+        registry_write_begin();
+        type_unregister_module( 9 );
+        CHECK( type_find_by_name( "TestSnapA" ) == NULL );    // The writer sees its own draft
+        type_register( &a );
+        type_register( &b );
+        registry_write_end();
+    }
+    job_wait( &readers );
+    job_system_shutdown();
+
+    int bad = 0;
+    for ( int i = 0; i < LOOKUPS; i++ ) bad += torn[ i ];
+    CHECK( bad == 0 );
+
+    Type* found = type_find_by_name( "TestSnapA" );
+    CHECK( found && found->size == ( rounds & 1 ? 8 : 4 ) && found->id == d.a_id );
+    type_unregister_module( 9 );
+}
+
+// ============================================================================
+// Tracing
+// ============================================================================
+
+#ifdef TRACE_ENABLED
+static void
+test_trace_job( void* data, uint32_t begin, uint32_t end )
+{
+    TRACE_BEGIN( zone, "test_job" );
+    sync_add32( (volatile int32_t*)data, 1 );
+    TRACE_END( zone );
+}
+
+static int
+test_trace_export( char* text, size_t size )
+{
+    FILE* file   = tmpfile();
+    int   events = trace_export_chrome( file );
+    rewind( file );
+    size_t length  = fread( text, 1, size - 1, file );
+    text[ length ] = 0;
+    fclose( file );
+    return events;
+}
+
+static void
+test_trace( void )
+{
+    static char text[ 1 << 20 ];
+
+    // Off: nothing recorded
+    trace_clear();
+    TRACE_BEGIN( skipped, "test_skipped" );
+    TRACE_END( skipped );
+    CHECK( test_trace_export( text, sizeof( text ) ) == 0 );
+
+    // Nested zones on this thread, one per chunk on whichever thread ran it
+    trace_enable( 1 );
+    TRACE_BEGIN( outer, "test_outer" );
+    for ( int i = 0; i < 3; i++ )
+    {
+        TRACE_BEGIN( inner, "test_inner" );
+        TRACE_END( inner );
+    }
+    TRACE_END( outer );
+
+    volatile int32_t chunks = 0;
+    job_system_init( 3 );
+    job_parallel_for( 1 << 16, 64, test_trace_job, (void*)&chunks );
+    job_system_shutdown();
+    trace_enable( 0 );
+
+    // Registry calls are zones too
+    trace_enable( 1 );
+    CHECK( type_find_by_name( "TestInner" ) != NULL );
+    trace_enable( 0 );
+
+    int events = test_trace_export( text, sizeof( text ) );
+    CHECK( events == 1 + 3 + chunks + 1 );
+    CHECK( strstr( text, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[" ) == text );
+    CHECK( strstr( text, "\"name\":\"test_outer\",\"ph\":\"X\",\"ts\":" ) != NULL );
+    CHECK( strstr( text, "\"name\":\"type_find_by_name\"" ) != NULL );
+    CHECK( strstr( text, "test_skipped" ) == NULL );
+
+    // The inner zones end first, inside the outer one
+    const char* outer_at = strstr( text, "\"test_outer\"" );
+    const char* inner_at = strstr( text, "\"test_inner\"" );
+    CHECK( inner_at && outer_at && inner_at < outer_at );
+    double outer_ts  = strtod( strstr( outer_at, "\"ts\":" ) + 5, NULL );
+    double outer_end = outer_ts + strtod( strstr( outer_at, "\"dur\":" ) + 6, NULL );
+    double inner_ts  = strtod( strstr( inner_at, "\"ts\":" ) + 5, NULL );
+    CHECK( inner_ts >= outer_ts && inner_ts <= outer_end );
+
+    // A full ring keeps the newest events
+    trace_clear();
+    trace_enable( 1 );
+    for ( int i = 0; i < TRACE_RING_EVENTS + 100; i++ )
+    {
+        TRACE_BEGIN( spin, "test_wrap" );
+        TRACE_END( spin );
+    }
+    trace_enable( 0 );
+    FILE* sink = tmpfile();
+    CHECK( trace_export_chrome( sink ) == TRACE_RING_EVENTS );
+    fclose( sink );
+    trace_clear();
+}
+#endif
+
+// ============================================================================
+// Hot reload (Linux inotify backend against the real game module)
+// ============================================================================
+
+#if defined( HOT_RELOAD_ENABLED ) && !defined( _WIN32 )
+#    include "hot_reload.h"
+#    include <time.h>
+#    include <unistd.h>
+
+static void
+sleep_ms( long ms )
+{
+    struct timespec ts = { ms / 1000, ( ms % 1000 ) * 1000000L };
+    nanosleep( &ts, NULL );
+}
+
+static int
+copy_file( const char* from, const char* to, int chunks )
+{
+    FILE* in  = fopen( from, "rb" );
+    FILE* out = fopen( to, "wb" );
+    if ( !in || !out )
+        return 0;
+
+    fseek( in, 0, SEEK_END );
+    long size = ftell( in );
+    fseek( in, 0, SEEK_SET );
+
+    // Write in several flushed pieces, like a linker does
+    char* data = (char*)malloc( (size_t)size );
+    size_t got = fread( data, 1, (size_t)size, in );
+    long   step = size / chunks + 1;
+    for ( long at = 0; at < (long)got; at += step )
+    {
+        long n = (long)got - at < step ? (long)got - at : step;
+        fwrite( data + at, 1, (size_t)n, out );
+        fflush( out );
+        sleep_ms( 5 );
+    }
+    free( data );
+    fclose( in );
+    fclose( out );
+    return got == (size_t)size;
+}
+
+// Module exports by name; memcpy because ISO C has no void* to function pointer cast
+static void*
+test_module_fn( Module* mod, const char* name, size_t size, void* fn )
+{
+    void* symbol = module_get_symbol( mod, name );
+    if ( symbol )
+        memcpy( fn, &symbol, size );
+    return symbol;
+}
+
+// GameState starts with the players storage
+static float
+test_game_position_x( Module* mod, uint32_t index )
+{
+    void* ( *get_state )( void );
+    if ( !test_module_fn( mod, "get_module_state", sizeof( get_state ), &get_state ) || !get_state() )
+        return -1.0f;
+
+    SoaStorage* players = *(SoaStorage**)get_state();
+    Type*       player  = type_find_by_hash( hash_string( "Player" ) );
+    int         column  = soa_column_index( players, player, "transform.position.x" );
+    return column < 0 ? -1.0f : ( (const float*)soa_column_data( players, column ) )[ index ];
+}
+
+static void
+test_hot_reload( void )
+{
+    char dir[] = "/tmp/cfast_reload_XXXXXX";
+    CHECK( mkdtemp( dir ) != NULL );
+
+    char path[ 256 ];
+    snprintf( path, sizeof( path ), "%s/game_module.so", dir );
+    CHECK( copy_file( GAME_MODULE_PATH, path, 1 ) );
+
+    // A module that fails to load leaves no watch behind
+    char broken[ 256 ];
+    snprintf( broken, sizeof( broken ), "%s/broken.so", dir );
+    FILE* junk = fopen( broken, "wb" );
+    fputs( "not an elf", junk );
+    fclose( junk );
+    CHECK( module_open( broken ) == NULL );
+    CHECK( hot_reload_fd() < 0 );
+
+    Module* mod = module_open( path );
+    CHECK( mod != NULL );
+    if ( !mod )
+        return;
+
+    CHECK( module_get_info( mod ) != NULL );
+    CHECK( module_get_symbol( mod, "get_module_state" ) != NULL );
+    CHECK( type_find_by_hash( hash_string( "Player" ) ) != NULL );
+
+    // ...and does not take down a watch it shares with an open module
+    CHECK( module_open( broken ) == NULL );
+    CHECK( hot_reload_fd() >= 0 );
+    unlink( broken );
+    hot_reload_poll();
+
+    // game_update moves players along with the columns game_init looked up
+    void ( *game_init )( uint32_t );
+    uint32_t ( *game_spawn_player )( const Player* );
+    void ( *game_update )( float );
+    CHECK( test_module_fn( mod, "game_init", sizeof( game_init ), &game_init ) );
+    CHECK( test_module_fn( mod, "game_spawn_player", sizeof( game_spawn_player ), &game_spawn_player ) );
+    CHECK( test_module_fn( mod, "game_update", sizeof( game_update ), &game_update ) );
+    Player hero = { .speed = 2.0f, .health = { 50, 100, 1 } };
+    game_init( 4 );
+    CHECK( game_spawn_player( &hero ) == 0 );
+    game_update( 0.5f );
+    CHECK( test_game_position_x( mod, 0 ) == 1.0f );
+
+    // Nothing happened yet
+    CHECK( hot_reload_poll() == 0 );
+    CHECK( !check_module_changed( mod ) );
+
+    // A multi-chunk rewrite is one pending change, held back until it settles
+    CHECK( copy_file( GAME_MODULE_PATH, path, 8 ) );
+    CHECK( hot_reload_poll() == 1 );
+    CHECK( !check_module_changed( mod ) );
+
+    int reloads = 0;
+    for ( int i = 0; i < 20 && !reloads; i++ )
+    {
+        hot_reload_wait( HOT_RELOAD_SETTLE_MS );
+        reloads += check_module_changed( mod );
+    }
+    CHECK( reloads == 1 );
+    CHECK( !check_module_changed( mod ) );
+
+    // Same build again: every type keeps its slot, nothing is appended
+    Type*    player = type_find_by_hash( hash_string( "Player" ) );
+    uint16_t types  = g_registry.type_count;
+    uint32_t fields = g_registry.field_count;
+    reload_module( mod );
+    CHECK( module_get_info( mod ) != NULL );
+    CHECK( type_find_by_hash( hash_string( "Player" ) ) == player );
+    CHECK( g_registry.type_count == types && g_registry.field_count == fields );
+
+    // The new build looked its columns up again in the fixup
+    CHECK( test_module_fn( mod, "game_update", sizeof( game_update ), &game_update ) );
+    game_update( 0.5f );
+    CHECK( test_game_position_x( mod, 0 ) == 2.0f );
+
+    // A broken build keeps the old code loaded
+    junk = fopen( path, "wb" );
+    fputs( "not an elf", junk );
+    fclose( junk );
+    while ( !check_module_changed( mod ) ) hot_reload_wait( HOT_RELOAD_SETTLE_MS );
+    ModuleInfo* before = module_get_info( mod );
+    reload_module( mod );
+    CHECK( module_get_info( mod ) == before );
+
+    // The game state goes before the module
+    void ( *game_shutdown )( void );
+    void* ( *get_module_state )( void );
+    CHECK( test_module_fn( mod, "game_shutdown", sizeof( game_shutdown ), &game_shutdown ) );
+    CHECK( test_module_fn( mod, "get_module_state", sizeof( get_module_state ), &get_module_state ) );
+    game_shutdown();
+    CHECK( get_module_state() == NULL );
+
+    uint16_t free_types = g_registry.free_type_count;
+    module_close( mod );
+    CHECK( type_find_by_hash( hash_string( "Player" ) ) == NULL );
+    CHECK( g_registry.free_type_count == free_types + 4 );
+    unlink( path );
+    rmdir( dir );
+}
+#endif
+
+// ============================================================================
+
+int
+main( void )
+{
+    printf( "=== Reflection Tests ===\n" );
+
+    register_test_types();
+
+    test_register_and_find();
+    test_find_by_name();
+    test_unregister_keeps_probe_chains();
+    test_reregister_keeps_ids();
+    test_field_paths();
+    test_type_table();
+    test_copy_plan();
+    test_type_ops();
+    test_soa_storage();
+    test_entity_kernels();
+    test_field_batch();
+    test_query();
+    test_display_list();
+    test_json_writer();
+    test_json_reader();
+    test_layout_migrate();
+    test_snapshot();
+    test_type_pool();
+    test_delta();
+    test_replicate();
+    test_job_system();
+    test_registry_snapshots();
+#ifdef TRACE_ENABLED
+    test_trace();
+#endif
+#if defined( HOT_RELOAD_ENABLED ) && !defined( _WIN32 )
+    test_hot_reload();
+#endif
+
+    printf( s_failures ? "%d check(s) failed\n" : "All tests passed\n", s_failures );
+    return s_failures ? 1 : 0;
+}
+
+// ============================================================================
@@ -0,0 +1,294 @@
+// ============================================================================
+// trace.c - Scoped trace zones, per-thread rings, Chrome trace export
+// ============================================================================
+#ifndef _WIN32
+#    define _POSIX_C_SOURCE 200809L    // clock_gettime
+#endif
+
+#include "trace.h"
+#include "json_writer.h"
+#include "simd.h"
+#include "sync.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#    include <windows.h>
+#else
+#    include <time.h>
+#endif
+
+#if SIMD_X86 && !defined( _MSC_VER )
+#    include <x86intrin.h>    // __rdtsc
+#endif
+
+#define TRACE_RING_MASK ( TRACE_RING_EVENTS - 1 )
+
+_Static_assert( ( TRACE_RING_EVENTS & TRACE_RING_MASK ) == 0, "ring size must be a power of two" );
+
+typedef struct TraceRing
+{
+    TraceEvent       events[ TRACE_RING_EVENTS ];
+    volatile int64_t head;    // Events ever recorded, only the owning thread writes it
+    char             name[ TRACE_NAME_LENGTH ];
+
+} TraceRing;
+
+volatile int32_t g_trace_enabled;
+
+static TraceRing* volatile s_rings[ TRACE_MAX_THREADS ];
+static int32_t             s_ring_count;    // Claimed, a slot may still be NULL for a moment
+
+static char    s_names[ TRACE_MAX_NAMES ][ TRACE_NAME_LENGTH ];
+static int32_t s_name_count;
+static int32_t s_name_lock;
+
+static uint64_t s_base_ticks;    // Clock pair read at the first trace_enable
+static uint64_t s_base_ns;
+
+static SYNC_THREAD_LOCAL TraceRing*  t_ring;
+static SYNC_THREAD_LOCAL int         t_ring_refused;    // Past TRACE_MAX_THREADS or out of memory
+static SYNC_THREAD_LOCAL const char* t_thread_name;     // Until the ring exists
+
+// ============================================================================
+// Clocks
+// ============================================================================
+
+static uint64_t
+trace_now_ns( void )
+{
+#ifdef _WIN32
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER        now;
+    if ( !frequency.QuadPart )
+        QueryPerformanceFrequency( &frequency );
+    QueryPerformanceCounter( &now );
+    return (uint64_t)( (double)now.QuadPart * 1e9 / (double)frequency.QuadPart );
+#else
+    struct timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+#endif
+}
+
+uint64_t
+trace_ticks( void )
+{
+#if SIMD_X86
+    return __rdtsc();
+#else
+    return trace_now_ns();
+#endif
+}
+
+void
+trace_enable( int enabled )
+{
+    if ( enabled && !s_base_ticks )
+    {
+        s_base_ns    = trace_now_ns();
+        s_base_ticks = trace_ticks();
+    }
+    sync_store32( (volatile int32_t*)&g_trace_enabled, enabled != 0 );
+}
+
+// ============================================================================
+// Recording
+// ============================================================================
+
+static TraceRing*
+trace_ring( void )
+{
+    if ( t_ring || t_ring_refused )
+        return t_ring;
+
+    int claim = sync_add32( &s_ring_count, 1 ) - 1;
+    if ( claim >= TRACE_MAX_THREADS )
+    {
+        t_ring_refused = 1;
+        return NULL;
+    }
+
+    TraceRing* ring = (TraceRing*)calloc( 1, sizeof( TraceRing ) );
+    if ( !ring )
+    {
+        t_ring_refused = 1;
+        return NULL;
+    }
+    if ( t_thread_name )
+        strncpy( ring->name, t_thread_name, TRACE_NAME_LENGTH - 1 );
+    else
+        snprintf( ring->name, sizeof( ring->name ), "Thread %d", claim );
+    sync_store_ptr( (void* volatile*)&s_rings[ claim ], ring );
+    t_ring = ring;
+    return ring;
+}
+
+// Index in s_names, -1 once the table is full. First record per call site only.
+static int
+trace_name_index( const char* name )
+{
+    while ( !sync_cas32( &s_name_lock, 0, 1 ) ) sync_pause();
+
+    int index = -1;
+    for ( int i = 0; i < s_name_count; i++ )
+    {
+        if ( strncmp( s_names[ i ], name, TRACE_NAME_LENGTH - 1 ) == 0 )
+        {
+            index = i;
+            break;
+        }
+    }
+    if ( index < 0 && s_name_count < TRACE_MAX_NAMES )
+    {
+        index = s_name_count;
+        strncpy( s_names[ index ], name, TRACE_NAME_LENGTH - 1 );
+        sync_store32( &s_name_count, index + 1 );
+    }
+
+    sync_store32( &s_name_lock, 0 );
+    return index;
+}
+
+void
+trace_record( const TraceZone* zone )
+{
+    uint64_t   end  = trace_ticks();
+    TraceRing* ring = trace_ring();
+    if ( !ring )
+        return;
+
+    int32_t name = sync_load32( zone->site ) - 1;
+    if ( name < 0 )
+    {
+        name = trace_name_index( zone->name );
+        if ( name < 0 )
+            return;
+        sync_store32( zone->site, name + 1 );
+    }
+
+    int64_t     head = ring->head;
+    TraceEvent* e    = &ring->events[ head & TRACE_RING_MASK ];
+    e->start         = zone->start;
+    e->end           = end;
+    e->name          = (uint32_t)name;
+    sync_store64( &ring->head, head + 1 );
+}
+
+// Threads that never record never get a ring
+void
+trace_thread_name( const char* name )
+{
+    t_thread_name = name;
+    if ( t_ring )
+        strncpy( t_ring->name, name, TRACE_NAME_LENGTH - 1 );
+}
+
+void
+trace_clear( void )
+{
+    int count = sync_load32( &s_ring_count );
+    for ( int i = 0; i < count && i < TRACE_MAX_THREADS; i++ )
+    {
+        TraceRing* ring = (TraceRing*)sync_load_ptr( (void* volatile*)&s_rings[ i ] );
+        if ( ring )
+            sync_store64( &ring->head, 0 );
+    }
+}
+
+// ============================================================================
+// Chrome trace export
+// ============================================================================
+
+static void
+trace_write_timestamp( JsonWriter* w, const char* key, uint64_t ticks, double ns_per_tick )
+{
+    json_key( w, key );
+    json_fixed( w, (uint64_t)( (double)ticks * ns_per_tick ), 3 );    // Microseconds, nanosecond digits
+}
+
+int
+trace_export_chrome( FILE* file )
+{
+    // Rate from the two clock pairs; ticks are nanoseconds already off x86
+    uint64_t now_ticks   = trace_ticks();
+    uint64_t now_ns      = trace_now_ns();
+    double   ns_per_tick = 1.0;
+    if ( now_ticks > s_base_ticks && now_ns > s_base_ns )
+        ns_per_tick = (double)( now_ns - s_base_ns ) / (double)( now_ticks - s_base_ticks );
+
+    TraceEvent* copy = (TraceEvent*)malloc( sizeof( TraceEvent ) * TRACE_RING_EVENTS );
+    if ( !copy )
+        return -1;
+
+    JsonWriter w;
+    json_writer_init( &w, file, JSON_COMPACT );
+    json_begin_object( &w );
+    json_key( &w, "displayTimeUnit" );
+    json_string( &w, "ns", 2 );
+    json_key( &w, "traceEvents" );
+    json_begin_array( &w );
+
+    int written = 0;
+    int rings   = sync_load32( &s_ring_count );
+    for ( int tid = 0; tid < rings && tid < TRACE_MAX_THREADS; tid++ )
+    {
+        TraceRing* ring = (TraceRing*)sync_load_ptr( (void* volatile*)&s_rings[ tid ] );
+        if ( !ring )
+            continue;
+
+        json_begin_object( &w );
+        json_key( &w, "name" );
+        json_string( &w, "thread_name", 11 );
+        json_key( &w, "ph" );
+        json_string( &w, "M", 1 );
+        json_key( &w, "pid" );
+        json_uint( &w, 1 );
+        json_key( &w, "tid" );
+        json_uint( &w, (uint64_t)tid );
+        json_key( &w, "args" );
+        json_begin_object( &w );
+        json_key( &w, "name" );
+        json_string( &w, ring->name, TRACE_NAME_LENGTH );
+        json_end_object( &w );
+        json_end_object( &w );
+
+        // The owner keeps recording: copy, then drop whatever it overwrote meanwhile
+        int64_t head  = sync_load64( &ring->head );
+        int64_t first = head > TRACE_RING_EVENTS ? head - TRACE_RING_EVENTS : 0;
+        for ( int64_t i = first; i < head; i++ ) copy[ i - first ] = ring->events[ i & TRACE_RING_MASK ];
+        int64_t after = sync_load64( &ring->head );
+        int64_t valid = after > TRACE_RING_EVENTS ? after - TRACE_RING_EVENTS : 0;
+
+        int32_t names = sync_load32( &s_name_count );
+        for ( int64_t i = valid > first ? valid : first; i < head; i++ )
+        {
+            const TraceEvent* e = &copy[ i - first ];
+            if ( (int32_t)e->name >= names )
+                continue;
+
+            uint64_t start = e->start > s_base_ticks ? e->start - s_base_ticks : 0;
+            json_begin_object( &w );
+            json_key( &w, "name" );
+            json_string( &w, s_names[ e->name ], TRACE_NAME_LENGTH );
+            json_key( &w, "ph" );
+            json_string( &w, "X", 1 );
+            trace_write_timestamp( &w, "ts", start, ns_per_tick );
+            trace_write_timestamp( &w, "dur", e->end > e->start ? e->end - e->start : 0, ns_per_tick );
+            json_key( &w, "pid" );
+            json_uint( &w, 1 );
+            json_key( &w, "tid" );
+            json_uint( &w, (uint64_t)tid );
+            json_end_object( &w );
+            written++;
+        }
+    }
+
+    json_end_array( &w );
+    json_end_object( &w );
+    int ok = json_writer_finish( &w );
+    json_writer_free( &w );
+    free( copy );
+    return ok ? written : -1;
+}
@@ -0,0 +1,84 @@
+// ============================================================================
+// trace.h - Scoped trace zones, per-thread rings, Chrome trace export
+// ============================================================================
+//
+// TRACE_BEGIN( zone, "name" ) ... TRACE_END( zone ) records one complete
+// event - name, start and end in TSC ticks - into the calling thread's ring.
+// A ring has a single writer, so recording is a few stores and a release of
+// the head: no locks, no read-modify-writes. Each ring keeps the newest
+// TRACE_RING_EVENTS; older events are overwritten.
+//
+// Names are copied into a table the first time a call site records, so a
+// module's string literals may go away with the module. Every thread, the
+// job workers included, records into the same set of rings.
+//
+// trace_export_chrome writes what the rings hold as Chrome trace JSON, for
+// chrome://tracing or ui.perfetto.dev. Ticks become microseconds against a
+// clock read at trace_enable and again at export.
+//
+// Zones compile to nothing without TRACE_ENABLED (the ENABLE_TRACE build
+// option). While tracing is off they cost one load and a branch.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#define TRACE_RING_EVENTS 16384    // Per thread, power of two
+#define TRACE_MAX_THREADS 64       // Threads past this record nothing
+#define TRACE_MAX_NAMES   1024     // Distinct zone names
+#define TRACE_NAME_LENGTH 48       // Longer names are cut
+
+typedef struct TraceEvent
+{
+    uint64_t start;    // Ticks
+    uint64_t end;
+    uint32_t name;     // Index in the name table
+
+} TraceEvent;
+
+typedef struct TraceZone
+{
+    uint64_t     start;    // 0 = tracing was off at TRACE_BEGIN
+    const char*  name;
+    int32_t*     site;     // Per call site, caches the name index + 1
+
+} TraceZone;
+
+extern volatile int32_t g_trace_enabled;
+
+void     trace_enable( int enabled );
+void     trace_clear( void );                      // Drops recorded events, call with no zone open anywhere
+void     trace_thread_name( const char* name );    // Viewer label for the calling thread, kept by pointer
+uint64_t trace_ticks( void );
+void     trace_record( const TraceZone* zone );
+
+// Returns events written, -1 on a write error
+int trace_export_chrome( FILE* file );
+
+static inline TraceZone
+trace_begin( const char* name, int32_t* site )
+{
+    TraceZone zone = { g_trace_enabled ? trace_ticks() : 0, name, site };
+    return zone;
+}
+
+static inline void
+trace_end( const TraceZone* zone )
+{
+    if ( zone->start )
+        trace_record( zone );
+}
+
+#ifdef TRACE_ENABLED
+#    define TRACE_BEGIN( zone, name )  \
+        static int32_t zone##_site; \
+        TraceZone      zone = trace_begin( name, &zone##_site )
+#    define TRACE_END( zone ) trace_end( &zone )
+#else
+#    define TRACE_BEGIN( zone, name )
+#    define TRACE_END( zone ) ( (void)0 )
+#endif
+
+#endif    // TRACE_H
@@ -0,0 +1,274 @@
+// ============================================================================
+// type_ops.c - Memberwise equality, hashing, copy and lerp compiled per Type
+// ============================================================================
+
+#include "type_ops.h"
+#include "entity_kernels.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DIFF_BLOCK 64    // Objects compared per memcmp before looking at single objects
+
+#define HASH_SEED   0x9E3779B97F4A7C15ull
+#define HASH_MUL_A  0xFF51AFD7ED558CCDull
+#define HASH_MUL_B  0xC4CEB9FE1A85EC53ull
+
+static TypeOps* s_ops[ MAX_TYPES ];
+
+// ============================================================================
+// Compile
+// ============================================================================
+
+static int
+leaf_is_float( const FlatField* leaf )
+{
+    return leaf->size == 4 && field_kind( leaf->field ) == FIELD_KIND_FLOAT;
+}
+
+TypeOps*
+type_ops_compile( const Type* type )
+{
+    FlatField leaves[ TYPE_OPS_MAX_LEAVES ];
+    uint16_t  leaf_count = type_flatten( type, leaves, TYPE_OPS_MAX_LEAVES );
+    if ( leaf_count > TYPE_OPS_MAX_LEAVES )
+    {
+        printf( "ERROR: %s has too many leaf fields for type ops\n", type_name( type ) );
+        return NULL;
+    }
+
+    // Data runs merge every adjacent leaf, lerp runs only leaves of the same class
+    OpsRun   runs[ TYPE_OPS_MAX_LEAVES * 2 ];
+    uint16_t run_count  = 0;
+    uint16_t lerp_count = 0;
+    for ( uint16_t i = 0; i < leaf_count; i++ )
+    {
+        const FlatField* leaf = &leaves[ i ];
+        OpsRun*          last = run_count ? &runs[ run_count - 1 ] : NULL;
+        if ( last && last->offset + last->size == leaf->offset )
+        {
+            last->size = (uint16_t)( last->size + leaf->size );
+            continue;
+        }
+        runs[ run_count ] = ( OpsRun ){ leaf->offset, leaf->size, 0 };
+        run_count++;
+    }
+    for ( uint16_t i = 0; i < leaf_count; i++ )
+    {
+        const FlatField* leaf     = &leaves[ i ];
+        uint8_t          is_float = (uint8_t)leaf_is_float( leaf );
+        OpsRun*          last     = lerp_count ? &runs[ run_count + lerp_count - 1 ] : NULL;
+        if ( last && last->offset + last->size == leaf->offset && last->is_float == is_float )
+        {
+            last->size = (uint16_t)( last->size + leaf->size );
+            continue;
+        }
+        runs[ run_count + lerp_count ] = ( OpsRun ){ leaf->offset, leaf->size, is_float };
+        lerp_count++;
+    }
+
+    TypeOps* ops     = (TypeOps*)malloc( sizeof( TypeOps ) + ( run_count + lerp_count ) * sizeof( OpsRun ) );
+    ops->type_hash   = type->hash;
+    ops->field_first = type->field_first;
+    ops->version     = type_info( type )->version;
+    ops->object_size = type->size;
+    ops->run_count   = run_count;
+    ops->lerp_count  = lerp_count;
+    ops->is_dense    = run_count == 1 && runs[ 0 ].offset == 0 && runs[ 0 ].size == type->size;
+    ops->all_float   = ops->is_dense && lerp_count == 1 && runs[ 1 ].is_float;
+    memcpy( ops->runs, runs, ( run_count + lerp_count ) * sizeof( OpsRun ) );
+    return ops;
+}
+
+const TypeOps*
+type_ops_get( const Type* type )
+{
+    TypeOps* ops = s_ops[ type->id ];
+    if ( ops && ops->type_hash == type->hash && ops->field_first == type->field_first &&
+         ops->version == type_info( type )->version && ops->object_size == type->size )
+    {
+        return ops;
+    }
+
+    free( ops );
+    s_ops[ type->id ] = type_ops_compile( type );
+    return s_ops[ type->id ];
+}
+
+// ============================================================================
+// One object
+// ============================================================================
+
+int
+type_ops_equal( const TypeOps* ops, const void* a, const void* b )
+{
+    const char* pa = (const char*)a;
+    const char* pb = (const char*)b;
+    for ( uint16_t r = 0; r < ops->run_count; r++ )
+    {
+        const OpsRun* run = &ops->runs[ r ];
+        if ( memcmp( pa + run->offset, pb + run->offset, run->size ) != 0 )
+            return 0;
+    }
+    return 1;
+}
+
+static inline uint64_t
+hash_mix( uint64_t hash, uint64_t word )
+{
+    hash ^= word * HASH_MUL_A;
+    hash = ( hash << 31 ) | ( hash >> 33 );
+    return hash * HASH_MUL_B;
+}
+
+// Eight bytes at a time; runs are hashed back to back, so padding never shows
+uint64_t
+type_ops_hash( const TypeOps* ops, const void* object )
+{
+    const char* p    = (const char*)object;
+    uint64_t    hash = HASH_SEED ^ ops->object_size;
+    for ( uint16_t r = 0; r < ops->run_count; r++ )
+    {
+        const char* at   = p + ops->runs[ r ].offset;
+        size_t      size = ops->runs[ r ].size;
+        for ( ; size >= 8; size -= 8, at += 8 )
+        {
+            uint64_t word;
+            memcpy( &word, at, 8 );
+            hash = hash_mix( hash, word );
+        }
+        if ( size )
+        {
+            uint64_t tail = 0;
+            memcpy( &tail, at, size );
+            hash = hash_mix( hash, tail ^ ( (uint64_t)size << 56 ) );
+        }
+    }
+
+    // fmix64
+    hash ^= hash >> 33;
+    hash *= HASH_MUL_A;
+    hash ^= hash >> 33;
+    hash *= HASH_MUL_B;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+void
+type_ops_copy( const TypeOps* ops, void* dst, const void* src )
+{
+    char*       d = (char*)dst;
+    const char* s = (const char*)src;
+    for ( uint16_t r = 0; r < ops->run_count; r++ )
+    {
+        const OpsRun* run = &ops->runs[ r ];
+        memcpy( d + run->offset, s + run->offset, run->size );
+    }
+}
+
+static void
+lerp_object( const TypeOps* ops, LerpFunc lerp, char* out, const char* a, const char* b, float t )
+{
+    const char*   nearer = t < 0.5f ? a : b;
+    const OpsRun* runs   = ops->runs + ops->run_count;
+    for ( uint16_t r = 0; r < ops->lerp_count; r++ )
+    {
+        const OpsRun* run = &runs[ r ];
+        if ( run->is_float )
+        {
+            const float* from = (const float*)( a + run->offset );
+            const float* to   = (const float*)( b + run->offset );
+            lerp( (float*)( out + run->offset ), from, to, t, run->size / 4 );
+        }
+        else if ( out != nearer )
+        {
+            memcpy( out + run->offset, nearer + run->offset, run->size );
+        }
+    }
+}
+
+void
+type_ops_lerp( const TypeOps* ops, void* out, const void* a, const void* b, float t )
+{
+    lerp_object( ops, entity_kernels()->lerp, (char*)out, (const char*)a, (const char*)b, t );
+}
+
+// ============================================================================
+// Arrays
+// ============================================================================
+
+size_t
+type_ops_diff( const TypeOps* ops, const void* a, const void* b, size_t count, uint32_t* changed )
+{
+    const char* pa      = (const char*)a;
+    const char* pb      = (const char*)b;
+    size_t      size    = ops->object_size;
+    size_t      written = 0;
+
+    if ( !ops->is_dense )
+    {
+        for ( size_t i = 0; i < count; i++ )
+        {
+            if ( !type_ops_equal( ops, pa + i * size, pb + i * size ) )
+                changed[ written++ ] = (uint32_t)i;
+        }
+        return written;
+    }
+
+    // No padding: skip unchanged blocks with one memcmp
+    for ( size_t first = 0; first < count; first += DIFF_BLOCK )
+    {
+        size_t last = first + DIFF_BLOCK < count ? first + DIFF_BLOCK : count;
+        if ( memcmp( pa + first * size, pb + first * size, ( last - first ) * size ) == 0 )
+            continue;
+        for ( size_t i = first; i < last; i++ )
+        {
+            if ( memcmp( pa + i * size, pb + i * size, size ) != 0 )
+                changed[ written++ ] = (uint32_t)i;
+        }
+    }
+    return written;
+}
+
+void
+type_ops_hash_array( const TypeOps* ops, const void* objects, size_t count, uint64_t* out )
+{
+    const char* p = (const char*)objects;
+    for ( size_t i = 0; i < count; i++ ) out[ i ] = type_ops_hash( ops, p + i * ops->object_size );
+}
+
+void
+type_ops_copy_array( const TypeOps* ops, void* dst, const void* src, size_t count )
+{
+    if ( ops->is_dense )
+    {
+        memcpy( dst, src, count * ops->object_size );
+        return;
+    }
+
+    char*       d    = (char*)dst;
+    const char* s    = (const char*)src;
+    size_t      size = ops->object_size;
+    for ( size_t i = 0; i < count; i++ ) type_ops_copy( ops, d + i * size, s + i * size );
+}
+
+void
+type_ops_lerp_array( const TypeOps* ops, void* out, const void* a, const void* b, size_t count, float t )
+{
+    LerpFunc lerp = entity_kernels()->lerp;
+    if ( ops->all_float )
+    {
+        lerp( (float*)out, (const float*)a, (const float*)b, t, count * ops->object_size / 4 );
+        return;
+    }
+
+    char*       po   = (char*)out;
+    const char* pa   = (const char*)a;
+    const char* pb   = (const char*)b;
+    size_t      size = ops->object_size;
+    for ( size_t i = 0; i < count; i++ )
+    {
+        lerp_object( ops, lerp, po + i * size, pa + i * size, pb + i * size, t );
+    }
+}
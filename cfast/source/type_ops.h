@@ -0,0 +1,66 @@
+// ============================================================================
+// type_ops.h - Memberwise equality, hashing, copy and lerp compiled per Type
+// ============================================================================
+//
+// Each Type is compiled once into TypeOps: its flattened leaf fields merged
+// into byte runs that skip padding, plus the same leaves split where float
+// and non-float leaves meet. Objects are then compared, hashed and copied a
+// run at a time (one memcmp / memcpy for padding-free types, one for a whole
+// array of them), never through a per-field walk of Type::fields.
+//
+// Everything is bitwise per leaf: +0 and -0 differ, a NaN equals itself.
+// Padding is never read, so objects that differ only there are equal and
+// hash the same, and copies leave the destination's padding alone.
+//
+// Lerp interpolates 4-byte float leaves as a + ( b - a ) * t through the
+// entity_kernels lerp pass - SIMD over each float run, over the whole array
+// when the type is nothing but floats - and takes every other leaf from the
+// nearer end: a while t < 0.5, else b.
+
+#ifndef TYPE_OPS_H
+#define TYPE_OPS_H
+
+#include "reflection_core.h"
+
+#define TYPE_OPS_MAX_LEAVES 256    // Flattened leaf limit per type
+
+typedef struct OpsRun
+{
+    uint16_t offset;
+    uint16_t size;        // Bytes
+    uint8_t  is_float;    // Lerp runs only: every leaf in it is a 4-byte float
+
+} OpsRun;
+
+typedef struct TypeOps
+{
+    TypeHash type_hash;
+    uint32_t field_first;    // Registry field range and version the ops were built from - a freed
+    uint8_t  version;        // range can come back to the same TypeID, the version then differs
+    uint16_t object_size;
+    uint8_t  is_dense;       // No padding: one run covers the object
+    uint8_t  all_float;      // Dense and float leaves only: arrays lerp as one float array
+    uint16_t run_count;      // Data runs, runs[ 0, run_count )
+    uint16_t lerp_count;     // Lerp runs, runs[ run_count, run_count + lerp_count )
+    OpsRun   runs[];
+
+} TypeOps;
+
+// Cached per TypeID and rebuilt when the type changes, NULL if it has too many leaves
+TypeOps*       type_ops_compile( const Type* type );
+const TypeOps* type_ops_get( const Type* type );
+
+// One object
+int      type_ops_equal( const TypeOps* ops, const void* a, const void* b );
+uint64_t type_ops_hash( const TypeOps* ops, const void* object );
+void     type_ops_copy( const TypeOps* ops, void* dst, const void* src );
+void     type_ops_lerp( const TypeOps* ops, void* out, const void* a, const void* b, float t );
+
+// Arrays of count objects, object_size apart. type_ops_diff writes the indices
+// where a and b differ to changed (count entries at most) and returns how many.
+size_t type_ops_diff( const TypeOps* ops, const void* a, const void* b, size_t count, uint32_t* changed );
+void   type_ops_hash_array( const TypeOps* ops, const void* objects, size_t count, uint64_t* out );
+void   type_ops_copy_array( const TypeOps* ops, void* dst, const void* src, size_t count );
+void   type_ops_lerp_array( const TypeOps* ops, void* out, const void* a, const void* b, size_t count, float t );
+
+#endif    // TYPE_OPS_H
@@ -0,0 +1,279 @@
+// ============================================================================
+// type_pool.c - Per-type object pools addressed by generational handles
+// ============================================================================
+
+#include "type_pool.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifdef _WIN32
+#    include <malloc.h>
+#    define chunk_alloc( size ) _aligned_malloc( size, POOL_ALIGNMENT )
+#    define chunk_free( ptr )   _aligned_free( ptr )
+#else
+#    define chunk_alloc( size ) aligned_alloc( POOL_ALIGNMENT, size )
+#    define chunk_free( ptr )   free( ptr )
+#endif
+
+// Stride * 256 is always a multiple of 64, as aligned_alloc wants
+static size_t
+chunk_bytes( uint16_t stride )
+{
+    return (size_t)stride * POOL_CHUNK_OBJECTS;
+}
+
+// Layout bookkeeping for the pool's current type: leaves, version, prototype
+static int
+pool_bind( TypePool* pool, const Type* type )
+{
+    LayoutLeaf  leaves[ MIGRATE_MAX_LEAVES ];
+    uint16_t    leaf_count = layout_leaves( type, leaves, MIGRATE_MAX_LEAVES );
+    LayoutLeaf* kept       = (LayoutLeaf*)malloc( ( leaf_count ? leaf_count : 1 ) * sizeof( LayoutLeaf ) );
+    char*       prototype  = (char*)malloc( type->size );
+    if ( leaf_count > MIGRATE_MAX_LEAVES || !kept || !prototype )
+    {
+        free( kept );
+        free( prototype );
+        return 0;
+    }
+    memcpy( kept, leaves, leaf_count * sizeof( LayoutLeaf ) );
+    migrate_prototype( type, prototype );
+
+    free( pool->leaves );
+    free( pool->prototype );
+    pool->type_hash  = type->hash;
+    pool->type_id    = type->id;
+    pool->stride     = type->size;
+    pool->leaves     = kept;
+    pool->leaf_count = leaf_count;
+    pool->version    = type_info( type )->version;
+    pool->prototype  = prototype;
+    return 1;
+}
+
+// ============================================================================
+// Create / destroy
+// ============================================================================
+
+TypePool*
+pool_create( const Type* type, uint32_t capacity )
+{
+    if ( type->size == 0 || type->alignment > POOL_ALIGNMENT )
+    {
+        printf( "ERROR: %s cannot be pooled (size %u, alignment %u)\n", type_name( type ), type->size,
+                type->alignment );
+        return NULL;
+    }
+
+    TypePool* pool = (TypePool*)calloc( 1, sizeof( TypePool ) );
+    if ( !pool )
+        return NULL;
+    pool->free_head = POOL_NONE;
+    if ( !pool_bind( pool, type ) || !pool_reserve( pool, capacity ? capacity : POOL_CHUNK_OBJECTS ) )
+    {
+        pool_destroy( pool );
+        return NULL;
+    }
+    return pool;
+}
+
+void
+pool_destroy( TypePool* pool )
+{
+    if ( !pool )
+        return;
+    for ( uint32_t i = 0; i < pool->capacity / POOL_CHUNK_OBJECTS; i++ ) chunk_free( pool->chunks[ i ] );
+    free( pool->generations );
+    free( pool->next_free );
+    free( pool->prototype );
+    free( pool->leaves );
+    free( pool );
+}
+
+int
+pool_reserve( TypePool* pool, uint32_t capacity )
+{
+    if ( capacity > POOL_MAX_OBJECTS )
+        return 0;
+    capacity = ( capacity + POOL_CHUNK_OBJECTS - 1 ) & ~( POOL_CHUNK_OBJECTS - 1 );
+    if ( capacity <= pool->capacity )
+        return 1;
+
+    uint16_t* generations = (uint16_t*)realloc( pool->generations, capacity * sizeof( uint16_t ) );
+    if ( !generations )
+        return 0;
+    pool->generations = generations;
+    uint32_t* next_free = (uint32_t*)realloc( pool->next_free, capacity * sizeof( uint32_t ) );
+    if ( !next_free )
+        return 0;
+    pool->next_free = next_free;
+
+    // Chunks one at a time: whatever was allocated before a failure stays usable
+    while ( pool->capacity < capacity )
+    {
+        char* chunk = (char*)chunk_alloc( chunk_bytes( pool->stride ) );
+        if ( !chunk )
+            return 0;
+        pool->chunks[ pool->capacity / POOL_CHUNK_OBJECTS ] = chunk;
+        memset( &pool->generations[ pool->capacity ], 0, POOL_CHUNK_OBJECTS * sizeof( uint16_t ) );
+        pool->capacity += POOL_CHUNK_OBJECTS;
+    }
+    return 1;
+}
+
+// ============================================================================
+// Alloc / free
+// ============================================================================
+
+Handle
+pool_alloc( TypePool* pool )
+{
+    uint32_t index = pool->free_head;
+    if ( index != POOL_NONE )
+        pool->free_head = pool->next_free[ index ];
+    else
+    {
+        // Geometric growth, so a burst of spawns allocates a handful of times
+        if ( pool->used == pool->capacity && !pool_reserve( pool, pool->capacity * 2 ) &&
+             !pool_reserve( pool, pool->capacity + 1 ) )
+            return HANDLE_NULL;
+        index = pool->used++;
+    }
+
+    uint16_t generation        = ( pool->generations[ index ] + 1 ) & POOL_GEN_MASK;
+    pool->generations[ index ] = generation;
+    memcpy( pool_slot( pool, index ), pool->prototype, pool->stride );
+    pool->count++;
+    return (Handle)generation << POOL_INDEX_BITS | index;
+}
+
+int
+pool_free( TypePool* pool, Handle handle )
+{
+    if ( !pool_get( pool, handle ) )
+        return 0;
+
+    uint32_t index             = handle & POOL_INDEX_MASK;
+    pool->generations[ index ] = ( pool->generations[ index ] + 1 ) & POOL_GEN_MASK;
+    pool->next_free[ index ]   = pool->free_head;
+    pool->free_head            = index;
+    pool->count--;
+    return 1;
+}
+
+// ============================================================================
+// Layout migration
+// ============================================================================
+
+int
+pool_migrate( TypePool* pool, const Type* new_type )
+{
+    if ( new_type->size == 0 || new_type->alignment > POOL_ALIGNMENT )
+        return 0;
+
+    MigrationPlan* plan =
+        migration_compile_leaves( pool->leaves, pool->leaf_count, pool->stride, pool->version, new_type );
+    if ( !plan )
+        return 0;
+    if ( plan->is_identity )
+    {
+        free( plan );
+        return pool_bind( pool, new_type );
+    }
+
+    // Every new chunk first, so a failure leaves the pool as it was
+    uint32_t chunk_count = pool->capacity / POOL_CHUNK_OBJECTS;
+    char**   fresh       = (char**)calloc( chunk_count ? chunk_count : 1, sizeof( char* ) );
+    int      ok          = fresh != NULL;
+    for ( uint32_t i = 0; ok && i < chunk_count; i++ )
+    {
+        fresh[ i ] = (char*)chunk_alloc( chunk_bytes( new_type->size ) );
+        ok         = fresh[ i ] != NULL;
+    }
+
+    // Leaves, version and prototype of the new layout; the pool is untouched if this fails
+    ok = ok && pool_bind( pool, new_type );
+    if ( !ok )
+    {
+        for ( uint32_t i = 0; fresh && i < chunk_count; i++ ) chunk_free( fresh[ i ] );
+        free( fresh );
+        free( plan );
+        return 0;
+    }
+
+    // Free slots are converted too - harmless, alloc overwrites them with the prototype
+    for ( uint32_t i = 0; i < chunk_count; i++ )
+    {
+        uint32_t first = i * POOL_CHUNK_OBJECTS;
+        uint32_t slots = pool->used > first ? pool->used - first : 0;
+        if ( slots > POOL_CHUNK_OBJECTS )
+            slots = POOL_CHUNK_OBJECTS;
+        migration_run( plan, pool->chunks[ i ], fresh[ i ], slots );
+        chunk_free( pool->chunks[ i ] );
+        pool->chunks[ i ] = fresh[ i ];
+    }
+    free( fresh );
+    free( plan );
+    return 1;
+}
+
+// ============================================================================
+// Registry pools
+// ============================================================================
+
+static TypePool* s_pools[ MAX_TYPES ];
+static uint16_t  s_pool_count;
+
+// A reload moves a type it changed to a fresh TypeID, which a later change may hand back: check both
+static int
+pool_current( const TypePool* pool, const Type* type )
+{
+    return pool->type_id == type->id && pool->version == type_info( type )->version;
+}
+
+TypePool*
+type_pool( const Type* type )
+{
+    for ( uint16_t i = 0; i < s_pool_count; i++ )
+    {
+        TypePool* pool = s_pools[ i ];
+        if ( pool->type_hash != type->hash )
+            continue;
+        if ( !pool_current( pool, type ) && !pool_migrate( pool, type ) )
+        {
+            printf( "ERROR: Pool of %s could not follow the new layout\n", type_name( type ) );
+            return NULL;
+        }
+        return pool;
+    }
+
+    if ( s_pool_count >= MAX_TYPES )
+        return NULL;
+    TypePool* pool = pool_create( type, 0 );
+    if ( pool )
+        s_pools[ s_pool_count++ ] = pool;
+    return pool;
+}
+
+int
+type_pools_migrate( void )
+{
+    int migrated = 0;
+    for ( uint16_t i = 0; i < s_pool_count; i++ )
+    {
+        Type* newest = type_find_by_hash( s_pools[ i ]->type_hash );
+        if ( newest && !pool_current( s_pools[ i ], newest ) )
+            migrated += type_pool( newest ) != NULL;
+    }
+    return migrated;
+}
+
+void
+type_pools_release( void )
+{
+    for ( uint16_t i = 0; i < s_pool_count; i++ ) pool_destroy( s_pools[ i ] );
+    s_pool_count = 0;
+}
+
+// ============================================================================
@@ -0,0 +1,114 @@
+// ============================================================================
+// type_pool.h - Per-type object pools addressed by generational handles
+// ============================================================================
+//
+// Objects of one registered type live in fixed chunks of POOL_CHUNK_OBJECTS
+// slots, stride Type::size, chunk base POOL_ALIGNMENT aligned. Chunks never
+// move, freed slots go on a LIFO free list, so once a pool has reserved its
+// peak, spawning and despawning never calls malloc.
+//
+// Code keeps a Handle rather than a pointer: 20 bits of slot index and 12 bits
+// of slot generation. The generation is bumped on alloc and on free, so live
+// slots have odd generations, a stale handle fails the compare and handle 0
+// is never valid. When a reload changes the type's layout, pool_migrate
+// re-lays every chunk through layout_migrate; indices do not change, so every
+// handle stays valid. A slot is reused for the same handle bits only after
+// 2048 alloc/free cycles on that slot.
+//
+// New objects are copies of the type's create() prototype (zero if it has
+// none), taken once per layout - create() itself is never called per object.
+
+#ifndef TYPE_POOL_H
+#define TYPE_POOL_H
+
+#include "reflection_core.h"
+#include "layout_migrate.h"
+
+#define POOL_INDEX_BITS     20
+#define POOL_INDEX_MASK     ( ( 1u << POOL_INDEX_BITS ) - 1 )
+#define POOL_GEN_MASK       0xFFFu
+#define POOL_MAX_OBJECTS    ( 1u << POOL_INDEX_BITS )
+#define POOL_CHUNK_SHIFT    8
+#define POOL_CHUNK_OBJECTS  ( 1u << POOL_CHUNK_SHIFT )
+#define POOL_MAX_CHUNKS     ( POOL_MAX_OBJECTS / POOL_CHUNK_OBJECTS )
+#define POOL_ALIGNMENT      64    // Chunk base alignment, also the largest type alignment supported
+#define POOL_NONE           UINT32_MAX
+
+typedef uint32_t Handle;    // generation << POOL_INDEX_BITS | index, 0 = none
+
+#define HANDLE_NULL 0u
+
+typedef struct TypePool
+{
+    TypeHash type_hash;
+    TypeID   type_id;        // Layout the chunks are in
+    uint16_t stride;         // Type::size
+    uint32_t count;          // Live objects
+    uint32_t used;           // Slots ever handed out, high water mark
+    uint32_t capacity;       // Slots in allocated chunks
+    uint32_t free_head;      // Most recently freed slot, POOL_NONE if empty
+
+    uint16_t*   generations;    // capacity entries, odd = live
+    uint32_t*   next_free;      // capacity entries, free list links
+    char*       prototype;      // stride bytes, copied into every new object
+    LayoutLeaf* leaves;         // Current layout, source side of the next migration
+    uint16_t    leaf_count;
+    uint8_t     version;
+    char*       chunks[ POOL_MAX_CHUNKS ];
+
+} TypePool;
+
+// ---------------------------------------------------------------------------
+// Owned pools
+// ---------------------------------------------------------------------------
+
+TypePool* pool_create( const Type* type, uint32_t capacity );
+void      pool_destroy( TypePool* pool );
+int       pool_reserve( TypePool* pool, uint32_t capacity );    // Rounds up to whole chunks
+
+Handle pool_alloc( TypePool* pool );                 // HANDLE_NULL when full or out of memory
+int    pool_free( TypePool* pool, Handle handle );    // 0 if the handle was stale
+
+// Re-lays every object out for new_type (same name, later registration). Handles
+// and the pool pointer stay valid, object pointers do not. 0 on failure, pool unchanged.
+int pool_migrate( TypePool* pool, const Type* new_type );
+
+static inline void*
+pool_slot( const TypePool* pool, uint32_t index )
+{
+    return pool->chunks[ index >> POOL_CHUNK_SHIFT ] + ( index & ( POOL_CHUNK_OBJECTS - 1 ) ) * pool->stride;
+}
+
+// Object for handle, NULL if stale or freed
+static inline void*
+pool_get( const TypePool* pool, Handle handle )
+{
+    uint32_t index      = handle & POOL_INDEX_MASK;
+    uint32_t generation = handle >> POOL_INDEX_BITS;
+    if ( index >= pool->used || pool->generations[ index ] != generation || !( generation & 1 ) )
+        return NULL;
+    return pool_slot( pool, index );
+}
+
+// Walk live objects with index in [0, used): HANDLE_NULL for free slots
+static inline Handle
+pool_handle_at( const TypePool* pool, uint32_t index )
+{
+    uint32_t generation = pool->generations[ index ];
+    return ( generation & 1 ) ? ( generation << POOL_INDEX_BITS | index ) : HANDLE_NULL;
+}
+
+// ---------------------------------------------------------------------------
+// Registry pools - one per type name, created on first use, owned by the core
+// ---------------------------------------------------------------------------
+
+// Pool for type, migrated first if it still holds an older registration
+TypePool* type_pool( const Type* type );
+
+// Moves every registry pool onto the newest registration of its type. Call
+// after a module re-registered its types. Returns the number of pools migrated.
+int type_pools_migrate( void );
+
+void type_pools_release( void );
+
+#endif    // TYPE_POOL_H
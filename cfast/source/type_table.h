@@ -0,0 +1,73 @@
+// ============================================================================
+// type_table.h - Declarative reflected structs, tables built by the compiler
+// ============================================================================
+//
+// A reflected struct is written once, as a list macro taking the struct name
+// and two row macros - see game_types.h:
+//
+//   #define VEC3_FIELDS( S, FIELD, NESTED ) FIELD( S, float, x, , 0 ) ...
+//
+// FIELD rows are primitives (dims is an array suffix or empty), NESTED rows
+// are reflected structs registered before this one. From the list:
+//
+//   TYPE_STRUCT( S, LIST )  the struct itself and TYPE_FIELD_S_member indices,
+//                           TYPE_FIELD_COUNT_S - field order is member order
+//   TYPE_TABLE( S, LIST )   static const k_S_fields / k_S_field_types, offsets
+//                           and sizes taken from the struct
+//   TYPE_DESC( S, ... )     a constant TypeDesc initializer for them
+//
+// TYPE_TABLE and TYPE_DESC need reflection_core.h; TYPE_STRUCT does not, so
+// shared headers stay light. Nested types are named, not numbered: the
+// registry resolves k_S_field_types to type ids when the table is registered.
+
+#ifndef TYPE_TABLE_H
+#define TYPE_TABLE_H
+
+#include <stddef.h>    // offsetof
+
+// Struct and field indices
+#define TYPE_MEMBER( S, type, member, dims, flags ) type member dims;
+#define TYPE_MEMBER_NESTED( S, type, member, flags ) type member;
+#define TYPE_INDEX( S, type, member, dims, flags ) TYPE_FIELD_##S##_##member,
+#define TYPE_INDEX_NESTED( S, type, member, flags ) TYPE_FIELD_##S##_##member,
+
+#define TYPE_STRUCT( S, LIST )                          \
+    typedef struct S                                    \
+    {                                                   \
+        LIST( S, TYPE_MEMBER, TYPE_MEMBER_NESTED )      \
+    } S;                                                \
+    enum                                                \
+    {                                                   \
+        LIST( S, TYPE_INDEX, TYPE_INDEX_NESTED )        \
+        TYPE_FIELD_COUNT_##S                            \
+    }
+
+// Field tables
+#define TYPE_FIELD_ROW( S, type, member, dims, flags ) \
+    { #member, offsetof( S, member ), sizeof( ( (S*)0 )->member ), 0, flags },
+#define TYPE_FIELD_ROW_NESTED( S, type, member, flags ) \
+    { #member, offsetof( S, member ), sizeof( type ), 0, flags },
+#define TYPE_FIELD_NAME( S, type, member, dims, flags )     "",
+#define TYPE_FIELD_NAME_NESTED( S, type, member, flags )    #type,
+
+#define TYPE_TABLE( S, LIST )                                                                                \
+    static const Field k_##S##_fields[] = { LIST( S, TYPE_FIELD_ROW, TYPE_FIELD_ROW_NESTED ) };              \
+    static const char* const k_##S##_field_types[] = { LIST( S, TYPE_FIELD_NAME, TYPE_FIELD_NAME_NESTED ) }; \
+    _Static_assert( sizeof( k_##S##_fields ) / sizeof( Field ) == TYPE_FIELD_COUNT_##S, #S " table out of step" )
+
+// Registration input - quants is NULL or a FieldQuant array with one entry per field
+#define TYPE_DESC( S, quant_table, module, type_version ) \
+    {                                                     \
+        .hash        = TYPE_NAME_HASH( #S ),              \
+        .name        = #S,                                \
+        .size        = sizeof( S ),                       \
+        .alignment   = _Alignof( S ),                     \
+        .fields      = k_##S##_fields,                    \
+        .field_count = TYPE_FIELD_COUNT_##S,              \
+        .quants      = quant_table,                       \
+        .field_types = k_##S##_field_types,               \
+        .module_id   = module,                            \
+        .version     = type_version,                      \
+    }
+
+#endif    // TYPE_TABLE_H